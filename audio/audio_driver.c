@@ -14,6 +14,8 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <string/string_list.h>
 #include "audio_driver.h"
@@ -25,11 +27,22 @@
 #include "../retroarch.h"
 #include "../runloop.h"
 #include "../performance.h"
+#include "../performance/performance_trace.h"
 
 #ifndef AUDIO_BUFFER_FREE_SAMPLES_COUNT
 #define AUDIO_BUFFER_FREE_SAMPLES_COUNT (8 * 1024)
 #endif
 
+/* Integral time of the rate control, in seconds of audio. */
+#ifndef AUDIO_RATE_CONTROL_TI
+#define AUDIO_RATE_CONTROL_TI 2.0
+#endif
+
+/* Weight of a new buffer level in the filtered one. */
+#ifndef AUDIO_RATE_CONTROL_SMOOTHING
+#define AUDIO_RATE_CONTROL_SMOOTHING 0.25
+#endif
+
 typedef struct audio_driver_input_data
 {
    float *data;
@@ -54,9 +67,21 @@ typedef struct audio_driver_input_data
    rarch_dsp_filter_t *dsp;
 
    bool rate_control; 
+   bool threaded;
    double orig_src_ratio;
    size_t driver_buffer_size;
 
+   /* PI rate control, see audio_driver_readjust_input_rate(). */
+   size_t rate_control_target;
+   size_t rate_control_avail;
+   double rate_control_fill;
+   double rate_control_integral;
+   bool rate_control_saturated;
+   unsigned underruns;
+   unsigned overruns;
+   /* Whether the driver drops what does not fit instead of blocking. */
+   bool nonblock;
+
    float volume_gain;
    struct retro_audio_callback audio_callback;
 
@@ -135,57 +160,125 @@ static const audio_driver_t * audio_get_ptr(const driver_t *driver)
    return NULL;
 }
 
+/* Size of a millisecond of output in the driver buffer. */
+static double audio_driver_bytes_per_ms(void)
+{
+   settings_t *settings = config_get_ptr();
+
+   return settings->audio.out_rate * 2.0 / 1000.0 *
+      (audio_data.use_float ? sizeof(float) : sizeof(int16_t));
+}
+
+static int audio_driver_compare_fill(const void *a, const void *b)
+{
+   float fill_a = *(const float*)a;
+   float fill_b = *(const float*)b;
+
+   if (fill_a < fill_b)
+      return -1;
+   return fill_a > fill_b;
+}
+
 /**
- * compute_audio_buffer_statistics:
+ * audio_driver_get_stats:
+ * @stats              : filled with the statistics.
  *
- * Computes audio buffer statistics.
+ * Computes statistics of the audio buffer level over the last
+ * AUDIO_BUFFER_FREE_SAMPLES_COUNT writes, along with the state of
+ * rate control.
  *
+ * Returns: true if rate control is running and enough samples
+ * were taken, otherwise false.
  **/
-static void compute_audio_buffer_statistics(void)
+bool audio_driver_get_stats(struct audio_driver_stats *stats)
 {
-   unsigned i, low_water_size, high_water_size, avg, stddev;
-   float avg_filled, deviation;
-   uint64_t accum = 0, accum_var = 0;
-   unsigned low_water_count = 0, high_water_count = 0;
-   unsigned samples = 0;
-   
-   samples = min(audio_data.buffer_free_samples_count,
-         AUDIO_BUFFER_FREE_SAMPLES_COUNT);
+   unsigned i, samples, first;
+   float *fill;
+   double accum = 0.0, accum_var = 0.0;
+   double size  = audio_data.driver_buffer_size;
 
-   if (samples < 3)
-      return;
+   memset(stats, 0, sizeof(*stats));
 
-   for (i = 1; i < samples; i++)
-      accum += audio_data.buffer_free_samples[i];
+   if (!audio_data.rate_control || !size
+         || audio_data.buffer_free_samples_count < 3)
+      return false;
 
-   avg = accum / (samples - 1);
+   /* The first level is taken before anything was written. */
+   first   = audio_data.buffer_free_samples_count <=
+      AUDIO_BUFFER_FREE_SAMPLES_COUNT;
+   samples = min(audio_data.buffer_free_samples_count,
+         AUDIO_BUFFER_FREE_SAMPLES_COUNT) - first;
+
+   if (!(fill = (float*)malloc(samples * sizeof(*fill))))
+      return false;
 
-   for (i = 1; i < samples; i++)
+   for (i = 0; i < samples; i++)
    {
-      int diff = avg - audio_data.buffer_free_samples[i];
-      accum_var += diff * diff;
-   }
+      unsigned avail = audio_data.buffer_free_samples[i + first];
 
-   stddev          = (unsigned)sqrt((double)accum_var / (samples - 2));
-   avg_filled      = 1.0f - (float)avg / audio_data.driver_buffer_size;
-   deviation       = (float)stddev / audio_data.driver_buffer_size;
+      fill[i] = avail >= size ? 0.0f : 100.0f * (1.0f - avail / size);
+      accum  += fill[i];
 
-   low_water_size  = audio_data.driver_buffer_size * 3 / 4;
-   high_water_size = audio_data.driver_buffer_size / 4;
+      if (fill[i] <= 25.0f)
+         stats->low_water++;
+      else if (fill[i] >= 75.0f)
+         stats->high_water++;
+   }
+
+   stats->samples  = samples;
+   stats->fill_avg = accum / samples;
 
-   for (i = 1; i < samples; i++)
+   for (i = 0; i < samples; i++)
    {
-      if (audio_data.buffer_free_samples[i] >= low_water_size)
-         low_water_count++;
-      else if (audio_data.buffer_free_samples[i] <= high_water_size)
-         high_water_count++;
+      double diff = fill[i] - stats->fill_avg;
+      accum_var  += diff * diff;
    }
 
+   stats->fill_stddev = sqrt(accum_var / (samples - 1));
+   stats->low_water   = 100.0f * stats->low_water / samples;
+   stats->high_water  = 100.0f * stats->high_water / samples;
+
+   qsort(fill, samples, sizeof(*fill), audio_driver_compare_fill);
+   stats->fill_p1  = fill[samples / 100];
+   stats->fill_p5  = fill[samples * 5 / 100];
+   stats->fill_p50 = fill[samples / 2];
+   stats->fill_p95 = fill[samples * 95 / 100];
+   stats->fill_p99 = fill[samples * 99 / 100];
+   free(fill);
+
+   stats->target       = 100.0f * audio_data.rate_control_target / size;
+   stats->latency_ms   = audio_data.rate_control_fill /
+      audio_driver_bytes_per_ms();
+   stats->underruns    = audio_data.underruns;
+   stats->overruns     = audio_data.overruns;
+   stats->ratio_adjust = audio_data.src_ratio / audio_data.orig_src_ratio;
+   stats->drift_ppm    = audio_data.rate_control_integral * 1000000.0;
+
+   return true;
+}
+
+/**
+ * compute_audio_buffer_statistics:
+ *
+ * Computes audio buffer statistics.
+ *
+ **/
+static void compute_audio_buffer_statistics(void)
+{
+   struct audio_driver_stats stats;
+
+   if (!audio_driver_get_stats(&stats))
+      return;
+
    RARCH_LOG("Average audio buffer saturation: %.2f %%, standard deviation (percentage points): %.2f %%.\n",
-         avg_filled * 100.0, deviation * 100.0);
+         stats.fill_avg, stats.fill_stddev);
    RARCH_LOG("Amount of time spent close to underrun: %.2f %%. Close to blocking: %.2f %%.\n",
-         (100.0 * low_water_count) / (samples - 1),
-         (100.0 * high_water_count) / (samples - 1));
+         stats.low_water, stats.high_water);
+   RARCH_LOG("Audio buffer target: %.2f %%, percentiles 1/5/50/95/99: %.1f/%.1f/%.1f/%.1f/%.1f %%.\n",
+         stats.target, stats.fill_p1, stats.fill_p5, stats.fill_p50,
+         stats.fill_p95, stats.fill_p99);
+   RARCH_LOG("Audio underruns: %u, overruns: %u, clock drift: %.0f ppm.\n",
+         stats.underruns, stats.overruns, stats.drift_ppm);
 }
 
 /**
@@ -218,6 +311,50 @@ const char *audio_driver_find_ident(int idx)
    return drv->ident;
 }
 
+static double audio_driver_clamp_adjust(double value, double limit)
+{
+   if (value > limit)
+      return limit;
+   if (value < -limit)
+      return -limit;
+   return value;
+}
+
+/**
+ * audio_driver_init_rate_control:
+ *
+ * Resets rate control and sets the buffer level it steers to,
+ * audio_rate_control_target milliseconds or half of the buffer.
+ **/
+static void audio_driver_init_rate_control(void)
+{
+   settings_t *settings = config_get_ptr();
+   size_t size          = audio_data.driver_buffer_size;
+   size_t target        = size / 2;
+
+   if (settings->audio.rate_control_target)
+   {
+      target = settings->audio.rate_control_target *
+         audio_driver_bytes_per_ms();
+
+      if (target > size * 3 / 4)
+      {
+         RARCH_WARN("Audio rate control target of %u ms does not fit into the audio buffer, using %u ms.\n",
+               settings->audio.rate_control_target,
+               (unsigned)(size * 3 / 4 / audio_driver_bytes_per_ms()));
+         target = size * 3 / 4;
+      }
+   }
+
+   audio_data.rate_control_target        = target;
+   audio_data.rate_control_fill          = target;
+   audio_data.rate_control_integral      = 0.0;
+   audio_data.rate_control_saturated     = false;
+   audio_data.underruns                  = 0;
+   audio_data.overruns                   = 0;
+   audio_data.buffer_free_samples_count  = 0;
+}
+
 /**
  * config_get_audio_driver_options:
  *
@@ -378,8 +515,9 @@ void init_audio(void)
    }
 
    find_audio_driver();
+   audio_data.threaded = false;
 #ifdef HAVE_THREADS
-   if (audio_data.audio_callback.callback)
+   if (audio_data.audio_callback.callback || settings->audio.threaded)
    {
       RARCH_LOG("Starting threaded audio driver ...\n");
       if (!rarch_threaded_audio_init(&driver->audio, &driver->audio_data,
@@ -390,6 +528,7 @@ void init_audio(void)
          RARCH_ERR("Cannot open threaded audio driver ... Exiting ...\n");
          rarch_fail(1, "init_audio()");
       }
+      audio_data.threaded = true;
    }
    else
 #endif
@@ -409,6 +548,7 @@ void init_audio(void)
    if (driver->audio_active && driver->audio->use_float(driver->audio_data))
       audio_data.use_float = true;
 
+   audio_data.nonblock = false;
    if (!settings->audio.sync && driver->audio_active)
    {
       event_command(EVENT_CMD_AUDIO_SET_NONBLOCKING_STATE);
@@ -462,6 +602,7 @@ void init_audio(void)
          audio_data.driver_buffer_size = 
             driver->audio->buffer_size(driver->audio_data);
          audio_data.rate_control = true;
+         audio_driver_init_rate_control();
       }
       else
          RARCH_WARN("Audio rate control was desired, but driver does not support needed features.\n");
@@ -469,10 +610,8 @@ void init_audio(void)
 
    event_command(EVENT_CMD_DSP_FILTER_INIT);
 
-   audio_data.buffer_free_samples_count = 0;
-
    if (driver->audio_active && !settings->audio.mute_enable &&
-         audio_data.audio_callback.callback)
+         audio_data.threaded)
    {
       /* Threaded driver is initially stopped. */
       driver->audio->start(driver->audio_data);
@@ -507,35 +646,72 @@ bool audio_driver_mute_toggle(void)
 
 /*
  * audio_driver_readjust_input_rate:
+ * @frames             : input frames about to be resampled.
  *
- * Readjust the audio input rate.
+ * Readjust the audio input rate, to hold the driver buffer at
+ * the rate control target.
+ *
+ * This is a PI controller on the filtered buffer level. The
+ * proportional part steers toward the target, like the plain
+ * rate control did toward half of the buffer. The integral part
+ * settles at the drift between the audio clock and the rate the
+ * content is timed at, so the level stays at the target
+ * instead of where the two cancel out. Both are limited by
+ * audio_rate_control_delta.
  */
-void audio_driver_readjust_input_rate(void)
+void audio_driver_readjust_input_rate(size_t frames)
 {
+   double fill, error, integral, ti;
    driver_t *driver     = driver_get_ptr();
    const audio_driver_t *audio = driver ? 
       (const audio_driver_t*)driver->audio : NULL;
    settings_t *settings = config_get_ptr();
    unsigned write_idx   = audio_data.buffer_free_samples_count++ &
       (AUDIO_BUFFER_FREE_SAMPLES_COUNT - 1);
-   int      half_size   = audio_data.driver_buffer_size / 2;
-   int      avail       = audio->write_avail(driver->audio_data);
-   int      delta_mid   = avail - half_size;
-   double   direction   = (double)delta_mid / half_size;
-   double   adjust      = 1.0 + settings->audio.rate_control_delta * direction;
-
-#if 0
-   RARCH_LOG_OUTPUT("Audio buffer is %u%% full\n",
-         (unsigned)(100 - (avail * 100) / audio_data.driver_buffer_size));
-#endif
+   double   size        = audio_data.driver_buffer_size;
+   double   delta       = settings->audio.rate_control_delta;
+   size_t   avail       = audio->write_avail(driver->audio_data);
 
    audio_data.buffer_free_samples[write_idx] = avail;
-   audio_data.src_ratio = audio_data.orig_src_ratio * adjust;
+   audio_data.rate_control_avail             = avail;
 
-#if 0
-   RARCH_LOG_OUTPUT("New rate: %lf, Orig rate: %lf\n",
-         audio_data.src_ratio, audio_data.orig_src_ratio);
-#endif
+   if (avail >= size)
+   {
+      /* Ran dry, but not before anything was written. */
+      if (audio_data.buffer_free_samples_count > 1)
+         audio_data.underruns++;
+      fill = 0.0;
+   }
+   else
+      fill = size - avail;
+
+   /* Writes come in chunks, steer the level in between. */
+   audio_data.rate_control_fill += AUDIO_RATE_CONTROL_SMOOTHING *
+      (fill - audio_data.rate_control_fill);
+
+   error = audio_driver_clamp_adjust((audio_data.rate_control_target -
+            audio_data.rate_control_fill) / (size / 2), 1.0);
+
+   /* Catch up quickly when far off, like after a stall,
+    * and keep the pitch steady close to the target. */
+   ti       = fabs(error) > 0.5 ?
+      AUDIO_RATE_CONTROL_TI / 4 : AUDIO_RATE_CONTROL_TI;
+   integral = audio_driver_clamp_adjust(audio_data.rate_control_integral
+         + delta * error * (frames / audio_data.in_rate) / ti, delta);
+
+   /* The buffer is drained on purpose when not blocking. */
+   if (!driver->nonblock_state)
+   {
+      audio_data.rate_control_integral = integral;
+
+      if (fabs(integral) >= delta && !audio_data.rate_control_saturated)
+         RARCH_WARN("Audio and video clocks drift apart by more than audio_rate_control_delta allows.\n");
+      audio_data.rate_control_saturated = fabs(integral) >= delta;
+   }
+
+   audio_data.src_ratio = audio_data.orig_src_ratio *
+      (1.0 + audio_driver_clamp_adjust(delta * error +
+         audio_data.rate_control_integral, delta));
 }
 
 bool audio_driver_alive(void)
@@ -570,6 +746,7 @@ void audio_driver_set_nonblock_state(bool toggle)
    const audio_driver_t *audio = audio_get_ptr(driver);
 
    audio->set_nonblock_state(driver->audio_data, toggle);
+   audio_data.nonblock = toggle;
 }
 
 void audio_driver_set_nonblocking_state(bool enable)
@@ -622,6 +799,8 @@ bool audio_driver_flush(const int16_t *data, size_t samples)
    if (!driver->audio_active || !audio_data.data)
       return false;
 
+   RARCH_TRACE_BEGIN("audio_flush");
+
    RARCH_PERFORMANCE_INIT(audio_convert_s16);
    RARCH_PERFORMANCE_START(audio_convert_s16);
    audio_convert_s16_to_float(audio_data.data, data, samples,
@@ -651,7 +830,7 @@ bool audio_driver_flush(const int16_t *data, size_t samples)
    src_data.data_out = audio_data.outsamples;
 
    if (audio_data.rate_control)
-      audio_driver_readjust_input_rate();
+      audio_driver_readjust_input_rate(src_data.input_frames);
 
    src_data.ratio = audio_data.src_ratio;
    if (runloop->is_slowmotion)
@@ -678,12 +857,23 @@ bool audio_driver_flush(const int16_t *data, size_t samples)
       output_size = sizeof(int16_t);
    }
 
+   /* A blocking write waits for room, that is just throttling.
+    * Without blocking, what does not fit is dropped. */
+   if (audio_data.rate_control && audio_data.nonblock
+         && output_frames * output_size * 2 > audio_data.rate_control_avail)
+      audio_data.overruns++;
+
+   RARCH_TRACE_BEGIN("audio_write");
    if (audio->write(driver->audio_data, output_data, output_frames * output_size * 2) < 0)
    {
+      RARCH_TRACE_END("audio_write");
+      RARCH_TRACE_END("audio_flush");
       driver->audio_active = false;
       return false;
    }
+   RARCH_TRACE_END("audio_write");
 
+   RARCH_TRACE_END("audio_flush");
    return true;
 }
 
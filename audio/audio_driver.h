@@ -115,10 +115,54 @@ bool audio_driver_mute_toggle(void);
 
 /*
  * audio_driver_readjust_input_rate:
+ * @frames             : input frames about to be resampled.
  *
- * Readjust the audio input rate.
+ * Readjust the audio input rate, to hold the driver buffer at
+ * the rate control target.
  */
-void audio_driver_readjust_input_rate(void);
+void audio_driver_readjust_input_rate(size_t frames);
+
+struct audio_driver_stats
+{
+   unsigned samples;
+
+   /* Buffer level in percent. */
+   float fill_avg;
+   float fill_stddev;
+   float fill_p1;
+   float fill_p5;
+   float fill_p50;
+   float fill_p95;
+   float fill_p99;
+   float target;
+
+   /* Percentage of writes close to underrun and to blocking. */
+   float low_water;
+   float high_water;
+
+   float latency_ms;
+   unsigned underruns;
+   /* Non-blocking writes which did not fit and lost samples. */
+   unsigned overruns;
+
+   /* Current input rate adjustment, and the part of it
+    * which makes up for clock drift. */
+   double ratio_adjust;
+   double drift_ppm;
+};
+
+/**
+ * audio_driver_get_stats:
+ * @stats              : filled with the statistics.
+ *
+ * Computes statistics of the audio buffer level over the last
+ * AUDIO_BUFFER_FREE_SAMPLES_COUNT writes, along with the state of
+ * rate control.
+ *
+ * Returns: true if rate control is running and enough samples
+ * were taken, otherwise false.
+ **/
+bool audio_driver_get_stats(struct audio_driver_stats *stats);
 
 bool audio_driver_alive(void);
 
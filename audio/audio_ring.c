@@ -0,0 +1,170 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(_XBOX)
+#include <windows.h>
+#endif
+
+#include "audio_ring.h"
+
+#if defined(__ATOMIC_ACQUIRE)
+#define AUDIO_RING_LOAD(ptr)       __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define AUDIO_RING_STORE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#else
+#if defined(__GNUC__)
+#define AUDIO_RING_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER) && !defined(_XBOX)
+#define AUDIO_RING_BARRIER() MemoryBarrier()
+#else
+#define AUDIO_RING_BARRIER()
+#endif
+
+static size_t audio_ring_load(volatile size_t *ptr)
+{
+   size_t val = *ptr;
+   AUDIO_RING_BARRIER();
+   return val;
+}
+
+static void audio_ring_store(volatile size_t *ptr, size_t val)
+{
+   AUDIO_RING_BARRIER();
+   *ptr = val;
+}
+
+#define AUDIO_RING_LOAD(ptr)       audio_ring_load(ptr)
+#define AUDIO_RING_STORE(ptr, val) audio_ring_store(ptr, val)
+#endif
+
+/* Keeps the positions of the two threads on their own cache lines. */
+#define AUDIO_RING_CACHE_LINE 64
+
+struct audio_ring
+{
+   uint8_t *buffer;
+   size_t bufsize;
+
+   /* Next byte to read, only stored by the reader. */
+   volatile size_t first;
+   uint8_t pad[AUDIO_RING_CACHE_LINE - sizeof(size_t)];
+
+   /* Next byte to write, only stored by the writer. */
+   volatile size_t end;
+};
+
+audio_ring_t *audio_ring_new(size_t size)
+{
+   audio_ring_t *ring = (audio_ring_t*)calloc(1, sizeof(*ring));
+
+   if (!ring)
+      return NULL;
+
+   /* One byte stays free to tell a full ring from an empty one. */
+   ring->buffer = (uint8_t*)calloc(1, size + 1);
+   if (!ring->buffer)
+   {
+      free(ring);
+      return NULL;
+   }
+   ring->bufsize = size + 1;
+
+   return ring;
+}
+
+void audio_ring_free(audio_ring_t *ring)
+{
+   if (!ring)
+      return;
+
+   free(ring->buffer);
+   free(ring);
+}
+
+void audio_ring_clear(audio_ring_t *ring)
+{
+   ring->first = 0;
+   ring->end   = 0;
+}
+
+size_t audio_ring_size(const audio_ring_t *ring)
+{
+   return ring->bufsize - 1;
+}
+
+size_t audio_ring_read_avail(const audio_ring_t *ring)
+{
+   size_t first = AUDIO_RING_LOAD(&((audio_ring_t*)ring)->first);
+   size_t end   = AUDIO_RING_LOAD(&((audio_ring_t*)ring)->end);
+
+   if (end < first)
+      end += ring->bufsize;
+   return end - first;
+}
+
+size_t audio_ring_write_avail(const audio_ring_t *ring)
+{
+   return (ring->bufsize - 1) - audio_ring_read_avail(ring);
+}
+
+size_t audio_ring_write(audio_ring_t *ring, const void *data, size_t size)
+{
+   size_t first_write;
+   size_t end   = ring->end;
+   size_t first = AUDIO_RING_LOAD(&ring->first);
+   size_t avail = first > end ?
+      first - end - 1 : ring->bufsize - 1 - (end - first);
+
+   if (size > avail)
+      size = avail;
+   if (!size)
+      return 0;
+
+   first_write = ring->bufsize - end;
+   if (first_write > size)
+      first_write = size;
+
+   memcpy(ring->buffer + end, data, first_write);
+   memcpy(ring->buffer, (const uint8_t*)data + first_write,
+         size - first_write);
+
+   AUDIO_RING_STORE(&ring->end, (end + size) % ring->bufsize);
+   return size;
+}
+
+size_t audio_ring_read(audio_ring_t *ring, void *data, size_t size)
+{
+   size_t first_read;
+   size_t first = ring->first;
+   size_t end   = AUDIO_RING_LOAD(&ring->end);
+   size_t avail = end >= first ? end - first : ring->bufsize - (first - end);
+
+   if (size > avail)
+      size = avail;
+   if (!size)
+      return 0;
+
+   first_read = ring->bufsize - first;
+   if (first_read > size)
+      first_read = size;
+
+   memcpy(data, ring->buffer + first, first_read);
+   memcpy((uint8_t*)data + first_read, ring->buffer, size - first_read);
+
+   AUDIO_RING_STORE(&ring->first, (first + size) % ring->bufsize);
+   return size;
+}
@@ -0,0 +1,90 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AUDIO_RING_H
+#define __AUDIO_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Ring buffer between exactly one writer thread and one reader
+ * thread, usually the main thread pushing samples and an audio
+ * thread or callback pulling them.
+ *
+ * Neither side takes a lock. Each side only stores its own position,
+ * and publishes it after the data is copied, so the amounts returned
+ * by audio_ring_read_avail() and audio_ring_write_avail() can be used
+ * from either thread. Waiting for data or for space is left to the
+ * caller. */
+typedef struct audio_ring audio_ring_t;
+
+/**
+ * audio_ring_new:
+ * @size               : capacity in bytes.
+ *
+ * Returns: new ring buffer, or NULL on failure.
+ **/
+audio_ring_t *audio_ring_new(size_t size);
+
+void audio_ring_free(audio_ring_t *ring);
+
+/**
+ * audio_ring_clear:
+ * @ring               : ring buffer.
+ *
+ * Drops everything queued. Neither side may use the ring
+ * while doing so.
+ **/
+void audio_ring_clear(audio_ring_t *ring);
+
+size_t audio_ring_size(const audio_ring_t *ring);
+
+size_t audio_ring_read_avail(const audio_ring_t *ring);
+
+size_t audio_ring_write_avail(const audio_ring_t *ring);
+
+/**
+ * audio_ring_write:
+ * @ring               : ring buffer.
+ * @data               : data to queue.
+ * @size               : size of @data in bytes.
+ *
+ * Queues as much of @data as fits. Writer thread only.
+ *
+ * Returns: number of bytes queued.
+ **/
+size_t audio_ring_write(audio_ring_t *ring, const void *data, size_t size);
+
+/**
+ * audio_ring_read:
+ * @ring               : ring buffer.
+ * @data               : buffer to copy to.
+ * @size               : size of @data in bytes.
+ *
+ * Takes up to @size queued bytes. Reader thread only.
+ *
+ * Returns: number of bytes taken.
+ **/
+size_t audio_ring_read(audio_ring_t *ring, void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -15,13 +15,21 @@
  */
 
 #include "audio_thread_wrapper.h"
+#include "audio_ring.h"
 #include <rthreads/rthreads.h>
 #include "../general.h"
 #include "../performance.h"
-#include <queues/fifo_buffer.h>
+#include "../performance/performance_trace.h"
 #include <stdlib.h>
 #include <string.h>
 
+/* How long the thread sleeps on an empty ring in pull mode,
+ * before looking again. */
+#define AUDIO_THREAD_IDLE_USEC 1000
+
+/* Writes the thread does to the driver per ring. */
+#define AUDIO_THREAD_CHUNKS 8
+
 typedef struct audio_thread
 {
    const audio_driver_t *driver;
@@ -37,12 +45,75 @@ typedef struct audio_thread
 
    int inited;
 
+   /* Pull mode, used for cores without an audio callback: the main
+    * thread writes to the ring and the thread feeds the driver. */
+   bool pull;
+   bool nonblock;
+   audio_ring_t *ring;
+   scond_t *space_cond;
+   uint8_t *chunk;
+   size_t chunk_size;
+
    /* Initialization options. */
    const char *device;
    unsigned out_rate;
    unsigned latency;
 } audio_thread_t;
 
+/**
+ * audio_thread_init_ring:
+ * @thr                : audio thread.
+ *
+ * Sets up the ring for pull mode, with room for half of the
+ * audio latency. The driver was opened with the other half.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool audio_thread_init_ring(audio_thread_t *thr)
+{
+   size_t frame_size = 2 * (thr->use_float ? sizeof(float) : sizeof(int16_t));
+   size_t frames     = (size_t)thr->out_rate * thr->latency / 2000;
+
+   if (frames < AUDIO_THREAD_CHUNKS)
+      frames = AUDIO_THREAD_CHUNKS;
+
+   thr->chunk_size   = frames / AUDIO_THREAD_CHUNKS * frame_size;
+   thr->ring         = audio_ring_new(frames * frame_size);
+   thr->chunk        = (uint8_t*)malloc(thr->chunk_size);
+
+   return thr->ring && thr->chunk;
+}
+
+/**
+ * audio_thread_pull:
+ * @thr                : audio thread.
+ *
+ * Moves a chunk from the ring to the driver, or waits a bit if
+ * the ring is empty.
+ *
+ * Returns: false if the driver failed, otherwise true.
+ **/
+static bool audio_thread_pull(audio_thread_t *thr)
+{
+   size_t size = audio_ring_read(thr->ring, thr->chunk, thr->chunk_size);
+
+   if (!size)
+   {
+      slock_lock(thr->lock);
+      if (thr->alive && !thr->stopped)
+         scond_wait_timeout(thr->cond, thr->lock, AUDIO_THREAD_IDLE_USEC);
+      slock_unlock(thr->lock);
+      return true;
+   }
+
+   /* Wakes up a blocking write waiting for space. */
+   slock_lock(thr->lock);
+   scond_signal(thr->space_cond);
+   slock_unlock(thr->lock);
+
+   return thr->driver->write(thr->driver_data, thr->chunk, size) >= 0;
+}
+
 static void audio_thread_loop(void *data)
 {
    audio_thread_t *thr = (audio_thread_t*)data;
@@ -51,11 +122,19 @@ static void audio_thread_loop(void *data)
       return;
 
    RARCH_LOG("[Audio Thread]: Initializing audio driver.\n");
-   thr->driver_data   = thr->driver->init(thr->device, thr->out_rate, thr->latency);
+   thr->driver_data   = thr->driver->init(thr->device, thr->out_rate,
+         thr->pull ? (thr->latency + 1) / 2 : thr->latency);
    slock_lock(thr->lock);
    thr->inited        = thr->driver_data ? 1 : -1;
    if (thr->inited > 0 && thr->driver->use_float)
       thr->use_float  = thr->driver->use_float(thr->driver_data);
+   if (thr->inited > 0 && thr->pull && !audio_thread_init_ring(thr))
+   {
+      RARCH_ERR("[Audio Thread]: Failed to allocate audio ring.\n");
+      thr->driver->free(thr->driver_data);
+      thr->driver_data = NULL;
+      thr->inited      = -1;
+   }
    scond_signal(thr->cond);
    slock_unlock(thr->lock);
 
@@ -70,6 +149,7 @@ static void audio_thread_loop(void *data)
    slock_unlock(thr->lock);
 
    RARCH_LOG("[Audio Thread]: Starting audio.\n");
+   perf_trace_thread_name("Audio");
 
    for (;;)
    {
@@ -91,7 +171,30 @@ static void audio_thread_loop(void *data)
       }
 
       slock_unlock(thr->lock);
+
+      if (thr->pull)
+      {
+         bool ok;
+
+         RARCH_TRACE_BEGIN("audio_thread_pull");
+         ok = audio_thread_pull(thr);
+         RARCH_TRACE_END("audio_thread_pull");
+
+         if (!ok)
+         {
+            RARCH_ERR("[Audio Thread]: Audio driver failed.\n");
+            slock_lock(thr->lock);
+            thr->alive = false;
+            scond_signal(thr->space_cond);
+            slock_unlock(thr->lock);
+            break;
+         }
+         continue;
+      }
+
+      RARCH_TRACE_BEGIN("audio_thread_callback");
       audio_driver_callback();
+      RARCH_TRACE_END("audio_thread_callback");
    }
 
    RARCH_LOG("[Audio Thread]: Tearing down driver.\n");
@@ -142,6 +245,10 @@ static void audio_thread_free(void *data)
       slock_free(thr->lock);
    if (thr->cond)
       scond_free(thr->cond);
+   if (thr->space_cond)
+      scond_free(thr->space_cond);
+   audio_ring_free(thr->ring);
+   free(thr->chunk);
    free(thr);
 }
 
@@ -153,6 +260,9 @@ static bool audio_thread_alive(void *data)
    if (!thr)
       return false;
 
+   if (thr->pull)
+      return !thr->is_paused;
+
    audio_thread_block(thr);
    alive = !thr->is_paused;
    audio_thread_unblock(thr);
@@ -190,8 +300,10 @@ static bool audio_thread_start(void *data)
 
 static void audio_thread_set_nonblock_state(void *data, bool state)
 {
-   (void)data;
-   (void)state;
+   audio_thread_t *thr = (audio_thread_t*)data;
+
+   if (thr)
+      thr->nonblock = state;
 }
 
 static bool audio_thread_use_float(void *data)
@@ -202,6 +314,44 @@ static bool audio_thread_use_float(void *data)
    return thr->use_float;
 }
 
+/**
+ * audio_thread_write_ring:
+ * @thr                : audio thread.
+ * @buf                : samples to queue.
+ * @size               : size of @buf in bytes.
+ *
+ * Queues samples for the thread in pull mode. The lock is only
+ * taken to wait, when a blocking write finds the ring full.
+ *
+ * Returns: number of bytes queued, or -1 if the driver failed.
+ **/
+static ssize_t audio_thread_write_ring(audio_thread_t *thr,
+      const void *buf, size_t size)
+{
+   size_t written = 0;
+
+   for (;;)
+   {
+      written += audio_ring_write(thr->ring,
+            (const uint8_t*)buf + written, size - written);
+
+      if (written == size || thr->nonblock || thr->is_paused)
+         return written;
+
+      slock_lock(thr->lock);
+      if (!thr->alive)
+      {
+         slock_unlock(thr->lock);
+         return -1;
+      }
+      /* Times out in case the thread is stopped. */
+      if (!audio_ring_write_avail(thr->ring))
+         scond_wait_timeout(thr->space_cond, thr->lock,
+               AUDIO_THREAD_IDLE_USEC);
+      slock_unlock(thr->lock);
+   }
+}
+
 static ssize_t audio_thread_write(void *data, const void *buf, size_t size)
 {
    ssize_t ret;
@@ -210,6 +360,9 @@ static ssize_t audio_thread_write(void *data, const void *buf, size_t size)
    if (!thr)
       return 0;
 
+   if (thr->pull)
+      return audio_thread_write_ring(thr, buf, size);
+
    ret = thr->driver->write(thr->driver_data, buf, size);
 
    if (ret < 0)
@@ -237,6 +390,36 @@ static const audio_driver_t audio_thread = {
    NULL,
 };
 
+static size_t audio_thread_write_avail(void *data)
+{
+   audio_thread_t *thr = (audio_thread_t*)data;
+
+   if (!thr || !thr->alive)
+      return 0;
+   return audio_ring_write_avail(thr->ring);
+}
+
+static size_t audio_thread_buffer_size(void *data)
+{
+   audio_thread_t *thr = (audio_thread_t*)data;
+   return thr ? audio_ring_size(thr->ring) : 0;
+}
+
+/* Rate control steers the level of the ring in pull mode. */
+static const audio_driver_t audio_thread_pull_driver = {
+   NULL,
+   audio_thread_write,
+   audio_thread_stop,
+   audio_thread_start,
+   audio_thread_alive,
+   audio_thread_set_nonblock_state,
+   audio_thread_free,
+   audio_thread_use_float,
+   "audio-thread",
+   audio_thread_write_avail,
+   audio_thread_buffer_size,
+};
+
 /**
  * rarch_threaded_audio_init:
  * @out_driver                : output driver
@@ -248,8 +431,9 @@ static const audio_driver_t audio_thread = {
  *
  * Starts a audio driver in a new thread.
  * Access to audio driver will be mediated through this driver.
- * This driver interfaces with audio callback and is 
- * only used in that case.
+ * If the core has an audio callback, the thread runs it. Otherwise
+ * the thread pulls the samples written from a ring buffer and the
+ * driver is opened with half of @latency, the ring holds the rest.
  *
  * Returns: true (1) if successful, otherwise false (0).
  **/
@@ -265,11 +449,14 @@ bool rarch_threaded_audio_init(const audio_driver_t **out_driver,
    thr->device         = device;
    thr->out_rate       = audio_out_rate;
    thr->latency        = latency;
+   thr->pull           = !audio_driver_has_callback();
 
    if (!(thr->cond     = scond_new()))
       goto error;
    if (!(thr->lock     = slock_new()))
       goto error;
+   if (thr->pull && !(thr->space_cond = scond_new()))
+      goto error;
 
    thr->alive = true;
    thr->stopped = true;
@@ -286,7 +473,7 @@ bool rarch_threaded_audio_init(const audio_driver_t **out_driver,
    if (thr->inited < 0) /* Thread failed. */
       goto error;
 
-   *out_driver         = &audio_thread;
+   *out_driver         = thr->pull ? &audio_thread_pull_driver : &audio_thread;
    *out_data           = thr;
    return true;
 
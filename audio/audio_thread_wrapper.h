@@ -31,7 +31,9 @@
  *
  * Starts a audio driver in a new thread.
  * Access to audio driver will be mediated through this driver.
- * This driver interfaces with audio callback and is only used in that case.
+ * If the core has an audio callback, the thread runs it. Otherwise
+ * the thread pulls the samples written from a ring buffer and the
+ * driver is opened with half of @latency, the ring holds the rest.
  *
  * Returns: true (1) if successful, otherwise false (0).
  **/
@@ -0,0 +1,221 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+
+#include "benchmark.h"
+#include "configuration.h"
+#include "general.h"
+#include "performance.h"
+#include "runloop.h"
+#include "system.h"
+
+/**
+ * rarch_benchmark_init:
+ *
+ * Overrides the loaded configuration for a benchmark run:
+ * performance counters with histograms are enabled, all throttling
+ * is disabled and, unless real drivers were asked for, the null
+ * video, audio and input drivers are used.
+ **/
+void rarch_benchmark_init(void)
+{
+   settings_t *settings = config_get_ptr();
+   global_t   *global   = global_get_ptr();
+   runloop_t  *runloop  = rarch_main_get_ptr();
+
+   if (!global->benchmark.enable)
+      return;
+
+   global->perfcnt_enable                     = true;
+   global->perfcnt_histogram_enable           = true;
+
+   settings->video.vsync                      = false;
+   settings->video.frame_delay                = 0;
+   settings->audio.sync                       = false;
+   settings->fastforward_ratio_throttle_enable = false;
+
+   if (!global->benchmark.real_drivers)
+   {
+      strlcpy(settings->video.driver, "null", sizeof(settings->video.driver));
+      strlcpy(settings->audio.driver, "null", sizeof(settings->audio.driver));
+      strlcpy(settings->input.driver, "null", sizeof(settings->input.driver));
+   }
+
+   if (!runloop->frames.video.max)
+      runloop->frames.video.max = BENCHMARK_DEFAULT_FRAMES;
+
+   global->benchmark.frames = 0;
+   global->benchmark.start  = 0;
+   global->benchmark.end    = 0;
+}
+
+/**
+ * rarch_benchmark_frame:
+ *
+ * Counts a frame of the benchmark run. The first frame is taken as
+ * warm-up and only starts the clock.
+ **/
+void rarch_benchmark_frame(void)
+{
+   global_t *global = global_get_ptr();
+
+   if (!global->benchmark.enable)
+      return;
+
+   if (!global->benchmark.start)
+   {
+      global->benchmark.start = rarch_get_time_usec();
+      return;
+   }
+
+   global->benchmark.frames++;
+   global->benchmark.end = rarch_get_time_usec();
+}
+
+static void benchmark_write_string(FILE *file, const char *s)
+{
+   fputc('"', file);
+
+   for (; s && *s; s++)
+   {
+      if (*s == '"' || *s == '\\')
+         fputc('\\', file);
+      if ((unsigned char)*s >= 0x20)
+         fputc(*s, file);
+   }
+
+   fputc('"', file);
+}
+
+static void benchmark_write_counters(FILE *file)
+{
+   size_t i, count;
+   struct rarch_perf_stats *stats = (struct rarch_perf_stats*)
+      calloc(2 * MAX_COUNTERS, sizeof(*stats));
+
+   if (!stats)
+      return;
+
+   count = rarch_perf_get_stats(stats, 2 * MAX_COUNTERS);
+
+   for (i = 0; i < count; i++)
+   {
+      const struct rarch_perf_stats *stat = &stats[i];
+
+      fputs(i ? ",\n    { \"name\": " : "\n    { \"name\": ", file);
+      benchmark_write_string(file, stat->ident);
+      fprintf(file, ", \"libretro\": %s, \"calls\": %llu, \"total\": %llu,"
+            " \"avg\": %llu, \"p50\": %llu, \"p95\": %llu, \"p99\": %llu,"
+            " \"max\": %llu }",
+            stat->libretro ? "true" : "false",
+            (unsigned long long)stat->calls,
+            (unsigned long long)stat->total,
+            (unsigned long long)stat->avg,
+            (unsigned long long)stat->p50,
+            (unsigned long long)stat->p95,
+            (unsigned long long)stat->p99,
+            (unsigned long long)stat->max);
+   }
+
+   fputs(count ? "\n  ]" : "]", file);
+   free(stats);
+}
+
+/**
+ * rarch_benchmark_report:
+ *
+ * Writes the result of the benchmark run as JSON, to the file given
+ * with --benchmark-output or to stdout. Has to be called before the
+ * core is unloaded, so that its performance counters are included.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+bool rarch_benchmark_report(void)
+{
+   FILE *file;
+   double seconds;
+   bool ret                    = true;
+   settings_t *settings        = config_get_ptr();
+   global_t   *global          = global_get_ptr();
+   rarch_system_info_t *system = rarch_system_info_get_ptr();
+
+   if (!global->benchmark.enable || !global->benchmark.frames)
+      return false;
+
+   seconds = (global->benchmark.end - global->benchmark.start) / 1000000.0;
+
+   if (*global->benchmark.output)
+   {
+      if (!(file = fopen(global->benchmark.output, "wb")))
+      {
+         RARCH_ERR("Failed to open benchmark output \"%s\".\n",
+               global->benchmark.output);
+         return false;
+      }
+   }
+   else
+      file = stdout;
+
+   fputs("{\n  \"core\": ", file);
+   benchmark_write_string(file, system ? system->info.library_name : NULL);
+   fputs(",\n  \"core_version\": ", file);
+   benchmark_write_string(file, system ? system->info.library_version : NULL);
+   fputs(",\n  \"content\": ", file);
+   benchmark_write_string(file, global->fullpath);
+
+   fprintf(file, ",\n  \"frames\": %llu,\n  \"seconds\": %.6f,\n"
+         "  \"fps\": %.3f,\n",
+         (unsigned long long)global->benchmark.frames, seconds,
+         seconds > 0.0 ? global->benchmark.frames / seconds : 0.0);
+
+#if defined(__linux__) || defined(__QNX__) || defined(__MACH__)
+   fputs("  \"tick_unit\": \"ns\",\n", file);
+#else
+   fputs("  \"tick_unit\": \"ticks\",\n", file);
+#endif
+
+   fputs("  \"drivers\": { \"video\": ", file);
+   benchmark_write_string(file, settings->video.driver);
+   fputs(", \"audio\": ", file);
+   benchmark_write_string(file, settings->audio.driver);
+   fputs(", \"input\": ", file);
+   benchmark_write_string(file, settings->input.driver);
+   fprintf(file, ", \"threaded_video\": %s },\n",
+         settings->video.threaded ? "true" : "false");
+
+   fprintf(file, "  \"features\": { \"rewind\": %s, \"softfilter\": ",
+         settings->rewind_enable ? "true" : "false");
+   benchmark_write_string(file, settings->video.softfilter_plugin);
+   fputs(", \"audio_dsp\": ", file);
+   benchmark_write_string(file, settings->audio.dsp_plugin);
+   fputs(", \"audio_resampler\": ", file);
+   benchmark_write_string(file, settings->audio.resampler);
+   fputs(" },\n  \"counters\": [", file);
+
+   benchmark_write_counters(file);
+   fputs("\n}\n", file);
+
+   if (file == stdout)
+      fflush(file);
+   else
+      ret = fclose(file) == 0;
+
+   return ret;
+}
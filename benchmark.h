@@ -0,0 +1,61 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_BENCHMARK_H
+#define __RARCH_BENCHMARK_H
+
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Frames run by --benchmark if --max-frames is not given. */
+#define BENCHMARK_DEFAULT_FRAMES 3000
+
+/**
+ * rarch_benchmark_init:
+ *
+ * Overrides the loaded configuration for a benchmark run:
+ * performance counters with histograms are enabled, all throttling
+ * is disabled and, unless real drivers were asked for, the null
+ * video, audio and input drivers are used.
+ **/
+void rarch_benchmark_init(void);
+
+/**
+ * rarch_benchmark_frame:
+ *
+ * Counts a frame of the benchmark run. The first frame is taken as
+ * warm-up and only starts the clock.
+ **/
+void rarch_benchmark_frame(void);
+
+/**
+ * rarch_benchmark_report:
+ *
+ * Writes the result of the benchmark run as JSON, to the file given
+ * with --benchmark-output or to stdout. Has to be called before the
+ * core is unloaded, so that its performance counters are included.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+bool rarch_benchmark_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
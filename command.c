@@ -16,6 +16,7 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifndef _WIN32
@@ -28,6 +29,7 @@
 #include <file/file_path.h>
 #include <retro_miscellaneous.h>
 #include <net/net_compat.h>
+#include <rhash.h>
 
 #include "msg_hash.h"
 
@@ -37,12 +39,51 @@
 
 #include "command.h"
 
+#include "audio/audio_driver.h"
+#include "dynamic.h"
 #include "general.h"
+#include "performance.h"
+#include "performance/performance_trace.h"
 #include "runloop.h"
+#include "system.h"
 
 #define DEFAULT_NETWORK_CMD_PORT 55355
 #define STDIN_BUF_SIZE 4096
 
+/* Datagrams may batch several commands, one per line. */
+#define NETWORK_CMD_BUF_SIZE 4096
+
+/* Replies to one batch of commands are collected and sent
+ * as one datagram while they fit. */
+#define CMD_REPLY_SIZE 32768
+
+/* Most bytes read by one READ_CORE_MEMORY or READ_STATE. */
+#define CMD_READ_MAX 4096
+
+/* Most queries waiting for rarch_cmd_run_queries(). */
+#define CMD_QUERY_MAX 64
+
+/* Where replies go, the sender of a datagram or stdout. */
+struct cmd_peer
+{
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+   bool net;
+   struct sockaddr_storage addr;
+   socklen_t addr_len;
+#else
+   char dummy;
+#endif
+};
+
+/* Query received by rarch_cmd_poll(). It is only run once the
+ * core returned from retro_run(), since it may use the core. */
+struct cmd_query
+{
+   unsigned index;
+   char *arg;
+   struct cmd_peer peer;
+};
+
 struct rarch_cmd
 {
 #ifdef HAVE_STDIN_CMD
@@ -55,11 +96,28 @@ struct rarch_cmd
    int net_fd;
 #endif
 
-   bool state[RARCH_BIND_LIST_END];
+   /* Sender of the commands being parsed. */
+   struct cmd_peer peer;
+
+   struct cmd_query queries[CMD_QUERY_MAX];
+   unsigned num_queries;
+
+   /* Replies collected for @reply_peer. */
+   char reply[CMD_REPLY_SIZE];
+   size_t reply_len;
+   struct cmd_peer reply_peer;
+
+   /* Snapshot taken by GET_STATE, read back with READ_STATE. */
+   uint8_t *savestate;
+   size_t savestate_size;
+
+   /* Bitmask of (1 << key_bind_id). */
+   uint64_t state;
 };
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
-static bool cmd_init_network(rarch_cmd_t *handle, uint16_t port)
+static bool cmd_init_network(rarch_cmd_t *handle, uint16_t port,
+      bool remote)
 {
    struct addrinfo hints = {0};
    char port_buf[16]     = {0};
@@ -69,20 +127,23 @@ static bool cmd_init_network(rarch_cmd_t *handle, uint16_t port)
    if (!network_init())
       return false;
 
-   RARCH_LOG("Bringing up command interface on port %hu.\n",
-         (unsigned short)port);
+   RARCH_LOG("Bringing up command interface on port %hu%s.\n",
+         (unsigned short)port, remote ? "" : " of 127.0.0.1");
 
 #if defined(_WIN32) || defined(HAVE_SOCKET_LEGACY)
    hints.ai_family   = AF_INET;
 #else
-   hints.ai_family   = AF_UNSPEC;
+   hints.ai_family   = remote ? AF_UNSPEC : AF_INET;
 #endif
    hints.ai_socktype = SOCK_DGRAM;
    hints.ai_flags    = AI_PASSIVE;
 
 
+   /* Commands can read and write the core's memory, so only local
+    * processes may send them unless remote access is enabled. */
    snprintf(port_buf, sizeof(port_buf), "%hu", (unsigned short)port);
-   if (getaddrinfo_rarch(NULL, port_buf, &hints, &res) < 0)
+   if (getaddrinfo_rarch(remote ? NULL : "127.0.0.1",
+            port_buf, &hints, &res) < 0)
       goto error;
 
    handle->net_fd = socket(res->ai_family,
@@ -127,7 +188,7 @@ static bool cmd_init_stdin(rarch_cmd_t *handle)
 #endif
 
 rarch_cmd_t *rarch_cmd_new(bool stdin_enable,
-      bool network_enable, uint16_t port)
+      bool network_enable, bool network_remote, uint16_t port)
 {
    rarch_cmd_t *handle = (rarch_cmd_t*)calloc(1, sizeof(*handle));
    if (!handle)
@@ -135,10 +196,11 @@ rarch_cmd_t *rarch_cmd_new(bool stdin_enable,
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
    handle->net_fd = -1;
-   if (network_enable && !cmd_init_network(handle, port))
+   if (network_enable && !cmd_init_network(handle, port, network_remote))
       goto error;
 #else
    (void)network_enable;
+   (void)network_remote;
    (void)port;
 #endif
 
@@ -159,11 +221,20 @@ error:
 
 void rarch_cmd_free(rarch_cmd_t *handle)
 {
+   unsigned i;
+
+   if (!handle)
+      return;
+
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
-   if (handle && handle->net_fd >= 0)
+   if (handle->net_fd >= 0)
       socket_close(handle->net_fd);
 #endif
 
+   for (i = 0; i < handle->num_queries; i++)
+      free(handle->queries[i].arg);
+
+   free(handle->savestate);
    free(handle);
 }
 
@@ -259,6 +330,397 @@ static const struct cmd_action_map action_map[] = {
    { "SET_SHADER", cmd_set_shader, "<shader path>" },
 };
 
+/* Commands which are answered, over the network to the sender
+ * or on stdout for stdin commands. They may take an argument,
+ * separated by a space. */
+struct cmd_query_map
+{
+   const char *str;
+   void (*query)(rarch_cmd_t *handle, const char *arg);
+};
+
+static void cmd_reply_flush(rarch_cmd_t *handle)
+{
+   if (!handle->reply_len)
+      return;
+
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+   if (handle->reply_peer.net)
+   {
+      sendto(handle->net_fd, handle->reply, handle->reply_len, 0,
+            (struct sockaddr*)&handle->reply_peer.addr,
+            handle->reply_peer.addr_len);
+      handle->reply_len = 0;
+      return;
+   }
+#endif
+
+   fwrite(handle->reply, 1, handle->reply_len, stdout);
+   fflush(stdout);
+   handle->reply_len = 0;
+}
+
+static void cmd_reply(rarch_cmd_t *handle, const char *data, size_t len)
+{
+   if (handle->reply_len + len > sizeof(handle->reply))
+      cmd_reply_flush(handle);
+
+   if (len > sizeof(handle->reply))
+   {
+      /* Too large to batch, goes out on its own. */
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+      if (handle->reply_peer.net)
+      {
+         sendto(handle->net_fd, data, len, 0,
+               (struct sockaddr*)&handle->reply_peer.addr,
+               handle->reply_peer.addr_len);
+         return;
+      }
+#endif
+
+      fwrite(data, 1, len, stdout);
+      fflush(stdout);
+      return;
+   }
+
+   memcpy(handle->reply + handle->reply_len, data, len);
+   handle->reply_len += len;
+}
+
+static void cmd_get_perf_counters(rarch_cmd_t *handle, const char *arg)
+{
+   size_t len = rarch_perf_get_stats_string(NULL, 0) + 1;
+   char  *buf = (char*)malloc(len);
+
+   (void)arg;
+
+   if (!buf)
+      return;
+
+   rarch_perf_get_stats_string(buf, len);
+   cmd_reply(handle, buf, strlen(buf));
+   free(buf);
+}
+
+static void cmd_dump_trace(rarch_cmd_t *handle, const char *arg)
+{
+   char msg[PATH_MAX_LENGTH + 32] = {0};
+   global_t *global               = global_get_ptr();
+   const char *path               = *global->perfcnt_trace_path ?
+      global->perfcnt_trace_path : PERF_TRACE_DEFAULT_PATH;
+
+   (void)arg;
+
+   strlcpy(msg, perf_trace_dump(path) ?
+         "Wrote trace to \"" : "Failed to write trace to \"", sizeof(msg));
+   strlcat(msg, path, sizeof(msg));
+   strlcat(msg, "\".\n", sizeof(msg));
+
+   cmd_reply(handle, msg, strlen(msg));
+}
+
+static void cmd_get_audio_stats(rarch_cmd_t *handle, const char *arg)
+{
+   char msg[512] = {0};
+   struct audio_driver_stats stats;
+
+   (void)arg;
+
+   if (!audio_driver_get_stats(&stats))
+      strlcpy(msg, "audio rate_control=false\n", sizeof(msg));
+   else
+      snprintf(msg, sizeof(msg), "audio rate_control=true samples=%u"
+            " fill_avg=%.2f fill_stddev=%.2f fill_p1=%.1f fill_p5=%.1f"
+            " fill_p50=%.1f fill_p95=%.1f fill_p99=%.1f target=%.2f"
+            " low_water=%.2f high_water=%.2f latency_ms=%.1f"
+            " underruns=%u overruns=%u ratio_adjust=%.6f drift_ppm=%.0f\n",
+            stats.samples, stats.fill_avg, stats.fill_stddev,
+            stats.fill_p1, stats.fill_p5, stats.fill_p50, stats.fill_p95,
+            stats.fill_p99, stats.target, stats.low_water, stats.high_water,
+            stats.latency_ms, stats.underruns, stats.overruns,
+            stats.ratio_adjust, stats.drift_ppm);
+
+   cmd_reply(handle, msg, strlen(msg));
+}
+
+static bool cmd_core_is_running(void)
+{
+   global_t *global = global_get_ptr();
+   return global->main_is_init && pretro_get_memory_data;
+}
+
+static void cmd_get_status(rarch_cmd_t *handle, const char *arg)
+{
+   char msg[PATH_MAX_LENGTH]   = {0};
+   char tail[64]               = {0};
+   size_t len                  = 0;
+   global_t *global            = global_get_ptr();
+   runloop_t *runloop          = rarch_main_get_ptr();
+   rarch_system_info_t *system = rarch_system_info_get_ptr();
+
+   (void)arg;
+
+   if (!global->main_is_init || global->core_type == CORE_TYPE_DUMMY)
+   {
+      strlcpy(msg, "GET_STATUS CONTENTLESS\n", sizeof(msg));
+      cmd_reply(handle, msg, strlen(msg));
+      return;
+   }
+
+   snprintf(tail, sizeof(tail), ",crc32=%08x frame=%llu\n",
+         (unsigned)global->content_crc,
+         (unsigned long long)video_driver_get_frame_count());
+
+   /* Only the names are cut short, the fixed fields always fit. */
+   len = sizeof(msg) - strlen(tail);
+   strlcpy(msg, runloop->is_paused ?
+         "GET_STATUS PAUSED " : "GET_STATUS PLAYING ", len);
+   if (system->info.library_name)
+      strlcat(msg, system->info.library_name, len);
+   strlcat(msg, ",", len);
+   strlcat(msg, global->basename, len);
+   strlcat(msg, tail, sizeof(msg));
+
+   cmd_reply(handle, msg, strlen(msg));
+}
+
+struct cmd_memory_map
+{
+   const char *str;
+   unsigned id;
+};
+
+static const struct cmd_memory_map memory_map[] = {
+   { "SAVE_RAM",   RETRO_MEMORY_SAVE_RAM },
+   { "RTC",        RETRO_MEMORY_RTC },
+   { "SYSTEM_RAM", RETRO_MEMORY_SYSTEM_RAM },
+   { "VIDEO_RAM",  RETRO_MEMORY_VIDEO_RAM },
+};
+
+/**
+ * cmd_get_memory:
+ * @arg               : "<region> <offset>", followed by the rest
+ *                      of the command.
+ * @rest              : what follows the offset.
+ * @offset            : parsed offset.
+ * @avail             : number of bytes in the region from @offset on.
+ *
+ * Looks up a memory region of the core by name.
+ *
+ * Returns: start of the region, or NULL if the region
+ * or offset is not valid.
+ **/
+static uint8_t *cmd_get_memory(const char *arg, char **rest,
+      size_t *offset, size_t *avail)
+{
+   unsigned i;
+   uint8_t *data = NULL;
+   size_t size   = 0;
+   char *end     = NULL;
+
+   if (!arg || !cmd_core_is_running())
+      return NULL;
+
+   for (i = 0; i < ARRAY_SIZE(memory_map); i++)
+   {
+      size_t len = strlen(memory_map[i].str);
+
+      if (!strncmp(arg, memory_map[i].str, len) && arg[len] == ' ')
+      {
+         data = (uint8_t*)pretro_get_memory_data(memory_map[i].id);
+         size = pretro_get_memory_size(memory_map[i].id);
+         arg += len;
+         break;
+      }
+   }
+
+   if (!data)
+      return NULL;
+
+   *offset = strtoul(arg, &end, 0);
+   if (end == arg || *offset >= size)
+      return NULL;
+
+   *rest  = end;
+   *avail = size - *offset;
+   return data;
+}
+
+static void cmd_reply_bytes(rarch_cmd_t *handle, const char *prefix,
+      const uint8_t *data, size_t len)
+{
+   size_t i;
+   size_t pos = 0;
+   size_t cap = strlen(prefix) + 3 * len + 2;
+   char  *msg = (char*)malloc(cap);
+
+   if (!msg)
+      return;
+
+   pos = strlcpy(msg, prefix, cap);
+   for (i = 0; i < len; i++)
+      pos += snprintf(msg + pos, cap - pos, " %02X", data[i]);
+   msg[pos++] = '\n';
+
+   cmd_reply(handle, msg, pos);
+   free(msg);
+}
+
+static void cmd_reply_error(rarch_cmd_t *handle, const char *cmd,
+      const char *arg)
+{
+   char msg[256] = {0};
+
+   snprintf(msg, sizeof(msg), "%s %s -1\n", cmd, arg ? arg : "");
+   cmd_reply(handle, msg, strlen(msg));
+}
+
+/* READ_CORE_MEMORY <region> <offset> <length>
+ * Replies with the command and the bytes in hex. */
+static void cmd_read_core_memory(rarch_cmd_t *handle, const char *arg)
+{
+   char prefix[128] = {0};
+   size_t offset    = 0;
+   size_t avail     = 0;
+   size_t len       = 0;
+   char *rest       = NULL;
+   uint8_t *data    = cmd_get_memory(arg, &rest, &offset, &avail);
+
+   if (data)
+      len = strtoul(rest, NULL, 0);
+
+   if (!data || !len)
+   {
+      cmd_reply_error(handle, "READ_CORE_MEMORY", arg);
+      return;
+   }
+
+   if (len > avail)
+      len = avail;
+   if (len > CMD_READ_MAX)
+      len = CMD_READ_MAX;
+
+   snprintf(prefix, sizeof(prefix), "READ_CORE_MEMORY %.*s 0x%lx",
+         (int)strcspn(arg, " "), arg, (unsigned long)offset);
+   cmd_reply_bytes(handle, prefix, data + offset, len);
+}
+
+/* WRITE_CORE_MEMORY <region> <offset> <byte> [<byte> ...]
+ * Bytes are in hex. Replies with the number of bytes written. */
+static void cmd_write_core_memory(rarch_cmd_t *handle, const char *arg)
+{
+   char msg[128]  = {0};
+   size_t offset  = 0;
+   size_t avail   = 0;
+   size_t written = 0;
+   char *rest     = NULL;
+   uint8_t *data  = cmd_get_memory(arg, &rest, &offset, &avail);
+
+   if (!data)
+   {
+      cmd_reply_error(handle, "WRITE_CORE_MEMORY", arg);
+      return;
+   }
+
+   while (written < avail)
+   {
+      char *end          = NULL;
+      unsigned long byte = strtoul(rest, &end, 16);
+
+      if (end == rest || byte > 0xff)
+         break;
+
+      data[offset + written++] = (uint8_t)byte;
+      rest = end;
+   }
+
+   snprintf(msg, sizeof(msg), "WRITE_CORE_MEMORY %.*s 0x%lx %u\n",
+         (int)strcspn(arg, " "), arg, (unsigned long)offset,
+         (unsigned)written);
+   cmd_reply(handle, msg, strlen(msg));
+}
+
+/* GET_STATE
+ * Serializes the core into a snapshot kept until the next GET_STATE.
+ * Replies with its size and CRC32. */
+static void cmd_get_state(rarch_cmd_t *handle, const char *arg)
+{
+   char msg[128] = {0};
+   size_t size   = 0;
+
+   (void)arg;
+
+   if (cmd_core_is_running())
+      size = pretro_serialize_size();
+
+   if (size && size != handle->savestate_size)
+   {
+      uint8_t *buf = (uint8_t*)realloc(handle->savestate, size);
+
+      if (!buf)
+         size = 0;
+      else
+         handle->savestate = buf;
+   }
+
+   if (!size || !pretro_serialize(handle->savestate, size))
+   {
+      handle->savestate_size = 0;
+      cmd_reply_error(handle, "GET_STATE", NULL);
+      return;
+   }
+
+   handle->savestate_size = size;
+
+   snprintf(msg, sizeof(msg), "GET_STATE %lu %08x\n",
+         (unsigned long)size,
+         (unsigned)crc32_calculate(handle->savestate, size));
+   cmd_reply(handle, msg, strlen(msg));
+}
+
+/* READ_STATE <offset> <length>
+ * Reads back the snapshot taken by GET_STATE. */
+static void cmd_read_state(rarch_cmd_t *handle, const char *arg)
+{
+   char prefix[64] = {0};
+   char *end       = NULL;
+   size_t offset   = 0;
+   size_t len      = 0;
+
+   if (arg)
+   {
+      offset = strtoul(arg, &end, 0);
+      if (end != arg)
+         len = strtoul(end, NULL, 0);
+   }
+
+   if (!len || offset >= handle->savestate_size)
+   {
+      cmd_reply_error(handle, "READ_STATE", arg);
+      return;
+   }
+
+   if (len > handle->savestate_size - offset)
+      len = handle->savestate_size - offset;
+   if (len > CMD_READ_MAX)
+      len = CMD_READ_MAX;
+
+   snprintf(prefix, sizeof(prefix), "READ_STATE 0x%lx",
+         (unsigned long)offset);
+   cmd_reply_bytes(handle, prefix, handle->savestate + offset, len);
+}
+
+static const struct cmd_query_map query_map[] = {
+   { "GET_PERF_COUNTERS", cmd_get_perf_counters },
+   { "DUMP_TRACE",        cmd_dump_trace },
+   { "GET_AUDIO_STATS",   cmd_get_audio_stats },
+   { "GET_STATUS",        cmd_get_status },
+   { "READ_CORE_MEMORY",  cmd_read_core_memory },
+   { "WRITE_CORE_MEMORY", cmd_write_core_memory },
+   { "GET_STATE",         cmd_get_state },
+   { "READ_STATE",        cmd_read_state },
+};
+
 static bool command_get_arg(const char *tok,
       const char **arg, unsigned *index)
 {
@@ -300,11 +762,95 @@ static bool command_get_arg(const char *tok,
    return false;
 }
 
+static void cmd_queue_query(rarch_cmd_t *handle, unsigned index,
+      const char *arg)
+{
+   struct cmd_query *query = NULL;
+
+   if (handle->num_queries >= CMD_QUERY_MAX)
+   {
+      RARCH_WARN("Too many queries received, dropping \"%s\".\n",
+            query_map[index].str);
+      return;
+   }
+
+   query        = &handle->queries[handle->num_queries];
+   query->index = index;
+   query->arg   = arg ? strdup(arg) : NULL;
+   query->peer  = handle->peer;
+
+   if (arg && !query->arg)
+      return;
+
+   handle->num_queries++;
+}
+
+static bool cmd_peer_equal(const struct cmd_peer *a,
+      const struct cmd_peer *b)
+{
+#if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
+   if (a->net != b->net)
+      return false;
+   if (a->net)
+      return a->addr_len == b->addr_len
+         && !memcmp(&a->addr, &b->addr, a->addr_len);
+#endif
+   return true;
+}
+
+void rarch_cmd_run_queries(rarch_cmd_t *handle)
+{
+   unsigned i;
+
+   if (!handle || !handle->num_queries)
+      return;
+
+   for (i = 0; i < handle->num_queries; i++)
+   {
+      struct cmd_query *query = &handle->queries[i];
+
+      /* Replies to one sender go out together. */
+      if (!cmd_peer_equal(&query->peer, &handle->reply_peer))
+      {
+         cmd_reply_flush(handle);
+         handle->reply_peer = query->peer;
+      }
+
+      query_map[query->index].query(handle, query->arg);
+      free(query->arg);
+      query->arg = NULL;
+   }
+
+   cmd_reply_flush(handle);
+   handle->num_queries = 0;
+}
+
 static void parse_sub_msg(rarch_cmd_t *handle, const char *tok)
 {
+   unsigned i;
    const char *arg = NULL;
    unsigned index  = 0;
 
+   for (i = 0; i < ARRAY_SIZE(query_map); i++)
+   {
+      size_t len = strlen(query_map[i].str);
+
+      if (strncmp(tok, query_map[i].str, len))
+         continue;
+
+      if (tok[len] == '\0')
+      {
+         cmd_queue_query(handle, i, NULL);
+         return;
+      }
+
+      if (tok[len] == ' ')
+      {
+         cmd_queue_query(handle, i, tok + len + 1);
+         return;
+      }
+   }
+
    if (command_get_arg(tok, &arg, &index))
    {
       if (arg)
@@ -313,7 +859,7 @@ static void parse_sub_msg(rarch_cmd_t *handle, const char *tok)
             RARCH_ERR("Command \"%s\" failed.\n", arg);
       }
       else
-         handle->state[map[index].id] = true;
+         BIT64_SET(handle->state, map[index].id);
    }
    else
       RARCH_WARN("%s \"%s\" %s.\n",
@@ -337,12 +883,17 @@ static void parse_msg(rarch_cmd_t *handle, char *buf)
 void rarch_cmd_set(rarch_cmd_t *handle, unsigned id)
 {
    if (id < RARCH_BIND_LIST_END)
-      handle->state[id] = true;
+      BIT64_SET(handle->state, id);
 }
 
 bool rarch_cmd_get(rarch_cmd_t *handle, unsigned id)
 {
-   return id < RARCH_BIND_LIST_END && handle->state[id];
+   return id < RARCH_BIND_LIST_END && BIT64_GET(handle->state, id);
+}
+
+uint64_t rarch_cmd_get_state(rarch_cmd_t *handle)
+{
+   return handle->state;
 }
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
@@ -365,15 +916,20 @@ static void network_cmd_poll(rarch_cmd_t *handle)
 
    for (;;)
    {
-      char buf[1024];
-      ssize_t ret = recvfrom(handle->net_fd, buf,
-            sizeof(buf) - 1, 0, NULL, NULL);
+      char buf[NETWORK_CMD_BUF_SIZE];
+      ssize_t ret;
+
+      handle->peer.addr_len = sizeof(handle->peer.addr);
+      ret = recvfrom(handle->net_fd, buf, sizeof(buf) - 1, 0,
+            (struct sockaddr*)&handle->peer.addr, &handle->peer.addr_len);
 
       if (ret <= 0)
          break;
 
       buf[ret] = '\0';
+      handle->peer.net = true;
       parse_msg(handle, buf);
+      handle->peer.net = false;
    }
 }
 #endif
@@ -530,7 +1086,7 @@ static void stdin_cmd_poll(rarch_cmd_t *handle)
 
 void rarch_cmd_poll(rarch_cmd_t *handle)
 {
-   memset(handle->state, 0, sizeof(handle->state));
+   handle->state = 0;
 
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
    network_cmd_poll(handle);
@@ -31,16 +31,26 @@ extern "C" {
 typedef struct rarch_cmd rarch_cmd_t;
 
 rarch_cmd_t *rarch_cmd_new(bool stdin_enable,
-      bool network_enable, uint16_t port);
+      bool network_enable, bool network_remote, uint16_t port);
 
 void rarch_cmd_free(rarch_cmd_t *handle);
 
+/* Reads pending commands. Hotkey commands only set state bits,
+ * queries are queued for rarch_cmd_run_queries(). */
 void rarch_cmd_poll(rarch_cmd_t *handle);
 
+/* Runs and replies to the queued queries. Must not be called
+ * while the core is inside retro_run(). */
+void rarch_cmd_run_queries(rarch_cmd_t *handle);
+
 void rarch_cmd_set(rarch_cmd_t *handle, unsigned id);
 
 bool rarch_cmd_get(rarch_cmd_t *handle, unsigned id);
 
+/* Returns bitmask of (1 << key_bind_id) of all commands received
+ * since the last rarch_cmd_poll(). */
+uint64_t rarch_cmd_get_state(rarch_cmd_t *handle);
+
 #if defined(HAVE_NETWORK_CMD) && defined(HAVE_NETPLAY)
 bool network_cmd_send(const char *cmd);
 #endif
@@ -13,6 +13,11 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef __linux__
+#include <stdio.h>
+#include <unistd.h>
+#endif
+
 #include <compat/strl.h>
 
 #include "command_event.h"
@@ -46,6 +51,10 @@
 #include <net/net_compat.h>
 #endif
 
+#ifdef HAVE_SHM
+#include "shm_export.h"
+#endif
+
 #ifdef HAVE_COMMAND
 static void event_init_command(void)
 {
@@ -61,9 +70,14 @@ static void event_init_command(void)
             "Cannot use this command interface.\n");
    }
 
+   if (settings->network_cmd_enable && settings->network_cmd_remote_enable)
+      RARCH_WARN("Network commands are accepted from any host.\n");
+
    if (!(driver->command = rarch_cmd_new(settings->stdin_cmd_enable
                && !input_driver_grab_stdin(),
-               settings->network_cmd_enable, settings->network_cmd_port)))
+               settings->network_cmd_enable,
+               settings->network_cmd_remote_enable,
+               settings->network_cmd_port)))
       RARCH_ERR("Failed to initialize command interface.\n");
 }
 #endif
@@ -84,6 +98,17 @@ static void event_free_temporary_content(void)
    {
       const char *path = global->temporary_content->elems[i].data;
 
+#ifdef __linux__
+      int fd;
+
+      /* In-memory files are gone once closed. */
+      if (sscanf(path, "/proc/self/fd/%d", &fd) == 1)
+      {
+         close(fd);
+         continue;
+      }
+#endif
+
       RARCH_LOG("%s: %s.\n",
             msg_hash_to_str(MSG_REMOVING_TEMPORARY_CONTENT_FILE), path);
       if (remove(path) < 0)
@@ -182,6 +207,9 @@ static void event_init_movie(void)
       }
 
       global->bsv.movie_playback = true;
+      /* The seek to movie_start_frame runs the core, it is done by
+       * rarch_main_iterate() once the core and drivers are set up. */
+
       rarch_main_msg_queue_push_new(MSG_STARTING_MOVIE_PLAYBACK, 2, 180, false);
       RARCH_LOG("%s.\n", msg_hash_to_str(MSG_STARTING_MOVIE_PLAYBACK));
       settings->rewind_granularity = 1;
@@ -564,6 +592,11 @@ static void event_deinit_core(bool reinit)
    global_t *global     = global_get_ptr();
    settings_t *settings = config_get_ptr();
    rarch_system_info_t *info = rarch_system_info_get_ptr();
+
+#ifdef HAVE_SHM
+   shm_export_deinit();
+#endif
+
    pretro_unload_game();
    pretro_deinit();
 
@@ -790,6 +823,10 @@ static bool event_init_core(void)
    retro_init_libretro_cbs(&driver->retro_ctx);
    rarch_init_system_av_info();
 
+#ifdef HAVE_SHM
+   shm_export_init();
+#endif
+
    return true;
 }
 
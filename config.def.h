@@ -351,6 +351,12 @@ static bool bundle_assets_extract_enable = false;
 
 static const bool def_history_list_enable = true;
 
+/* Extract zipped content for cores which need a full path into an
+ * in-memory file instead of the extraction directory (Linux only).
+ * The core then sees a /proc/self/fd/ path without the original
+ * file name or extension. */
+static const bool extraction_memfd_enable = false;
+
 static const unsigned int def_user_language = 0;
 
 /* VIDEO */
@@ -633,6 +639,14 @@ static const bool rate_control = false;
  * is allowed to adjust input rate. */
 static const float rate_control_delta = 0.005;
 
+/* Audio buffer level rate control steers to, in milliseconds.
+ * 0 is half of the buffer. */
+static const unsigned rate_control_target = 0;
+
+/* Run the audio driver on its own thread. The main thread
+ * queues samples without waiting for the driver. */
+static const bool audio_threaded = false;
+
 /* Maximum timing skew. Defines how much adjust_system_rates
  * is allowed to adjust input rate. */
 static const float max_timing_skew = 0.05;
@@ -698,8 +712,16 @@ static const bool fastforward_ratio_throttle_enable = false;
 /* Enable stdin/network command interface. */
 static const bool network_cmd_enable = false;
 static const uint16_t network_cmd_port = 55355;
+
+/* Accept network commands from other hosts, not only from 127.0.0.1. */
+static const bool network_cmd_remote_enable = false;
 static const bool stdin_cmd_enable = false;
 
+/* Publish the last frame and the system RAM of the core in
+ * shared memory every frame. */
+static const bool shm_export_enable = false;
+static const char *shm_export_name = "/retroarch";
+
 /* Number of entries that will be kept in content history playlist file. */
 static const unsigned default_content_history_size = 100;
 
@@ -739,6 +761,10 @@ static const unsigned turbo_duty_cycle = 3;
  * gamepads, plug-and-play style. */
 static const bool input_autodetect_enable = true;
 
+/* Drain joypad events on a separate thread as soon as they arrive,
+ * instead of once per frame. Only supported by the udev joypad driver. */
+static const bool input_poll_thread = false;
+
 /* Join device Ids for devices that uses separate ids for the same gamepad
  * like tha Archos Gamepad 2
  */
@@ -535,8 +535,10 @@ static void config_set_defaults(void)
    settings->audio.latency                     = g_defaults.settings.out_latency;
    settings->audio.sync                        = audio_sync;
    settings->audio.is_minix                    = is_minix;
+   settings->audio.threaded                    = audio_threaded;
    settings->audio.rate_control                = rate_control;
    settings->audio.rate_control_delta          = rate_control_delta;
+   settings->audio.rate_control_target         = rate_control_target;
    settings->audio.max_timing_skew             = max_timing_skew;
    settings->audio.volume                      = audio_volume;
 
@@ -558,7 +560,11 @@ static void config_set_defaults(void)
    settings->savestate_auto_load               = savestate_auto_load;
    settings->network_cmd_enable                = network_cmd_enable;
    settings->network_cmd_port                  = network_cmd_port;
+   settings->network_cmd_remote_enable         = network_cmd_remote_enable;
    settings->stdin_cmd_enable                  = stdin_cmd_enable;
+   settings->shm_export_enable                 = shm_export_enable;
+   strlcpy(settings->shm_export_name, shm_export_name,
+         sizeof(settings->shm_export_name));
    settings->content_history_size              = default_content_history_size;
    settings->libretro_log_level                = libretro_log_level;
 
@@ -623,6 +629,7 @@ static void config_set_defaults(void)
    }
    memset(settings->input.autoconfigured, 0,
          sizeof(settings->input.autoconfigured));
+   input_driver_binds_changed();
 
    /* Verify that binds are in proper order. */
    for (i = 0; i < MAX_USERS; i++)
@@ -649,6 +656,7 @@ static void config_set_defaults(void)
    settings->input.overlay_opacity                 = 0.7f;
    settings->input.overlay_scale                   = 1.0f;
    settings->input.autodetect_enable               = input_autodetect_enable;
+   settings->input.poll_thread                     = input_poll_thread;
    settings->input.join_device_ids                 = input_join_device_ids;
    settings->input.rewind_forward_combo            = input_rewind_forward_combo;
    *settings->input.keyboard_layout                = '\0';
@@ -699,6 +707,7 @@ static void config_set_defaults(void)
    *settings->screenshot_directory = '\0';
    *settings->system_directory = '\0';
    *settings->extraction_directory = '\0';
+   settings->extraction_memfd_enable = extraction_memfd_enable;
    *settings->input_remapping_directory = '\0';
    *settings->input.autoconfig_dir = '\0';
    *settings->input.overlay = '\0';
@@ -1152,6 +1161,8 @@ static void config_read_keybinds_conf(config_file_t *conf)
 
    for (i = 0; i < MAX_USERS; i++)
       read_keybinds_user(conf, i);
+
+   input_driver_binds_changed();
 }
 
 /* Also dumps inherited values, useful for logging. */
@@ -1485,8 +1496,10 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT_BASE(conf, settings, audio.latency, "audio_latency");
    CONFIG_GET_BOOL_BASE(conf, settings, audio.sync, "audio_sync");
    CONFIG_GET_BOOL_BASE(conf, settings, audio.is_minix, "audio_minix");
+   CONFIG_GET_BOOL_BASE(conf, settings, audio.threaded, "audio_threaded");
    CONFIG_GET_BOOL_BASE(conf, settings, audio.rate_control, "audio_rate_control");
    CONFIG_GET_FLOAT_BASE(conf, settings, audio.rate_control_delta, "audio_rate_control_delta");
+   CONFIG_GET_INT_BASE(conf, settings, audio.rate_control_target, "audio_rate_control_target");
    CONFIG_GET_FLOAT_BASE(conf, settings, audio.max_timing_skew, "audio_max_timing_skew");
    CONFIG_GET_FLOAT_BASE(conf, settings, audio.volume, "audio_volume");
    CONFIG_GET_STRING_BASE(conf, settings, audio.resampler, "audio_resampler");
@@ -1553,6 +1566,7 @@ static bool config_load_file(const char *path, bool set_defaults)
          sizeof(settings->resampler_directory));
    config_get_path(conf, "extraction_directory", settings->extraction_directory,
          sizeof(settings->extraction_directory));
+   CONFIG_GET_BOOL_BASE(conf, settings, extraction_memfd_enable, "extraction_memfd_enable");
    config_get_path(conf, "input_remapping_directory", settings->input_remapping_directory,
          sizeof(settings->input_remapping_directory));
    config_get_path(conf, "core_assets_directory", settings->core_assets_directory,
@@ -1592,6 +1606,13 @@ static bool config_load_file(const char *path, bool set_defaults)
       CONFIG_GET_BOOL_BASE(conf, global, verbosity, "log_verbosity");
 
    CONFIG_GET_BOOL_BASE(conf, global, perfcnt_enable, "perfcnt_enable");
+   CONFIG_GET_BOOL_BASE(conf, global, perfcnt_histogram_enable, "perfcnt_histogram_enable");
+   CONFIG_GET_INT_BASE(conf, global, perfcnt_dump_interval, "perfcnt_dump_interval");
+   config_get_path(conf, "perfcnt_dump_path", global->perfcnt_dump_path,
+         sizeof(global->perfcnt_dump_path));
+   CONFIG_GET_BOOL_BASE(conf, global, perfcnt_trace_enable, "perfcnt_trace_enable");
+   config_get_path(conf, "perfcnt_trace_path", global->perfcnt_trace_path,
+         sizeof(global->perfcnt_trace_path));
 
    config_get_path(conf, "recording_output_directory", global->record.output_dir,
          sizeof(global->record.output_dir));
@@ -1659,8 +1680,12 @@ static bool config_load_file(const char *path, bool set_defaults)
 
    CONFIG_GET_BOOL_BASE(conf, settings, network_cmd_enable, "network_cmd_enable");
    CONFIG_GET_INT_BASE(conf, settings, network_cmd_port, "network_cmd_port");
+   CONFIG_GET_BOOL_BASE(conf, settings, network_cmd_remote_enable, "network_cmd_remote_enable");
    CONFIG_GET_BOOL_BASE(conf, settings, stdin_cmd_enable, "stdin_cmd_enable");
 
+   CONFIG_GET_BOOL_BASE(conf, settings, shm_export_enable, "shm_export_enable");
+   CONFIG_GET_STRING_BASE(conf, settings, shm_export_name, "shm_export_name");
+
    CONFIG_GET_PATH_BASE(conf, settings, content_history_directory, "content_history_dir");
 
    CONFIG_GET_BOOL_BASE(conf, settings, history_list_enable, "history_list_enable");
@@ -1672,6 +1697,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT_BASE(conf, settings, input.turbo_duty_cycle, "input_duty_cycle");
 
    CONFIG_GET_BOOL_BASE(conf, settings, input.autodetect_enable, "input_autodetect_enable");
+   CONFIG_GET_BOOL_BASE(conf, settings, input.poll_thread, "input_poll_thread");
    CONFIG_GET_BOOL_BASE(conf, settings, input.join_device_ids, "input_join_device_ids");
    CONFIG_GET_PATH_BASE(conf, settings, input.autoconfig_dir, "joypad_autoconfig_dir");
 
@@ -2592,9 +2618,12 @@ bool config_save_file(const char *path)
          settings->network.buildbot_auto_extract_archive);
    config_set_string(conf, "camera_device", settings->camera.device);
    config_set_bool(conf, "camera_allow", settings->camera.allow);
+   config_set_bool(conf, "audio_threaded", settings->audio.threaded);
    config_set_bool(conf, "audio_rate_control", settings->audio.rate_control);
    config_set_float(conf, "audio_rate_control_delta",
          settings->audio.rate_control_delta);
+   config_set_int(conf, "audio_rate_control_target",
+         settings->audio.rate_control_target);
    config_set_float(conf, "audio_max_timing_skew",
          settings->audio.max_timing_skew);
    config_set_float(conf, "audio_volume", settings->audio.volume);
@@ -2621,6 +2650,8 @@ bool config_save_file(const char *path)
          settings->system_directory : "default");
    config_set_path(conf, "extraction_directory",
          settings->extraction_directory);
+   config_set_bool(conf, "extraction_memfd_enable",
+         settings->extraction_memfd_enable);
    config_set_path(conf, "input_remapping_directory",
          settings->input_remapping_directory);
    config_set_path(conf, "input_remapping_path",
@@ -2691,6 +2722,8 @@ bool config_save_file(const char *path)
          settings->input.autoconfig_dir);
    config_set_bool(conf, "input_autodetect_enable",
          settings->input.autodetect_enable);
+   config_set_bool(conf, "input_poll_thread",
+         settings->input.poll_thread);
 
 #ifdef HAVE_OVERLAY
    config_set_path(conf, "overlay_directory",
@@ -2814,6 +2847,14 @@ bool config_save_file(const char *path)
    config_set_int(conf, "libretro_log_level", settings->libretro_log_level);
    config_set_bool(conf, "log_verbosity", global->verbosity);
    config_set_bool(conf, "perfcnt_enable", global->perfcnt_enable);
+   config_set_bool(conf, "perfcnt_histogram_enable",
+         global->perfcnt_histogram_enable);
+   config_set_int(conf, "perfcnt_dump_interval",
+         global->perfcnt_dump_interval);
+   config_set_path(conf, "perfcnt_dump_path", global->perfcnt_dump_path);
+   config_set_bool(conf, "perfcnt_trace_enable",
+         global->perfcnt_trace_enable);
+   config_set_path(conf, "perfcnt_trace_path", global->perfcnt_trace_path);
 
    config_set_bool(conf, "core_set_supports_no_game_enable",
          settings->core.set_supports_no_game_enable);
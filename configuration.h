@@ -207,8 +207,10 @@ typedef struct settings
       char dsp_plugin[PATH_MAX_LENGTH];
       char filter_dir[PATH_MAX_LENGTH];
 
+      bool threaded;
       bool rate_control;
       float rate_control_delta;
+      unsigned rate_control_target;
       float max_timing_skew;
       float volume; /* dB scale. */
       char resampler[32];
@@ -242,6 +244,7 @@ typedef struct settings
       unsigned device[MAX_USERS];
       char device_names[MAX_USERS][64];
       bool autodetect_enable;
+      bool poll_thread;
       bool join_device_ids;
       bool netplay_client_swap_input;
 
@@ -326,6 +329,7 @@ typedef struct settings
    bool system_in_content_dir;
 
    char extraction_directory[PATH_MAX_LENGTH];
+   bool extraction_memfd_enable;
    char playlist_directory[PATH_MAX_LENGTH];
 
    bool history_list_enable;
@@ -349,8 +353,12 @@ typedef struct settings
 
    bool network_cmd_enable;
    unsigned network_cmd_port;
+   bool network_cmd_remote_enable;
    bool stdin_cmd_enable;
 
+   bool shm_export_enable;
+   char shm_export_name[PATH_MAX_LENGTH];
+
    char core_assets_directory[PATH_MAX_LENGTH];
    char assets_directory[PATH_MAX_LENGTH];
    char dynamic_wallpapers_directory[PATH_MAX_LENGTH];
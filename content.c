@@ -33,16 +33,32 @@
 #include <compat/strl.h>
 #include <file/file_path.h>
 #include <file/file_extract.h>
+#include <rhash.h>
 
 #include "msg_hash.h"
 #include "content.h"
 #include "file_ops.h"
+#ifdef HAVE_ZLIB
+#include "decompress/zip_support.h"
+#endif
 #include "general.h"
 #include "dynamic.h"
 #include "movie.h"
 #include "patch.h"
 #include "system.h"
 
+#if defined(HAVE_ZLIB) && defined(__linux__)
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#ifdef SYS_memfd_create
+#define HAVE_CONTENT_MEMFD
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#endif
+#endif
+
 /**
  * read_content_file:
  * @path         : buffer of the content file.
@@ -55,15 +71,31 @@
  *
  * Returns: true if successful, false on error.
  **/
-static bool read_content_file(unsigned i, const char *path, void **buf,
-      ssize_t *length)
+static bool read_content_entry(const char *path, const char *zip_entry,
+      void **buf, ssize_t *length)
+{
+#ifdef HAVE_ZLIB
+   /* Inflated straight from the archive, whatever characters
+    * the archive path or the entry name contain. */
+   if (zip_entry && *zip_entry)
+   {
+      *length = read_zip_file(path, zip_entry, buf, NULL);
+      return *length >= 0;
+   }
+#endif
+
+   return read_file(path, buf, length);
+}
+
+static bool read_content_file(unsigned i, const char *path,
+      const char *zip_entry, void **buf, ssize_t *length)
 {
    uint8_t *ret_buf = NULL;
    global_t *global = global_get_ptr();
 
    RARCH_LOG("%s: %s.\n",
          msg_hash_to_str(MSG_LOADING_CONTENT_FILE), path);
-   if (!read_file(path, (void**) &ret_buf, length))
+   if (!read_content_entry(path, zip_entry, (void**) &ret_buf, length))
       return false;
 
    if (*length < 0)
@@ -76,11 +108,9 @@ static bool read_content_file(unsigned i, const char *path, void **buf,
    if (!global->block_patch)
       patch_content(&ret_buf, length);
    
-#ifdef HAVE_ZLIB
-   global->content_crc = zlib_crc32_calculate(ret_buf, *length);
+   global->content_crc = crc32_calculate(ret_buf, *length);
 
    RARCH_LOG("CRC32: 0x%x .\n", (unsigned)global->content_crc);
-#endif
    *buf = ret_buf;
 
    return true;
@@ -347,7 +377,8 @@ void save_ram_file(const char *path, int type)
 }
 
 static bool load_content_dont_need_fullpath(
-      struct retro_game_info *info, unsigned i, const char *path)
+      struct retro_game_info *info, unsigned i, const char *path,
+      const char *zip_entry)
 {
    ssize_t len;
    /* Load the content into memory. */
@@ -357,9 +388,11 @@ static bool load_content_dont_need_fullpath(
    bool ret = false;
 
    if (i == 0)
-      ret = read_content_file(i, path, (void**)&info->data, &len);
+      ret = read_content_file(i, path, zip_entry,
+            (void**)&info->data, &len);
    else
-      ret = read_file(path, (void**)&info->data, &len);
+      ret = read_content_entry(path, zip_entry,
+            (void**)&info->data, &len);
 
    if (!ret || len < 0)
    {
@@ -450,13 +483,16 @@ static bool load_content_need_fullpath(
  * load_content:
  * @special          : subsystem of content to be loaded. Can be NULL.
  * content           : 
+ * @zip_entries      : ZIP archive entry to load for each content file,
+ *                     or empty to load the file itself. Can be NULL.
  *
  * Load content file (for libretro core).
  *
  * Returns : true if successful, otherwise false.
  **/
 static bool load_content(const struct retro_subsystem_info *special,
-      const struct string_list *content)
+      const struct string_list *content,
+      const struct string_list *zip_entries)
 {
    unsigned i;
    bool ret = true;
@@ -472,10 +508,12 @@ static bool load_content(const struct retro_subsystem_info *special,
 
    for (i = 0; i < content->size; i++)
    {
-      const char *path     = content->elems[i].data;
-      int         attr     = content->elems[i].attr.i;
-      bool need_fullpath   = attr & 2;
-      bool require_content = attr & 4;
+      const char *path      = content->elems[i].data;
+      const char *zip_entry = zip_entries ?
+         zip_entries->elems[i].data : NULL;
+      int         attr      = content->elems[i].attr.i;
+      bool need_fullpath    = attr & 2;
+      bool require_content  = attr & 4;
 
       if (require_content && !*path)
       {
@@ -491,7 +529,23 @@ static bool load_content(const struct retro_subsystem_info *special,
 
       if (!need_fullpath && *path)
       {
-         if (!load_content_dont_need_fullpath(&info[i], i, path))
+         if (zip_entry && *zip_entry)
+         {
+            union string_list_elem_attr attributes;
+            char entry_path[PATH_MAX_LENGTH] = {0};
+
+            /* The core still sees which entry it got. */
+            attributes.i = 0;
+            strlcpy(entry_path, path, sizeof(entry_path));
+            strlcat(entry_path, "#", sizeof(entry_path));
+            strlcat(entry_path, zip_entry, sizeof(entry_path));
+            string_list_append(additional_path_allocs,
+                  entry_path, attributes);
+            info[i].path = additional_path_allocs->elems
+               [additional_path_allocs->size - 1].data;
+         }
+
+         if (!load_content_dont_need_fullpath(&info[i], i, path, zip_entry))
             goto end;
       }
       else
@@ -523,6 +577,40 @@ end:
    return ret;
 }
 
+#ifdef HAVE_CONTENT_MEMFD
+/**
+ * content_extract_to_memfd:
+ * @zip_path         : path of the ZIP archive.
+ * @name             : name of the entry inside the archive.
+ * @s                : buffer for the path of the in-memory file.
+ * @len              : size of @s.
+ *
+ * Extracts an archive entry into an anonymous in-memory file, for
+ * cores which need a path to load content from. The file descriptor
+ * is kept open until event_free_temporary_content() closes it.
+ *
+ * Returns : true if successful, otherwise false.
+ **/
+static bool content_extract_to_memfd(const char *zip_path,
+      const char *name, char *s, size_t len)
+{
+   int fd = syscall(SYS_memfd_create, path_basename(name), MFD_CLOEXEC);
+
+   if (fd < 0)
+      return false;
+
+   snprintf(s, len, "/proc/self/fd/%d", fd);
+
+   if (!zlib_extract_to_file(zip_path, name, s))
+   {
+      close(fd);
+      return false;
+   }
+
+   return true;
+}
+#endif
+
 /**
  * init_content_file:
  *
@@ -540,6 +628,7 @@ bool init_content_file(void)
    union string_list_elem_attr attr;
    bool ret                                   = false;
    struct string_list *content                = NULL;
+   struct string_list *zip_entries            = NULL;
    const struct retro_subsystem_info *special = NULL;
    settings_t *settings                       = config_get_ptr();
    rarch_system_info_t *system                = rarch_system_info_get_ptr();
@@ -614,6 +703,13 @@ bool init_content_file(void)
    }
 
 #ifdef HAVE_ZLIB
+   if (!(zip_entries = string_list_new()))
+      goto error;
+
+   for (i = 0; i < content->size; i++)
+      if (!string_list_append(zip_entries, "", attr))
+         goto error;
+
    /* Try to extract all content we're going to load if appropriate. */
    for (i = 0; i < content->size; i++)
    {
@@ -630,10 +726,43 @@ bool init_content_file(void)
 
       if (ext && !strcasecmp(ext, "zip"))
       {
+         char name[PATH_MAX_LENGTH]              = {0};
          char temporary_content[PATH_MAX_LENGTH] = {0};
+         const char *path  = content->elems[i].data;
+         const char *entry = zlib_find_first_content_file(path, valid_ext);
+
+         if (!entry)
+         {
+            RARCH_ERR("Failed to extract content from zipped file: %s.\n",
+                  path);
+            goto error;
+         }
+
+         strlcpy(name, entry, sizeof(name));
+
+         /* Cores loading content from memory get the entry inflated
+          * straight into their buffer by load_content(). */
+         if (!(content->elems[i].attr.i & 2))
+         {
+            string_list_set(zip_entries, i, name);
+            continue;
+         }
+
+#ifdef HAVE_CONTENT_MEMFD
+         if (settings->extraction_memfd_enable
+               && content_extract_to_memfd(path, name,
+                  temporary_content, sizeof(temporary_content)))
+         {
+            RARCH_LOG("Extracted \"%s\" to memory: %s.\n",
+                  name, temporary_content);
+            string_list_set(content, i, temporary_content);
+            string_list_append(global->temporary_content,
+                  temporary_content, attr);
+            continue;
+         }
+#endif
 
-         strlcpy(temporary_content, content->elems[i].data,
-               sizeof(temporary_content));
+         strlcpy(temporary_content, path, sizeof(temporary_content));
 
          if (!zlib_extract_first_content_file(temporary_content,
                   sizeof(temporary_content), valid_ext,
@@ -652,12 +781,14 @@ bool init_content_file(void)
 #endif
 
    /* Set attr to need_fullpath as appropriate. */
-   ret = load_content(special, content);
+   ret = load_content(special, content, zip_entries);
 
 error:
    global->content_is_init = (ret) ? true : false;
 
    if (content)
       string_list_free(content);
+   if (zip_entries)
+      string_list_free(zip_entries);
    return ret;
 }
@@ -22,15 +22,177 @@
 #include <file/file_extract.h>
 #include "dir_list_special.h"
 #include "config.def.h"
+#include "core_info_cache.h"
+#include "performance.h"
+
+#include <ctype.h>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#define CORE_INFO_PARSE_MIN_PER_THREAD 8
+
+/* Hash index from lowercase file extension to every core supporting it. */
+struct core_info_ext_bucket
+{
+   uint32_t hash;
+   char *ext;
+   const char **cores;
+   size_t count;
+   size_t capacity;
+};
+
+struct core_info_ext_index
+{
+   struct core_info_ext_bucket *buckets;
+   size_t mask;
+};
+
+static uint32_t core_info_ext_hash(const char *ext, char *out, size_t size)
+{
+   size_t i;
+   uint32_t hash = 5381;
+
+   if (*ext == '.')
+      ext++;
+
+   for (i = 0; ext[i] && i + 1 < size; i++)
+   {
+      out[i] = tolower((unsigned char)ext[i]);
+      hash   = ((hash << 5) + hash) + (unsigned char)out[i];
+   }
+   out[i] = '\0';
+
+   return hash;
+}
+
+static struct core_info_ext_bucket *core_info_ext_index_find(
+      const struct core_info_ext_index *index, const char *ext, bool create)
+{
+   char key[64];
+   size_t i;
+   uint32_t hash;
+
+   if (!index || !ext || !*ext)
+      return NULL;
+
+   hash = core_info_ext_hash(ext, key, sizeof(key));
+
+   for (i = hash & index->mask; ; i = (i + 1) & index->mask)
+   {
+      struct core_info_ext_bucket *bucket = &index->buckets[i];
+
+      if (!bucket->ext)
+      {
+         if (!create)
+            return NULL;
+         bucket->hash = hash;
+         bucket->ext  = strdup(key);
+         return bucket->ext ? bucket : NULL;
+      }
+
+      if (bucket->hash == hash && !strcmp(bucket->ext, key))
+         return bucket;
+   }
+}
+
+static void core_info_ext_index_free(struct core_info_ext_index *index)
+{
+   size_t i;
+
+   if (!index)
+      return;
+
+   for (i = 0; i <= index->mask; i++)
+   {
+      free(index->buckets[i].ext);
+      free(index->buckets[i].cores);
+   }
+
+   free(index->buckets);
+   free(index);
+}
+
+static struct core_info_ext_index *core_info_ext_index_new(
+      const core_info_list_t *core_info_list)
+{
+   size_t i, j, num_ext = 0, size = 16;
+   struct core_info_ext_index *index = NULL;
+
+   for (i = 0; i < core_info_list->count; i++)
+   {
+      if (core_info_list->list[i].supported_extensions_list)
+         num_ext += core_info_list->list[i].supported_extensions_list->size;
+   }
+
+   /* Keep the load factor below 1/2. */
+   while (size < num_ext * 2)
+      size <<= 1;
+
+   index = (struct core_info_ext_index*)calloc(1, sizeof(*index));
+   if (!index)
+      return NULL;
+
+   index->mask    = size - 1;
+   index->buckets = (struct core_info_ext_bucket*)
+      calloc(size, sizeof(*index->buckets));
+   if (!index->buckets)
+      goto error;
+
+   for (i = 0; i < core_info_list->count; i++)
+   {
+      const core_info_t *info = &core_info_list->list[i];
+
+      if (!info->supported_extensions_list)
+         continue;
+
+      for (j = 0; j < info->supported_extensions_list->size; j++)
+      {
+         struct core_info_ext_bucket *bucket = core_info_ext_index_find(
+               index, info->supported_extensions_list->elems[j].data, true);
+
+         if (!bucket)
+            continue;
+
+         /* Duplicate extension in the same core. */
+         if (bucket->count && bucket->cores[bucket->count - 1] == info->path)
+            continue;
+
+         if (bucket->count == bucket->capacity)
+         {
+            size_t capacity    = bucket->capacity ? bucket->capacity * 2 : 4;
+            const char **cores = (const char**)realloc(bucket->cores,
+                  capacity * sizeof(*cores));
+
+            if (!cores)
+               goto error;
+
+            bucket->cores    = cores;
+            bucket->capacity = capacity;
+         }
+
+         /* Core paths are not moved when the list is sorted,
+          * so they identify a core. */
+         bucket->cores[bucket->count++] = info->path;
+      }
+   }
+
+   return index;
+
+error:
+   core_info_ext_index_free(index);
+   return NULL;
+}
+
 static void core_info_list_resolve_all_extensions(
       core_info_list_t *core_info_list)
 {
-   size_t i, all_ext_len = 0;
+   size_t i, all_ext_len = 0, pos = 0;
 
    if (!core_info_list)
       return;
@@ -50,132 +212,244 @@ static void core_info_list_resolve_all_extensions(
 
    for (i = 0; i < core_info_list->count; i++)
    {
-      if (!core_info_list->list[i].supported_extensions)
+      size_t len;
+      const char *ext = core_info_list->list[i].supported_extensions;
+
+      if (!ext)
          continue;
 
-      strlcat(core_info_list->all_ext,
-            core_info_list->list[i].supported_extensions, all_ext_len);
-      strlcat(core_info_list->all_ext, "|", all_ext_len);
+      len = strlen(ext);
+      memcpy(core_info_list->all_ext + pos, ext, len);
+      pos += len;
+      core_info_list->all_ext[pos++] = '|';
    }
+
+   core_info_list->all_ext[pos] = '\0';
 }
 
-static void core_info_list_resolve_all_firmware(
-      core_info_list_t *core_info_list)
+static void core_info_get_info_path(const char *core_path,
+      char *s, size_t len)
 {
-   size_t i;
-   unsigned c;
+   char info_path_base[PATH_MAX_LENGTH] = {0};
+   settings_t *settings                 = config_get_ptr();
 
-   if (!core_info_list)
-      return;
+   fill_pathname_base(info_path_base, core_path, sizeof(info_path_base));
+   path_remove_extension(info_path_base);
 
-   for (i = 0; i < core_info_list->count; i++)
-   {
-      unsigned count    = 0;
-      core_info_t *info = (core_info_t*)&core_info_list->list[i];
+#if defined(RARCH_MOBILE) || (defined(RARCH_CONSOLE) && !defined(PSP))
+   char *substr = strrchr(info_path_base, '_');
+   if (substr)
+      *substr = '\0';
+#endif
 
-      if (!info || !info->data)
-         continue;
+   strlcat(info_path_base, ".info", sizeof(info_path_base));
 
-      if (!config_get_uint(info->data, "firmware_count", &count))
-         continue;
+   fill_pathname_join(s, (*settings->libretro_info_path) ?
+         settings->libretro_info_path : settings->libretro_directory,
+         info_path_base, len);
+}
+
+/**
+ * core_info_parse:
+ * @info                   : Core info to fill in.
+ * @info_path              : Path to .info file.
+ *
+ * Reads all strings and firmware of @info from an .info file.
+ * Safe to call from worker threads.
+ **/
+static void core_info_parse(core_info_t *info, const char *info_path)
+{
+   unsigned c, count = 0;
+   config_file_t *conf = config_file_new(info_path);
 
+   if (!conf)
+      return;
+
+   config_get_string(conf, "display_name", &info->display_name);
+   config_get_string(conf, "corename", &info->core_name);
+   config_get_string(conf, "systemname", &info->systemname);
+   config_get_string(conf, "manufacturer", &info->system_manufacturer);
+   config_get_string(conf, "supported_extensions",
+         &info->supported_extensions);
+   config_get_string(conf, "authors", &info->authors);
+   config_get_string(conf, "permissions", &info->permissions);
+   config_get_string(conf, "license", &info->licenses);
+   config_get_string(conf, "categories", &info->categories);
+   config_get_string(conf, "database", &info->databases);
+   config_get_string(conf, "notes", &info->notes);
+   config_get_bool(conf, "supports_no_game", &info->supports_no_game);
+
+   if (config_get_uint(conf, "firmware_count", &count) && count)
+   {
       info->firmware = (core_info_firmware_t*)
          calloc(count, sizeof(*info->firmware));
+      info->firmware_count = info->firmware ? count : 0;
+   }
 
-      if (!info->firmware)
-         continue;
+   for (c = 0; c < info->firmware_count; c++)
+   {
+      char path_key[64] = {0};
+      char desc_key[64] = {0};
+      char opt_key[64]  = {0};
 
-      for (c = 0; c < count; c++)
-      {
-         char path_key[64] = {0};
-         char desc_key[64] = {0};
-         char opt_key[64]  = {0};
+      snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
+      snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
+      snprintf(opt_key, sizeof(opt_key), "firmware%u_opt", c);
+
+      config_get_string(conf, path_key, &info->firmware[c].path);
+      config_get_string(conf, desc_key, &info->firmware[c].desc);
+      config_get_bool(conf, opt_key , &info->firmware[c].optional);
+   }
 
-         snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
-         snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
-         snprintf(opt_key, sizeof(opt_key), "firmware%u_opt", c);
+   info->has_info = true;
 
-         config_get_string(info->data, path_key, &info->firmware[c].path);
-         config_get_string(info->data, desc_key, &info->firmware[c].desc);
-         config_get_bool(info->data, opt_key , &info->firmware[c].optional);
-      }
+   config_file_free(conf);
+}
+
+static void core_info_split_lists(core_info_t *info)
+{
+   if (info->supported_extensions)
+      info->supported_extensions_list =
+         string_split(info->supported_extensions, "|");
+   if (info->authors)
+      info->authors_list = string_split(info->authors, "|");
+   if (info->permissions)
+      info->permissions_list = string_split(info->permissions, "|");
+   if (info->licenses)
+      info->licenses_list = string_split(info->licenses, "|");
+   if (info->categories)
+      info->categories_list = string_split(info->categories, "|");
+   if (info->databases)
+      info->databases_list = string_split(info->databases, "|");
+   if (info->notes)
+      info->note_list = string_split(info->notes, "|");
+}
+
+typedef struct core_info_parse_job
+{
+   core_info_t *list;
+   const core_info_cache_key_t *keys;
+   const size_t *stale;
+   size_t num_stale;
+   unsigned first;
+   unsigned stride;
+} core_info_parse_job_t;
+
+static void core_info_parse_worker(void *data)
+{
+   size_t i;
+   core_info_parse_job_t *job = (core_info_parse_job_t*)data;
+
+   for (i = job->first; i < job->num_stale; i += job->stride)
+   {
+      size_t idx = job->stale[i];
+      core_info_parse(&job->list[idx], job->keys[idx].info_path);
+   }
+}
+
+/**
+ * core_info_parse_stale:
+ * @list                   : Core infos.
+ * @keys                   : .info file of every entry in @list.
+ * @stale                  : Indices of entries to parse.
+ * @num_stale              : Number of entries in @stale.
+ *
+ * Parses all entries which were not found in the cache,
+ * spreading them over all CPU cores if there are enough of them.
+ **/
+static void core_info_parse_stale(core_info_t *list,
+      const core_info_cache_key_t *keys,
+      const size_t *stale, size_t num_stale)
+{
+   unsigned i, num_threads = 1;
+   core_info_parse_job_t jobs[16];
+#ifdef HAVE_THREADS
+   sthread_t *threads[16] = {NULL};
+
+   num_threads = rarch_get_cpu_cores();
+   if (num_threads > num_stale / CORE_INFO_PARSE_MIN_PER_THREAD)
+      num_threads = num_stale / CORE_INFO_PARSE_MIN_PER_THREAD;
+   if (num_threads > 16)
+      num_threads = 16;
+   if (num_threads < 1)
+      num_threads = 1;
+#endif
+
+   for (i = 0; i < num_threads; i++)
+   {
+      jobs[i].list      = list;
+      jobs[i].keys      = keys;
+      jobs[i].stale     = stale;
+      jobs[i].num_stale = num_stale;
+      jobs[i].first     = i;
+      jobs[i].stride    = num_threads;
+   }
+
+#ifdef HAVE_THREADS
+   for (i = 1; i < num_threads; i++)
+      threads[i] = sthread_create(core_info_parse_worker, &jobs[i]);
+#endif
+
+   core_info_parse_worker(&jobs[0]);
+
+#ifdef HAVE_THREADS
+   for (i = 1; i < num_threads; i++)
+   {
+      if (threads[i])
+         sthread_join(threads[i]);
+      else
+         core_info_parse_worker(&jobs[i]);
    }
+#endif
 }
 
 void core_info_get_name(const char *path, char *s, size_t len)
 {
    size_t i;
-   core_info_t *core_info = NULL;
-   core_info_list_t *core_info_list = NULL;
-   settings_t *settings = config_get_ptr();
    struct string_list *contents = dir_list_new_special(NULL, DIR_LIST_CORES);
 
    if (!contents)
       return;
 
-   core_info_list = (core_info_list_t*)calloc(1, sizeof(*core_info_list));
-   if (!core_info_list)
-      goto error;
-
-   core_info = (core_info_t*)calloc(contents->size, sizeof(*core_info));
-   if (!core_info)
-      goto error;
-
-   core_info_list->list = core_info;
-   core_info_list->count = contents->size;
-
    for (i = 0; i < contents->size; i++)
    {
-      char info_path_base[PATH_MAX_LENGTH] = {0};
-      char info_path[PATH_MAX_LENGTH]      = {0};
-
-      core_info[i].path = strdup(contents->elems[i].data);
+      char info_path[PATH_MAX_LENGTH] = {0};
+      char *core_name                 = NULL;
+      config_file_t *conf             = NULL;
 
-      if (!core_info[i].path)
-         break;
-
-      if (strcmp(core_info[i].path, path) != 0)
+      if (strcmp(contents->elems[i].data, path) != 0)
             continue;
 
-      fill_pathname_base(info_path_base, contents->elems[i].data,
-            sizeof(info_path_base));
-      path_remove_extension(info_path_base);
-
-#if defined(RARCH_MOBILE) || (defined(RARCH_CONSOLE) && !defined(PSP))
-      char *substr = strrchr(info_path_base, '_');
-      if (substr)
-         *substr = '\0';
-#endif
-
-      strlcat(info_path_base, ".info", sizeof(info_path_base));
-
-      fill_pathname_join(info_path, (*settings->libretro_info_path) ?
-            settings->libretro_info_path : settings->libretro_directory,
-            info_path_base, sizeof(info_path));
+      core_info_get_info_path(contents->elems[i].data,
+            info_path, sizeof(info_path));
 
-      core_info[i].data = config_file_new(info_path);
+      conf = config_file_new(info_path);
 
-      if (core_info[i].data)
-         config_get_string(core_info[i].data, "corename",
-               &core_info[i].core_name);
+      if (conf)
+      {
+         config_get_string(conf, "corename", &core_name);
+         config_file_free(conf);
+      }
 
-      strlcpy(s, core_info[i].core_name, len);
+      if (core_name)
+         strlcpy(s, core_name, len);
+      free(core_name);
    }
 
-error:
-   if (contents)
-      dir_list_free(contents);
-   contents = NULL;
-   core_info_list_free(core_info_list);
+   dir_list_free(contents);
 }
 
 core_info_list_t *core_info_list_new(void)
 {
-   size_t i;
-   core_info_t *core_info = NULL;
+   size_t i, num_stale = 0;
+   char cache_path[PATH_MAX_LENGTH] = {0};
+   core_info_t *core_info           = NULL;
    core_info_list_t *core_info_list = NULL;
-   settings_t *settings = config_get_ptr();
-   struct string_list *contents = dir_list_new_special(NULL, DIR_LIST_CORES);
+   core_info_cache_key_t *keys      = NULL;
+   size_t *stale                    = NULL;
+   core_info_cache_t *cache         = NULL;
+   settings_t *settings             = config_get_ptr();
+   struct string_list *contents     = dir_list_new_special(NULL, DIR_LIST_CORES);
 
    if (!contents)
       return NULL;
@@ -191,102 +465,76 @@ core_info_list_t *core_info_list_new(void)
    core_info_list->list = core_info;
    core_info_list->count = contents->size;
 
+   keys  = (core_info_cache_key_t*)calloc(contents->size + 1, sizeof(*keys));
+   stale = (size_t*)calloc(contents->size + 1, sizeof(*stale));
+   if (!keys || !stale)
+      goto error;
+
+   fill_pathname_join(cache_path, (*settings->libretro_info_path) ?
+         settings->libretro_info_path : settings->libretro_directory,
+         CORE_INFO_CACHE_FILE, sizeof(cache_path));
+
+   cache = core_info_cache_open(cache_path);
+
    for (i = 0; i < contents->size; i++)
    {
-      char info_path_base[PATH_MAX_LENGTH] = {0};
-      char info_path[PATH_MAX_LENGTH]      = {0};
+      char info_path[PATH_MAX_LENGTH] = {0};
       core_info[i].path = strdup(contents->elems[i].data);
 
       if (!core_info[i].path)
          break;
 
-      fill_pathname_base(info_path_base, contents->elems[i].data,
-            sizeof(info_path_base));
-      path_remove_extension(info_path_base);
+      core_info_get_info_path(core_info[i].path, info_path, sizeof(info_path));
 
-#if defined(RARCH_MOBILE) || (defined(RARCH_CONSOLE) && !defined(PSP))
-      char *substr = strrchr(info_path_base, '_');
-      if (substr)
-         *substr = '\0';
-#endif
+      if (!core_info_cache_key_init(&keys[i], info_path))
+         continue;
 
-      strlcat(info_path_base, ".info", sizeof(info_path_base));
+      if (!core_info_cache_get(cache, &keys[i], i, &core_info[i]))
+         stale[num_stale++] = i;
+   }
 
-      fill_pathname_join(info_path, (*settings->libretro_info_path) ?
-            settings->libretro_info_path : settings->libretro_directory,
-            info_path_base, sizeof(info_path));
+   core_info_cache_close(cache);
 
-      core_info[i].data = config_file_new(info_path);
+   if (num_stale)
+   {
+      RARCH_LOG("Parsing %u of %u core info files.\n",
+            (unsigned)num_stale, (unsigned)contents->size);
 
-      if (core_info[i].data)
-      {
-         unsigned count = 0;
-         config_get_string(core_info[i].data, "display_name",
-               &core_info[i].display_name);
-         config_get_string(core_info[i].data, "corename",
-               &core_info[i].core_name);
-         config_get_string(core_info[i].data, "systemname",
-               &core_info[i].systemname);
-         config_get_string(core_info[i].data, "manufacturer",
-               &core_info[i].system_manufacturer);
-         config_get_uint(core_info[i].data, "firmware_count", &count);
-         core_info[i].firmware_count = count;
-         if (config_get_string(core_info[i].data, "supported_extensions",
-                  &core_info[i].supported_extensions) &&
-               core_info[i].supported_extensions)
-            core_info[i].supported_extensions_list =
-               string_split(core_info[i].supported_extensions, "|");
-
-         if (config_get_string(core_info[i].data, "authors",
-                  &core_info[i].authors) &&
-               core_info[i].authors)
-            core_info[i].authors_list =
-               string_split(core_info[i].authors, "|");
-
-         if (config_get_string(core_info[i].data, "permissions",
-                  &core_info[i].permissions) &&
-               core_info[i].permissions)
-            core_info[i].permissions_list =
-               string_split(core_info[i].permissions, "|");
-
-         if (config_get_string(core_info[i].data, "license",
-                  &core_info[i].licenses) &&
-               core_info[i].licenses)
-            core_info[i].licenses_list =
-               string_split(core_info[i].licenses, "|");
-
-         if (config_get_string(core_info[i].data, "categories",
-                  &core_info[i].categories) &&
-               core_info[i].categories)
-            core_info[i].categories_list =
-               string_split(core_info[i].categories, "|");
-
-         if (config_get_string(core_info[i].data, "database",
-                  &core_info[i].databases) &&
-               core_info[i].databases)
-            core_info[i].databases_list =
-               string_split(core_info[i].databases, "|");
-
-         if (config_get_string(core_info[i].data, "notes",
-                  &core_info[i].notes) &&
-               core_info[i].notes)
-            core_info[i].note_list = string_split(core_info[i].notes, "|");
-
-         config_get_bool(core_info[i].data, "supports_no_game",
-               &core_info[i].supports_no_game);
-      }
+      core_info_parse_stale(core_info, keys, stale, num_stale);
+
+      if (!core_info_cache_write(cache_path, core_info, keys, contents->size))
+         RARCH_WARN("Failed to write core info cache: %s.\n", cache_path);
+   }
+
+   for (i = 0; i < contents->size; i++)
+   {
+      if (!core_info[i].path)
+         break;
+
+      core_info_split_lists(&core_info[i]);
 
       if (!core_info[i].display_name)
          core_info[i].display_name = strdup(path_basename(core_info[i].path));
    }
 
    core_info_list_resolve_all_extensions(core_info_list);
-   core_info_list_resolve_all_firmware(core_info_list);
+   core_info_list->ext_index = core_info_ext_index_new(core_info_list);
 
+   for (i = 0; i < contents->size; i++)
+      free(keys[i].info_path);
+   free(keys);
+   free(stale);
    dir_list_free(contents);
    return core_info_list;
 
 error:
+   if (keys)
+   {
+      for (i = 0; i < contents->size; i++)
+         free(keys[i].info_path);
+   }
+   free(keys);
+   free(stale);
    if (contents)
       dir_list_free(contents);
    core_info_list_free(core_info_list);
@@ -327,7 +575,6 @@ void core_info_list_free(core_info_list_t *core_info_list)
       string_list_free(info->licenses_list);
       string_list_free(info->categories_list);
       string_list_free(info->databases_list);
-      config_file_free(info->data);
 
       for (j = 0; j < info->firmware_count; j++)
       {
@@ -337,6 +584,7 @@ void core_info_list_free(core_info_list_t *core_info_list)
       free(info->firmware);
    }
 
+   core_info_ext_index_free(core_info_list->ext_index);
    free(core_info_list->all_ext);
    free(core_info_list->list);
    free(core_info_list);
@@ -350,7 +598,7 @@ size_t core_info_list_num_info_files(core_info_list_t *core_info_list)
       return 0;
 
    for (i = 0; i < core_info_list->count; i++)
-      num += !!core_info_list->list[i].data;
+      num += core_info_list->list[i].has_info;
 
    return num;
 }
@@ -469,69 +717,111 @@ const char *core_info_list_get_all_extensions(core_info_list_t *core_info_list)
 }
 
 /* qsort_r() is not in standard C, sadly. */
-static const char *core_info_tmp_path;
-static const struct string_list *core_info_tmp_list;
+static const char **core_info_tmp_supported;
+static size_t core_info_tmp_num_supported;
+
+static int core_info_path_ptr_cmp(const void *a_, const void *b_)
+{
+   const char *a = *(const char* const*)a_;
+   const char *b = *(const char* const*)b_;
+
+   return (a > b) - (a < b);
+}
+
+static bool core_info_tmp_is_supported(const core_info_t *info)
+{
+   return core_info_tmp_num_supported && bsearch(&info->path,
+         core_info_tmp_supported, core_info_tmp_num_supported,
+         sizeof(*core_info_tmp_supported), core_info_path_ptr_cmp);
+}
 
 static int core_info_qsort_cmp(const void *a_, const void *b_)
 {
    const core_info_t *a = (const core_info_t*)a_;
    const core_info_t *b = (const core_info_t*)b_;
-   int support_a        = core_info_does_support_any_file(a, core_info_tmp_list) ||
-      core_info_does_support_file(a, core_info_tmp_path);
-   int support_b        = core_info_does_support_any_file(b, core_info_tmp_list) ||
-      core_info_does_support_file(b, core_info_tmp_path);
+   int support_a        = core_info_tmp_is_supported(a);
+   int support_b        = core_info_tmp_is_supported(b);
 
    if (support_a != support_b)
       return support_b - support_a;
    return strcasecmp(a->display_name, b->display_name);
 }
 
+static void core_info_add_supported(const struct core_info_ext_index *index,
+      const char *path, const char ***cores, size_t *num, size_t *capacity)
+{
+   const struct core_info_ext_bucket *bucket =
+      core_info_ext_index_find(index, path_get_extension(path), false);
+
+   if (!bucket)
+      return;
+
+   if (*num + bucket->count > *capacity)
+   {
+      size_t new_capacity = (*num + bucket->count) * 2;
+      const char **tmp    = (const char**)realloc((void*)*cores,
+            new_capacity * sizeof(*tmp));
+
+      if (!tmp)
+         return;
+
+      *cores    = tmp;
+      *capacity = new_capacity;
+   }
+
+   memcpy((void*)(*cores + *num), bucket->cores,
+         bucket->count * sizeof(*bucket->cores));
+   *num += bucket->count;
+}
+
 void core_info_list_get_supported_cores(core_info_list_t *core_info_list,
       const char *path, const core_info_t **infos, size_t *num_infos)
 {
    struct string_list *list = NULL;
-   size_t supported = 0, i;
+   const char **cores       = NULL;
+   size_t num_cores = 0, capacity = 0;
+   size_t supported = 0;
 
    if (!core_info_list)
       return;
 
    (void)list;
 
-   core_info_tmp_path = path;
+   core_info_add_supported(core_info_list->ext_index, path,
+         &cores, &num_cores, &capacity);
 
 #ifdef HAVE_ZLIB
    if (!strcasecmp(path_get_extension(path), "zip"))
       list = zlib_get_file_list(path, NULL);
-   core_info_tmp_list = list;
+
+   if (list)
+   {
+      size_t i;
+      for (i = 0; i < list->size; i++)
+         core_info_add_supported(core_info_list->ext_index,
+               list->elems[i].data, &cores, &num_cores, &capacity);
+      string_list_free(list);
+   }
 #endif
 
+   if (num_cores)
+      qsort((void*)cores, num_cores, sizeof(*cores), core_info_path_ptr_cmp);
+
+   core_info_tmp_supported     = cores;
+   core_info_tmp_num_supported = num_cores;
+
    /* Let supported core come first in list so we can return 
     * a pointer to them. */
    qsort(core_info_list->list, core_info_list->count,
          sizeof(core_info_t), core_info_qsort_cmp);
 
-   for (i = 0; i < core_info_list->count; i++, supported++)
-   {
-      const core_info_t *core = &core_info_list->list[i];
+   while (supported < core_info_list->count &&
+         core_info_tmp_is_supported(&core_info_list->list[supported]))
+      supported++;
 
-      if (!core)
-         continue;
-
-      if (core_info_does_support_file(core, path))
-         continue;
-
-#ifdef HAVE_ZLIB
-      if (core_info_does_support_any_file(core, list))
-         continue;
-#endif
-
-      break;
-   }
-
-#ifdef HAVE_ZLIB
-   if (list)
-      string_list_free(list);
-#endif
+   core_info_tmp_supported     = NULL;
+   core_info_tmp_num_supported = 0;
+   free((void*)cores);
 
    *infos = core_info_list->list;
    *num_infos = supported;
@@ -38,7 +38,8 @@ typedef struct
 typedef struct
 {
    char *path;
-   config_file_t *data;
+   /* Set if the .info file of the core was read. */
+   bool has_info;
    char *display_name;
    char *core_name;
    char *system_manufacturer;
@@ -69,6 +70,7 @@ typedef struct
    core_info_t *list;
    size_t count;
    char *all_ext;
+   struct core_info_ext_index *ext_index;
 } core_info_list_t;
 
 core_info_list_t *core_info_list_new(void);
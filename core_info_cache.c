@@ -0,0 +1,480 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <rhash.h>
+
+#include "core_info_cache.h"
+#include "file_ops.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* Binary cache of parsed .info files.
+ *
+ * Layout (native endianness, it is never shared between machines):
+ *   core_info_cache_header_t
+ *   core_info_cache_entry_t    [header.count]
+ *   core_info_cache_firmware_t [header.firmware_count]
+ *   string table               [header.strings_size]
+ *
+ * Strings are stored as offsets into the string table,
+ * offset 0 is the empty string and stands for NULL.
+ */
+
+#define CORE_INFO_CACHE_MAGIC   0x43494352 /* "RCIC" */
+#define CORE_INFO_CACHE_VERSION 2
+
+typedef struct core_info_cache_header
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t count;
+   uint32_t firmware_count;
+   uint32_t strings_size;
+   /* Keeps the 64-bit fields of the entries, which are read in
+    * place right after the header, aligned. */
+   uint32_t reserved;
+} core_info_cache_header_t;
+
+/* Fails to compile if the header breaks entry alignment. */
+typedef char core_info_cache_header_aligned[
+   (sizeof(core_info_cache_header_t) % 8 == 0) ? 1 : -1];
+
+/* String members of core_info_t stored in the cache. */
+static const size_t core_info_cache_strings[] = {
+   offsetof(core_info_t, display_name),
+   offsetof(core_info_t, core_name),
+   offsetof(core_info_t, system_manufacturer),
+   offsetof(core_info_t, systemname),
+   offsetof(core_info_t, supported_extensions),
+   offsetof(core_info_t, authors),
+   offsetof(core_info_t, permissions),
+   offsetof(core_info_t, licenses),
+   offsetof(core_info_t, categories),
+   offsetof(core_info_t, databases),
+   offsetof(core_info_t, notes),
+};
+
+#define CORE_INFO_CACHE_STRINGS (sizeof(core_info_cache_strings) / sizeof(core_info_cache_strings[0]))
+
+typedef struct core_info_cache_entry
+{
+   uint64_t size;
+   int64_t mtime;
+   uint32_t hash;
+   uint32_t info_path;
+   uint32_t strings[CORE_INFO_CACHE_STRINGS];
+   uint32_t firmware;
+   uint32_t firmware_count;
+   uint32_t supports_no_game;
+} core_info_cache_entry_t;
+
+typedef char core_info_cache_entry_aligned[
+   (sizeof(core_info_cache_entry_t) % 8 == 0) ? 1 : -1];
+
+typedef struct core_info_cache_firmware
+{
+   uint32_t path;
+   uint32_t desc;
+   uint32_t optional;
+} core_info_cache_firmware_t;
+
+struct core_info_cache
+{
+   uint8_t *data;
+   size_t size;
+#ifdef HAVE_MMAP
+   int fd;
+#endif
+
+   const core_info_cache_header_t *header;
+   const core_info_cache_entry_t *entries;
+   const core_info_cache_firmware_t *firmware;
+   const char *strings;
+};
+
+bool core_info_cache_key_init(core_info_cache_key_t *key,
+      const char *info_path)
+{
+   struct stat st;
+
+   memset(key, 0, sizeof(*key));
+
+   if (stat(info_path, &st) < 0)
+      return false;
+
+   key->info_path = strdup(info_path);
+   key->size      = st.st_size;
+   key->mtime     = st.st_mtime;
+
+   return key->info_path != NULL;
+}
+
+void core_info_cache_close(core_info_cache_t *cache)
+{
+   if (!cache)
+      return;
+
+#ifdef HAVE_MMAP
+   if (cache->fd >= 0)
+   {
+      if (cache->data)
+         munmap(cache->data, cache->size);
+      close(cache->fd);
+   }
+   else
+#endif
+      free(cache->data);
+
+   free(cache);
+}
+
+static bool core_info_cache_validate(core_info_cache_t *cache)
+{
+   size_t i, j, entries_size, firmware_size;
+   const core_info_cache_header_t *header =
+      (const core_info_cache_header_t*)cache->data;
+
+   if (cache->size < sizeof(*header))
+      return false;
+   if (header->magic != CORE_INFO_CACHE_MAGIC
+         || header->version != CORE_INFO_CACHE_VERSION)
+      return false;
+
+   entries_size  = (size_t)header->count * sizeof(core_info_cache_entry_t);
+   firmware_size = (size_t)header->firmware_count
+      * sizeof(core_info_cache_firmware_t);
+
+   if (cache->size != sizeof(*header) + entries_size + firmware_size
+         + header->strings_size || !header->strings_size)
+      return false;
+
+   cache->header   = header;
+   cache->entries  = (const core_info_cache_entry_t*)(header + 1);
+   cache->firmware = (const core_info_cache_firmware_t*)
+      ((const uint8_t*)cache->entries + entries_size);
+   cache->strings  = (const char*)cache->firmware + firmware_size;
+
+   /* All strings must be terminated within the table. */
+   if (cache->strings[header->strings_size - 1] != '\0')
+      return false;
+
+   for (i = 0; i < header->count; i++)
+   {
+      const core_info_cache_entry_t *entry = &cache->entries[i];
+
+      if (entry->info_path >= header->strings_size)
+         return false;
+      for (j = 0; j < CORE_INFO_CACHE_STRINGS; j++)
+         if (entry->strings[j] >= header->strings_size)
+            return false;
+      if (entry->firmware > header->firmware_count ||
+            entry->firmware_count > header->firmware_count - entry->firmware)
+         return false;
+   }
+
+   for (i = 0; i < header->firmware_count; i++)
+   {
+      if (cache->firmware[i].path >= header->strings_size ||
+            cache->firmware[i].desc >= header->strings_size)
+         return false;
+   }
+
+   return true;
+}
+
+core_info_cache_t *core_info_cache_open(const char *path)
+{
+   core_info_cache_t *cache = (core_info_cache_t*)
+      calloc(1, sizeof(*cache));
+
+   if (!cache)
+      return NULL;
+
+#ifdef HAVE_MMAP
+   {
+      struct stat st;
+
+      cache->fd = open(path, O_RDONLY);
+      if (cache->fd < 0)
+         goto error;
+
+      if (fstat(cache->fd, &st) < 0 || !st.st_size)
+         goto error;
+
+      cache->size = st.st_size;
+      cache->data = (uint8_t*)mmap(NULL, cache->size,
+            PROT_READ, MAP_SHARED, cache->fd, 0);
+
+      if (cache->data == MAP_FAILED)
+      {
+         cache->data = NULL;
+         goto error;
+      }
+   }
+#else
+   {
+      ssize_t len = 0;
+      void *buf   = NULL;
+
+      if (!read_file(path, &buf, &len) || len <= 0)
+      {
+         free(buf);
+         goto error;
+      }
+
+      cache->data = (uint8_t*)buf;
+      cache->size = len;
+   }
+#endif
+
+   if (!core_info_cache_validate(cache))
+      goto error;
+
+   return cache;
+
+error:
+   core_info_cache_close(cache);
+   return NULL;
+}
+
+static char *core_info_cache_strdup(const core_info_cache_t *cache,
+      uint32_t offset)
+{
+   if (!offset)
+      return NULL;
+   return strdup(cache->strings + offset);
+}
+
+static const core_info_cache_entry_t *core_info_cache_find(
+      const core_info_cache_t *cache, const char *info_path, size_t hint)
+{
+   size_t i;
+   uint32_t hash = djb2_calculate(info_path);
+
+   /* Entries are usually in the same order as the core directory. */
+   if (hint < cache->header->count
+         && cache->entries[hint].hash == hash
+         && !strcmp(cache->strings + cache->entries[hint].info_path, info_path))
+      return &cache->entries[hint];
+
+   for (i = 0; i < cache->header->count; i++)
+   {
+      const core_info_cache_entry_t *entry = &cache->entries[i];
+
+      if (entry->hash == hash
+            && !strcmp(cache->strings + entry->info_path, info_path))
+         return entry;
+   }
+
+   return NULL;
+}
+
+bool core_info_cache_get(core_info_cache_t *cache,
+      const core_info_cache_key_t *key, size_t hint, core_info_t *info)
+{
+   size_t i;
+   const core_info_cache_entry_t *entry = NULL;
+
+   if (!cache || !key->info_path)
+      return false;
+
+   entry = core_info_cache_find(cache, key->info_path, hint);
+
+   if (!entry || entry->size != key->size || entry->mtime != key->mtime)
+      return false;
+
+   for (i = 0; i < CORE_INFO_CACHE_STRINGS; i++)
+      *(char**)((uint8_t*)info + core_info_cache_strings[i]) =
+         core_info_cache_strdup(cache, entry->strings[i]);
+
+   info->supports_no_game = entry->supports_no_game;
+   info->firmware_count   = entry->firmware_count;
+
+   if (entry->firmware_count)
+   {
+      info->firmware = (core_info_firmware_t*)
+         calloc(entry->firmware_count, sizeof(*info->firmware));
+
+      for (i = 0; info->firmware && i < entry->firmware_count; i++)
+      {
+         const core_info_cache_firmware_t *fw =
+            &cache->firmware[entry->firmware + i];
+
+         info->firmware[i].path     = core_info_cache_strdup(cache, fw->path);
+         info->firmware[i].desc     = core_info_cache_strdup(cache, fw->desc);
+         info->firmware[i].optional = fw->optional;
+      }
+   }
+
+   info->has_info = true;
+
+   return true;
+}
+
+typedef struct core_info_cache_buffer
+{
+   char *data;
+   size_t size;
+   size_t capacity;
+} core_info_cache_buffer_t;
+
+static uint32_t core_info_cache_add_string(
+      core_info_cache_buffer_t *buf, const char *str)
+{
+   size_t offset, len;
+
+   if (!str || !*str)
+      return 0;
+
+   len = strlen(str) + 1;
+
+   if (buf->size + len > buf->capacity)
+   {
+      size_t capacity = (buf->capacity + len) * 2;
+      char *data      = (char*)realloc(buf->data, capacity);
+
+      if (!data)
+         return 0;
+
+      buf->data     = data;
+      buf->capacity = capacity;
+   }
+
+   offset = buf->size;
+   memcpy(buf->data + offset, str, len);
+   buf->size += len;
+
+   return offset;
+}
+
+bool core_info_cache_write(const char *path, const core_info_t *list,
+      const core_info_cache_key_t *keys, size_t count)
+{
+   size_t i, j, size;
+   uint8_t *data                        = NULL;
+   core_info_cache_header_t header      = {0};
+   core_info_cache_entry_t *entries     = NULL;
+   core_info_cache_firmware_t *firmware = NULL;
+   core_info_cache_buffer_t strings     = {0};
+   bool ret                             = false;
+
+   for (i = 0; i < count; i++)
+   {
+      if (!list[i].has_info || !keys[i].info_path)
+         continue;
+      header.count++;
+      if (list[i].firmware)
+         header.firmware_count += list[i].firmware_count;
+   }
+
+   entries  = (core_info_cache_entry_t*)
+      calloc(header.count + 1, sizeof(*entries));
+   firmware = (core_info_cache_firmware_t*)
+      calloc(header.firmware_count + 1, sizeof(*firmware));
+
+   if (!entries || !firmware)
+      goto end;
+
+   /* Offset 0 is reserved for NULL. */
+   strings.data     = (char*)calloc(1, 4096);
+   strings.capacity = 4096;
+   strings.size     = 1;
+   if (!strings.data)
+      goto end;
+
+   header.count          = 0;
+   header.firmware_count = 0;
+
+   for (i = 0; i < count; i++)
+   {
+      core_info_cache_entry_t *entry = NULL;
+      const core_info_t *info        = &list[i];
+
+      if (!info->has_info || !keys[i].info_path)
+         continue;
+
+      entry            = &entries[header.count++];
+      entry->size      = keys[i].size;
+      entry->mtime     = keys[i].mtime;
+      entry->hash      = djb2_calculate(keys[i].info_path);
+      entry->info_path = core_info_cache_add_string(&strings,
+            keys[i].info_path);
+
+      for (j = 0; j < CORE_INFO_CACHE_STRINGS; j++)
+         entry->strings[j] = core_info_cache_add_string(&strings,
+               *(char* const*)((const uint8_t*)info + core_info_cache_strings[j]));
+
+      entry->supports_no_game = info->supports_no_game;
+      entry->firmware         = header.firmware_count;
+
+      if (!info->firmware)
+         continue;
+
+      entry->firmware_count   = info->firmware_count;
+
+      for (j = 0; j < info->firmware_count; j++)
+      {
+         core_info_cache_firmware_t *fw = &firmware[header.firmware_count++];
+
+         fw->path     = core_info_cache_add_string(&strings,
+               info->firmware[j].path);
+         fw->desc     = core_info_cache_add_string(&strings,
+               info->firmware[j].desc);
+         fw->optional = info->firmware[j].optional;
+      }
+   }
+
+   header.magic        = CORE_INFO_CACHE_MAGIC;
+   header.version      = CORE_INFO_CACHE_VERSION;
+   header.strings_size = strings.size;
+
+   size = sizeof(header)
+      + header.count * sizeof(*entries)
+      + header.firmware_count * sizeof(*firmware)
+      + strings.size;
+
+   data = (uint8_t*)malloc(size);
+   if (!data)
+      goto end;
+
+   memcpy(data, &header, sizeof(header));
+   memcpy(data + sizeof(header), entries,
+         header.count * sizeof(*entries));
+   memcpy(data + sizeof(header) + header.count * sizeof(*entries),
+         firmware, header.firmware_count * sizeof(*firmware));
+   memcpy(data + size - strings.size, strings.data, strings.size);
+
+   ret = write_file(path, data, size);
+
+end:
+   free(data);
+   free(strings.data);
+   free(firmware);
+   free(entries);
+   return ret;
+}
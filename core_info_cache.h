@@ -0,0 +1,97 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_INFO_CACHE_H_
+#define CORE_INFO_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <boolean.h>
+
+#include "core_info.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CORE_INFO_CACHE_FILE "core_info.cache"
+
+/* Identifies the .info file a core_info_t was parsed from. */
+typedef struct core_info_cache_key
+{
+   char *info_path;
+   uint64_t size;
+   int64_t mtime;
+} core_info_cache_key_t;
+
+typedef struct core_info_cache core_info_cache_t;
+
+/**
+ * core_info_cache_key_init:
+ * @key                : Key to initialize.
+ * @info_path          : Path to .info file.
+ *
+ * Returns: true (1) if @info_path exists, otherwise false (0).
+ **/
+bool core_info_cache_key_init(core_info_cache_key_t *key,
+      const char *info_path);
+
+/**
+ * core_info_cache_open:
+ * @path               : Path to cache file.
+ *
+ * Maps a core info cache written by core_info_cache_write().
+ *
+ * Returns: handle to the cache, NULL if it does not exist or is invalid.
+ **/
+core_info_cache_t *core_info_cache_open(const char *path);
+
+void core_info_cache_close(core_info_cache_t *cache);
+
+/**
+ * core_info_cache_get:
+ * @cache              : Cache handle.
+ * @key                : .info file to look up.
+ * @hint               : Index the entry was expected at.
+ * @info               : Core info to fill in.
+ *
+ * Fills in all strings and firmware of @info from the cache,
+ * if the cached entry of @key matches its size and mtime.
+ * String lists are left to the caller.
+ *
+ * Returns: true (1) on a cache hit, otherwise false (0).
+ **/
+bool core_info_cache_get(core_info_cache_t *cache,
+      const core_info_cache_key_t *key, size_t hint, core_info_t *info);
+
+/**
+ * core_info_cache_write:
+ * @path               : Path to cache file.
+ * @list               : Core infos.
+ * @keys               : .info file of every entry in @list.
+ * @count              : Number of entries in @list.
+ *
+ * Writes all core infos which were read from an .info file to @path.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool core_info_cache_write(const char *path, const core_info_t *list,
+      const core_info_cache_key_t *keys, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -14,6 +14,8 @@ extern "C" {
 #include <libswscale/swscale.h>
 #include <libavutil/time.h>
 #include <libavutil/opt.h>
+#include <libavutil/cpu.h>
+#include <libavutil/pixdesc.h>
 #include <libavdevice/avdevice.h>
 #include <libswresample/swresample.h>
 #ifdef HAVE_SSA
@@ -113,7 +115,6 @@ static double pts_bias;
 
 /* Threaded FIFOs. */
 static volatile bool decode_thread_dead;
-static fifo_buffer_t *video_decode_fifo;
 static fifo_buffer_t *audio_decode_fifo;
 static scond_t *fifo_cond;
 static scond_t *fifo_decode_cond;
@@ -127,6 +128,369 @@ static uint32_t *video_frame_temp_buffer;
 
 static bool main_sleeping;
 
+/* Decoded video frames. The video decode thread converts each frame
+ * once, straight into a free slot, and retro_run() hands the slot to
+ * video_cb by pointer. Frames which the decoder already outputs as
+ * RGB32 are not converted at all; the slot keeps a reference to the
+ * decoder's frame instead.
+ *
+ * Slots from video_frames_read on, video_frames_count of them, are
+ * owned by the main thread, the rest by the video decode thread.
+ * While video_frames_shown is set, the main thread also owns the slot
+ * right before video_frames_read. It holds the frame last passed to
+ * video_cb, which the frontend may use until the next retro_run().
+ * All of them are protected by fifo_lock. */
+#define VIDEO_FRAME_RING_SIZE 32
+
+struct video_frame
+{
+   int64_t pts;
+   uint32_t *data;
+   AVFrame *direct;
+   bool is_direct;
+};
+
+static struct video_frame video_frames[VIDEO_FRAME_RING_SIZE];
+static unsigned video_frames_read;
+static unsigned video_frames_count;
+static bool video_frames_shown;
+
+/* Demux and decode pipeline. The decode thread demuxes, and hands
+ * packets to a video and an audio decode thread through bounded
+ * queues. Subtitles are decoded on the video thread, which renders
+ * them. */
+#define VIDEO_PACKET_QUEUE_SIZE 64
+#define AUDIO_PACKET_QUEUE_SIZE 256
+#define MAX_DECODE_THREADS 16
+#define MAX_SWS_SLICES 8
+
+/* Slices start on multiples of this, to keep subsampled chroma
+ * rows whole. */
+#define SWS_SLICE_ALIGN 16
+
+enum packet_type
+{
+   PACKET_DATA = 0,
+   /* Flush the decoder, queued by seeking. */
+   PACKET_FLUSH,
+   /* No more packets, drain the decoder and stop. */
+   PACKET_EOF
+};
+
+struct queued_packet
+{
+   AVPacket pkt;
+   enum packet_type type;
+};
+
+struct packet_queue
+{
+   struct queued_packet *packets;
+   unsigned size;
+   unsigned first;
+   unsigned count;
+   unsigned flushes_queued;
+   unsigned flushes_done;
+   bool abort;
+   slock_t *lock;
+   scond_t *cond;
+   struct retro_perf_counter *depth;
+};
+
+static struct packet_queue video_packets;
+static struct packet_queue audio_packets;
+
+/* Converts frames to RGB32 in horizontal slices, each with its own
+ * SwsContext. The calling thread does the first slice. */
+struct sws_pool;
+
+struct sws_slice
+{
+   struct sws_pool *pool;
+   struct SwsContext *sws;
+   sthread_t *thread;
+   unsigned y;
+   unsigned height;
+};
+
+struct sws_pool
+{
+   struct sws_slice slices[MAX_SWS_SLICES];
+   unsigned num;
+   int chroma_shift;
+   slock_t *lock;
+   scond_t *cond;
+   scond_t *done_cond;
+   unsigned generation;
+   unsigned pending;
+   bool dead;
+   const AVFrame *src;
+   AVFrame *dst;
+};
+
+static struct retro_perf_callback perf_cb;
+
+/* Time spent in each stage. The queue counters instead add up the
+ * depth of their queue at every packet, so their average is the
+ * average depth. */
+static struct retro_perf_counter ffmpeg_demux            = { "ffmpeg_demux" };
+static struct retro_perf_counter ffmpeg_video_decode     = { "ffmpeg_video_decode" };
+static struct retro_perf_counter ffmpeg_video_scale      = { "ffmpeg_video_scale" };
+static struct retro_perf_counter ffmpeg_audio_decode     = { "ffmpeg_audio_decode" };
+static struct retro_perf_counter ffmpeg_video_queue      = { "ffmpeg_video_queue" };
+static struct retro_perf_counter ffmpeg_audio_queue      = { "ffmpeg_audio_queue" };
+
+#define FFMPEG_PERF_START(counter) do { \
+   if (perf_cb.perf_start) \
+      perf_cb.perf_start(&(counter)); \
+} while(0)
+
+#define FFMPEG_PERF_STOP(counter) do { \
+   if (perf_cb.perf_stop) \
+      perf_cb.perf_stop(&(counter)); \
+} while(0)
+
+static unsigned decode_threads(void)
+{
+   int threads = av_cpu_count();
+
+   if (threads < 1)
+      return 1;
+   if (threads > MAX_DECODE_THREADS)
+      return MAX_DECODE_THREADS;
+   return threads;
+}
+
+static bool packet_queue_init(struct packet_queue *queue, unsigned size,
+      struct retro_perf_counter *depth)
+{
+   memset(queue, 0, sizeof(*queue));
+
+   queue->packets = (struct queued_packet*)
+      av_mallocz(size * sizeof(*queue->packets));
+   queue->size    = size;
+   queue->lock    = slock_new();
+   queue->cond    = scond_new();
+   queue->depth   = depth;
+
+   return queue->packets && queue->lock && queue->cond;
+}
+
+static void packet_queue_clear_locked(struct packet_queue *queue)
+{
+   unsigned i, count = 0;
+
+   /* Drops the packets, but keeps markers in order, a flush
+    * is waited for. */
+   for (i = 0; i < queue->count; i++)
+   {
+      struct queued_packet *packet = &queue->packets[
+         (queue->first + i) % queue->size];
+
+      if (packet->type == PACKET_DATA)
+         av_free_packet(&packet->pkt);
+      else
+         queue->packets[(queue->first + count++) % queue->size] = *packet;
+   }
+
+   queue->count = count;
+   scond_broadcast(queue->cond);
+}
+
+static void packet_queue_clear(struct packet_queue *queue)
+{
+   if (!queue->lock)
+      return;
+
+   slock_lock(queue->lock);
+   packet_queue_clear_locked(queue);
+   slock_unlock(queue->lock);
+}
+
+static void packet_queue_free(struct packet_queue *queue)
+{
+   if (queue->lock)
+      packet_queue_clear(queue);
+
+   av_freep(&queue->packets);
+   if (queue->cond)
+      scond_free(queue->cond);
+   if (queue->lock)
+      slock_free(queue->lock);
+
+   memset(queue, 0, sizeof(*queue));
+}
+
+/**
+ * packet_queue_abort:
+ * @queue              : packet queue.
+ *
+ * Wakes up and fails everything waiting on @queue, for
+ * shutting down the pipeline.
+ **/
+static void packet_queue_abort(struct packet_queue *queue)
+{
+   if (!queue->lock)
+      return;
+
+   slock_lock(queue->lock);
+   queue->abort = true;
+   scond_broadcast(queue->cond);
+   slock_unlock(queue->lock);
+}
+
+/**
+ * packet_queue_put:
+ * @queue              : packet queue.
+ * @pkt                : packet to queue, owned by the queue afterwards.
+ *                       Ignored for markers.
+ * @type               : packet or marker.
+ *
+ * Waits for room in @queue if it is full.
+ *
+ * Returns: false if the queue was aborted, otherwise true.
+ **/
+static bool packet_queue_put(struct packet_queue *queue,
+      AVPacket *pkt, enum packet_type type)
+{
+   struct queued_packet *packet = NULL;
+
+   slock_lock(queue->lock);
+
+   while (!queue->abort && queue->count == queue->size)
+      scond_wait(queue->cond, queue->lock);
+
+   if (queue->abort)
+   {
+      slock_unlock(queue->lock);
+      if (type == PACKET_DATA)
+         av_free_packet(pkt);
+      return false;
+   }
+
+   packet       = &queue->packets[
+      (queue->first + queue->count++) % queue->size];
+   packet->type = type;
+
+   if (type == PACKET_DATA)
+      packet->pkt = *pkt;
+   else
+      av_init_packet(&packet->pkt);
+
+   if (type == PACKET_FLUSH)
+      queue->flushes_queued++;
+
+   if (queue->depth)
+   {
+      queue->depth->total += queue->count;
+      queue->depth->call_cnt++;
+   }
+
+   scond_broadcast(queue->cond);
+   slock_unlock(queue->lock);
+   return true;
+}
+
+/**
+ * packet_queue_get:
+ * @queue              : packet queue.
+ * @pkt                : filled with the packet, to be freed by the caller.
+ * @type               : filled with the type of the packet.
+ *
+ * Waits for a packet if @queue is empty.
+ *
+ * Returns: false if the queue was aborted, otherwise true.
+ **/
+static bool packet_queue_get(struct packet_queue *queue,
+      AVPacket *pkt, enum packet_type *type)
+{
+   struct queued_packet *packet = NULL;
+
+   slock_lock(queue->lock);
+
+   while (!queue->abort && !queue->count)
+      scond_wait(queue->cond, queue->lock);
+
+   if (queue->abort)
+   {
+      slock_unlock(queue->lock);
+      return false;
+   }
+
+   packet        = &queue->packets[queue->first];
+   *pkt          = packet->pkt;
+   *type         = packet->type;
+   queue->first  = (queue->first + 1) % queue->size;
+   queue->count--;
+
+   scond_broadcast(queue->cond);
+   slock_unlock(queue->lock);
+   return true;
+}
+
+/**
+ * packet_queue_flush:
+ * @queue              : packet queue.
+ *
+ * Drops the queued packets, queues a flush for the decoder and
+ * waits until the decoder has flushed.
+ **/
+static void packet_queue_flush(struct packet_queue *queue)
+{
+   unsigned serial;
+
+   if (!queue->lock)
+      return;
+
+   slock_lock(queue->lock);
+   packet_queue_clear_locked(queue);
+   slock_unlock(queue->lock);
+
+   if (!packet_queue_put(queue, NULL, PACKET_FLUSH))
+      return;
+
+   slock_lock(queue->lock);
+   serial = queue->flushes_queued;
+   while (!queue->abort && (int)(queue->flushes_done - serial) < 0)
+      scond_wait(queue->cond, queue->lock);
+   slock_unlock(queue->lock);
+}
+
+static void packet_queue_flush_done(struct packet_queue *queue)
+{
+   slock_lock(queue->lock);
+   queue->flushes_done++;
+   scond_broadcast(queue->cond);
+   slock_unlock(queue->lock);
+}
+
+static void init_perf_counter(struct retro_perf_counter *counter)
+{
+   const char *ident = counter->ident;
+
+   /* Counters are dropped by the frontend when the core is unloaded. */
+   memset(counter, 0, sizeof(*counter));
+   counter->ident = ident;
+
+   if (perf_cb.perf_register)
+      perf_cb.perf_register(counter);
+}
+
+static void init_perf_counters(void)
+{
+   memset(&perf_cb, 0, sizeof(perf_cb));
+
+   if (!CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_GET_PERF_INTERFACE, &perf_cb))
+      memset(&perf_cb, 0, sizeof(perf_cb));
+
+   init_perf_counter(&ffmpeg_demux);
+   init_perf_counter(&ffmpeg_video_decode);
+   init_perf_counter(&ffmpeg_video_scale);
+   init_perf_counter(&ffmpeg_audio_decode);
+   init_perf_counter(&ffmpeg_video_queue);
+   init_perf_counter(&ffmpeg_audio_queue);
+}
+
 /* Seeking. */
 static bool do_seek;
 static double seek_time;
@@ -363,6 +727,152 @@ static void check_variables(void)
    }
 }
 
+static bool video_frames_init(void)
+{
+   unsigned i;
+   size_t frame_size = media.width * media.height * sizeof(uint32_t);
+
+   video_frames_read  = 0;
+   video_frames_count = 0;
+   video_frames_shown = false;
+
+   for (i = 0; i < VIDEO_FRAME_RING_SIZE; i++)
+   {
+      video_frames[i].data   = (uint32_t*)av_malloc(frame_size);
+      video_frames[i].direct = av_frame_alloc();
+      if (!video_frames[i].data || !video_frames[i].direct)
+         return false;
+   }
+
+   return true;
+}
+
+static void video_frames_free(void)
+{
+   unsigned i;
+
+   for (i = 0; i < VIDEO_FRAME_RING_SIZE; i++)
+   {
+      av_freep(&video_frames[i].data);
+      av_frame_free(&video_frames[i].direct);
+      video_frames[i].is_direct = false;
+   }
+
+   video_frames_read  = 0;
+   video_frames_count = 0;
+   video_frames_shown = false;
+}
+
+static struct video_frame *video_frames_get_shown(void)
+{
+   return &video_frames[(video_frames_read + VIDEO_FRAME_RING_SIZE - 1)
+      % VIDEO_FRAME_RING_SIZE];
+}
+
+/* Drops all queued frames. The slot the video decode thread may be
+ * filling stays the next one to be queued, the shown frame is kept.
+ * Call with fifo_lock held, and not while the main thread uses a
+ * queued slot. */
+static void video_frames_clear(void)
+{
+   struct video_frame *shown = video_frames_get_shown();
+
+   while (video_frames_count)
+   {
+      struct video_frame *frame = &video_frames[video_frames_read];
+
+      if (frame->is_direct)
+         av_frame_unref(frame->direct);
+      frame->is_direct   = false;
+
+      video_frames_read  = (video_frames_read + 1) % VIDEO_FRAME_RING_SIZE;
+      video_frames_count--;
+   }
+
+   /* Moves the shown frame right before video_frames_read again.
+    * Only the slots change, its pixels stay where they are. */
+   if (video_frames_shown && shown != video_frames_get_shown())
+   {
+      struct video_frame tmp    = *video_frames_get_shown();
+      *video_frames_get_shown() = *shown;
+      *shown                    = tmp;
+   }
+}
+
+/* Gives the oldest queued frame back to the video decode thread.
+ * Call with fifo_lock held. */
+static void video_frames_release(void)
+{
+   struct video_frame *frame = &video_frames[video_frames_read];
+
+   if (frame->is_direct)
+      av_frame_unref(frame->direct);
+   frame->is_direct   = false;
+
+   video_frames_read  = (video_frames_read + 1) % VIDEO_FRAME_RING_SIZE;
+   video_frames_count--;
+   scond_broadcast(fifo_decode_cond);
+}
+
+/* Gives the shown frame back to the video decode thread.
+ * Call with fifo_lock held. */
+static void video_frames_release_shown(void)
+{
+   struct video_frame *frame = video_frames_get_shown();
+
+   if (!video_frames_shown)
+      return;
+
+   if (frame->is_direct)
+      av_frame_unref(frame->direct);
+   frame->is_direct   = false;
+   video_frames_shown = false;
+   scond_broadcast(fifo_decode_cond);
+}
+
+/* Takes the oldest queued frame out of the queue to be passed to
+ * video_cb, in place of the frame shown before.
+ * Call with fifo_lock held. */
+static const struct video_frame *video_frames_show(void)
+{
+   video_frames_release_shown();
+
+   video_frames_read  = (video_frames_read + 1) % VIDEO_FRAME_RING_SIZE;
+   video_frames_count--;
+   video_frames_shown = true;
+
+   return video_frames_get_shown();
+}
+
+static const uint8_t *video_frame_pixels(const struct video_frame *frame,
+      size_t *pitch)
+{
+   if (frame->is_direct)
+   {
+      *pitch = frame->direct->linesize[0];
+      return frame->direct->data[0];
+   }
+
+   *pitch = media.width * sizeof(uint32_t);
+   return (const uint8_t*)frame->data;
+}
+
+static void video_frame_copy(uint8_t *dst, const uint8_t *src,
+      size_t pitch)
+{
+   unsigned y;
+   size_t row_size = media.width * sizeof(uint32_t);
+
+   if (pitch == row_size)
+   {
+      memcpy(dst, src, row_size * media.height);
+      return;
+   }
+
+   for (y = 0; y < media.height; y++, src += pitch, dst += row_size)
+      memcpy(dst, src, row_size);
+}
+
 static void seek_frame(int seek_frames)
 {
    char msg[256];
@@ -391,11 +901,15 @@ static void seek_frame(int seek_frames)
    }
    audio_frames = frame_cnt * media.sample_rate / media.interpolate_fps;
 
-   if (video_decode_fifo)
-      fifo_clear(video_decode_fifo);
+   video_frames_clear();
    if (audio_decode_fifo)
       fifo_clear(audio_decode_fifo);
-   scond_signal(fifo_decode_cond);
+   scond_broadcast(fifo_decode_cond);
+
+   /* Lets the decode thread get to the seek, if it waits
+    * for room in a queue. */
+   packet_queue_clear(&video_packets);
+   packet_queue_clear(&audio_packets);
 
    while (!decode_thread_dead && do_seek)
       scond_wait(fifo_cond, fifo_lock);
@@ -543,7 +1057,7 @@ void CORE_PREFIX(retro_run)(void)
       while (!decode_thread_dead && fifo_read_avail(audio_decode_fifo) < to_read_bytes)
       {
          main_sleeping = true;
-         scond_signal(fifo_decode_cond);
+         scond_broadcast(fifo_decode_cond);
          scond_wait(fifo_cond, fifo_lock);
          main_sleeping = false;
       }
@@ -563,7 +1077,7 @@ void CORE_PREFIX(retro_run)(void)
 
       if (!decode_thread_dead)
          fifo_read(audio_decode_fifo, audio_buffer, to_read_bytes);
-      scond_signal(fifo_decode_cond);
+      scond_broadcast(fifo_decode_cond);
 
       slock_unlock(fifo_lock);
       audio_frames += to_read_frames;
@@ -573,7 +1087,9 @@ void CORE_PREFIX(retro_run)(void)
 
    if (video_stream >= 0)
    {
-      bool dupe = true; /* unused if GL enabled */
+      /* Frame passed to video_cb, unused if GL enabled. */
+      const uint8_t *pixels = NULL;
+      size_t pitch          = media.width * sizeof(uint32_t);
 
       /* Video */
       if (min_pts > frames[1].pts)
@@ -585,61 +1101,99 @@ void CORE_PREFIX(retro_run)(void)
 
       while (!decode_thread_dead && min_pts > frames[1].pts)
       {
-         size_t to_read_frame_bytes;
-         int64_t pts = 0;
+         const struct video_frame *frame = NULL;
+         int64_t pts                     = 0;
 
          slock_lock(fifo_lock);
-         to_read_frame_bytes = media.width * media.height * sizeof(uint32_t) + sizeof(int64_t);
 
-         while (!decode_thread_dead && fifo_read_avail(video_decode_fifo) < to_read_frame_bytes)
+         /* Does not sleep holding the shown frame. If no other one
+          * comes, video_cb gets a copy of it. */
+         if (video_frames_shown && !video_frames_count && !decode_thread_dead)
+         {
+            size_t shown_pitch;
+            const uint8_t *shown_pixels = video_frame_pixels(
+                  video_frames_get_shown(), &shown_pitch);
+
+            slock_unlock(fifo_lock);
+            video_frame_copy((uint8_t*)video_frame_temp_buffer,
+                  shown_pixels, shown_pitch);
+            slock_lock(fifo_lock);
+
+            video_frames_release_shown();
+            pixels = (const uint8_t*)video_frame_temp_buffer;
+            pitch  = media.width * sizeof(uint32_t);
+         }
+
+         while (!decode_thread_dead && !video_frames_count)
          {
             main_sleeping = true;
-            scond_signal(fifo_decode_cond);
+            scond_broadcast(fifo_decode_cond);
             scond_wait(fifo_cond, fifo_lock);
             main_sleeping = false;
          }
 
          if (!decode_thread_dead)
          {
-            fifo_read(video_decode_fifo, &pts, sizeof(int64_t));
+            frame = &video_frames[video_frames_read];
+            pts   = frame->pts;
+
 #if defined(HAVE_OPENGL)
-            if (use_gl)
-            {
-#if defined(HAVE_OPENGLES)
-               fifo_read(video_decode_fifo, video_frame_temp_buffer, media.width * media.height * sizeof(uint32_t));
-               glBindTexture(GL_TEXTURE_2D, frames[1].tex);
-               glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
-                     media.width, media.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, video_frame_temp_buffer);
-               glBindTexture(GL_TEXTURE_2D, 0);
-#else
-               uint32_t *data = NULL;
-               glBindBuffer(GL_PIXEL_UNPACK_BUFFER, frames[1].pbo);
-
-               data = (uint32_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
-                     0, media.width * media.height, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
-               
-               fifo_read(video_decode_fifo, data, media.width * media.height * sizeof(uint32_t));
-               
-               glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-               glBindTexture(GL_TEXTURE_2D, frames[1].tex);
-               glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
-                     media.width, media.height, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
-               glBindTexture(GL_TEXTURE_2D, 0);
-               glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-#endif
-            }
-            else
+            if (!use_gl)
 #endif
             {
-               fifo_read(video_decode_fifo, video_frame_temp_buffer, media.width * media.height * sizeof(uint32_t));
-               dupe = false;
+               /* Only the newest frame is shown. */
+               frame  = video_frames_show();
+               pixels = video_frame_pixels(frame, &pitch);
             }
          }
-
-         scond_signal(fifo_decode_cond);
          slock_unlock(fifo_lock);
 
+         if (!frame)
+            break;
+
          frames[1].pts = av_q2d(fctx->streams[video_stream]->time_base) * pts;
+
+#if defined(HAVE_OPENGL)
+         if (use_gl)
+         {
+            size_t gl_pitch;
+            const uint8_t *gl_pixels = video_frame_pixels(frame, &gl_pitch);
+
+#if defined(HAVE_OPENGLES)
+            if (gl_pitch != media.width * sizeof(uint32_t))
+            {
+               video_frame_copy((uint8_t*)video_frame_temp_buffer,
+                     gl_pixels, gl_pitch);
+               gl_pixels = (const uint8_t*)video_frame_temp_buffer;
+            }
+
+            glBindTexture(GL_TEXTURE_2D, frames[1].tex);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                  media.width, media.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, gl_pixels);
+            glBindTexture(GL_TEXTURE_2D, 0);
+#else
+            uint8_t *data = NULL;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, frames[1].pbo);
+
+            data = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                  0, media.width * media.height * sizeof(uint32_t),
+                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+            video_frame_copy(data, gl_pixels, gl_pitch);
+
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindTexture(GL_TEXTURE_2D, frames[1].tex);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                  media.width, media.height, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+
+            slock_lock(fifo_lock);
+            video_frames_release();
+            slock_unlock(fifo_lock);
+         }
+#endif
       }
 
 #ifdef HAVE_OPENGL
@@ -686,9 +1240,7 @@ void CORE_PREFIX(retro_run)(void)
       }
       else
 #endif
-      {
-         CORE_PREFIX(video_cb)(dupe ? NULL : video_frame_temp_buffer, media.width, media.height, media.width * sizeof(uint32_t));
-      }
+         CORE_PREFIX(video_cb)(pixels, media.width, media.height, pitch);
    }
 #ifdef HAVE_GL_FFT
    else if (fft)
@@ -731,6 +1283,15 @@ static bool open_codec(AVCodecContext **ctx, unsigned index)
    }
 
    *ctx = fctx->streams[index]->codec;
+
+   if ((*ctx)->codec_type == AVMEDIA_TYPE_VIDEO)
+   {
+      (*ctx)->thread_count = decode_threads();
+      (*ctx)->thread_type  = FF_THREAD_FRAME | FF_THREAD_SLICE;
+      /* Decoded frames are kept by reference, see output_video_frame(). */
+      (*ctx)->refcounted_frames = 1;
+   }
+
    if (avcodec_open2(*ctx, codec, NULL) < 0)
       return false;
 
@@ -943,26 +1504,205 @@ static void set_colorspace(struct SwsContext *sws,
    }
 }
 
-static bool decode_video(AVPacket *pkt, AVFrame *frame, AVFrame *conv, struct SwsContext *sws)
+static void sws_slice_scale(struct sws_slice *slice,
+      const AVFrame *src, AVFrame *dst)
 {
-   int got_ptr = 0;
-   int ret     = avcodec_decode_video2(vctx, frame, &got_ptr, pkt);
+   unsigned i;
+   const uint8_t *src_data[4] = {NULL};
+   uint8_t *dst_data[4]       = {NULL};
+   int chroma_shift           = slice->pool->chroma_shift;
 
-   if (ret < 0)
-      return false;
+   for (i = 0; i < 4 && src->data[i]; i++)
+   {
+      /* Alpha is not subsampled. */
+      unsigned y  = (i == 1 || i == 2) ?
+         slice->y >> chroma_shift : slice->y;
+      src_data[i] = src->data[i] + y * src->linesize[i];
+   }
 
-   if (got_ptr)
+   dst_data[0] = dst->data[0] + slice->y * dst->linesize[0];
+
+   sws_scale(slice->sws, src_data, src->linesize, 0, slice->height,
+         dst_data, dst->linesize);
+}
+
+static void sws_slice_thread(void *data)
+{
+   struct sws_slice *slice = (struct sws_slice*)data;
+   struct sws_pool  *pool  = slice->pool;
+   unsigned generation     = 0;
+
+   slock_lock(pool->lock);
+
+   for (;;)
+   {
+      while (!pool->dead && pool->generation == generation)
+         scond_wait(pool->cond, pool->lock);
+
+      if (pool->dead)
+         break;
+
+      generation = pool->generation;
+      slock_unlock(pool->lock);
+
+      sws_slice_scale(slice, pool->src, pool->dst);
+
+      slock_lock(pool->lock);
+      if (--pool->pending == 0)
+         scond_signal(pool->done_cond);
+   }
+
+   slock_unlock(pool->lock);
+}
+
+static void sws_pool_free(struct sws_pool *pool)
+{
+   unsigned i;
+
+   if (pool->lock)
    {
-      set_colorspace(sws, media.width, media.height,
-            av_frame_get_colorspace(frame), av_frame_get_color_range(frame));
-      sws_scale(sws, (const uint8_t * const*)frame->data, frame->linesize, 0, media.height,
-            conv->data, conv->linesize);
+      slock_lock(pool->lock);
+      pool->dead = true;
+      scond_broadcast(pool->cond);
+      slock_unlock(pool->lock);
+   }
+
+   for (i = 0; i < MAX_SWS_SLICES; i++)
+   {
+      if (pool->slices[i].thread)
+         sthread_join(pool->slices[i].thread);
+      if (pool->slices[i].sws)
+         sws_freeContext(pool->slices[i].sws);
+   }
+
+   if (pool->cond)
+      scond_free(pool->cond);
+   if (pool->done_cond)
+      scond_free(pool->done_cond);
+   if (pool->lock)
+      slock_free(pool->lock);
+
+   memset(pool, 0, sizeof(*pool));
+}
+
+/**
+ * sws_pool_init:
+ * @pool               : pool to set up.
+ * @pix_fmt            : pixel format of the decoded frames.
+ *
+ * Splits the frame into as many slices as there are cores.
+ * Only planar formats are split, the rows of a slice are found
+ * by offsetting every plane then.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool sws_pool_init(struct sws_pool *pool, enum AVPixelFormat pix_fmt)
+{
+   unsigned i;
+   int chroma_h_shift  = 0;
+   unsigned num        = decode_threads();
+   unsigned max_slices = media.height / SWS_SLICE_ALIGN;
+
+   memset(pool, 0, sizeof(*pool));
+
+   av_pix_fmt_get_chroma_sub_sample(pix_fmt,
+         &chroma_h_shift, &pool->chroma_shift);
+
+   if (num > MAX_SWS_SLICES)
+      num = MAX_SWS_SLICES;
+   if (num > max_slices)
+      num = max_slices;
+   if (num < 1 || av_pix_fmt_count_planes(pix_fmt) < 2)
+      num = 1;
+
+   pool->num = num;
+
+   for (i = 0; i < num; i++)
+   {
+      struct sws_slice *slice = &pool->slices[i];
+      unsigned end            = (i + 1 == num) ? media.height :
+         (media.height * (i + 1) / num) & ~(SWS_SLICE_ALIGN - 1);
+
+      slice->pool   = pool;
+      slice->y      = i ? pool->slices[i - 1].y + pool->slices[i - 1].height : 0;
+      slice->height = end - slice->y;
+      slice->sws    = sws_getCachedContext(NULL,
+            media.width, slice->height, pix_fmt,
+            media.width, slice->height, PIX_FMT_RGB32,
+            SWS_POINT, NULL, NULL, NULL);
+
+      if (!slice->sws)
+         goto error;
+   }
+
+   if (num == 1)
       return true;
+
+   pool->lock      = slock_new();
+   pool->cond      = scond_new();
+   pool->done_cond = scond_new();
+
+   if (!pool->lock || !pool->cond || !pool->done_cond)
+      goto error;
+
+   for (i = 1; i < num; i++)
+   {
+      pool->slices[i].thread = sthread_create(sws_slice_thread,
+            &pool->slices[i]);
+      if (!pool->slices[i].thread)
+         goto error;
    }
 
+   return true;
+
+error:
+   sws_pool_free(pool);
    return false;
 }
 
+static void sws_pool_scale(struct sws_pool *pool,
+      const AVFrame *src, AVFrame *dst)
+{
+   unsigned i;
+
+   for (i = 0; i < pool->num; i++)
+      set_colorspace(pool->slices[i].sws, media.width, media.height,
+            av_frame_get_colorspace(src), av_frame_get_color_range(src));
+
+   if (pool->num > 1)
+   {
+      slock_lock(pool->lock);
+      pool->src     = src;
+      pool->dst     = dst;
+      pool->pending = pool->num - 1;
+      pool->generation++;
+      scond_broadcast(pool->cond);
+      slock_unlock(pool->lock);
+   }
+
+   sws_slice_scale(&pool->slices[0], src, dst);
+
+   if (pool->num > 1)
+   {
+      slock_lock(pool->lock);
+      while (pool->pending)
+         scond_wait(pool->done_cond, pool->lock);
+      slock_unlock(pool->lock);
+   }
+}
+
+static bool decode_video(AVPacket *pkt, AVFrame *frame)
+{
+   int ret;
+   int got_ptr = 0;
+
+   FFMPEG_PERF_START(ffmpeg_video_decode);
+   ret = avcodec_decode_video2(vctx, frame, &got_ptr, pkt);
+   FFMPEG_PERF_STOP(ffmpeg_video_decode);
+
+   return ret >= 0 && got_ptr;
+}
+
 static int16_t *decode_audio(AVCodecContext *ctx, AVPacket *pkt, AVFrame *frame, int16_t *buffer, size_t *buffer_cap,
       SwrContext *swr)
 {
@@ -974,7 +1714,12 @@ static int16_t *decode_audio(AVCodecContext *ctx, AVPacket *pkt, AVFrame *frame,
       int64_t pts;
       size_t required_buffer;
 
-      int ret = avcodec_decode_audio4(ctx, frame, &got_ptr, &pkt_tmp);
+      int ret;
+
+      FFMPEG_PERF_START(ffmpeg_audio_decode);
+      ret = avcodec_decode_audio4(ctx, frame, &got_ptr, &pkt_tmp);
+      FFMPEG_PERF_STOP(ffmpeg_audio_decode);
+
       if (ret < 0)
          return buffer;
 
@@ -1038,16 +1783,9 @@ static void decode_thread_seek(double time)
    if (ret < 0)
       log_cb(RETRO_LOG_ERROR, "av_seek_frame() failed.\n");
 
-   if (actx[audio_streams_ptr])
-      avcodec_flush_buffers(actx[audio_streams_ptr]);
-   if (vctx)
-      avcodec_flush_buffers(vctx);
-   if (sctx[subtitle_streams_ptr])
-      avcodec_flush_buffers(sctx[subtitle_streams_ptr]);
-#ifdef HAVE_SSA
-   if (ass_track[subtitle_streams_ptr])
-      ass_flush_events(ass_track[subtitle_streams_ptr]);
-#endif
+   /* The decode threads flush their decoders. */
+   packet_queue_flush(&video_packets);
+   packet_queue_flush(&audio_packets);
 }
 
 #ifdef HAVE_SSA
@@ -1100,29 +1838,216 @@ static void render_ass_img(AVFrame *conv_frame, ASS_Image *img)
 }
 #endif
 
-static void decode_thread(void *data)
+static void decode_subtitle(AVPacket *pkt, AVCodecContext *ctx,
+      void *track)
 {
+   AVSubtitle sub;
+   int finished = 0;
+#ifdef HAVE_SSA
    unsigned i;
-   AVFrame *aud_frame, *vid_frame;
-   SwrContext *swr[audio_streams_num];
-   void *conv_frame_buf    = NULL;
-   size_t frame_size       = 0;
-   int16_t *audio_buffer   = NULL;
-   size_t audio_buffer_cap = 0;
-   AVFrame *conv_frame     = NULL;
-   struct SwsContext *sws  = NULL;
+   ASS_Track *ass_track_active = (ASS_Track*)track;
+#endif
+
+   (void)track;
+
+   if (!ctx)
+      return;
+
+   memset(&sub, 0, sizeof(sub));
+
+   while (!finished)
+   {
+      if (avcodec_decode_subtitle2(ctx, &sub, &finished, pkt) < 0)
+      {
+         log_cb(RETRO_LOG_ERROR, "Decode subtitles failed.\n");
+         break;
+      }
+   }
+
+#ifdef HAVE_SSA
+   for (i = 0; i < sub.num_rects; i++)
+   {
+      if (sub.rects[i]->ass)
+         ass_process_data(ass_track_active, sub.rects[i]->ass, strlen(sub.rects[i]->ass));
+   }
+#endif
+
+   avsubtitle_free(&sub);
+}
+
+static void output_video_frame(AVFrame *vid_frame, AVFrame *conv_frame,
+      struct sws_pool *pool, void *track)
+{
+   struct video_frame *out;
+   int64_t pts       = av_frame_get_best_effort_timestamp(vid_frame);
+   double video_time = pts * av_q2d(fctx->streams[video_stream]->time_base);
+   bool direct       = vid_frame->format == PIX_FMT_RGB32
+      && vid_frame->width  == (int)media.width
+      && vid_frame->height == (int)media.height;
+
+   (void)track;
+
+#ifdef HAVE_SSA
+   /* Subtitles are blended into the frame, which the decoder
+    * may still use as a reference. */
+   if (ass_render && track)
+      direct = false;
+#endif
+
+   slock_lock(fifo_lock);
+
+   while (!decode_thread_dead && video_frames_count
+         + video_frames_shown == VIDEO_FRAME_RING_SIZE)
+   {
+      if (!main_sleeping)
+         scond_wait(fifo_decode_cond, fifo_lock);
+      else
+      {
+         video_frames_clear();
+         break;
+      }
+   }
+
+   out = &video_frames[(video_frames_read + video_frames_count)
+      % VIDEO_FRAME_RING_SIZE];
+   slock_unlock(fifo_lock);
+
+   if (decode_thread_dead)
+   {
+      av_frame_unref(vid_frame);
+      return;
+   }
+
+   /* The slot is ours until it is queued. */
+   out->pts       = pts;
+   out->is_direct = direct;
+
+   if (direct)
+      av_frame_move_ref(out->direct, vid_frame);
+   else
+   {
+      avpicture_fill((AVPicture*)conv_frame, (const uint8_t*)out->data,
+            PIX_FMT_RGB32, media.width, media.height);
+
+      FFMPEG_PERF_START(ffmpeg_video_scale);
+      sws_pool_scale(pool, vid_frame, conv_frame);
+      FFMPEG_PERF_STOP(ffmpeg_video_scale);
+
+      av_frame_unref(vid_frame);
+
+#ifdef HAVE_SSA
+      if (ass_render && track)
+      {
+         int change = 0;
+         ASS_Image *img = ass_render_frame(ass_render, (ASS_Track*)track,
+               1000 * video_time, &change);
+
+         /* Do it on CPU for now.
+          * We're in a thread anyways, so shouldn't really matter. */
+         render_ass_img(conv_frame, img);
+      }
+#endif
+   }
+
+   slock_lock(fifo_lock);
+   decode_last_video_time = video_time;
+   if (!decode_thread_dead)
+      video_frames_count++;
+   else if (direct)
+   {
+      av_frame_unref(out->direct);
+      out->is_direct = false;
+   }
+   scond_signal(fifo_cond);
+   slock_unlock(fifo_lock);
+}
+
+static void video_decode_thread(void *data)
+{
+   struct sws_pool pool;
+   AVFrame *vid_frame     = av_frame_alloc();
+   AVFrame *conv_frame    = av_frame_alloc();
+   bool pool_ok           = sws_pool_init(&pool, vctx->pix_fmt);
 
    (void)data;
-   
-   if (video_stream >= 0)
+
+   if (!vid_frame || !conv_frame || !pool_ok)
    {
-      sws = sws_getCachedContext(NULL,
-            media.width, media.height, vctx->pix_fmt,
-            media.width, media.height, PIX_FMT_RGB32,
-            SWS_POINT, NULL, NULL, NULL);
+      log_cb(RETRO_LOG_ERROR, "Failed to set up video decoding.\n");
+      goto end;
+   }
+
+   while (!decode_thread_dead)
+   {
+      AVPacket pkt;
+      enum packet_type type;
+      int subtitle_ptr;
+      void *track = NULL;
+
+      if (!packet_queue_get(&video_packets, &pkt, &type))
+         break;
+
+      slock_lock(decode_thread_lock);
+      subtitle_ptr = subtitle_streams_ptr;
+#ifdef HAVE_SSA
+      track        = ass_track[subtitle_ptr];
+#endif
+      slock_unlock(decode_thread_lock);
+
+      if (type == PACKET_FLUSH)
+      {
+         avcodec_flush_buffers(vctx);
+         if (sctx[subtitle_ptr])
+            avcodec_flush_buffers(sctx[subtitle_ptr]);
+#ifdef HAVE_SSA
+         if (track)
+            ass_flush_events((ASS_Track*)track);
+#endif
+         packet_queue_flush_done(&video_packets);
+         continue;
+      }
+
+      if (type == PACKET_EOF)
+      {
+         /* Frame threading holds back a few frames. */
+         av_init_packet(&pkt);
+         pkt.data = NULL;
+         pkt.size = 0;
+
+         while (!decode_thread_dead && decode_video(&pkt, vid_frame))
+            output_video_frame(vid_frame, conv_frame, &pool, track);
+         break;
+      }
+
+      if (pkt.stream_index == video_stream)
+      {
+         if (decode_video(&pkt, vid_frame))
+            output_video_frame(vid_frame, conv_frame, &pool, track);
+      }
+      else
+         decode_subtitle(&pkt, sctx[subtitle_ptr], track);
+
+      av_free_packet(&pkt);
    }
 
-   for (i = 0; (int)i < audio_streams_num; i++)
+end:
+   if (pool_ok)
+      sws_pool_free(&pool);
+   av_frame_free(&vid_frame);
+   av_frame_free(&conv_frame);
+}
+
+static void audio_decode_thread(void *data)
+{
+   int i;
+   SwrContext *swr[MAX_STREAMS] = {NULL};
+   AVFrame *aud_frame      = av_frame_alloc();
+   int16_t *audio_buffer   = NULL;
+   size_t audio_buffer_cap = 0;
+
+   (void)data;
+
+   for (i = 0; i < audio_streams_num; i++)
    {
       swr[i] = swr_alloc();
 
@@ -1135,30 +2060,71 @@ static void decode_thread(void *data)
       swr_init(swr[i]);
    }
 
-   aud_frame = av_frame_alloc();
-   vid_frame = av_frame_alloc();
+   while (!decode_thread_dead)
+   {
+      AVPacket pkt;
+      enum packet_type type;
+
+      if (!packet_queue_get(&audio_packets, &pkt, &type))
+         break;
+
+      if (type == PACKET_EOF)
+         break;
+
+      if (type == PACKET_FLUSH)
+      {
+         for (i = 0; i < audio_streams_num; i++)
+            avcodec_flush_buffers(actx[i]);
+         packet_queue_flush_done(&audio_packets);
+         continue;
+      }
+
+      for (i = 0; i < audio_streams_num; i++)
+      {
+         if (audio_streams[i] == pkt.stream_index)
+         {
+            audio_buffer = decode_audio(actx[i], &pkt, aud_frame,
+                  audio_buffer, &audio_buffer_cap, swr[i]);
+            break;
+         }
+      }
+
+      av_free_packet(&pkt);
+   }
+
+   for (i = 0; i < audio_streams_num; i++)
+      swr_free(&swr[i]);
+
+   av_frame_free(&aud_frame);
+   av_freep(&audio_buffer);
+}
+
+static void decode_thread(void *data)
+{
+   bool eof                  = false;
+   sthread_t *video_thread   = NULL;
+   sthread_t *audio_thread   = NULL;
+
+   (void)data;
 
    if (video_stream >= 0)
+      video_thread = sthread_create(video_decode_thread, NULL);
+   if (audio_streams_num > 0)
+      audio_thread = sthread_create(audio_decode_thread, NULL);
+
+   if ((video_stream >= 0 && !video_thread)
+         || (audio_streams_num > 0 && !audio_thread))
    {
-      frame_size = avpicture_get_size(PIX_FMT_RGB32, media.width, media.height);
-      conv_frame = av_frame_alloc();
-      conv_frame_buf = av_malloc(frame_size);
-      avpicture_fill((AVPicture*)conv_frame, (const uint8_t*)conv_frame_buf,
-            PIX_FMT_RGB32, media.width, media.height);
+      log_cb(RETRO_LOG_ERROR, "Failed to start decode threads.\n");
+      goto end;
    }
 
    while (!decode_thread_dead)
    {
       bool seek;
       double seek_time_thread;
-      int audio_stream, audio_stream_ptr;
-      int subtitle_stream;
+      int audio_stream, subtitle_stream;
       AVPacket pkt;
-      AVCodecContext *actx_active;
-      AVCodecContext *sctx_active;
-#ifdef HAVE_SSA
-      ASS_Track *ass_track_active
-#endif
 
       slock_lock(fifo_lock);
       seek = do_seek;
@@ -1173,8 +2139,7 @@ static void decode_thread(void *data)
          do_seek = false;
          seek_time = 0.0;
 
-         if (video_decode_fifo)
-            fifo_clear(video_decode_fifo);
+         video_frames_clear();
          if (audio_decode_fifo)
             fifo_clear(audio_decode_fifo);
 
@@ -1183,122 +2148,58 @@ static void decode_thread(void *data)
       }
 
       memset(&pkt, 0, sizeof(pkt));
+
+      FFMPEG_PERF_START(ffmpeg_demux);
       if (av_read_frame(fctx, &pkt) < 0)
+      {
+         FFMPEG_PERF_STOP(ffmpeg_demux);
+         eof = true;
          break;
+      }
+      FFMPEG_PERF_STOP(ffmpeg_demux);
 
       slock_lock(decode_thread_lock);
       audio_stream                = audio_streams[audio_streams_ptr];
-      audio_stream_ptr            = audio_streams_ptr;
       subtitle_stream             = subtitle_streams[subtitle_streams_ptr];
-      actx_active                 = actx[audio_streams_ptr];
-      sctx_active                 = sctx[subtitle_streams_ptr];
-#ifdef HAVE_SSA
-      ass_track_active            = ass_track[subtitle_streams_ptr];
-#endif
       slock_unlock(decode_thread_lock);
 
-      if (pkt.stream_index == video_stream)
+      /* The packet outlives the next av_read_frame() in the queue. */
+      if (av_dup_packet(&pkt) < 0)
       {
-         if (decode_video(&pkt, vid_frame, conv_frame, sws))
-         {
-            size_t decoded_size;
-            int64_t pts       = av_frame_get_best_effort_timestamp(vid_frame);
-            double video_time = pts * av_q2d(fctx->streams[video_stream]->time_base);
-
-#ifdef HAVE_SSA
-            if (ass_render)
-            {
-               int change = 0;
-               ASS_Image *img = ass_render_frame(ass_render, ass_track_active,
-                     1000 * video_time, &change);
-
-               /* Do it on CPU for now.
-                * We're in a thread anyways, so shouldn't really matter. */
-               render_ass_img(conv_frame, img);
-            }
-#endif
-
-            decoded_size = frame_size + sizeof(pts);
-            slock_lock(fifo_lock);
-
-            while (!decode_thread_dead 
-                  && fifo_write_avail(video_decode_fifo) < decoded_size)
-            {
-               if (!main_sleeping)
-                  scond_wait(fifo_decode_cond, fifo_lock);
-               else
-               {
-                  fifo_clear(video_decode_fifo);
-                  break;
-               }
-            }
-
-            decode_last_video_time = video_time;
-            if (!decode_thread_dead)
-            {
-               int stride;
-               unsigned y;
-               const uint8_t *src = NULL;
-               
-               fifo_write(video_decode_fifo, &pts, sizeof(pts));
-               src    = conv_frame->data[0];
-               stride = conv_frame->linesize[0];
-
-               for (y = 0; y < media.height; y++, src += stride)
-                  fifo_write(video_decode_fifo, src, media.width * sizeof(uint32_t));
-            }
-            scond_signal(fifo_cond);
-            slock_unlock(fifo_lock);
-         }
-      }
-      else if (pkt.stream_index == audio_stream)
-      {
-         audio_buffer = decode_audio(actx_active, &pkt, aud_frame,
-               audio_buffer, &audio_buffer_cap,
-               swr[audio_stream_ptr]);
-      }
-      else if (pkt.stream_index == subtitle_stream)
-      {
-         AVSubtitle sub;
-         int finished = 0;
-
-         memset(&sub, 0, sizeof(sub));
-
-         while (!finished)
-         {
-            if (avcodec_decode_subtitle2(sctx_active, &sub, &finished, &pkt) < 0)
-            {
-               log_cb(RETRO_LOG_ERROR, "Decode subtitles failed.\n");
-               break;
-            }
-         }
-
-#ifdef HAVE_SSA
-         for (i = 0; i < sub.num_rects; i++)
-         {
-            if (sub.rects[i]->ass)
-               ass_process_data(ass_track_active, sub.rects[i]->ass, strlen(sub.rects[i]->ass));
-         }
-#endif
-
-         avsubtitle_free(&sub);
+         av_free_packet(&pkt);
+         continue;
       }
 
-      av_free_packet(&pkt);
+      if (pkt.stream_index == video_stream)
+         packet_queue_put(&video_packets, &pkt, PACKET_DATA);
+      else if (audio_streams_num > 0 && pkt.stream_index == audio_stream)
+         packet_queue_put(&audio_packets, &pkt, PACKET_DATA);
+      else if (video_thread && subtitle_streams_num > 0
+            && pkt.stream_index == subtitle_stream)
+         packet_queue_put(&video_packets, &pkt, PACKET_DATA);
+      else
+         av_free_packet(&pkt);
    }
 
-   if (sws)
-      sws_freeContext(sws);
-   sws = NULL;
-
-   for (i = 0; (int)i < audio_streams_num; i++)
-      swr_free(&swr[i]);
+end:
+   /* Let the decoders finish what is queued, unless shutting down. */
+   if (eof && !decode_thread_dead)
+   {
+      if (video_thread)
+         packet_queue_put(&video_packets, NULL, PACKET_EOF);
+      if (audio_thread)
+         packet_queue_put(&audio_packets, NULL, PACKET_EOF);
+   }
+   else
+   {
+      packet_queue_abort(&video_packets);
+      packet_queue_abort(&audio_packets);
+   }
 
-   av_frame_free(&aud_frame);
-   av_frame_free(&vid_frame);
-   av_frame_free(&conv_frame);
-   av_freep(&conv_frame_buf);
-   av_freep(&audio_buffer);
+   if (video_thread)
+      sthread_join(video_thread);
+   if (audio_thread)
+      sthread_join(audio_thread);
 
    slock_lock(fifo_lock);
    decode_thread_dead = true;
@@ -1420,12 +2321,17 @@ void CORE_PREFIX(retro_unload_game)(void)
    {
       slock_lock(fifo_lock);
       decode_thread_dead = true;
-      scond_signal(fifo_decode_cond);
+      scond_broadcast(fifo_decode_cond);
       slock_unlock(fifo_lock);
+      packet_queue_abort(&video_packets);
+      packet_queue_abort(&audio_packets);
       sthread_join(decode_thread_handle);
    }
    decode_thread_handle = NULL;
 
+   packet_queue_free(&video_packets);
+   packet_queue_free(&audio_packets);
+
    if (fifo_cond)
       scond_free(fifo_cond);
    if (fifo_decode_cond)
@@ -1435,8 +2341,7 @@ void CORE_PREFIX(retro_unload_game)(void)
    if (decode_thread_lock)
       slock_free(decode_thread_lock);
 
-   if (video_decode_fifo)
-      fifo_free(video_decode_fifo);
+   video_frames_free();
    if (audio_decode_fifo)
       fifo_free(audio_decode_fifo);
 
@@ -1444,7 +2349,6 @@ void CORE_PREFIX(retro_unload_game)(void)
    fifo_decode_cond = NULL;
    fifo_lock = NULL;
    decode_thread_lock = NULL;
-   video_decode_fifo = NULL;
    audio_decode_fifo = NULL;
 
    decode_last_video_time = 0.0;
@@ -1521,6 +2425,8 @@ bool CORE_PREFIX(retro_load_game)(const struct retro_game_info *info)
 
    CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS, desc);
 
+   init_perf_counters();
+
    if (!CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt))
    {
       LOG_ERR("Cannot set pixel format.");
@@ -1559,10 +2465,14 @@ bool CORE_PREFIX(retro_load_game)(const struct retro_game_info *info)
    is_glfft = video_stream < 0 && audio_streams_num > 0;
 #endif
 
-   if (video_stream >= 0 || is_glfft)
+   if (video_stream >= 0 && !video_frames_init())
    {
-      video_decode_fifo = fifo_new(media.width * media.height * sizeof(uint32_t) * 32);
+      LOG_ERR("Failed to allocate video frames.");
+      goto error;
+   }
 
+   if (video_stream >= 0 || is_glfft)
+   {
 #ifdef HAVE_OPENGL
       use_gl = true;
       hw_render.context_reset = context_reset;
@@ -1588,6 +2498,20 @@ bool CORE_PREFIX(retro_load_game)(const struct retro_game_info *info)
       audio_decode_fifo = fifo_new(buffer_seconds * media.sample_rate * sizeof(int16_t) * 2);
    }
 
+   if (video_stream >= 0 && !packet_queue_init(&video_packets,
+            VIDEO_PACKET_QUEUE_SIZE, &ffmpeg_video_queue))
+   {
+      LOG_ERR("Failed to allocate packet queue.");
+      goto error;
+   }
+
+   if (audio_streams_num > 0 && !packet_queue_init(&audio_packets,
+            AUDIO_PACKET_QUEUE_SIZE, &ffmpeg_audio_queue))
+   {
+      LOG_ERR("Failed to allocate packet queue.");
+      goto error;
+   }
+
    fifo_cond = scond_new();
    fifo_decode_cond = scond_new();
    fifo_lock = slock_new();
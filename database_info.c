@@ -204,22 +204,45 @@ int database_info_build_query(char *s, size_t len,
    return 0;
 }
 
-static char *bin_to_hex_alloc(const uint8_t *data, size_t len)
+/* Size of the blocks strings of a database_info_list_t
+ * are allocated from. */
+#define DB_INFO_STRINGS_BLOCK_SIZE (16 * 1024)
+
+static char *database_info_strdup(struct rmsgpack_dom_arena *strings,
+      const struct rmsgpack_dom_value *val)
+{
+   char *ret = (char*)rmsgpack_dom_arena_alloc(strings,
+         val->val.string.len + 1);
+
+   if (!ret)
+      return NULL;
+
+   memcpy(ret, val->val.string.buff, val->val.string.len);
+   ret[val->val.string.len] = '\0';
+   return ret;
+}
+
+static char *bin_to_hex_alloc(struct rmsgpack_dom_arena *strings,
+      const uint8_t *data, size_t len)
 {
    size_t i;
-   char *ret = (char*)malloc(len * 2 + 1);
+   static const char hex[] = "0123456789ABCDEF";
+   char *ret = (char*)rmsgpack_dom_arena_alloc(strings, len * 2 + 1);
 
-   if (len && !ret)
+   if (!ret)
       return NULL;
-   
+
    for (i = 0; i < len; i++)
-      snprintf(ret+i*2, 3, "%02X", data[i]);
+   {
+      ret[i * 2]     = hex[data[i] >> 4];
+      ret[i * 2 + 1] = hex[data[i] & 0xf];
+   }
+   ret[len * 2] = '\0';
    return ret;
 }
 
-
 static int database_cursor_iterate(libretrodb_cursor_t *cur,
-      database_info_t *db_info)
+      database_info_t *db_info, struct rmsgpack_dom_arena *strings)
 {
    unsigned i;
    struct rmsgpack_dom_value item;
@@ -229,10 +252,7 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
       return -1;
 
    if (item.type != RDT_MAP)
-   {
-      rmsgpack_dom_value_free(&item);
       return 1;
-   }
 
    db_info->analog_supported       = -1;
    db_info->rumble_supported       = -1;
@@ -252,49 +272,49 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
       switch (value)
       {
          case DB_CURSOR_SERIAL:
-            db_info->serial = strdup(val->val.string.buff);
+            db_info->serial = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_ROM_NAME:
-            db_info->rom_name = strdup(val->val.string.buff);
+            db_info->rom_name = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_NAME:
-            db_info->name = strdup(val->val.string.buff);
+            db_info->name = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_DESCRIPTION:
-            db_info->description = strdup(val->val.string.buff);
+            db_info->description = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_PUBLISHER:
-            db_info->publisher = strdup(val->val.string.buff);
+            db_info->publisher = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_DEVELOPER:
             db_info->developer = string_split(val->val.string.buff, "|");
             break;
          case DB_CURSOR_ORIGIN:
-            db_info->origin = strdup(val->val.string.buff);
+            db_info->origin = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_FRANCHISE:
-            db_info->franchise = strdup(val->val.string.buff);
+            db_info->franchise = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_BBFC_RATING:
-            db_info->bbfc_rating = strdup(val->val.string.buff);
+            db_info->bbfc_rating = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_ESRB_RATING:
-            db_info->esrb_rating = strdup(val->val.string.buff);
+            db_info->esrb_rating = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_ELSPA_RATING:
-            db_info->elspa_rating = strdup(val->val.string.buff);
+            db_info->elspa_rating = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_CERO_RATING:
-            db_info->cero_rating = strdup(val->val.string.buff);
+            db_info->cero_rating = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_PEGI_RATING:
-            db_info->pegi_rating = strdup(val->val.string.buff);
+            db_info->pegi_rating = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_ENHANCEMENT_HW:
-            db_info->enhancement_hw = strdup(val->val.string.buff);
+            db_info->enhancement_hw = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_EDGE_MAGAZINE_REVIEW:
-            db_info->edge_magazine_review = strdup(val->val.string.buff);
+            db_info->edge_magazine_review = database_info_strdup(strings, val);
             break;
          case DB_CURSOR_EDGE_MAGAZINE_RATING:
             db_info->edge_magazine_rating = val->val.uint_;
@@ -327,10 +347,10 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
             db_info->crc32 = swap_if_little32(*(uint32_t*)val->val.binary.buff);
             break;
          case DB_CURSOR_CHECKSUM_SHA1:
-            db_info->sha1 = bin_to_hex_alloc((uint8_t*)val->val.binary.buff, val->val.binary.len);
+            db_info->sha1 = bin_to_hex_alloc(strings, (uint8_t*)val->val.binary.buff, val->val.binary.len);
             break;
          case DB_CURSOR_CHECKSUM_MD5:
-            db_info->md5 = bin_to_hex_alloc((uint8_t*)val->val.binary.buff, val->val.binary.len);
+            db_info->md5 = bin_to_hex_alloc(strings, (uint8_t*)val->val.binary.buff, val->val.binary.len);
             break;
          default:
             RARCH_LOG("Unknown key: %s\n", str);
@@ -338,8 +358,6 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
       }
    }
 
-   rmsgpack_dom_value_free(&item);
-
    return 0;
 }
 
@@ -453,8 +471,7 @@ database_info_list_t *database_info_list_new(
    libretrodb_t db;
    libretrodb_cursor_t cur;
    int ret                                  = 0;
-   unsigned k                               = 0;
-   database_info_t *database_info           = NULL;
+   size_t cap                               = 0;
    database_info_list_t *database_info_list = NULL;
 
    if ((database_cursor_open(&db, &cur, rdb_path, query) != 0))
@@ -466,37 +483,48 @@ database_info_list_t *database_info_list_new(
    if (!database_info_list)
       goto end;
 
+   database_info_list->strings = rmsgpack_dom_arena_new(
+         DB_INFO_STRINGS_BLOCK_SIZE);
+
+   if (!database_info_list->strings)
+      goto error;
+
    while (ret != -1)
    {
       database_info_t db_info = {0};
-      ret = database_cursor_iterate(&cur, &db_info);
+      ret = database_cursor_iterate(&cur, &db_info,
+            database_info_list->strings);
 
-      if (ret == 0)
+      if (ret != 0)
+         continue;
+
+      if (database_info_list->count == cap)
       {
-         database_info_t *db_ptr = NULL;
-         database_info = (database_info_t*)
-            realloc(database_info, (k+1) * sizeof(database_info_t));
+         database_info_t *list = NULL;
+
+         cap  = cap ? cap * 2 : 16;
+         list = (database_info_t*)realloc(database_info_list->list,
+               cap * sizeof(database_info_t));
 
-         if (!database_info)
+         if (!list)
          {
-            database_info_list_free(database_info_list);
-            database_info_list = NULL;
-            goto end;
+            if (db_info.developer)
+               string_list_free(db_info.developer);
+            goto error;
          }
 
-         db_ptr = &database_info[k];
-
-         if (!db_ptr)
-            continue;
+         database_info_list->list = list;
+      }
 
-         memcpy(db_ptr, &db_info, sizeof(*db_ptr));
+      memcpy(&database_info_list->list[database_info_list->count++],
+            &db_info, sizeof(db_info));
+   }
 
-         k++;
-      }
-   } 
+   goto end;
 
-   database_info_list->list  = database_info;
-   database_info_list->count = k;
+error:
+   database_info_list_free(database_info_list);
+   database_info_list = NULL;
 
 end:
    database_cursor_close(&db, &cur);
@@ -511,51 +539,17 @@ void database_info_list_free(database_info_list_t *database_info_list)
    if (!database_info_list)
       return;
 
+   /* All other strings are owned by the string arena. */
    for (i = 0; i < database_info_list->count; i++)
    {
       database_info_t *info = &database_info_list->list[i];
 
-      if (!info)
-         continue;
-
-      if (info->name)
-         free(info->name);
-      if (info->rom_name)
-         free(info->rom_name);
-      if (info->serial)
-         free(info->serial);
-      if (info->description)
-         free(info->description);
-      if (info->publisher)
-         free(info->publisher);
       if (info->developer)
          string_list_free(info->developer);
       info->developer = NULL;
-      if (info->origin)
-         free(info->origin);
-      if (info->franchise)
-         free(info->franchise);
-      if (info->edge_magazine_review)
-         free(info->edge_magazine_review);
-
-      if (info->cero_rating)
-         free(info->cero_rating);
-      if (info->pegi_rating)
-         free(info->pegi_rating);
-      if (info->enhancement_hw)
-         free(info->enhancement_hw);
-      if (info->elspa_rating)
-         free(info->elspa_rating);
-      if (info->esrb_rating)
-         free(info->esrb_rating);
-      if (info->bbfc_rating)
-         free(info->bbfc_rating);
-      if (info->sha1)
-         free(info->sha1);
-      if (info->md5)
-         free(info->md5);
    }
 
+   rmsgpack_dom_arena_free(database_info_list->strings);
    free(database_info_list->list);
    free(database_info_list);
 }
@@ -44,7 +44,9 @@ enum database_type
    DATABASE_TYPE_NONE = 0,
    DATABASE_TYPE_ITERATE,
    DATABASE_TYPE_ITERATE_ZIP,
-   DATABASE_TYPE_CRC_LOOKUP
+   DATABASE_TYPE_HASH,
+   DATABASE_TYPE_CRC_LOOKUP,
+   DATABASE_TYPE_SERIAL_LOOKUP
 };
 
 typedef struct
@@ -94,6 +96,9 @@ typedef struct
 {
    database_info_t *list;
    size_t count;
+
+   /* Owns all strings of @list, except for developer. */
+   struct rmsgpack_dom_arena *strings;
 } database_info_list_t;
 
 database_info_list_t *database_info_list_new(const char *rdb_path,
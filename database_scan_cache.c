@@ -0,0 +1,642 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "database_scan_cache.h"
+
+/* File layout, all integers little endian:
+ *
+ * "RASC", version, database signature, entry count (uint32 each),
+ * then per entry:
+ *
+ * path, size (uint64), mtime (int64), flags (uint8), crc32 (uint32),
+ * serial, zip_name, match count (uint32), and per match:
+ * db_name, label, crc32 (uint32).
+ *
+ * Strings are a uint16 length followed by the characters,
+ * a length of zero is a NULL string. */
+
+#define DATABASE_SCAN_CACHE_MAGIC   0x43534152
+#define DATABASE_SCAN_CACHE_VERSION 1
+
+struct database_scan_cache
+{
+   char *path;
+   uint32_t signature;
+   bool dirty;
+
+   database_scan_cache_entry_t *entries;
+   size_t count;
+   size_t cap;
+
+   /* Open addressing table of entry index + 1, 0 for free slots. */
+   size_t *slots;
+   size_t num_slots;
+};
+
+static uint32_t database_scan_cache_hash(const char *path)
+{
+   uint32_t hash = 5381;
+
+   while (*path)
+      hash = (hash << 5) + hash + (uint8_t)*path++;
+
+   return hash;
+}
+
+static size_t *database_scan_cache_slot(const database_scan_cache_t *cache,
+      const char *path)
+{
+   size_t mask = cache->num_slots - 1;
+   size_t i    = database_scan_cache_hash(path) & mask;
+
+   while (cache->slots[i])
+   {
+      if (!strcmp(cache->entries[cache->slots[i] - 1].path, path))
+         break;
+      i = (i + 1) & mask;
+   }
+
+   return &cache->slots[i];
+}
+
+static bool database_scan_cache_rehash(database_scan_cache_t *cache,
+      size_t num_slots)
+{
+   size_t i;
+   size_t *slots = (size_t*)calloc(num_slots, sizeof(*slots));
+
+   if (!slots)
+      return false;
+
+   free(cache->slots);
+   cache->slots     = slots;
+   cache->num_slots = num_slots;
+
+   for (i = 0; i < cache->count; i++)
+      *database_scan_cache_slot(cache, cache->entries[i].path) = i + 1;
+
+   return true;
+}
+
+static void database_scan_cache_clear_matches(
+      database_scan_cache_entry_t *entry)
+{
+   size_t i;
+
+   for (i = 0; i < entry->num_matches; i++)
+   {
+      free(entry->matches[i].db_name);
+      free(entry->matches[i].label);
+   }
+
+   free(entry->matches);
+   entry->matches     = NULL;
+   entry->num_matches = 0;
+   entry->flags      &= ~DATABASE_SCAN_CACHE_LOOKED_UP;
+}
+
+static void database_scan_cache_clear_entry(
+      database_scan_cache_entry_t *entry)
+{
+   database_scan_cache_clear_matches(entry);
+   free(entry->serial);
+   free(entry->zip_name);
+   entry->serial   = NULL;
+   entry->zip_name = NULL;
+   entry->crc32    = 0;
+   entry->flags    = 0;
+}
+
+static char *database_scan_cache_strdup(const char *s)
+{
+   return (s && *s) ? strdup(s) : NULL;
+}
+
+/* Adds a new entry, taking ownership of @path. */
+static database_scan_cache_entry_t *database_scan_cache_add(
+      database_scan_cache_t *cache, char *path)
+{
+   database_scan_cache_entry_t *entry = NULL;
+
+   if (cache->count == cache->cap)
+   {
+      size_t cap = cache->cap ? cache->cap * 2 : 256;
+      database_scan_cache_entry_t *entries = (database_scan_cache_entry_t*)
+         realloc(cache->entries, cap * sizeof(*entries));
+
+      if (!entries)
+         return NULL;
+
+      cache->entries = entries;
+      cache->cap     = cap;
+   }
+
+   if ((cache->count + 1) * 2 > cache->num_slots
+         && !database_scan_cache_rehash(cache, cache->num_slots
+            ? cache->num_slots * 2 : 512))
+      return NULL;
+
+   entry = &cache->entries[cache->count];
+   memset(entry, 0, sizeof(*entry));
+   entry->path = path;
+
+   *database_scan_cache_slot(cache, path) = ++cache->count;
+
+   return entry;
+}
+
+static bool database_scan_cache_read_u32(FILE *file, uint32_t *value)
+{
+   uint8_t buf[4];
+
+   if (fread(buf, 1, sizeof(buf), file) != sizeof(buf))
+      return false;
+
+   *value = buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+   return true;
+}
+
+static bool database_scan_cache_read_u64(FILE *file, uint64_t *value)
+{
+   uint32_t lo, hi;
+
+   if (!database_scan_cache_read_u32(file, &lo)
+         || !database_scan_cache_read_u32(file, &hi))
+      return false;
+
+   *value = ((uint64_t)hi << 32) | lo;
+   return true;
+}
+
+static bool database_scan_cache_read_str(FILE *file, char **s)
+{
+   uint8_t buf[2];
+   size_t len;
+
+   *s = NULL;
+
+   if (fread(buf, 1, sizeof(buf), file) != sizeof(buf))
+      return false;
+
+   len = buf[0] | (buf[1] << 8);
+   if (!len)
+      return true;
+
+   if (!(*s = (char*)malloc(len + 1)))
+      return false;
+
+   if (fread(*s, 1, len, file) != len)
+      return false;
+
+   (*s)[len] = '\0';
+   return true;
+}
+
+static bool database_scan_cache_read_entry(database_scan_cache_t *cache,
+      FILE *file, bool keep_matches)
+{
+   uint8_t flags;
+   uint32_t i, num_matches;
+   char *path                         = NULL;
+   database_scan_cache_entry_t *entry = NULL;
+
+   if (!database_scan_cache_read_str(file, &path) || !path)
+      goto error;
+
+   /* Should not happen, but keep the table consistent. */
+   if (*database_scan_cache_slot(cache, path))
+      goto error;
+
+   if (!(entry = database_scan_cache_add(cache, path)))
+      goto error;
+
+   if (!database_scan_cache_read_u64(file, &entry->size)
+         || !database_scan_cache_read_u64(file, (uint64_t*)&entry->mtime)
+         || fread(&flags, 1, 1, file) != 1
+         || !database_scan_cache_read_u32(file, &entry->crc32)
+         || !database_scan_cache_read_str(file, &entry->serial)
+         || !database_scan_cache_read_str(file, &entry->zip_name)
+         || !database_scan_cache_read_u32(file, &num_matches))
+      return false;
+
+   entry->flags = flags;
+
+   if (num_matches > 0xffff)
+      return false;
+
+   if (num_matches)
+   {
+      entry->matches = (database_scan_cache_match_t*)
+         calloc(num_matches, sizeof(*entry->matches));
+      if (!entry->matches)
+         return false;
+   }
+
+   for (i = 0; i < num_matches; i++)
+   {
+      database_scan_cache_match_t *match = &entry->matches[i];
+
+      entry->num_matches++;
+
+      if (!database_scan_cache_read_str(file, &match->db_name)
+            || !database_scan_cache_read_str(file, &match->label)
+            || !database_scan_cache_read_u32(file, &match->crc32)
+            || !match->db_name)
+         return false;
+   }
+
+   if (!keep_matches)
+      database_scan_cache_clear_matches(entry);
+
+   return true;
+
+error:
+   free(path);
+   return false;
+}
+
+static void database_scan_cache_read(database_scan_cache_t *cache)
+{
+   uint32_t magic, version, signature, count, i;
+   FILE *file = fopen(cache->path, "rb");
+
+   if (!file)
+      return;
+
+   if (!database_scan_cache_read_u32(file, &magic)
+         || !database_scan_cache_read_u32(file, &version)
+         || !database_scan_cache_read_u32(file, &signature)
+         || !database_scan_cache_read_u32(file, &count)
+         || magic   != DATABASE_SCAN_CACHE_MAGIC
+         || version != DATABASE_SCAN_CACHE_VERSION)
+      goto end;
+
+   for (i = 0; i < count; i++)
+   {
+      if (!database_scan_cache_read_entry(cache, file,
+               signature == cache->signature))
+      {
+         /* Truncated file, drop the entry that could not be read
+          * completely and keep the ones before it. */
+         if (cache->count > i)
+         {
+            database_scan_cache_entry_t *entry = &cache->entries[--cache->count];
+            database_scan_cache_clear_entry(entry);
+            free(entry->path);
+            database_scan_cache_rehash(cache, cache->num_slots);
+         }
+         break;
+      }
+   }
+
+   /* Matches were dropped for the new databases. */
+   if (signature != cache->signature)
+      cache->dirty = true;
+
+end:
+   fclose(file);
+}
+
+static bool database_scan_cache_write_u32(FILE *file, uint32_t value)
+{
+   uint8_t buf[4];
+
+   buf[0] = value;
+   buf[1] = value >> 8;
+   buf[2] = value >> 16;
+   buf[3] = value >> 24;
+
+   return fwrite(buf, 1, sizeof(buf), file) == sizeof(buf);
+}
+
+static bool database_scan_cache_write_u64(FILE *file, uint64_t value)
+{
+   return database_scan_cache_write_u32(file, (uint32_t)value)
+      && database_scan_cache_write_u32(file, (uint32_t)(value >> 32));
+}
+
+static bool database_scan_cache_write_str(FILE *file, const char *s)
+{
+   uint8_t buf[2];
+   size_t len = s ? strlen(s) : 0;
+
+   if (len > 0xffff)
+      len = 0;
+
+   buf[0] = len;
+   buf[1] = len >> 8;
+
+   return fwrite(buf, 1, sizeof(buf), file) == sizeof(buf)
+      && (!len || fwrite(s, 1, len, file) == len);
+}
+
+static bool database_scan_cache_write_entry(FILE *file,
+      const database_scan_cache_entry_t *entry)
+{
+   size_t i;
+   uint8_t flags      = entry->flags;
+   /* Matches of a lookup that did not finish are incomplete. */
+   size_t num_matches = (flags & DATABASE_SCAN_CACHE_LOOKED_UP) ?
+      entry->num_matches : 0;
+
+   if (!database_scan_cache_write_str(file, entry->path)
+         || !database_scan_cache_write_u64(file, entry->size)
+         || !database_scan_cache_write_u64(file, (uint64_t)entry->mtime)
+         || fwrite(&flags, 1, 1, file) != 1
+         || !database_scan_cache_write_u32(file, entry->crc32)
+         || !database_scan_cache_write_str(file, entry->serial)
+         || !database_scan_cache_write_str(file, entry->zip_name)
+         || !database_scan_cache_write_u32(file, num_matches))
+      return false;
+
+   for (i = 0; i < num_matches; i++)
+   {
+      const database_scan_cache_match_t *match = &entry->matches[i];
+
+      if (!database_scan_cache_write_str(file, match->db_name)
+            || !database_scan_cache_write_str(file, match->label)
+            || !database_scan_cache_write_u32(file, match->crc32))
+         return false;
+   }
+
+   return true;
+}
+
+bool database_scan_cache_write(database_scan_cache_t *cache)
+{
+   size_t i;
+   bool ret   = true;
+   FILE *file = NULL;
+
+   if (!cache || !cache->dirty)
+      return true;
+
+   if (!(file = fopen(cache->path, "wb")))
+      return false;
+
+   ret = database_scan_cache_write_u32(file, DATABASE_SCAN_CACHE_MAGIC)
+      && database_scan_cache_write_u32(file, DATABASE_SCAN_CACHE_VERSION)
+      && database_scan_cache_write_u32(file, cache->signature)
+      && database_scan_cache_write_u32(file, cache->count);
+
+   for (i = 0; ret && i < cache->count; i++)
+      ret = database_scan_cache_write_entry(file, &cache->entries[i]);
+
+   if (fclose(file) != 0)
+      ret = false;
+
+   if (ret)
+      cache->dirty = false;
+
+   return ret;
+}
+
+/* Whether @path is a file right inside @dir. */
+static bool database_scan_cache_in_dir(const char *path,
+      const char *dir, size_t dir_len)
+{
+   const char *name = path + dir_len;
+
+   if (strncmp(path, dir, dir_len))
+      return false;
+
+   if (dir[dir_len - 1] != '/' && dir[dir_len - 1] != '\\')
+   {
+      if (*name != '/' && *name != '\\')
+         return false;
+      name++;
+   }
+
+   return *name && !strchr(name, '/') && !strchr(name, '\\');
+}
+
+void database_scan_cache_prune(database_scan_cache_t *cache,
+      const char *dir)
+{
+   size_t i;
+   size_t count = 0;
+   size_t dir_len;
+
+   if (!cache || !dir || !*dir)
+      return;
+
+   dir_len = strlen(dir);
+
+   for (i = 0; i < cache->count; i++)
+   {
+      database_scan_cache_entry_t *entry = &cache->entries[i];
+
+      if (!entry->seen
+            && database_scan_cache_in_dir(entry->path, dir, dir_len))
+      {
+         database_scan_cache_clear_entry(entry);
+         free(entry->path);
+         continue;
+      }
+
+      cache->entries[count++] = *entry;
+   }
+
+   if (count == cache->count)
+      return;
+
+   cache->count = count;
+   cache->dirty = true;
+   database_scan_cache_rehash(cache, cache->num_slots);
+}
+
+database_scan_cache_t *database_scan_cache_new(const char *path,
+      uint32_t signature)
+{
+   database_scan_cache_t *cache = (database_scan_cache_t*)
+      calloc(1, sizeof(*cache));
+
+   if (!cache)
+      return NULL;
+
+   cache->signature = signature;
+
+   if (!(cache->path = strdup(path))
+         || !database_scan_cache_rehash(cache, 512))
+   {
+      database_scan_cache_free(cache);
+      return NULL;
+   }
+
+   database_scan_cache_read(cache);
+
+   return cache;
+}
+
+void database_scan_cache_free(database_scan_cache_t *cache)
+{
+   size_t i;
+
+   if (!cache)
+      return;
+
+   for (i = 0; i < cache->count; i++)
+   {
+      database_scan_cache_clear_entry(&cache->entries[i]);
+      free(cache->entries[i].path);
+   }
+
+   free(cache->entries);
+   free(cache->slots);
+   free(cache->path);
+   free(cache);
+}
+
+database_scan_cache_entry_t *database_scan_cache_find(
+      database_scan_cache_t *cache, const char *path,
+      uint64_t size, int64_t mtime)
+{
+   size_t index;
+   database_scan_cache_entry_t *entry = NULL;
+
+   if (!cache || !path)
+      return NULL;
+
+   if (!(index = *database_scan_cache_slot(cache, path)))
+      return NULL;
+
+   entry = &cache->entries[index - 1];
+
+   if (entry->size != size || entry->mtime != mtime)
+      return NULL;
+
+   entry->seen = true;
+   return entry;
+}
+
+database_scan_cache_entry_t *database_scan_cache_update(
+      database_scan_cache_t *cache, const char *path,
+      uint64_t size, int64_t mtime)
+{
+   size_t index;
+   char *path_copy                    = NULL;
+   database_scan_cache_entry_t *entry = NULL;
+
+   if (!cache || !path)
+      return NULL;
+
+   if ((index = *database_scan_cache_slot(cache, path)))
+   {
+      entry = &cache->entries[index - 1];
+      database_scan_cache_clear_entry(entry);
+   }
+   else
+   {
+      if (!(path_copy = strdup(path)))
+         return NULL;
+
+      if (!(entry = database_scan_cache_add(cache, path_copy)))
+      {
+         free(path_copy);
+         return NULL;
+      }
+   }
+
+   entry->size  = size;
+   entry->mtime = mtime;
+   entry->seen  = true;
+   cache->dirty = true;
+
+   return entry;
+}
+
+bool database_scan_cache_set_crc(database_scan_cache_t *cache,
+      database_scan_cache_entry_t *entry, uint32_t crc32,
+      const char *zip_name)
+{
+   if (!cache || !entry)
+      return false;
+
+   free(entry->zip_name);
+   entry->zip_name = database_scan_cache_strdup(zip_name);
+   entry->crc32    = crc32;
+   entry->flags   |= DATABASE_SCAN_CACHE_HAS_CRC;
+   cache->dirty    = true;
+
+   return !zip_name || !*zip_name || entry->zip_name;
+}
+
+bool database_scan_cache_set_serial(database_scan_cache_t *cache,
+      database_scan_cache_entry_t *entry, const char *serial)
+{
+   if (!cache || !entry)
+      return false;
+
+   free(entry->serial);
+   if (!(entry->serial = database_scan_cache_strdup(serial)))
+      return false;
+
+   entry->flags |= DATABASE_SCAN_CACHE_HAS_SERIAL;
+   cache->dirty  = true;
+
+   return true;
+}
+
+bool database_scan_cache_add_match(database_scan_cache_t *cache,
+      database_scan_cache_entry_t *entry, const char *db_name,
+      const char *label, uint32_t crc32)
+{
+   database_scan_cache_match_t *matches = NULL;
+   database_scan_cache_match_t *match   = NULL;
+
+   if (!cache || !entry || !db_name)
+      return false;
+
+   matches = (database_scan_cache_match_t*)realloc(entry->matches,
+         (entry->num_matches + 1) * sizeof(*matches));
+   if (!matches)
+      return false;
+
+   entry->matches = matches;
+   match          = &matches[entry->num_matches];
+   match->db_name = strdup(db_name);
+   match->label   = database_scan_cache_strdup(label);
+   match->crc32   = crc32;
+
+   if (!match->db_name)
+   {
+      free(match->label);
+      return false;
+   }
+
+   entry->num_matches++;
+   cache->dirty = true;
+
+   return true;
+}
+
+void database_scan_cache_set_looked_up(database_scan_cache_t *cache,
+      database_scan_cache_entry_t *entry)
+{
+   if (!cache || !entry)
+      return;
+
+   entry->flags |= DATABASE_SCAN_CACHE_LOOKED_UP;
+   cache->dirty  = true;
+}
+
+size_t database_scan_cache_size(const database_scan_cache_t *cache)
+{
+   return cache ? cache->count : 0;
+}
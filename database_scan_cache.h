@@ -0,0 +1,159 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASE_SCAN_CACHE_H_
+#define DATABASE_SCAN_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Remembers what the database scanner found out about a file,
+ * so that rescans can skip files which did not change.
+ *
+ * A file is identified by its path, size and modification time.
+ * Its CRC32 or serial stays valid as long as those match, the
+ * matches found for it only as long as the databases do not change
+ * either. The databases are summed up in a signature, when that
+ * differs from the one stored in the cache file all matches are
+ * dropped, but the CRCs are kept. */
+
+enum database_scan_cache_flags
+{
+   DATABASE_SCAN_CACHE_HAS_CRC     = (1 << 0),
+   DATABASE_SCAN_CACHE_HAS_SERIAL  = (1 << 1),
+   /* All databases were searched, @matches is complete. */
+   DATABASE_SCAN_CACHE_LOOKED_UP   = (1 << 2)
+};
+
+typedef struct database_scan_cache_match
+{
+   /* Playlist name, like "Nintendo - Super Nintendo Entertainment System.lpl". */
+   char *db_name;
+   char *label;
+   uint32_t crc32;
+} database_scan_cache_match_t;
+
+typedef struct database_scan_cache_entry
+{
+   char *path;
+   uint64_t size;
+   int64_t mtime;
+   unsigned flags;
+   uint32_t crc32;
+   char *serial;
+   /* Archive member the CRC belongs to, if any. */
+   char *zip_name;
+   database_scan_cache_match_t *matches;
+   size_t num_matches;
+   /* Found or updated during this scan. */
+   bool seen;
+} database_scan_cache_entry_t;
+
+typedef struct database_scan_cache database_scan_cache_t;
+
+/**
+ * database_scan_cache_new:
+ * @path       : path of the cache file.
+ * @signature  : signature of the current databases.
+ *
+ * Loads the scan cache from @path. A missing or unreadable cache
+ * file results in an empty cache.
+ *
+ * Returns: scan cache handle, NULL on allocation failure.
+ **/
+database_scan_cache_t *database_scan_cache_new(const char *path,
+      uint32_t signature);
+
+/**
+ * database_scan_cache_write:
+ * @cache      : scan cache handle.
+ *
+ * Writes the cache back to its file, if anything changed.
+ *
+ * Returns: true on success, otherwise false.
+ **/
+bool database_scan_cache_write(database_scan_cache_t *cache);
+
+void database_scan_cache_free(database_scan_cache_t *cache);
+
+/**
+ * database_scan_cache_prune:
+ * @cache      : scan cache handle.
+ * @dir        : directory that was scanned completely.
+ *
+ * Drops the entries of files right inside @dir which the scan did
+ * not come across, so the cache does not keep growing with removed
+ * content. Entries of other directories are kept. Invalidates
+ * pointers to entries.
+ **/
+void database_scan_cache_prune(database_scan_cache_t *cache,
+      const char *dir);
+
+/**
+ * database_scan_cache_find:
+ * @cache      : scan cache handle.
+ * @path       : path of the file.
+ * @size       : current size of the file.
+ * @mtime      : current modification time of the file.
+ *
+ * Returns: entry of @path, or NULL if there is none or the
+ * file changed since it was cached.
+ **/
+database_scan_cache_entry_t *database_scan_cache_find(
+      database_scan_cache_t *cache, const char *path,
+      uint64_t size, int64_t mtime);
+
+/**
+ * database_scan_cache_update:
+ * @cache      : scan cache handle.
+ * @path       : path of the file.
+ * @size       : current size of the file.
+ * @mtime      : current modification time of the file.
+ *
+ * Starts over the entry of @path, for a file that is scanned again.
+ * The entry stays valid until the next call.
+ *
+ * Returns: empty entry of @path, NULL on allocation failure.
+ **/
+database_scan_cache_entry_t *database_scan_cache_update(
+      database_scan_cache_t *cache, const char *path,
+      uint64_t size, int64_t mtime);
+
+bool database_scan_cache_set_crc(database_scan_cache_t *cache,
+      database_scan_cache_entry_t *entry, uint32_t crc32,
+      const char *zip_name);
+
+bool database_scan_cache_set_serial(database_scan_cache_t *cache,
+      database_scan_cache_entry_t *entry, const char *serial);
+
+bool database_scan_cache_add_match(database_scan_cache_t *cache,
+      database_scan_cache_entry_t *entry, const char *db_name,
+      const char *label, uint32_t crc32);
+
+void database_scan_cache_set_looked_up(database_scan_cache_t *cache,
+      database_scan_cache_entry_t *entry);
+
+size_t database_scan_cache_size(const database_scan_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -23,20 +23,16 @@
 
 #include <retro_miscellaneous.h>
 #include <file/file_path.h>
+#include <file/file_extract.h>
 
 #include "zip_support.h"
 
-#include "../deps/zlib/unzip.h"
-
-/* Undefined at the end of the file
- * Don't use outside of this file
- */
-#define RARCH_ZIP_SUPPORT_BUFFER_SIZE_MAX 16384
-
 /* Extract the relative path relative_path from a 
- * zip archive archive_path and allocate a buf for it to write it in. */
-/* This code is inspired by:
- * stackoverflow.com/questions/10440113/simple-way-to-unzip-a-zip-file-using-zlib
+ * zip archive archive_path and allocate a buf for it to write it in.
+ *
+ * The entry is looked up in the cached central directory of the
+ * archive and only that entry is inflated, straight from the
+ * archive into the buffer.
  *
  * optional_outfile if not NULL will be used to extract the file. buf will be 0
  * then.
@@ -46,149 +42,43 @@ int read_zip_file(const char *archive_path,
       const char *relative_path, void **buf,
       const char* optional_outfile)
 {
-   uLong i;
-   unz_global_info global_info;
-   ssize_t    bytes_read = -1;
-   bool finished_reading = false;
-   unzFile      *zipfile = (unzFile*)unzOpen(archive_path);
+   size_t len                            = 0;
+   const struct zlib_index_entry *entry  = NULL;
+   const zlib_index_t *index             = zlib_index_get(archive_path);
 
-   if (!zipfile)
+   if (!index)
    {
-      RARCH_ERR("Could not open ZIP file %s.\n",archive_path);
+      RARCH_ERR("Could not read ZIP file %s.\n", archive_path);
       return -1;
    }
 
-   /* Get info about the zip file */
-   if (unzGetGlobalInfo(zipfile, &global_info) != UNZ_OK)
-   {
-      RARCH_ERR("Could not get global ZIP file info of %s."
-                "Could be only a GZIP file without the ZIP part.\n",
-                archive_path);
-      goto error;
-   }
+   entry = zlib_index_find(index, relative_path);
 
-   for ( i = 0; i < global_info.number_entry; ++i )
+   if (!entry)
    {
-      /* Get info about current file. */
-      unz_file_info file_info;
-      char filename[PATH_MAX_LENGTH] = {0};
-      char last_char = ' ';
-
-      if (unzGetCurrentFileInfo(
-            zipfile,
-            &file_info,
-            filename,
-            PATH_MAX_LENGTH,
-            NULL, 0, NULL, 0 ) != UNZ_OK )
-      {
-         RARCH_ERR("Could not read file info in ZIP %s.\n",
-               archive_path);
-         goto error;
-      }
-
-      /* Check if this entry is a directory or file. */
-      last_char = filename[strlen(filename)-1];
-
-      if ( last_char == '/' || last_char == '\\' )
-      {
-         /* We skip directories */
-      }
-      else if (!strcmp(filename, relative_path))
-      {
-         /* We found the correct file in the zip, 
-          * now extract it to *buf. */
-         if (unzOpenCurrentFile(zipfile) != UNZ_OK )
-         {
-            RARCH_ERR("The file %s in %s could not be read.\n", 
-                  relative_path, archive_path);
-            goto error;
-         }
-
-         if (optional_outfile == 0)
-         {
-            /* Allocate outbuffer */
-            *buf       = malloc(file_info.uncompressed_size + 1 );
-            bytes_read = unzReadCurrentFile(zipfile, *buf, file_info.uncompressed_size);
-
-            if (bytes_read != (ssize_t)file_info.uncompressed_size)
-            {
-               RARCH_ERR(
-                     "Tried to read %d bytes, but only got %d of file %s in ZIP %s.\n",
-                     (unsigned int) file_info.uncompressed_size, (int)bytes_read,
-                     relative_path, archive_path);
-               free(*buf);
-               goto close;
-            }
-            ((char*)(*buf))[file_info.uncompressed_size] = '\0';
-         }
-         else
-         {
-            char read_buffer[RARCH_ZIP_SUPPORT_BUFFER_SIZE_MAX] = {0};
-            FILE* outsink = fopen(optional_outfile,"wb");
-
-            if (outsink == NULL)
-            {
-               RARCH_ERR("Could not open outfilepath %s.\n", optional_outfile);
-               goto close;
-            }
-
-            bytes_read = 0;
-
-            do
-            {
-               ssize_t fwrite_bytes;
-
-               bytes_read = unzReadCurrentFile(zipfile, read_buffer,
-                     RARCH_ZIP_SUPPORT_BUFFER_SIZE_MAX );
-               fwrite_bytes = fwrite(read_buffer,1,bytes_read,outsink);
-
-               if (fwrite_bytes == bytes_read)
-                  continue;
-
-               /* couldn't write all bytes */
-               RARCH_ERR("Error writing to %s.\n",optional_outfile);
-               fclose(outsink);
-               goto close;
-            } while(bytes_read > 0);
-
-            fclose(outsink);
-         }
-         finished_reading = true;
-      }
-
-      unzCloseCurrentFile(zipfile);
+      RARCH_ERR("File %s not found in %s\n",
+            relative_path, archive_path);
+      return -1;
+   }
 
-      if (finished_reading)
-         break;
+   len = entry->size;
 
-      if ((i + 1) < global_info.number_entry)
+   if (optional_outfile)
+   {
+      if (!zlib_extract_to_file(archive_path, relative_path,
+               optional_outfile))
       {
-         if (unzGoToNextFile(zipfile) == UNZ_OK)
-            continue;
-
-         RARCH_ERR(
-               "Could not iterate to next file in %s. ZIP file might be corrupt.\n",
-               archive_path );
-         goto error;
+         RARCH_ERR("Could not extract %s in %s to %s.\n",
+               relative_path, archive_path, optional_outfile);
+         return -1;
       }
    }
-
-   unzClose(zipfile);
-
-   if(!finished_reading)
+   else if (!zlib_extract_to_buffer(archive_path, relative_path, buf, &len))
    {
-      RARCH_ERR("File %s not found in %s\n",
+      RARCH_ERR("The file %s in %s could not be read.\n",
             relative_path, archive_path);
       return -1;
    }
 
-   return bytes_read;
-
-close:
-   unzCloseCurrentFile(zipfile);
-error:
-   unzClose(zipfile);
-   return -1;
+   return len;
 }
-
-#undef RARCH_ZIP_SUPPORT_BUFFER_SIZE_MAX
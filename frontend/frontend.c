@@ -23,6 +23,8 @@
 #include "../retroarch.h"
 #include "../runloop.h"
 #include "../runloop_data.h"
+#include "../performance/performance_trace.h"
+#include "../benchmark.h"
 
 #include "frontend.h"
 
@@ -85,6 +87,8 @@ void main_exit(void *args)
 
    main_exit_save_config();
 
+   rarch_benchmark_report();
+
    if (global->main_is_init)
    {
 #ifdef HAVE_MENU
@@ -96,6 +100,16 @@ void main_exit(void *args)
 
    event_command(EVENT_CMD_PERFCNT_REPORT_FRONTEND_LOG);
 
+   if (global->perfcnt_trace_enable)
+   {
+      const char *path = *global->perfcnt_trace_path ?
+         global->perfcnt_trace_path : PERF_TRACE_DEFAULT_PATH;
+
+      if (perf_trace_dump(path))
+         RARCH_LOG("[PERF]: Wrote trace to \"%s\".\n", path);
+      perf_trace_deinit();
+   }
+
 #if defined(HAVE_LOGGER) && !defined(ANDROID)
    logger_shutdown();
 #endif
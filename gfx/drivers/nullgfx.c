@@ -18,6 +18,8 @@
 #include "../../driver.h"
 #include "../video_viewport.h"
 
+static uint64_t null_gfx_frame_count;
+
 static void *null_gfx_init(const video_info_t *video,
       const input_driver_t **input, void **input_data)
 {
@@ -25,6 +27,8 @@ static void *null_gfx_init(const video_info_t *video,
    *input_data = NULL;
    (void)video;
 
+   null_gfx_frame_count = 0;
+
    return (void*)-1;
 }
 
@@ -38,6 +42,8 @@ static bool null_gfx_frame(void *data, const void *frame,
    (void)pitch;
    (void)msg;
 
+   null_gfx_frame_count++;
+
    return true;
 }
 
@@ -109,11 +115,38 @@ static bool null_gfx_read_viewport(void *data, uint8_t *buffer)
    return true;
 }
 
+static uint64_t null_gfx_get_frame_count(void *data)
+{
+   (void)data;
+   return null_gfx_frame_count;
+}
+
+static const video_poke_interface_t null_gfx_poke_interface = {
+   null_gfx_get_frame_count,
+   NULL, /* set_video_mode */
+   NULL, /* set_filtering */
+   NULL, /* get_video_output_size */
+   NULL, /* get_video_output_prev */
+   NULL, /* get_video_output_next */
+   NULL, /* get_current_framebuffer */
+   NULL, /* get_proc_address */
+   NULL, /* set_aspect_ratio */
+   NULL, /* apply_state_changes */
+#ifdef HAVE_MENU
+   NULL, /* set_texture_frame */
+   NULL, /* set_texture_enable */
+#endif
+   NULL, /* set_osd_msg */
+   NULL, /* show_mouse */
+   NULL, /* grab_mouse_toggle */
+   NULL, /* get_current_shader */
+};
+
 static void null_gfx_get_poke_interface(void *data,
       const video_poke_interface_t **iface)
 {
    (void)data;
-   (void)iface;
+   *iface = &null_gfx_poke_interface;
 }
 
 video_driver_t video_null = {
@@ -74,12 +74,24 @@ static void filter_thread_loop(void *data)
 }
 #endif
 
+struct rarch_softfilter_pass
+{
+   const struct softfilter_implementation *impl;
+   void *impl_data;
+
+   struct softfilter_work_packet *packets;
+   unsigned threads;
+
+   unsigned in_fmt;
+   enum retro_pixel_format out_pix_fmt;
+};
+
 struct rarch_softfilter
 {
    config_file_t *conf;
 
-   const struct softfilter_implementation *impl;
-   void *impl_data;
+   struct rarch_softfilter_pass *passes;
+   unsigned num_passes;
 
    struct rarch_soft_plug *plugs;
    unsigned num_plugs;
@@ -87,7 +99,14 @@ struct rarch_softfilter
    unsigned max_width, max_height;
    enum retro_pixel_format pix_fmt, out_pix_fmt;
 
-   struct softfilter_work_packet *packets;
+   /* Intermediate frames of a chain. Pass i writes into
+    * buffers[i & 1] and the next pass reads it back, the last
+    * pass writes straight into the caller's output. */
+   void *buffers[2];
+   size_t buffer_size;
+
+   /* Size of the worker pool, the largest thread count
+    * of all passes. */
    unsigned threads;
 
 #ifdef HAVE_THREADS
@@ -118,33 +137,43 @@ static const struct softfilter_config softfilter_config = {
    config_userdata_free,
 };
 
-static bool create_softfilter_graph(rarch_softfilter_t *filt,
+static unsigned softfilter_fmt_bpp(enum retro_pixel_format fmt)
+{
+   return fmt == RETRO_PIXEL_FORMAT_XRGB8888 ?
+      SOFTFILTER_BPP_XRGB8888 : SOFTFILTER_BPP_RGB565;
+}
+
+/**
+ * create_softfilter_pass:
+ * @filt                 : Softfilter handle.
+ * @pass                 : Pass to create.
+ * @key                  : Config key naming the filter of this pass.
+ * @in_pixel_format      : Output format of the previous pass, or
+ *                         the core's format for the first one.
+ * @max_width            : Maximum input width of this pass.
+ * @max_height           : Maximum input height of this pass.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool create_softfilter_pass(rarch_softfilter_t *filt,
+      struct rarch_softfilter_pass *pass, const char *key,
       enum retro_pixel_format in_pixel_format,
       unsigned max_width, unsigned max_height,
       softfilter_simd_mask_t cpu_features,
       unsigned threads)
 {
-   unsigned input_fmts, input_fmt, output_fmts, i;
+   unsigned input_fmts, output_fmts, output_fmt;
    struct config_file_userdata userdata;
-   char key[64]  = {0};
    char name[64] = {0};
 
-   snprintf(key, sizeof(key), "filter");
-
    if (!config_get_array(filt->conf, key, name, sizeof(name)))
    {
-      RARCH_ERR("Could not find 'filter' array in config.\n");
+      RARCH_ERR("Could not find '%s' array in config.\n", key);
       return false;
    }
 
-   if (filt->num_plugs == 0)
-   {
-      RARCH_ERR("No filter plugs found. Exiting...\n");
-      return false;
-   }
-
-   filt->impl = softfilter_find_implementation(filt, name);
-   if (!filt->impl)
+   pass->impl = softfilter_find_implementation(filt, name);
+   if (!pass->impl)
    {
       RARCH_ERR("Could not find implementation.\n");
       return false;
@@ -153,85 +182,187 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
    userdata.conf = filt->conf;
    /* Index-specific configs take priority over ident-specific. */
    userdata.prefix[0] = key; 
-   userdata.prefix[1] = filt->impl->short_ident;
+   userdata.prefix[1] = pass->impl->short_ident;
 
    /* Simple assumptions. */
-   filt->pix_fmt = in_pixel_format;
-   input_fmts = filt->impl->query_input_formats();
+   input_fmts = pass->impl->query_input_formats();
 
    switch (in_pixel_format)
    {
       case RETRO_PIXEL_FORMAT_XRGB8888:
-         input_fmt = SOFTFILTER_FMT_XRGB8888;
+         pass->in_fmt = SOFTFILTER_FMT_XRGB8888;
          break;
       case RETRO_PIXEL_FORMAT_RGB565:
-         input_fmt = SOFTFILTER_FMT_RGB565;
+         pass->in_fmt = SOFTFILTER_FMT_RGB565;
          break;
       default:
          return false;
    }
 
-   if (!(input_fmt & input_fmts))
+   if (!(pass->in_fmt & input_fmts))
    {
       RARCH_ERR("Softfilter does not support input format.\n");
       return false;
    }
 
-   output_fmts = filt->impl->query_output_formats(input_fmt);
+   output_fmts = pass->impl->query_output_formats(pass->in_fmt);
    /* If we have a match of input/output formats, use that. */
-   if (output_fmts & input_fmt)
-      filt->out_pix_fmt = in_pixel_format;
+   if (output_fmts & pass->in_fmt)
+   {
+      pass->out_pix_fmt = in_pixel_format;
+      output_fmt        = pass->in_fmt;
+   }
    else if (output_fmts & SOFTFILTER_FMT_XRGB8888)
-      filt->out_pix_fmt = RETRO_PIXEL_FORMAT_XRGB8888;
+   {
+      pass->out_pix_fmt = RETRO_PIXEL_FORMAT_XRGB8888;
+      output_fmt        = SOFTFILTER_FMT_XRGB8888;
+   }
    else if (output_fmts & SOFTFILTER_FMT_RGB565)
-      filt->out_pix_fmt = RETRO_PIXEL_FORMAT_RGB565;
+   {
+      pass->out_pix_fmt = RETRO_PIXEL_FORMAT_RGB565;
+      output_fmt        = SOFTFILTER_FMT_RGB565;
+   }
    else
    {
       RARCH_ERR("Did not find suitable output format for softfilter.\n");
       return false;
    }
 
-   filt->max_width = max_width;
-   filt->max_height = max_height;
-
-   filt->impl_data = filt->impl->create(
-         &softfilter_config, input_fmt, input_fmt, max_width, max_height,
+   pass->impl_data = pass->impl->create(
+         &softfilter_config, pass->in_fmt, output_fmt,
+         max_width, max_height,
          threads != RARCH_SOFTFILTER_THREADS_AUTO ? threads : 
          rarch_get_cpu_cores(), cpu_features,
          &userdata);
-   if (!filt->impl_data)
+   if (!pass->impl_data)
    {
       RARCH_ERR("Failed to create softfilter state.\n");
       return false;
    }
 
-   threads = filt->impl->query_num_threads(filt->impl_data);
-   if (!threads)
+   pass->threads = pass->impl->query_num_threads(pass->impl_data);
+   if (!pass->threads)
    {
       RARCH_ERR("Invalid number of threads.\n");
       return false;
    }
 
-   RARCH_LOG("Using %u threads for softfilter.\n", threads);
-
-   filt->packets = (struct softfilter_work_packet*)
-      calloc(threads, sizeof(*filt->packets));
-   if (!filt->packets)
+   pass->packets = (struct softfilter_work_packet*)
+      calloc(pass->threads, sizeof(*pass->packets));
+   if (!pass->packets)
    {
       RARCH_ERR("Failed to allocate softfilter packets.\n");
       return false;
    }
 
+   return true;
+}
+
+/**
+ * create_softfilter_graph:
+ *
+ * A config either names a single filter:
+ *
+ *    filter = scale2x
+ *
+ * or a chain of them, run in order:
+ *
+ *    filters = 2
+ *    filter0 = scale2x
+ *    filter1 = darken
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool create_softfilter_graph(rarch_softfilter_t *filt,
+      enum retro_pixel_format in_pixel_format,
+      unsigned max_width, unsigned max_height,
+      softfilter_simd_mask_t cpu_features,
+      unsigned threads)
+{
+   unsigned i, passes = 0;
+   unsigned width     = max_width;
+   unsigned height    = max_height;
+   bool chained       = config_get_uint(filt->conf, "filters", &passes);
+
+   if (!chained)
+      passes = 1;
+
+   if (passes == 0)
+   {
+      RARCH_ERR("No filters in config.\n");
+      return false;
+   }
+
+   if (filt->num_plugs == 0)
+   {
+      RARCH_ERR("No filter plugs found. Exiting...\n");
+      return false;
+   }
+
+   filt->passes = (struct rarch_softfilter_pass*)
+      calloc(passes, sizeof(*filt->passes));
+   if (!filt->passes)
+      return false;
+
+   filt->num_passes  = passes;
+   filt->pix_fmt     = in_pixel_format;
+   filt->out_pix_fmt = in_pixel_format;
+   filt->max_width   = max_width;
+   filt->max_height  = max_height;
+
+   for (i = 0; i < passes; i++)
+   {
+      struct rarch_softfilter_pass *pass = &filt->passes[i];
+      char key[64] = {0};
+
+      if (chained)
+         snprintf(key, sizeof(key), "filter%u", i);
+      else
+         snprintf(key, sizeof(key), "filter");
+
+      if (!create_softfilter_pass(filt, pass, key, filt->out_pix_fmt,
+               width, height, cpu_features, threads))
+         return false;
+
+      pass->impl->query_output_size(pass->impl_data,
+            &width, &height, width, height);
+      filt->out_pix_fmt = pass->out_pix_fmt;
+
+      if (pass->threads > filt->threads)
+         filt->threads = pass->threads;
+
+      /* Every pass but the last one needs room for its output. */
+      if (i + 1 < passes)
+      {
+         size_t size = width * height * softfilter_fmt_bpp(pass->out_pix_fmt);
+         if (size > filt->buffer_size)
+            filt->buffer_size = size;
+      }
+   }
+
+   if (filt->buffer_size)
+   {
+      filt->buffers[0] = malloc(filt->buffer_size);
+      if (passes > 2)
+         filt->buffers[1] = malloc(filt->buffer_size);
+
+      if (!filt->buffers[0] || (passes > 2 && !filt->buffers[1]))
+      {
+         RARCH_ERR("Failed to allocate softfilter buffers.\n");
+         return false;
+      }
+   }
+
+   RARCH_LOG("Using %u threads for softfilter.\n", filt->threads);
+
 #ifdef HAVE_THREADS
    filt->thread_data = (struct filter_thread_data*)
-      calloc(threads, sizeof(*filt->thread_data));
+      calloc(filt->threads, sizeof(*filt->thread_data));
    if (!filt->thread_data)
       return false;
-   filt->threads = threads;
 
-   for (i = 0; i < threads; i++)
+   for (i = 0; i < filt->threads; i++)
    {
-      filt->thread_data[i].userdata = filt->impl_data;
       filt->thread_data[i].done = true;
 
       filt->thread_data[i].lock = slock_new();
@@ -438,9 +569,15 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
    if (!filt)
       return;
 
-   free(filt->packets);
-   if (filt->impl && filt->impl_data)
-      filt->impl->destroy(filt->impl_data);
+   for (i = 0; i < filt->num_passes; i++)
+   {
+      free(filt->passes[i].packets);
+      if (filt->passes[i].impl && filt->passes[i].impl_data)
+         filt->passes[i].impl->destroy(filt->passes[i].impl_data);
+   }
+   free(filt->passes);
+   free(filt->buffers[0]);
+   free(filt->buffers[1]);
 
 #ifdef HAVE_DYLIB
    for (i = 0; i < filt->num_plugs; i++)
@@ -452,7 +589,7 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
 #endif
 
 #ifdef HAVE_THREADS
-   for (i = 0; i < filt->threads; i++)
+   for (i = 0; filt->thread_data && i < filt->threads; i++)
    {
       if (!filt->thread_data[i].thread)
          continue;
@@ -466,6 +603,8 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
    }
    free(filt->thread_data);
 #endif
+   if (filt->conf)
+      config_file_free(filt->conf);
    free(filt);
 }
 
@@ -480,9 +619,24 @@ void rarch_softfilter_get_output_size(rarch_softfilter_t *filt,
       unsigned *out_width, unsigned *out_height,
       unsigned width, unsigned height)
 {
-   if (filt && filt->impl && filt->impl->query_output_size)
-      filt->impl->query_output_size(filt->impl_data, out_width,
-            out_height, width, height);
+   unsigned i;
+
+   if (!filt)
+      return;
+
+   for (i = 0; i < filt->num_passes; i++)
+   {
+      const struct rarch_softfilter_pass *pass = &filt->passes[i];
+
+      if (!pass->impl || !pass->impl->query_output_size)
+         return;
+
+      pass->impl->query_output_size(pass->impl_data, &width, &height,
+            width, height);
+   }
+
+   *out_width  = width;
+   *out_height = height;
 }
 
 enum retro_pixel_format rarch_softfilter_get_output_format(
@@ -491,24 +645,30 @@ enum retro_pixel_format rarch_softfilter_get_output_format(
    return filt->out_pix_fmt;
 }
 
-void rarch_softfilter_process(rarch_softfilter_t *filt,
-      void *output, size_t output_stride,
-      const void *input, unsigned width, unsigned height, size_t input_stride)
+/**
+ * softfilter_run_pass:
+ * @filt                 : Softfilter handle.
+ * @pass                 : Pass whose work packets are filled in.
+ *
+ * Runs the work packets of @pass on the worker pool and waits
+ * for them. Packet i always goes to worker i, so a worker filters
+ * the same band of the frame in every pass and mostly reads back
+ * what it wrote in the previous one.
+ **/
+static void softfilter_run_pass(rarch_softfilter_t *filt,
+      const struct rarch_softfilter_pass *pass)
 {
    unsigned i;
 
-   if (filt && filt->impl && filt->impl->get_work_packets)
-      filt->impl->get_work_packets(filt->impl_data, filt->packets,
-            output, output_stride, input, width, height, input_stride);
-   
 #ifdef HAVE_THREADS
    /* Fire off workers */
-   for (i = 0; i < filt->threads; i++)
+   for (i = 0; i < pass->threads; i++)
    {
 #if 0
       RARCH_LOG("Firing off filter thread %u ...\n", i);
 #endif
-      filt->thread_data[i].packet = &filt->packets[i];
+      filt->thread_data[i].packet   = &pass->packets[i];
+      filt->thread_data[i].userdata = pass->impl_data;
       slock_lock(filt->thread_data[i].lock);
       filt->thread_data[i].done = false;
       scond_signal(filt->thread_data[i].cond);
@@ -516,7 +676,7 @@ void rarch_softfilter_process(rarch_softfilter_t *filt,
    }
 
    /* Wait for workers */
-   for (i = 0; i < filt->threads; i++)
+   for (i = 0; i < pass->threads; i++)
    {
 #if 0
       RARCH_LOG("Waiting for filter thread %u ...\n", i);
@@ -527,8 +687,51 @@ void rarch_softfilter_process(rarch_softfilter_t *filt,
       slock_unlock(filt->thread_data[i].lock);
    }
 #else
-   for (i = 0; i < filt->threads; i++)
-      filt->packets[i].work(filt->impl_data, filt->packets[i].thread_data);
+   for (i = 0; i < pass->threads; i++)
+      if (pass->packets[i].work)
+         pass->packets[i].work(pass->impl_data, pass->packets[i].thread_data);
 #endif
 }
 
+void rarch_softfilter_process(rarch_softfilter_t *filt,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, size_t input_stride)
+{
+   unsigned i;
+
+   if (!filt)
+      return;
+
+   for (i = 0; i < filt->num_passes; i++)
+   {
+      const struct rarch_softfilter_pass *pass = &filt->passes[i];
+      void *pass_output          = output;
+      size_t pass_output_stride  = output_stride;
+      unsigned out_width         = width;
+      unsigned out_height        = height;
+
+      if (!pass->impl || !pass->impl->get_work_packets)
+         return;
+
+      pass->impl->query_output_size(pass->impl_data,
+            &out_width, &out_height, width, height);
+
+      if (i + 1 < filt->num_passes)
+      {
+         pass_output        = filt->buffers[i & 1];
+         pass_output_stride = out_width
+            * softfilter_fmt_bpp(pass->out_pix_fmt);
+      }
+
+      pass->impl->get_work_packets(pass->impl_data, pass->packets,
+            pass_output, pass_output_stride,
+            input, width, height, input_stride);
+
+      softfilter_run_pass(filt, pass);
+
+      input        = pass_output;
+      input_stride = pass_output_stride;
+      width        = out_width;
+      height       = out_height;
+   }
+}
@@ -34,6 +34,7 @@
 */
  
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -64,6 +65,7 @@ struct filter_data
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   int simd;
    uint16_t RGBtoYUV[65536];
    uint16_t tbl_5_to_8[32];
    uint16_t tbl_6_to_8[64];
@@ -225,7 +227,6 @@ static void *twoxbr_generic_create(const struct softfilter_config *config,
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
    (void)config;
    (void)userdata;
  
@@ -234,8 +235,11 @@ static void *twoxbr_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   filt->simd    = (simd & SOFTFILTER_SIMD_NATIVE) != 0;
+#endif
    if (!filt->workers)
    {
       free(filt);
@@ -534,6 +538,31 @@ int eq8(uint32_t A, uint32_t B,
      }\
  
  
+#define twoxbr_declare_variables(typename_t, in, prevline, prevline2, nextline, nextline2) \
+         typename_t E[4]; \
+         typename_t ex, e, i, ke, ki, ex2, ex3, px; \
+         typename_t A1 = *(in - prevline2 - 1); \
+         typename_t B1 = *(in - prevline2); \
+         typename_t C1 = *(in - prevline2 + 1); \
+         typename_t A0 = *(in - prevline - 2); \
+         typename_t PA = *(in - prevline - 1); \
+         typename_t PB = *(in - prevline); \
+         typename_t PC = *(in - prevline + 1); \
+         typename_t C4 = *(in - prevline + 2); \
+         typename_t D0 = *(in - 2); \
+         typename_t PD = *(in - 1); \
+         typename_t PE = *(in); \
+         typename_t PF = *(in + 1); \
+         typename_t F4 = *(in + 2); \
+         typename_t G0 = *(in + nextline - 2); \
+         typename_t PG = *(in + nextline - 1); \
+         typename_t PH = *(in + nextline); \
+         typename_t _PI = *(in + nextline + 1); \
+         typename_t I4 = *(in + nextline + 2); \
+         typename_t G5 = *(in + nextline2 - 1); \
+         typename_t H5 = *(in + nextline2); \
+         typename_t I5 = *(in + nextline2 + 1)
+
 #ifndef twoxbr_function
 #define twoxbr_function(FILTRO, Z) \
             E[0] = E[1] = E[2] = E[3] = PE;\
@@ -554,7 +583,7 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
       int first, int last, uint32_t *src,
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned nextline, finish;
+   unsigned y, finish;
    uint32_t pg_red_mask      = RED_MASK8888;
    uint32_t pg_green_mask    = GREEN_MASK8888;
    uint32_t pg_blue_mask     = BLUE_MASK8888;
@@ -564,38 +593,22 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
 
    (void)filt;
 
-   nextline = (last) ? 0 : src_stride;
-   
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned prevline2 = (first && y < 2) ?
+         prevline : prevline + src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
  
       for (finish = width; finish; finish -= 1)
       {
-         uint32_t E[4];
-         uint32_t ex, e, i, ke, ki, ex2, ex3, px;
-         uint32_t A1 = *(in - nextline - nextline - 1);
-         uint32_t B1 = *(in - nextline - nextline);
-         uint32_t C1 = *(in - nextline - nextline + 1);
-         uint32_t A0 = *(in - nextline - 2);
-         uint32_t PA = *(in - nextline - 1);
-         uint32_t PB = *(in - nextline);
-         uint32_t PC = *(in - nextline + 1);
-         uint32_t C4 = *(in - nextline + 2);
-         uint32_t D0 = *(in - 2);
-         uint32_t PD = *(in - 1);
-         uint32_t PE = *(in);
-         uint32_t PF = *(in + 1);
-         uint32_t F4 = *(in + 2);
-         uint32_t G0 = *(in + nextline - 2);
-         uint32_t PG = *(in + nextline - 1);
-         uint32_t PH = *(in + nextline);
-         uint32_t _PI = *(in + nextline + 1);
-         uint32_t I4 = *(in + nextline + 2);
-         uint32_t G5 = *(in + nextline + nextline - 1);
-         uint32_t H5 = *(in + nextline + nextline);
-         uint32_t I5 = *(in + nextline + nextline + 1);
+         twoxbr_declare_variables(uint32_t, in,
+               prevline, prevline2, nextline, nextline2);
  
          /*
           * Map of the pixels:          A1 B1 C1
@@ -618,46 +631,30 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
    uint16_t pg_red_mask, pg_green_mask, pg_blue_mask, pg_lbmask;
-   unsigned nextline, finish;
+   unsigned y, finish;
    struct filter_data *filt = (struct filter_data*)data;
 
    pg_red_mask   = RED_MASK565;
    pg_green_mask = GREEN_MASK565;
    pg_blue_mask  = BLUE_MASK565;
    pg_lbmask     = PG_LBMASK565;
-   nextline = (last) ? 0 : src_stride;
-   
  
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned prevline2 = (first && y < 2) ?
+         prevline : prevline + src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
  
       for (finish = width; finish; finish -= 1)
       {
-         uint16_t E[4];
-         uint16_t ex, e, i, ke, ki, ex2, ex3, px;
-         uint16_t A1 = *(in - nextline - nextline - 1);
-         uint16_t B1 = *(in - nextline - nextline);
-         uint16_t C1 = *(in - nextline - nextline + 1);
-         uint16_t A0 = *(in - nextline - 2);
-         uint16_t PA = *(in - nextline - 1);
-         uint16_t PB = *(in - nextline);
-         uint16_t PC = *(in - nextline + 1);
-         uint16_t C4 = *(in - nextline + 2);
-         uint16_t D0 = *(in - 2);
-         uint16_t PD = *(in - 1);
-         uint16_t PE = *(in);
-         uint16_t PF = *(in + 1);
-         uint16_t F4 = *(in + 2);
-         uint16_t G0 = *(in + nextline - 2);
-         uint16_t PG = *(in + nextline - 1);
-         uint16_t PH = *(in + nextline);
-         uint16_t _PI = *(in + nextline + 1);
-         uint16_t I4 = *(in + nextline + 2);
-         uint16_t G5 = *(in + nextline + nextline - 1);
-         uint16_t H5 = *(in + nextline + nextline);
-         uint16_t I5 = *(in + nextline + nextline + 1);
+         twoxbr_declare_variables(uint16_t, in,
+               prevline, prevline2, nextline, nextline2);
  
          /*
           * Map of the pixels:          A1 B1 C1
@@ -675,6 +672,169 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
    }
 }
  
+#ifdef SOFTFILTER_SIMD_NATIVE
+/* Every rule of twoxbr_function needs PE to differ from two
+ * orthogonal neighbours next to each other, otherwise all four
+ * outputs are PE. That holds for most pixels, so those are written
+ * a vector at a time and only the remaining ones, marked in edges,
+ * go through the scalar rules. */
+#define twoxbr_simd_flat(fmt, in, prevline, nextline, edges, any) \
+   { \
+      const sf_##fmt##_t PB = sf_load_##fmt(in - prevline); \
+      const sf_##fmt##_t PD = sf_load_##fmt(in - 1); \
+      const sf_##fmt##_t PE = sf_load_##fmt(in); \
+      const sf_##fmt##_t PF = sf_load_##fmt(in + 1); \
+      const sf_##fmt##_t PH = sf_load_##fmt(in + nextline); \
+      const sf_##fmt##_t flat = sf_or_##fmt( \
+            sf_and_##fmt(sf_eq_##fmt(PE, PF), sf_eq_##fmt(PE, PD)), \
+            sf_and_##fmt(sf_eq_##fmt(PE, PH), sf_eq_##fmt(PE, PB))); \
+      const sf_##fmt##_t edge = sf_andnot_##fmt(flat, \
+            sf_eq_##fmt(PE, PE)); \
+      \
+      sf_store2_##fmt(out, PE, PE); \
+      sf_store2_##fmt(out + dst_stride, PE, PE); \
+      sf_store_##fmt(edges, edge); \
+      any = sf_any_##fmt(edge); \
+   }
+
+static void twoxbr_simd_xrgb8888(void *data, unsigned width, unsigned height,
+      int first, int last, uint32_t *src,
+      unsigned src_stride, uint32_t *dst, unsigned dst_stride)
+{
+   unsigned y, finish;
+   uint32_t pg_red_mask      = RED_MASK8888;
+   uint32_t pg_green_mask    = GREEN_MASK8888;
+   uint32_t pg_blue_mask     = BLUE_MASK8888;
+   uint32_t pg_lbmask        = PG_LBMASK8888;
+   uint32_t pg_alpha_mask    = ALPHA_MASK8888;
+   struct filter_data *filt = (struct filter_data*)data;
+
+   (void)filt;
+
+   for (y = 0; y < height; y++)
+   {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned prevline2 = (first && y < 2) ?
+         prevline : prevline + src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
+      uint32_t *in  = (uint32_t*)src;
+      uint32_t *out = (uint32_t*)dst;
+
+      for (finish = width; finish >= SF_XRGB8888_LANES; finish -= SF_XRGB8888_LANES)
+      {
+         uint32_t edges[SF_XRGB8888_LANES];
+         unsigned lane;
+         int any;
+
+         twoxbr_simd_flat(xrgb8888, in, prevline, nextline, edges, any);
+
+         if (!any)
+         {
+            in  += SF_XRGB8888_LANES;
+            out += 2 * SF_XRGB8888_LANES;
+            continue;
+         }
+
+         for (lane = 0; lane < SF_XRGB8888_LANES; lane++)
+         {
+            if (edges[lane])
+            {
+               twoxbr_declare_variables(uint32_t, in,
+                     prevline, prevline2, nextline, nextline2);
+               twoxbr_function(FILTRO_RGB8888, filt);
+            }
+            else
+            {
+               in++;
+               out += 2;
+            }
+         }
+      }
+
+      for (; finish; finish -= 1)
+      {
+         twoxbr_declare_variables(uint32_t, in,
+               prevline, prevline2, nextline, nextline2);
+         twoxbr_function(FILTRO_RGB8888, filt);
+      }
+
+      src += src_stride;
+      dst += 2 * dst_stride;
+   }
+}
+
+static void twoxbr_simd_rgb565(void *data, unsigned width, unsigned height,
+      int first, int last, uint16_t *src,
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+{
+   uint16_t pg_red_mask, pg_green_mask, pg_blue_mask, pg_lbmask;
+   unsigned y, finish;
+   struct filter_data *filt = (struct filter_data*)data;
+
+   pg_red_mask   = RED_MASK565;
+   pg_green_mask = GREEN_MASK565;
+   pg_blue_mask  = BLUE_MASK565;
+   pg_lbmask     = PG_LBMASK565;
+
+   for (y = 0; y < height; y++)
+   {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned prevline2 = (first && y < 2) ?
+         prevline : prevline + src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
+      uint16_t *in  = (uint16_t*)src;
+      uint16_t *out = (uint16_t*)dst;
+
+      for (finish = width; finish >= SF_RGB565_LANES; finish -= SF_RGB565_LANES)
+      {
+         uint16_t edges[SF_RGB565_LANES];
+         unsigned lane;
+         int any;
+
+         twoxbr_simd_flat(rgb565, in, prevline, nextline, edges, any);
+
+         if (!any)
+         {
+            in  += SF_RGB565_LANES;
+            out += 2 * SF_RGB565_LANES;
+            continue;
+         }
+
+         for (lane = 0; lane < SF_RGB565_LANES; lane++)
+         {
+            if (edges[lane])
+            {
+               twoxbr_declare_variables(uint16_t, in,
+                     prevline, prevline2, nextline, nextline2);
+               twoxbr_function(FILTRO_RGB565, filt);
+            }
+            else
+            {
+               in++;
+               out += 2;
+            }
+         }
+      }
+
+      for (; finish; finish -= 1)
+      {
+         twoxbr_declare_variables(uint16_t, in,
+               prevline, prevline2, nextline, nextline2);
+         twoxbr_function(FILTRO_RGB565, filt);
+      }
+
+      src += src_stride;
+      dst += 2 * dst_stride;
+   }
+}
+#endif
+
 static void twoxbr_work_cb_rgb565(void *data, void *thread_data)
 {
    struct softfilter_thread_data *thr = 
@@ -683,6 +843,19 @@ static void twoxbr_work_cb_rgb565(void *data, void *thread_data)
    uint16_t *output = (uint16_t*)thr->out_data;
    unsigned width = thr->width;
    unsigned height = thr->height;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   struct filter_data *filt = (struct filter_data*)data;
+
+   if (filt->simd)
+   {
+    
+      twoxbr_simd_rgb565(data, width, height,
+            thr->first, thr->last, input,
+            thr->in_pitch / SOFTFILTER_BPP_RGB565, output,
+            thr->out_pitch / SOFTFILTER_BPP_RGB565);
+      return;
+   }
+#endif
  
    twoxbr_generic_rgb565(data, width, height,
          thr->first, thr->last, input,
@@ -698,6 +871,19 @@ static void twoxbr_work_cb_xrgb8888(void *data, void *thread_data)
    uint32_t *output = (uint32_t*)thr->out_data;
    unsigned width = thr->width;
    unsigned height = thr->height;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   struct filter_data *filt = (struct filter_data*)data;
+
+   if (filt->simd)
+   {
+    
+      twoxbr_simd_xrgb8888(data, width, height,
+            thr->first, thr->last, input,
+            thr->in_pitch / SOFTFILTER_BPP_XRGB8888, output,
+            thr->out_pitch / SOFTFILTER_BPP_XRGB8888);
+      return;
+   }
+#endif
  
    twoxbr_generic_xrgb8888(data, width, height,
          thr->first, thr->last, input,
@@ -713,13 +899,20 @@ static void twoxbr_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   unsigned bands = filt->threads;
+
+   /* Bands read up to two rows beyond their edges from the
+    * neighbouring bands, so keep them at least two rows high. */
+   if (bands > height / 2)
+      bands = (height > 1) ? height / 2 : 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
  
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = (i < bands) ? (height * i) / bands : height;
+      unsigned y_end   = (i < bands) ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * 
          TWOXBR_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
@@ -730,7 +923,7 @@ static void twoxbr_generic_packets(void *data,
  
       /* Workers need to know if they can access 
        * pixels outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
  
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
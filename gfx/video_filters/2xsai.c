@@ -15,6 +15,7 @@
  */
 
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -44,6 +45,7 @@ struct filter_data
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   int simd;
 };
 
 static unsigned twoxsai_generic_input_fmts(void)
@@ -67,7 +69,6 @@ static void *twoxsai_generic_create(const struct softfilter_config *config,
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
    (void)config;
    (void)userdata;
 
@@ -76,8 +77,11 @@ static void *twoxsai_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   filt->simd    = (simd & SOFTFILTER_SIMD_NATIVE) != 0;
+#endif
    if (!filt->workers)
    {
       free(filt);
@@ -118,12 +122,12 @@ static void twoxsai_generic_destroy(void *data)
 
 #define twoxsai_result(A, B, C, D) (((A) != (C) || (A) != (D)) - ((B) != (C) || (B) != (D)));
 
-#define twoxsai_declare_variables(typename_t, in, nextline) \
+#define twoxsai_declare_variables(typename_t, in, prevline, nextline, nextline2) \
          typename_t product, product1, product2; \
-         typename_t colorI = *(in - nextline - 1); \
-         typename_t colorE = *(in - nextline + 0); \
-         typename_t colorF = *(in - nextline + 1); \
-         typename_t colorJ = *(in - nextline + 2); \
+         typename_t colorI = *(in - prevline - 1); \
+         typename_t colorE = *(in - prevline + 0); \
+         typename_t colorF = *(in - prevline + 1); \
+         typename_t colorJ = *(in - prevline + 2); \
          typename_t colorG = *(in - 1); \
          typename_t colorA = *(in + 0); \
          typename_t colorB = *(in + 1); \
@@ -132,9 +136,9 @@ static void twoxsai_generic_destroy(void *data)
          typename_t colorC = *(in + nextline + 0); \
          typename_t colorD = *(in + nextline + 1); \
          typename_t colorL = *(in + nextline + 2); \
-         typename_t colorM = *(in + nextline + nextline - 1); \
-         typename_t colorN = *(in + nextline + nextline + 0); \
-         typename_t colorO = *(in + nextline + nextline + 1);
+         typename_t colorM = *(in + nextline2 - 1); \
+         typename_t colorN = *(in + nextline2 + 0); \
+         typename_t colorO = *(in + nextline2 + 1);
 
 #ifndef twoxsai_function
 #define twoxsai_function(result_cb, interpolate_cb, interpolate2_cb) \
@@ -228,17 +232,21 @@ static void twoxsai_generic_xrgb8888(unsigned width, unsigned height,
       int first, int last, uint32_t *src, 
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned nextline, finish;
-   nextline = (last) ? 0 : src_stride;
+   unsigned y, finish;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         twoxsai_declare_variables(uint32_t, in, nextline);
+         twoxsai_declare_variables(uint32_t, in, prevline, nextline, nextline2);
 
          /*
           * Map of the pixels:           I|E F|J
@@ -260,17 +268,21 @@ static void twoxsai_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src, 
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
-   unsigned nextline, finish;
-   nextline = (last) ? 0 : src_stride;
+   unsigned y, finish;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         twoxsai_declare_variables(uint16_t, in, nextline);
+         twoxsai_declare_variables(uint16_t, in, prevline, nextline, nextline2);
 
          /*
           * Map of the pixels:           I|E F|J
@@ -288,6 +300,162 @@ static void twoxsai_generic_rgb565(unsigned width, unsigned height,
    }
 }
 
+#ifdef SOFTFILTER_SIMD_NATIVE
+/* Branchless twoxsai_function over a whole vector of pixels.
+ * The four cases of the scalar version are mutually exclusive,
+ * so every one of them is computed and the results are merged. */
+#define twoxsai_simd_block(fmt, typename_t, in, prevline, nextline, nextline2) \
+   { \
+      const sf_##fmt##_t colorI = sf_load_##fmt(in - prevline - 1); \
+      const sf_##fmt##_t colorE = sf_load_##fmt(in - prevline + 0); \
+      const sf_##fmt##_t colorF = sf_load_##fmt(in - prevline + 1); \
+      const sf_##fmt##_t colorJ = sf_load_##fmt(in - prevline + 2); \
+      const sf_##fmt##_t colorG = sf_load_##fmt(in - 1); \
+      const sf_##fmt##_t colorA = sf_load_##fmt(in + 0); \
+      const sf_##fmt##_t colorB = sf_load_##fmt(in + 1); \
+      const sf_##fmt##_t colorK = sf_load_##fmt(in + 2); \
+      const sf_##fmt##_t colorH = sf_load_##fmt(in + nextline - 1); \
+      const sf_##fmt##_t colorC = sf_load_##fmt(in + nextline + 0); \
+      const sf_##fmt##_t colorD = sf_load_##fmt(in + nextline + 1); \
+      const sf_##fmt##_t colorL = sf_load_##fmt(in + nextline + 2); \
+      const sf_##fmt##_t colorM = sf_load_##fmt(in + nextline2 - 1); \
+      const sf_##fmt##_t colorN = sf_load_##fmt(in + nextline2 + 0); \
+      const sf_##fmt##_t colorO = sf_load_##fmt(in + nextline2 + 1); \
+      const sf_##fmt##_t eqAD = sf_eq_##fmt(colorA, colorD); \
+      const sf_##fmt##_t eqBC = sf_eq_##fmt(colorB, colorC); \
+      const sf_##fmt##_t case1 = sf_andnot_##fmt(eqBC, eqAD); \
+      const sf_##fmt##_t case2 = sf_andnot_##fmt(eqAD, eqBC); \
+      const sf_##fmt##_t case3 = sf_and_##fmt(eqAD, eqBC); \
+      const sf_##fmt##_t iAB = sf_interpolate_##fmt(colorA, colorB); \
+      const sf_##fmt##_t iAC = sf_interpolate_##fmt(colorA, colorC); \
+      const sf_##fmt##_t iABCD = sf_interpolate2_##fmt(colorA, colorB, colorC, colorD); \
+      /* A == C && A == F && B != E && B == J */ \
+      const sf_##fmt##_t keepA = sf_andnot_##fmt(sf_eq_##fmt(colorB, colorE), \
+            sf_and_##fmt(sf_and_##fmt(sf_eq_##fmt(colorA, colorC), \
+                  sf_eq_##fmt(colorA, colorF)), sf_eq_##fmt(colorB, colorJ))); \
+      /* B == E && B == D && A != F && A == I */ \
+      const sf_##fmt##_t keepB = sf_andnot_##fmt(sf_eq_##fmt(colorA, colorF), \
+            sf_and_##fmt(sf_and_##fmt(sf_eq_##fmt(colorB, colorE), \
+                  sf_eq_##fmt(colorB, colorD)), sf_eq_##fmt(colorA, colorI))); \
+      /* A == B && A == H && G != C && C == M */ \
+      const sf_##fmt##_t keep1A = sf_andnot_##fmt(sf_eq_##fmt(colorG, colorC), \
+            sf_and_##fmt(sf_and_##fmt(sf_eq_##fmt(colorA, colorB), \
+                  sf_eq_##fmt(colorA, colorH)), sf_eq_##fmt(colorC, colorM))); \
+      /* C == G && C == D && A != H && A == I */ \
+      const sf_##fmt##_t keep1C = sf_andnot_##fmt(sf_eq_##fmt(colorA, colorH), \
+            sf_and_##fmt(sf_and_##fmt(sf_eq_##fmt(colorC, colorG), \
+                  sf_eq_##fmt(colorC, colorD)), sf_eq_##fmt(colorA, colorI))); \
+      const sf_##fmt##_t r = sf_add_##fmt( \
+            sf_add_##fmt(sf_result_##fmt(colorA, colorB, colorG, colorE), \
+               sf_result_##fmt(colorB, colorA, colorK, colorF)), \
+            sf_add_##fmt(sf_result_##fmt(colorB, colorA, colorH, colorN), \
+               sf_result_##fmt(colorA, colorB, colorL, colorO))); \
+      sf_##fmt##_t product, product1, product2; \
+      \
+      /* When A == B, both interpolations and the vote collapse to A. */ \
+      product = sf_sel_##fmt(keepA, colorA, sf_sel_##fmt(keepB, colorB, iAB)); \
+      product = sf_sel_##fmt(case3, iAB, product); \
+      product = sf_sel_##fmt(case2, sf_sel_##fmt(sf_or_##fmt(keepB, \
+                  sf_and_##fmt(sf_eq_##fmt(colorB, colorF), sf_eq_##fmt(colorA, colorH))), \
+               colorB, iAB), product); \
+      product = sf_sel_##fmt(case1, sf_sel_##fmt(sf_or_##fmt(keepA, \
+                  sf_and_##fmt(sf_eq_##fmt(colorA, colorE), sf_eq_##fmt(colorB, colorL))), \
+               colorA, iAB), product); \
+      \
+      product1 = sf_sel_##fmt(keep1A, colorA, sf_sel_##fmt(keep1C, colorC, iAC)); \
+      product1 = sf_sel_##fmt(case3, iAC, product1); \
+      product1 = sf_sel_##fmt(case2, sf_sel_##fmt(sf_or_##fmt(keep1C, \
+                  sf_and_##fmt(sf_eq_##fmt(colorC, colorH), sf_eq_##fmt(colorA, colorF))), \
+               colorC, iAC), product1); \
+      product1 = sf_sel_##fmt(case1, sf_sel_##fmt(sf_or_##fmt(keep1A, \
+                  sf_and_##fmt(sf_eq_##fmt(colorA, colorG), sf_eq_##fmt(colorC, colorO))), \
+               colorA, iAC), product1); \
+      \
+      product2 = sf_sel_##fmt(sf_gtz_##fmt(r), colorA, \
+            sf_sel_##fmt(sf_ltz_##fmt(r), colorB, iABCD)); \
+      product2 = sf_sel_##fmt(case3, product2, iABCD); \
+      product2 = sf_sel_##fmt(case2, colorB, product2); \
+      product2 = sf_sel_##fmt(case1, colorA, product2); \
+      \
+      sf_store2_##fmt(out, colorA, product); \
+      sf_store2_##fmt(out + dst_stride, product1, product2); \
+   }
+
+static void twoxsai_simd_xrgb8888(unsigned width, unsigned height,
+      int first, int last, uint32_t *src, 
+      unsigned src_stride, uint32_t *dst, unsigned dst_stride)
+{
+   unsigned y, finish;
+
+   for (y = 0; y < height; y++)
+   {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
+      uint32_t *in  = (uint32_t*)src;
+      uint32_t *out = (uint32_t*)dst;
+
+      for (finish = width; finish >= SF_XRGB8888_LANES;
+            finish -= SF_XRGB8888_LANES)
+      {
+         twoxsai_simd_block(xrgb8888, uint32_t, in,
+               prevline, nextline, nextline2);
+         in  += SF_XRGB8888_LANES;
+         out += 2 * SF_XRGB8888_LANES;
+      }
+
+      for (; finish; finish -= 1)
+      {
+         twoxsai_declare_variables(uint32_t, in, prevline, nextline, nextline2);
+         twoxsai_function(twoxsai_result, twoxsai_interpolate_xrgb8888,
+               twoxsai_interpolate2_xrgb8888);
+      }
+
+      src += src_stride;
+      dst += 2 * dst_stride;
+   }
+}
+
+static void twoxsai_simd_rgb565(unsigned width, unsigned height,
+      int first, int last, uint16_t *src, 
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+{
+   unsigned y, finish;
+
+   for (y = 0; y < height; y++)
+   {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
+      uint16_t *in  = (uint16_t*)src;
+      uint16_t *out = (uint16_t*)dst;
+
+      for (finish = width; finish >= SF_RGB565_LANES;
+            finish -= SF_RGB565_LANES)
+      {
+         twoxsai_simd_block(rgb565, uint16_t, in,
+               prevline, nextline, nextline2);
+         in  += SF_RGB565_LANES;
+         out += 2 * SF_RGB565_LANES;
+      }
+
+      for (; finish; finish -= 1)
+      {
+         twoxsai_declare_variables(uint16_t, in, prevline, nextline, nextline2);
+         twoxsai_function(twoxsai_result, twoxsai_interpolate_rgb565,
+               twoxsai_interpolate2_rgb565);
+      }
+
+      src += src_stride;
+      dst += 2 * dst_stride;
+   }
+}
+#endif
+
 static void twoxsai_work_cb_rgb565(void *data, void *thread_data)
 {
    struct softfilter_thread_data *thr = 
@@ -296,6 +464,19 @@ static void twoxsai_work_cb_rgb565(void *data, void *thread_data)
    uint16_t *output = (uint16_t*)thr->out_data;
    unsigned width = thr->width;
    unsigned height = thr->height;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   struct filter_data *filt = (struct filter_data*)data;
+
+   if (filt->simd)
+   {
+      twoxsai_simd_rgb565(width, height,
+            thr->first, thr->last, input,
+            thr->in_pitch / SOFTFILTER_BPP_RGB565,
+            output,
+            thr->out_pitch / SOFTFILTER_BPP_RGB565);
+      return;
+   }
+#endif
 
    twoxsai_generic_rgb565(width, height,
          thr->first, thr->last, input,
@@ -312,6 +493,19 @@ static void twoxsai_work_cb_xrgb8888(void *data, void *thread_data)
    uint32_t *output = (uint32_t*)thr->out_data;
    unsigned width = thr->width;
    unsigned height = thr->height;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   struct filter_data *filt = (struct filter_data*)data;
+
+   if (filt->simd)
+   {
+      twoxsai_simd_xrgb8888(width, height,
+            thr->first, thr->last, input,
+            thr->in_pitch / SOFTFILTER_BPP_XRGB8888,
+            output,
+            thr->out_pitch / SOFTFILTER_BPP_XRGB8888);
+      return;
+   }
+#endif
 
    twoxsai_generic_xrgb8888(width, height,
          thr->first, thr->last, input,
@@ -328,13 +522,20 @@ static void twoxsai_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   unsigned bands = filt->threads;
+
+   /* Bands read up to two rows beyond their edges from the
+    * neighbouring bands, so keep them at least two rows high. */
+   if (bands > height / 2)
+      bands = (height > 1) ? height / 2 : 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = (i < bands) ? (height * i) / bands : height;
+      unsigned y_end   = (i < bands) ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * 
          TWOXSAI_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
@@ -346,7 +547,7 @@ static void twoxsai_generic_packets(void *data,
       /* Workers need to know if they can access pixels 
        * outside their given buffer.
        */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
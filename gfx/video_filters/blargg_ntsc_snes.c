@@ -15,6 +15,7 @@
  */
 
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -39,6 +40,7 @@ struct softfilter_thread_data
    unsigned height;
    int first;
    int last;
+   int burst;
 };
 
 struct filter_data
@@ -49,6 +51,7 @@ struct filter_data
    struct snes_ntsc_t *ntsc;
    int burst;
    int burst_toggle;
+   int simd;
 };
 
 
@@ -121,14 +124,15 @@ static void *blargg_ntsc_snes_generic_create(const struct softfilter_config *con
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
-
    struct filter_data *filt = (struct filter_data*)calloc(1, sizeof(*filt));
    if (!filt)
       return NULL;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   filt->simd    = (simd & SOFTFILTER_SIMD_NATIVE) != 0;
+#endif
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -164,27 +168,183 @@ static void blargg_ntsc_snes_generic_destroy(void *data)
    free(filt);
 }
 
+#ifdef SOFTFILTER_SIMD_NATIVE
+/* Only the low 32 bits of a kernel entry reach the output pixel,
+ * so the sums can be done in 32-bit lanes even where
+ * snes_ntsc_rgb_t is wider. */
+static INLINE sf_xrgb8888_t blargg_ntsc_snes_load_kernel(
+      const snes_ntsc_rgb_t *k)
+{
+   if (sizeof(snes_ntsc_rgb_t) == sizeof(uint32_t))
+      return sf_load_xrgb8888((const uint32_t*)k);
+#if defined(__SSE2__)
+   return _mm_castps_si128(_mm_shuffle_ps(
+            _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)k)),
+            _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(k + 2))),
+            _MM_SHUFFLE(2, 0, 2, 0)));
+#else
+   return vld2q_u32((const uint32_t*)k).val[0];
+#endif
+}
+
+static INLINE void blargg_ntsc_snes_store_rgb565(uint16_t *out,
+      sf_xrgb8888_t lo, sf_xrgb8888_t hi)
+{
+#if defined(__SSE2__)
+   lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+   hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+   _mm_storeu_si128((__m128i*)out, _mm_packs_epi32(lo, hi));
+#else
+   vst1q_u16(out, vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+#endif
+}
+
+/* SNES_NTSC_CLAMP_ and SNES_NTSC_RGB_OUT_ for 16 bits. */
+static INLINE sf_xrgb8888_t blargg_ntsc_snes_clamp_rgb565(sf_xrgb8888_t raw)
+{
+   sf_xrgb8888_t sub   = sf_and_xrgb8888(sf_srl_xrgb8888(raw, 8),
+         sf_set1_xrgb8888(snes_ntsc_clamp_mask));
+   sf_xrgb8888_t clamp = sf_sub_xrgb8888(
+         sf_set1_xrgb8888(snes_ntsc_clamp_add), sub);
+
+   raw   = sf_or_xrgb8888(raw, clamp);
+   clamp = sf_sub_xrgb8888(clamp, sub);
+   raw   = sf_and_xrgb8888(raw, clamp);
+
+   return sf_or_xrgb8888(sf_or_xrgb8888(
+            sf_and_xrgb8888(sf_srl_xrgb8888(raw, 12),
+               sf_set1_xrgb8888(0xF800)),
+            sf_and_xrgb8888(sf_srl_xrgb8888(raw, 7),
+               sf_set1_xrgb8888(0x07E0))),
+         sf_and_xrgb8888(sf_srl_xrgb8888(raw, 3),
+            sf_set1_xrgb8888(0x001F)));
+}
+
+static const uint32_t blargg_ntsc_snes_lanes01[4] = { ~0u, ~0u, 0, 0 };
+static const uint32_t blargg_ntsc_snes_lanes23[4] = { 0, 0, ~0u, ~0u };
+
+/* Generates the seven output pixels of a chunk at once, and junk
+ * in an eighth one. kN_A is the kernel of input slot N, A chunks ago.
+ * Unrolled from SNES_NTSC_RGB_OUT_14_: the first four pixels still
+ * see slot 1 and 2 of the previous chunk, the last three only
+ * slot 2 of it. */
+static INLINE void blargg_ntsc_snes_chunk_rgb565(uint16_t *out,
+      const snes_ntsc_rgb_t *k0_0, const snes_ntsc_rgb_t *k0_1,
+      const snes_ntsc_rgb_t *k1_0, const snes_ntsc_rgb_t *k1_1,
+      const snes_ntsc_rgb_t *k1_2, const snes_ntsc_rgb_t *k2_0,
+      const snes_ntsc_rgb_t *k2_1, const snes_ntsc_rgb_t *k2_2)
+{
+   sf_xrgb8888_t lo = sf_add_xrgb8888(
+         sf_add_xrgb8888(
+            sf_add_xrgb8888(blargg_ntsc_snes_load_kernel(k0_0),
+               blargg_ntsc_snes_load_kernel(k0_1 + 7)),
+            sf_add_xrgb8888(
+               sf_and_xrgb8888(blargg_ntsc_snes_load_kernel(k1_0 + 12),
+                  sf_load_xrgb8888(blargg_ntsc_snes_lanes23)),
+               blargg_ntsc_snes_load_kernel(k1_1 + 19))),
+         sf_add_xrgb8888(
+            sf_and_xrgb8888(blargg_ntsc_snes_load_kernel(k1_2 + 26),
+               sf_load_xrgb8888(blargg_ntsc_snes_lanes01)),
+            sf_add_xrgb8888(blargg_ntsc_snes_load_kernel(k2_1 + 31),
+               blargg_ntsc_snes_load_kernel(k2_2 + 38))));
+   sf_xrgb8888_t hi = sf_add_xrgb8888(
+         sf_add_xrgb8888(
+            sf_add_xrgb8888(blargg_ntsc_snes_load_kernel(k0_0 + 4),
+               blargg_ntsc_snes_load_kernel(k0_1 + 11)),
+            sf_add_xrgb8888(blargg_ntsc_snes_load_kernel(k1_0 + 16),
+               blargg_ntsc_snes_load_kernel(k1_1 + 23))),
+         sf_add_xrgb8888(blargg_ntsc_snes_load_kernel(k2_0 + 28),
+            blargg_ntsc_snes_load_kernel(k2_1 + 35)));
+
+   blargg_ntsc_snes_store_rgb565(out,
+         blargg_ntsc_snes_clamp_rgb565(lo),
+         blargg_ntsc_snes_clamp_rgb565(hi));
+}
+
+/* Same output as snes_ntsc_blit. */
+static void blargg_ntsc_snes_blit_simd(snes_ntsc_t const *ntsc,
+      const uint16_t *input, long in_row_width, int burst_phase,
+      int in_width, int in_height, uint16_t *rgb_out, long out_pitch)
+{
+   int chunk_count = (in_width - 1) / snes_ntsc_in_chunk;
+
+   for (; in_height; --in_height)
+   {
+      int n;
+      uint16_t last[8];
+      const uint16_t *line_in = input + 1;
+      uint16_t *line_out      = rgb_out;
+      char const *ktable      = (char const*)ntsc->table
+         + burst_phase * (snes_ntsc_burst_size * sizeof(snes_ntsc_rgb_t));
+      const snes_ntsc_rgb_t *black = SNES_NTSC_IN_FORMAT(ktable,
+            snes_ntsc_black);
+      const snes_ntsc_rgb_t *k0_1  = black;
+      const snes_ntsc_rgb_t *k1_1  = black;
+      const snes_ntsc_rgb_t *k1_2  = black;
+      const snes_ntsc_rgb_t *k2_1  = SNES_NTSC_IN_FORMAT(ktable,
+            SNES_NTSC_ADJ_IN(input[0]));
+      const snes_ntsc_rgb_t *k2_2  = black;
+
+      /* Lane 7 of every chunk is overwritten by the next one. */
+      for (n = chunk_count; n; --n)
+      {
+         unsigned c0 = SNES_NTSC_ADJ_IN(line_in[0]);
+         unsigned c1 = SNES_NTSC_ADJ_IN(line_in[1]);
+         unsigned c2 = SNES_NTSC_ADJ_IN(line_in[2]);
+         const snes_ntsc_rgb_t *k0_0 = SNES_NTSC_IN_FORMAT(ktable, c0);
+         const snes_ntsc_rgb_t *k1_0 = SNES_NTSC_IN_FORMAT(ktable, c1);
+         const snes_ntsc_rgb_t *k2_0 = SNES_NTSC_IN_FORMAT(ktable, c2);
+
+         blargg_ntsc_snes_chunk_rgb565(line_out,
+               k0_0, k0_1, k1_0, k1_1, k1_2, k2_0, k2_1, k2_2);
+
+         k0_1 = k0_0;
+         k1_2 = k1_1;
+         k1_1 = k1_0;
+         k2_2 = k2_1;
+         k2_1 = k2_0;
+
+         line_in  += 3;
+         line_out += 7;
+      }
+
+      /* finish final pixels */
+      blargg_ntsc_snes_chunk_rgb565(last,
+            black, k0_1, black, k1_1, k1_2, black, k2_1, k2_2);
+      memcpy(line_out, last, snes_ntsc_out_chunk * sizeof(*line_out));
+
+      burst_phase = (burst_phase + 1) % snes_ntsc_burst_count;
+      input      += in_row_width;
+      rgb_out     = (uint16_t*)((char*)rgb_out + out_pitch);
+   }
+}
+#endif
+
 static void blargg_ntsc_snes_render_rgb565(void *data, int width, int height,
-      int first, int last,
+      int first, int last, int burst,
       uint16_t *input, int pitch, uint16_t *output, int outpitch)
 {
    struct filter_data *filt = (struct filter_data*)data;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   if (width <= 256 && filt->simd)
+      blargg_ntsc_snes_blit_simd(filt->ntsc, input, pitch, burst,
+            width, height, output, outpitch * 2);
+   else
+#endif
    if(width <= 256)
-      snes_ntsc_blit(filt->ntsc, input, pitch, filt->burst,
+      snes_ntsc_blit(filt->ntsc, input, pitch, burst,
             width, height, output, outpitch * 2, first, last);
    else
-      snes_ntsc_blit_hires(filt->ntsc, input, pitch, filt->burst,
+      snes_ntsc_blit_hires(filt->ntsc, input, pitch, burst,
             width, height, output, outpitch * 2, first, last);
-
-   filt->burst ^= filt->burst_toggle;
 }
 
 static void blargg_ntsc_snes_rgb565(void *data, unsigned width, unsigned height,
-      int first, int last, uint16_t *src, 
+      int first, int last, int burst, uint16_t *src, 
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
    blargg_ntsc_snes_render_rgb565(data, width, height,
-         first, last,
+         first, last, burst,
          src, src_stride,
          dst, dst_stride);
 
@@ -200,7 +360,7 @@ static void blargg_ntsc_snes_work_cb_rgb565(void *data, void *thread_data)
    unsigned height = thr->height;
 
    blargg_ntsc_snes_rgb565(data, width, height,
-         thr->first, thr->last, input,
+         thr->first, thr->last, thr->burst, input,
          thr->in_pitch / SOFTFILTER_BPP_RGB565,
          output,
          thr->out_pitch / SOFTFILTER_BPP_RGB565);
@@ -213,13 +373,18 @@ static void blargg_ntsc_snes_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   unsigned bands = filt->threads;
+
+   if (bands > height)
+      bands = height ? height : 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = (i < bands) ? (height * i) / bands : height;
+      unsigned y_end   = (i < bands) ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
@@ -229,13 +394,18 @@ static void blargg_ntsc_snes_generic_packets(void *data,
 
       /* Workers need to know if they can 
        * access pixels outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
+      /* The burst phase advances with every row. */
+      thr->burst = (filt->burst + y_start) % snes_ntsc_burst_count;
+
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
          packets[i].work = blargg_ntsc_snes_work_cb_rgb565;
       packets[i].thread_data = thr;
    }
+
+   filt->burst ^= filt->burst_toggle;
 }
 
 static const struct softfilter_implementation blargg_ntsc_snes_generic = {
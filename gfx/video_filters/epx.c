@@ -15,6 +15,7 @@
  */
 
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -44,6 +45,7 @@ struct filter_data
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   int simd;
 };
 
 static unsigned epx_generic_input_fmts(void)
@@ -67,7 +69,6 @@ static void *epx_generic_create(const struct softfilter_config *config,
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
    (void)config;
    (void)userdata;
 
@@ -76,8 +77,11 @@ static void *epx_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   filt->simd    = (simd & SOFTFILTER_SIMD_NATIVE) != 0;
+#endif
    if (!filt->workers)
    {
       free(filt);
@@ -113,104 +117,22 @@ static void EPX_16(int width, int height,
 	uint16_t	colorX, colorA, colorB, colorC, colorD;
 	uint16_t	*sP = NULL, *uP = NULL, *lP = NULL;
 	uint32_t	*dP1 = NULL, *dP2 = NULL;
-	int		w, prevline;
+	int		w, y;
 
    if (!src || !dst)
       return;
 
-   prevline = (first) ? 0 : src_stride;
-
-	height -= 2;
-
 	/*   D
 	 * A X C
 	 *   B
     */
 
-	/* top edge */
-
-	sP  = (uint16_t *)(src - prevline);
-	lP  = (uint16_t *)(src + src_stride);
-	dP1 = (uint32_t *)(dst);
-	dP2 = (uint32_t *)(dst + dst_stride);
-
-	// left edge
-
-	colorX = *sP;
-	colorC = *++sP;
-	colorB = *lP++;
-
-	if ((colorX != colorC) && (colorB != colorX))
-	{
-	#ifdef MSB_FIRST
-		*dP1 = (colorX << 16) + colorX;
-		*dP2 = (colorX << 16) + ((colorB == colorC) ? colorB : colorX);
-	#else
-		*dP1 = colorX + (colorX << 16);
-		*dP2 = colorX + (((colorB == colorC) ? colorB : colorX) << 16);
-	#endif
-	}
-	else
-		*dP1 = *dP2 = (colorX << 16) + colorX;
-
-	dP1++;
-	dP2++;
-
-	//
-
-	for (w = width - 2; w; w--)
-	{
-		colorA = colorX;
-		colorX = colorC;
-		colorC = *++sP;
-		colorB = *lP++;
-
-		if ((colorA != colorC) && (colorB != colorX))
-		{
-		#ifdef MSB_FIRST
-			*dP1 = (colorX << 16) + colorX;
-			*dP2 = (((colorA == colorB) ? colorA : colorX) << 16) + 
-            ((colorB == colorC) ? colorB : colorX);
-		#else
-			*dP1 = colorX + (colorX << 16);
-			*dP2 = ((colorA == colorB) ? colorA : colorX) + 
-            (((colorB == colorC) ? colorB : colorX) << 16);
-		#endif
-		}
-		else
-			*dP1 = *dP2 = (colorX << 16) + colorX;
-
-		dP1++;
-		dP2++;
-	}
-
-	/* right edge */
-
-	colorA = colorX;
-	colorX = colorC;
-	colorB = *lP;
-
-	if ((colorA != colorX) && (colorB != colorX))
-	{
-	#ifdef MSB_FIRST
-		*dP1 = (colorX << 16) + colorX;
-		*dP2 = (((colorA == colorB) ? colorA : colorX) << 16) + colorX;
-	#else
-		*dP1 = colorX + (colorX << 16);
-		*dP2 = ((colorA == colorB) ? colorA : colorX) + (colorX << 16);
-	#endif
-	}
-	else
-		*dP1 = *dP2 = (colorX << 16) + colorX;
-
-	src += src_stride;
-	dst += dst_stride << 1;
-
-	for (; height; height--)
+	for (y = 0; y < height; y++)
 	{
+		/* Rows beyond the frame are clamped to its edges. */
 		sP  = (uint16_t *) src;
-		uP  = (uint16_t *) (src - src_stride);
-		lP  = (uint16_t *) (src + src_stride);
+		uP  = (uint16_t *) ((first && y == 0) ? src : src - src_stride);
+		lP  = (uint16_t *) ((last && y == height - 1) ? src : src + src_stride);
 		dP1 = (uint32_t *) dst;
 		dP2 = (uint32_t *) (dst + dst_stride);
 
@@ -289,81 +211,76 @@ static void EPX_16(int width, int height,
 		src += src_stride;
 		dst += dst_stride << 1;
 	}
+}
 
-	/* bottom edge */
-
-	sP  = (uint16_t *) src;
-	uP  = (uint16_t *) (src - src_stride);
-	dP1 = (uint32_t *) dst;
-	dP2 = (uint32_t *) (dst + dst_stride);
-
-	/* left edge */
-
-	colorX = *sP;
-	colorC = *++sP;
-	colorD = *uP++;
-
-	if ((colorX != colorC) && (colorX != colorD))
-	{
-	#ifdef MSB_FIRST
-		*dP1 = (colorX << 16) + ((colorC == colorD) ? colorC : colorX);
-		*dP2 = (colorX << 16) + colorX;
-	#else
-		*dP1 = colorX + (((colorC == colorD) ? colorC : colorX) << 16);
-		*dP2 = colorX + (colorX << 16);
-	#endif
-	}
-	else
-		*dP1 = *dP2 = (colorX << 16) + colorX;
-
-	dP1++;
-	dP2++;
-
-	for (w = width - 2; w; w--)
-	{
-		colorA = colorX;
-		colorX = colorC;
-		colorC = *++sP;
-		colorD = *uP++;
-
-		if ((colorA != colorC) && (colorX != colorD))
-		{
-		#ifdef MSB_FIRST
-			*dP1 = (((colorD == colorA) ? colorD : colorX) << 16) + 
-            ((colorC == colorD) ? colorC : colorX);
-			*dP2 = (colorX << 16) + colorX;
-		#else
-			*dP1 = ((colorD == colorA) ? colorD : colorX) + 
-            (((colorC == colorD) ? colorC : colorX) << 16);
-			*dP2 = colorX + (colorX << 16);
-		#endif
-		}
-		else
-			*dP1 = *dP2 = (colorX << 16) + colorX;
-
-		dP1++;
-		dP2++;
-	}
-
-	/* right edge */
-
-	colorA = colorX;
-	colorX = colorC;
-	colorD = *uP;
+#ifdef SOFTFILTER_SIMD_NATIVE
+/* EPX_16 with the inner pixels done a vector at a time.
+ * The edge pixels of a row use themselves as their missing
+ * neighbour, which is what the edge cases of EPX_16 boil down to. */
+static void epx_simd_rgb565(unsigned width, unsigned height,
+      int first, int last,
+      uint16_t *src, unsigned src_stride, uint16_t *dst,
+      unsigned dst_stride)
+{
+   unsigned x, y;
 
-	if ((colorA != colorX) && (colorX != colorD))
-	{
-	#ifdef MSB_FIRST
-		*dP1 = (((colorD == colorA) ? colorD : colorX) << 16) + colorX;
-		*dP2 = (colorX << 16) + colorX;
-	#else
-		*dP1 = ((colorD == colorA) ? colorD : colorX) + (colorX << 16);
-		*dP2 = colorX + (colorX << 16);
-	#endif
-	}
-	else
-		*dP1 = *dP2 = (colorX << 16) + colorX;
+   for (y = 0; y < height; y++)
+   {
+      /* Rows beyond the frame are clamped to its edges. */
+      const uint16_t *sP = src;
+      const uint16_t *uP = (first && y == 0) ? src : src - src_stride;
+      const uint16_t *lP = (last && y == height - 1) ? src : src + src_stride;
+      uint16_t *dP1      = dst;
+      uint16_t *dP2      = dst + dst_stride;
+
+      for (x = 0; x < width; x++)
+      {
+         uint16_t colorX, colorA, colorB, colorC, colorD;
+
+         if (x > 0 && x + SF_RGB565_LANES < width)
+         {
+            const sf_rgb565_t vX = sf_load_rgb565(sP + x);
+            const sf_rgb565_t vA = sf_load_rgb565(sP + x - 1);
+            const sf_rgb565_t vC = sf_load_rgb565(sP + x + 1);
+            const sf_rgb565_t vB = sf_load_rgb565(lP + x);
+            const sf_rgb565_t vD = sf_load_rgb565(uP + x);
+            const sf_rgb565_t edge = sf_andnot_rgb565(
+                  sf_or_rgb565(sf_eq_rgb565(vA, vC), sf_eq_rgb565(vB, vD)),
+                  sf_set1_rgb565(0xffff));
+
+            sf_store2_rgb565(dP1 + 2 * x,
+                  sf_sel_rgb565(sf_and_rgb565(edge, sf_eq_rgb565(vD, vA)), vD, vX),
+                  sf_sel_rgb565(sf_and_rgb565(edge, sf_eq_rgb565(vC, vD)), vC, vX));
+            sf_store2_rgb565(dP2 + 2 * x,
+                  sf_sel_rgb565(sf_and_rgb565(edge, sf_eq_rgb565(vA, vB)), vA, vX),
+                  sf_sel_rgb565(sf_and_rgb565(edge, sf_eq_rgb565(vB, vC)), vB, vX));
+
+            x += SF_RGB565_LANES - 1;
+            continue;
+         }
+
+         colorX = sP[x];
+         colorA = (x > 0) ? sP[x - 1] : colorX;
+         colorC = (x < width - 1) ? sP[x + 1] : colorX;
+         colorB = lP[x];
+         colorD = uP[x];
+
+         if ((colorA != colorC) && (colorB != colorD))
+         {
+            dP1[2 * x]     = (colorD == colorA) ? colorD : colorX;
+            dP1[2 * x + 1] = (colorC == colorD) ? colorC : colorX;
+            dP2[2 * x]     = (colorA == colorB) ? colorA : colorX;
+            dP2[2 * x + 1] = (colorB == colorC) ? colorB : colorX;
+         }
+         else
+            dP1[2 * x] = dP1[2 * x + 1] = dP2[2 * x] = dP2[2 * x + 1] = colorX;
+      }
+
+      src += src_stride;
+      dst += dst_stride << 1;
+   }
 }
+#endif
 
 static void epx_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src, 
@@ -384,6 +301,19 @@ static void epx_work_cb_rgb565(void *data, void *thread_data)
    uint16_t *output = (uint16_t*)thr->out_data;
    unsigned width = thr->width;
    unsigned height = thr->height;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   struct filter_data *filt = (struct filter_data*)data;
+
+   if (filt->simd)
+   {
+      epx_simd_rgb565(width, height,
+            thr->first, thr->last, input,
+            thr->in_pitch / SOFTFILTER_BPP_RGB565,
+            output,
+            thr->out_pitch / SOFTFILTER_BPP_RGB565);
+      return;
+   }
+#endif
 
    epx_generic_rgb565(width, height,
          thr->first, thr->last, input,
@@ -400,13 +330,18 @@ static void epx_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   unsigned bands = filt->threads;
+
+   if (bands > height)
+      bands = height ? height : 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = (i < bands) ? (height * i) / bands : height;
+      unsigned y_end   = (i < bands) ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * EPX_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
@@ -416,7 +351,7 @@ static void epx_generic_packets(void *data,
 
       /* Workers need to know if they can 
        * access pixels outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
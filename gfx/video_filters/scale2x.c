@@ -17,6 +17,7 @@
 // Compile: gcc -o scale2x.so -shared scale2x.c -std=c99 -O3 -Wall -pedantic -fPIC
 
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdlib.h>
 
 #ifdef RARCH_INTERNAL
@@ -45,8 +46,33 @@ struct filter_data
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   int simd;
 };
 
+#define SCALE2X_PIXEL(typename_t, x, width, src, prevline, nextline, out0, out1) \
+   { \
+      const typename_t A = *(src - prevline); \
+      const typename_t B = (x > 0) ? *(src - 1) : *src; \
+      const typename_t C = *src; \
+      const typename_t D = (x < width - 1) ? *(src + 1) : *src; \
+      const typename_t E = *(src + nextline); \
+      \
+      if (A != E && B != D) \
+      { \
+         *out0++ = (A == B ? A : C); \
+         *out0++ = (A == D ? A : C); \
+         *out1++ = (E == B ? E : C); \
+         *out1++ = (E == D ? E : C); \
+      } \
+      else \
+      { \
+         *out0++ = C; \
+         *out0++ = C; \
+         *out1++ = C; \
+         *out1++ = C; \
+      } \
+   }
+
 #define SCALE2X_GENERIC(typename_t, width, height, first, last, src, src_stride, dst, dst_stride, out0, out1) \
    for (y = 0; y < height; ++y) \
    { \
@@ -55,32 +81,61 @@ struct filter_data
       \
       for (x = 0; x < width; ++x) \
       { \
-         const typename_t A = *(src - prevline); \
-         const typename_t B = (x > 0) ? *(src - 1) : *src; \
-         const typename_t C = *src; \
-         const typename_t D = (x < width - 1) ? *(src + 1) : *src; \
-         const typename_t E = *(src++ + nextline); \
-         \
-         if (A != E && B != D) \
-         { \
-            *out0++ = (A == B ? A : C); \
-            *out0++ = (A == D ? A : C); \
-            *out1++ = (E == B ? E : C); \
-            *out1++ = (E == D ? E : C); \
-         } \
-         else \
+         SCALE2X_PIXEL(typename_t, x, width, src, prevline, nextline, out0, out1); \
+         src++; \
+      } \
+      \
+      src += src_stride - width; \
+      out0 += dst_stride + dst_stride - (width * SCALE2X_SCALE); \
+      out1 += dst_stride + dst_stride - (width * SCALE2X_SCALE); \
+   }
+
+#ifdef SOFTFILTER_SIMD_NATIVE
+/* SCALE2X_GENERIC with the inner pixels done a vector at a time.
+ * The first and last pixel of a row clamp their horizontal
+ * neighbours, so they stay scalar. */
+#define SCALE2X_SIMD(fmt, typename_t, lanes, width, height, first, last, src, src_stride, dst, dst_stride, out0, out1) \
+   for (y = 0; y < height; ++y) \
+   { \
+      const int prevline = ((y == 0) && first) ? 0 : src_stride; \
+      const int nextline = ((y == height - 1) && last) ? 0 : src_stride; \
+      \
+      for (x = 0; x < width; ++x) \
+      { \
+         if (x > 0 && x + lanes < width) \
          { \
-            *out0++ = C; \
-            *out0++ = C; \
-            *out1++ = C; \
-            *out1++ = C; \
+            const sf_##fmt##_t A = sf_load_##fmt(src - prevline); \
+            const sf_##fmt##_t B = sf_load_##fmt(src - 1); \
+            const sf_##fmt##_t C = sf_load_##fmt(src); \
+            const sf_##fmt##_t D = sf_load_##fmt(src + 1); \
+            const sf_##fmt##_t E = sf_load_##fmt(src + nextline); \
+            const sf_##fmt##_t edge = sf_andnot_##fmt( \
+                  sf_or_##fmt(sf_eq_##fmt(A, E), sf_eq_##fmt(B, D)), \
+                  sf_set1_##fmt((typename_t)~0)); \
+            \
+            sf_store2_##fmt(out0, \
+                  sf_sel_##fmt(sf_and_##fmt(edge, sf_eq_##fmt(A, B)), A, C), \
+                  sf_sel_##fmt(sf_and_##fmt(edge, sf_eq_##fmt(A, D)), A, C)); \
+            sf_store2_##fmt(out1, \
+                  sf_sel_##fmt(sf_and_##fmt(edge, sf_eq_##fmt(E, B)), E, C), \
+                  sf_sel_##fmt(sf_and_##fmt(edge, sf_eq_##fmt(E, D)), E, C)); \
+            \
+            src  += lanes; \
+            out0 += 2 * lanes; \
+            out1 += 2 * lanes; \
+            x    += lanes - 1; \
+            continue; \
          } \
+         \
+         SCALE2X_PIXEL(typename_t, x, width, src, prevline, nextline, out0, out1); \
+         src++; \
       } \
       \
       src += src_stride - width; \
       out0 += dst_stride + dst_stride - (width * SCALE2X_SCALE); \
       out1 += dst_stride + dst_stride - (width * SCALE2X_SCALE); \
    }
+#endif
 
 static void scale2x_generic_rgb565(unsigned width, unsigned height,
       int first, int last,
@@ -108,6 +163,34 @@ static void scale2x_generic_xrgb8888(unsigned width, unsigned height,
          src, src_stride, dst, dst_stride, out0, out1);
 }
 
+#ifdef SOFTFILTER_SIMD_NATIVE
+static void scale2x_simd_rgb565(unsigned width, unsigned height,
+      int first, int last,
+      const uint16_t *src, unsigned src_stride,
+      uint16_t *dst, unsigned dst_stride)
+{
+   unsigned x, y;
+   uint16_t *out0, *out1;
+   out0 = (uint16_t*)dst;
+   out1 = (uint16_t*)(dst + dst_stride);
+   SCALE2X_SIMD(rgb565, uint16_t, SF_RGB565_LANES, width, height,
+         first, last, src, src_stride, dst, dst_stride, out0, out1);
+}
+
+static void scale2x_simd_xrgb8888(unsigned width, unsigned height,
+      int first, int last,
+      const uint32_t *src, unsigned src_stride,
+      uint32_t *dst, unsigned dst_stride)
+{
+   unsigned x, y;
+   uint32_t *out0, *out1;
+   out0 = (uint32_t*)dst;
+   out1 = (uint32_t*)(dst + dst_stride);
+   SCALE2X_SIMD(xrgb8888, uint32_t, SF_XRGB8888_LANES, width, height,
+         first, last, src, src_stride, dst, dst_stride, out0, out1);
+}
+#endif
+
 static unsigned scale2x_generic_input_fmts(void)
 {
    return SOFTFILTER_FMT_XRGB8888 | SOFTFILTER_FMT_RGB565;
@@ -129,7 +212,6 @@ static void *scale2x_generic_create(const struct softfilter_config *config,
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
    (void)config;
    (void)userdata;
 
@@ -138,8 +220,11 @@ static void *scale2x_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   filt->simd    = (simd & SOFTFILTER_SIMD_NATIVE) != 0;
+#endif
    if (!filt->workers)
    {
       free(filt);
@@ -175,6 +260,19 @@ static void scale2x_work_cb_xrgb8888(void *data, void *thread_data)
    uint32_t *output = (uint32_t*)thr->out_data;
    unsigned width = thr->width;
    unsigned height = thr->height;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   struct filter_data *filt = (struct filter_data*)data;
+
+   if (filt->simd)
+   {
+      scale2x_simd_xrgb8888(width, height,
+            thr->first, thr->last, input,
+            thr->in_pitch / SOFTFILTER_BPP_XRGB8888,
+            output,
+            thr->out_pitch / SOFTFILTER_BPP_XRGB8888);
+      return;
+   }
+#endif
 
    scale2x_generic_xrgb8888(width, height,
          thr->first, thr->last, input,
@@ -191,6 +289,19 @@ static void scale2x_work_cb_rgb565(void *data, void *thread_data)
    uint16_t *output = (uint16_t*)thr->out_data;
    unsigned width = thr->width;
    unsigned height = thr->height;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   struct filter_data *filt = (struct filter_data*)data;
+
+   if (filt->simd)
+   {
+      scale2x_simd_rgb565(width, height,
+            thr->first, thr->last, input,
+            thr->in_pitch / SOFTFILTER_BPP_RGB565,
+            output,
+            thr->out_pitch / SOFTFILTER_BPP_RGB565);
+      return;
+   }
+#endif
 
    scale2x_generic_rgb565(width, height,
          thr->first, thr->last, input, 
@@ -206,13 +317,18 @@ static void scale2x_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   unsigned bands = filt->threads;
+
+   if (bands > height)
+      bands = height ? height : 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = (i < bands) ? (height * i) / bands : height;
+      unsigned y_end   = (i < bands) ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * 
          SCALE2X_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
@@ -223,7 +339,7 @@ static void scale2x_generic_packets(void *data,
 
       /* Workers need to know if they can access pixels 
        * outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
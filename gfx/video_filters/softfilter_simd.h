@@ -0,0 +1,352 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOFTFILTER_SIMD_H__
+#define SOFTFILTER_SIMD_H__
+
+/* Thin vector layer shared by the SIMD paths of the softfilters.
+ *
+ * sf_*_rgb565 operates on SF_RGB565_LANES pixels of RGB565,
+ * sf_*_xrgb8888 on SF_XRGB8888_LANES pixels of XRGB8888.
+ * Comparisons return all ones in lanes where they hold.
+ *
+ * SOFTFILTER_SIMD_NATIVE is the softfilter_simd_mask_t bit a CPU
+ * needs to run these, and is left undefined if this target
+ * has no vector unit we support. */
+
+#include <stdint.h>
+#include <retro_inline.h>
+
+#include "softfilter.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+#define SOFTFILTER_SIMD_NATIVE SOFTFILTER_SIMD_SSE2
+
+#define SF_RGB565_LANES   8
+#define SF_XRGB8888_LANES 4
+
+typedef __m128i sf_rgb565_t;
+typedef __m128i sf_xrgb8888_t;
+
+#define sf_srl_rgb565(a, n)   _mm_srli_epi16(a, n)
+#define sf_srl_xrgb8888(a, n) _mm_srli_epi32(a, n)
+
+static INLINE sf_rgb565_t sf_load_rgb565(const uint16_t *p)
+{
+   return _mm_loadu_si128((const __m128i*)p);
+}
+
+static INLINE sf_xrgb8888_t sf_load_xrgb8888(const uint32_t *p)
+{
+   return _mm_loadu_si128((const __m128i*)p);
+}
+
+static INLINE void sf_store_rgb565(uint16_t *p, sf_rgb565_t a)
+{
+   _mm_storeu_si128((__m128i*)p, a);
+}
+
+static INLINE void sf_store_xrgb8888(uint32_t *p, sf_xrgb8888_t a)
+{
+   _mm_storeu_si128((__m128i*)p, a);
+}
+
+static INLINE sf_rgb565_t sf_set1_rgb565(uint16_t v)
+{
+   return _mm_set1_epi16((short)v);
+}
+
+static INLINE sf_xrgb8888_t sf_set1_xrgb8888(uint32_t v)
+{
+   return _mm_set1_epi32((int)v);
+}
+
+/* Stores a and b interleaved, a[0] b[0] a[1] b[1] ... */
+static INLINE void sf_store2_rgb565(uint16_t *p, sf_rgb565_t a, sf_rgb565_t b)
+{
+   _mm_storeu_si128((__m128i*)p,     _mm_unpacklo_epi16(a, b));
+   _mm_storeu_si128((__m128i*)p + 1, _mm_unpackhi_epi16(a, b));
+}
+
+static INLINE void sf_store2_xrgb8888(uint32_t *p,
+      sf_xrgb8888_t a, sf_xrgb8888_t b)
+{
+   _mm_storeu_si128((__m128i*)p,     _mm_unpacklo_epi32(a, b));
+   _mm_storeu_si128((__m128i*)p + 1, _mm_unpackhi_epi32(a, b));
+}
+
+static INLINE sf_rgb565_t sf_eq_rgb565(sf_rgb565_t a, sf_rgb565_t b)
+{
+   return _mm_cmpeq_epi16(a, b);
+}
+
+static INLINE sf_xrgb8888_t sf_eq_xrgb8888(sf_xrgb8888_t a, sf_xrgb8888_t b)
+{
+   return _mm_cmpeq_epi32(a, b);
+}
+
+/* Signed comparisons against zero. */
+static INLINE sf_rgb565_t sf_gtz_rgb565(sf_rgb565_t a)
+{
+   return _mm_cmpgt_epi16(a, _mm_setzero_si128());
+}
+
+static INLINE sf_xrgb8888_t sf_gtz_xrgb8888(sf_xrgb8888_t a)
+{
+   return _mm_cmpgt_epi32(a, _mm_setzero_si128());
+}
+
+static INLINE sf_rgb565_t sf_ltz_rgb565(sf_rgb565_t a)
+{
+   return _mm_cmplt_epi16(a, _mm_setzero_si128());
+}
+
+static INLINE sf_xrgb8888_t sf_ltz_xrgb8888(sf_xrgb8888_t a)
+{
+   return _mm_cmplt_epi32(a, _mm_setzero_si128());
+}
+
+static INLINE sf_rgb565_t sf_add_rgb565(sf_rgb565_t a, sf_rgb565_t b)
+{
+   return _mm_add_epi16(a, b);
+}
+
+static INLINE sf_xrgb8888_t sf_add_xrgb8888(sf_xrgb8888_t a, sf_xrgb8888_t b)
+{
+   return _mm_add_epi32(a, b);
+}
+
+static INLINE sf_rgb565_t sf_sub_rgb565(sf_rgb565_t a, sf_rgb565_t b)
+{
+   return _mm_sub_epi16(a, b);
+}
+
+static INLINE sf_xrgb8888_t sf_sub_xrgb8888(sf_xrgb8888_t a, sf_xrgb8888_t b)
+{
+   return _mm_sub_epi32(a, b);
+}
+
+#define SF_BITWISE_SSE2(fmt) \
+static INLINE sf_##fmt##_t sf_and_##fmt(sf_##fmt##_t a, sf_##fmt##_t b) \
+{ \
+   return _mm_and_si128(a, b); \
+} \
+static INLINE sf_##fmt##_t sf_or_##fmt(sf_##fmt##_t a, sf_##fmt##_t b) \
+{ \
+   return _mm_or_si128(a, b); \
+} \
+/* ~m & a */ \
+static INLINE sf_##fmt##_t sf_andnot_##fmt(sf_##fmt##_t m, sf_##fmt##_t a) \
+{ \
+   return _mm_andnot_si128(m, a); \
+} \
+/* m ? a : b, per lane */ \
+static INLINE sf_##fmt##_t sf_sel_##fmt(sf_##fmt##_t m, \
+      sf_##fmt##_t a, sf_##fmt##_t b) \
+{ \
+   return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); \
+} \
+static INLINE int sf_any_##fmt(sf_##fmt##_t m) \
+{ \
+   return _mm_movemask_epi8(m) != 0; \
+}
+
+SF_BITWISE_SSE2(rgb565)
+SF_BITWISE_SSE2(xrgb8888)
+
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+
+#define SOFTFILTER_SIMD_NATIVE SOFTFILTER_SIMD_NEON
+
+#define SF_RGB565_LANES   8
+#define SF_XRGB8888_LANES 4
+
+typedef uint16x8_t sf_rgb565_t;
+typedef uint32x4_t sf_xrgb8888_t;
+
+#define sf_srl_rgb565(a, n)   vshrq_n_u16(a, n)
+#define sf_srl_xrgb8888(a, n) vshrq_n_u32(a, n)
+
+static INLINE sf_rgb565_t sf_load_rgb565(const uint16_t *p)
+{
+   return vld1q_u16(p);
+}
+
+static INLINE sf_xrgb8888_t sf_load_xrgb8888(const uint32_t *p)
+{
+   return vld1q_u32(p);
+}
+
+static INLINE void sf_store_rgb565(uint16_t *p, sf_rgb565_t a)
+{
+   vst1q_u16(p, a);
+}
+
+static INLINE void sf_store_xrgb8888(uint32_t *p, sf_xrgb8888_t a)
+{
+   vst1q_u32(p, a);
+}
+
+static INLINE sf_rgb565_t sf_set1_rgb565(uint16_t v)
+{
+   return vdupq_n_u16(v);
+}
+
+static INLINE sf_xrgb8888_t sf_set1_xrgb8888(uint32_t v)
+{
+   return vdupq_n_u32(v);
+}
+
+/* Stores a and b interleaved, a[0] b[0] a[1] b[1] ... */
+static INLINE void sf_store2_rgb565(uint16_t *p, sf_rgb565_t a, sf_rgb565_t b)
+{
+   uint16x8x2_t ab;
+   ab.val[0] = a;
+   ab.val[1] = b;
+   vst2q_u16(p, ab);
+}
+
+static INLINE void sf_store2_xrgb8888(uint32_t *p,
+      sf_xrgb8888_t a, sf_xrgb8888_t b)
+{
+   uint32x4x2_t ab;
+   ab.val[0] = a;
+   ab.val[1] = b;
+   vst2q_u32(p, ab);
+}
+
+static INLINE sf_rgb565_t sf_eq_rgb565(sf_rgb565_t a, sf_rgb565_t b)
+{
+   return vceqq_u16(a, b);
+}
+
+static INLINE sf_xrgb8888_t sf_eq_xrgb8888(sf_xrgb8888_t a, sf_xrgb8888_t b)
+{
+   return vceqq_u32(a, b);
+}
+
+/* Signed comparisons against zero. */
+static INLINE sf_rgb565_t sf_gtz_rgb565(sf_rgb565_t a)
+{
+   return vcgtq_s16(vreinterpretq_s16_u16(a), vdupq_n_s16(0));
+}
+
+static INLINE sf_xrgb8888_t sf_gtz_xrgb8888(sf_xrgb8888_t a)
+{
+   return vcgtq_s32(vreinterpretq_s32_u32(a), vdupq_n_s32(0));
+}
+
+static INLINE sf_rgb565_t sf_ltz_rgb565(sf_rgb565_t a)
+{
+   return vcltq_s16(vreinterpretq_s16_u16(a), vdupq_n_s16(0));
+}
+
+static INLINE sf_xrgb8888_t sf_ltz_xrgb8888(sf_xrgb8888_t a)
+{
+   return vcltq_s32(vreinterpretq_s32_u32(a), vdupq_n_s32(0));
+}
+
+#define SF_ARITH_NEON(fmt, suffix) \
+static INLINE sf_##fmt##_t sf_add_##fmt(sf_##fmt##_t a, sf_##fmt##_t b) \
+{ \
+   return vaddq_##suffix(a, b); \
+} \
+static INLINE sf_##fmt##_t sf_sub_##fmt(sf_##fmt##_t a, sf_##fmt##_t b) \
+{ \
+   return vsubq_##suffix(a, b); \
+} \
+static INLINE sf_##fmt##_t sf_and_##fmt(sf_##fmt##_t a, sf_##fmt##_t b) \
+{ \
+   return vandq_##suffix(a, b); \
+} \
+static INLINE sf_##fmt##_t sf_or_##fmt(sf_##fmt##_t a, sf_##fmt##_t b) \
+{ \
+   return vorrq_##suffix(a, b); \
+} \
+/* ~m & a */ \
+static INLINE sf_##fmt##_t sf_andnot_##fmt(sf_##fmt##_t m, sf_##fmt##_t a) \
+{ \
+   return vbicq_##suffix(a, m); \
+} \
+/* m ? a : b, per lane */ \
+static INLINE sf_##fmt##_t sf_sel_##fmt(sf_##fmt##_t m, \
+      sf_##fmt##_t a, sf_##fmt##_t b) \
+{ \
+   return vbslq_##suffix(m, a, b); \
+} \
+static INLINE int sf_any_##fmt(sf_##fmt##_t m) \
+{ \
+   uint64x2_t m64 = vreinterpretq_u64_##suffix(m); \
+   return (vgetq_lane_u64(m64, 0) | vgetq_lane_u64(m64, 1)) != 0; \
+}
+
+SF_ARITH_NEON(rgb565, u16)
+SF_ARITH_NEON(xrgb8888, u32)
+
+#endif
+
+#ifdef SOFTFILTER_SIMD_NATIVE
+
+/* The blends of the 2xSaI family, bit-exact with their scalar
+ * counterparts: (A + B) / 2 and (A + B + C + D) / 4 per channel. */
+#define SF_INTERPOLATE(fmt, typename_t, lb_mask, lo_mask, qb_mask, qo_mask) \
+static INLINE sf_##fmt##_t sf_interpolate_##fmt(sf_##fmt##_t a, sf_##fmt##_t b) \
+{ \
+   const sf_##fmt##_t lb = sf_set1_##fmt((typename_t)lb_mask); \
+   return sf_add_##fmt(sf_add_##fmt( \
+            sf_srl_##fmt(sf_and_##fmt(a, lb), 1), \
+            sf_srl_##fmt(sf_and_##fmt(b, lb), 1)), \
+         sf_and_##fmt(sf_and_##fmt(a, b), sf_set1_##fmt((typename_t)lo_mask))); \
+} \
+static INLINE sf_##fmt##_t sf_interpolate2_##fmt(sf_##fmt##_t a, \
+      sf_##fmt##_t b, sf_##fmt##_t c, sf_##fmt##_t d) \
+{ \
+   const sf_##fmt##_t qb = sf_set1_##fmt((typename_t)qb_mask); \
+   const sf_##fmt##_t qo = sf_set1_##fmt((typename_t)qo_mask); \
+   sf_##fmt##_t hi = sf_add_##fmt( \
+         sf_add_##fmt(sf_srl_##fmt(sf_and_##fmt(a, qb), 2), \
+            sf_srl_##fmt(sf_and_##fmt(b, qb), 2)), \
+         sf_add_##fmt(sf_srl_##fmt(sf_and_##fmt(c, qb), 2), \
+            sf_srl_##fmt(sf_and_##fmt(d, qb), 2))); \
+   sf_##fmt##_t lo = sf_add_##fmt( \
+         sf_add_##fmt(sf_and_##fmt(a, qo), sf_and_##fmt(b, qo)), \
+         sf_add_##fmt(sf_and_##fmt(c, qo), sf_and_##fmt(d, qo))); \
+   return sf_add_##fmt(hi, sf_and_##fmt(sf_srl_##fmt(lo, 2), qo)); \
+}
+
+SF_INTERPOLATE(rgb565, uint16_t, 0xF7DE, 0x0821, 0xE79C, 0x1863)
+SF_INTERPOLATE(xrgb8888, uint32_t, 0xFEFEFEFE, 0x01010101,
+      0xFCFCFCFC, 0x03030303)
+
+/* The 2xSaI vote, (A != C || A != D) - (B != C || B != D),
+ * as a signed lane value. */
+#define SF_RESULT(fmt) \
+static INLINE sf_##fmt##_t sf_result_##fmt(sf_##fmt##_t a, sf_##fmt##_t b, \
+      sf_##fmt##_t c, sf_##fmt##_t d) \
+{ \
+   return sf_sub_##fmt( \
+         sf_and_##fmt(sf_eq_##fmt(a, c), sf_eq_##fmt(a, d)), \
+         sf_and_##fmt(sf_eq_##fmt(b, c), sf_eq_##fmt(b, d))); \
+}
+
+SF_RESULT(rgb565)
+SF_RESULT(xrgb8888)
+
+#endif
+
+#endif
@@ -17,6 +17,7 @@
 // Compile: gcc -o supereagle.so -shared supereagle.c -std=c99 -O3 -Wall -pedantic -fPIC
 
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdlib.h>
 
 #ifdef RARCH_INTERNAL
@@ -45,6 +46,7 @@ struct filter_data
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   int simd;
 };
 
 static unsigned supereagle_generic_input_fmts(void)
@@ -68,7 +70,6 @@ static void *supereagle_generic_create(const struct softfilter_config *config,
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
    (void)config;
    (void)userdata;
 
@@ -76,8 +77,11 @@ static void *supereagle_generic_create(const struct softfilter_config *config,
    if (!filt)
       return NULL;
    filt->workers = (struct softfilter_thread_data*)calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   filt->simd    = (simd & SOFTFILTER_SIMD_NATIVE) != 0;
+#endif
    if (!filt->workers)
    {
       free(filt);
@@ -114,10 +118,10 @@ static void supereagle_generic_destroy(void *data)
 
 #define supereagle_result(A, B, C, D) (((A) != (C) || (A) != (D)) - ((B) != (C) || (B) != (D)));
 
-#define supereagle_declare_variables(typename_t, in, nextline) \
+#define supereagle_declare_variables(typename_t, in, prevline, nextline, nextline2) \
          typename_t product1a, product1b, product2a, product2b; \
-         const typename_t colorB1 = *(in - nextline + 0); \
-         const typename_t colorB2 = *(in - nextline + 1); \
+         const typename_t colorB1 = *(in - prevline + 0); \
+         const typename_t colorB2 = *(in - prevline + 1); \
          const typename_t color4  = *(in - 1); \
          const typename_t color5  = *(in + 0); \
          const typename_t color6  = *(in + 1); \
@@ -126,8 +130,8 @@ static void supereagle_generic_destroy(void *data)
          const typename_t color2  = *(in + nextline + 0); \
          const typename_t color3  = *(in + nextline + 1); \
          const typename_t colorS1 = *(in + nextline + 2); \
-         const typename_t colorA1 = *(in + nextline + nextline + 0); \
-         const typename_t colorA2 = *(in + nextline + nextline + 1)
+         const typename_t colorA1 = *(in + nextline2 + 0); \
+         const typename_t colorA2 = *(in + nextline2 + 1)
 
 #ifndef supereagle_function
 #define supereagle_function(result_cb, interpolate_cb, interpolate2_cb) \
@@ -219,17 +223,21 @@ static void supereagle_generic_xrgb8888(unsigned width, unsigned height,
       int first, int last, uint32_t *src, 
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned finish, nextline;
-   nextline = (last) ? 0 : src_stride;
+   unsigned y, finish;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         supereagle_declare_variables(uint32_t, in, nextline);
+         supereagle_declare_variables(uint32_t, in, prevline, nextline, nextline2);
 
          supereagle_function(supereagle_result, supereagle_interpolate_xrgb8888, supereagle_interpolate2_xrgb8888);
       }
@@ -243,17 +251,21 @@ static void supereagle_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src, 
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
-   unsigned nextline, finish;
-   nextline = (last) ? 0 : src_stride;
+   unsigned y, finish;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         supereagle_declare_variables(uint16_t, in, nextline);
+         supereagle_declare_variables(uint16_t, in, prevline, nextline, nextline2);
 
          supereagle_function(supereagle_result, supereagle_interpolate_rgb565, supereagle_interpolate2_rgb565);
       }
@@ -263,6 +275,149 @@ static void supereagle_generic_rgb565(unsigned width, unsigned height,
    }
 }
 
+#ifdef SOFTFILTER_SIMD_NATIVE
+/* Branchless supereagle_function over a whole vector of pixels.
+ * Every case of the scalar version is computed and the results
+ * are merged, the cases are mutually exclusive. */
+#define supereagle_simd_block(fmt, in, prevline, nextline, nextline2) \
+   { \
+      const sf_##fmt##_t colorB1 = sf_load_##fmt(in - prevline + 0); \
+      const sf_##fmt##_t colorB2 = sf_load_##fmt(in - prevline + 1); \
+      const sf_##fmt##_t color4  = sf_load_##fmt(in - 1); \
+      const sf_##fmt##_t color5  = sf_load_##fmt(in + 0); \
+      const sf_##fmt##_t color6  = sf_load_##fmt(in + 1); \
+      const sf_##fmt##_t colorS2 = sf_load_##fmt(in + 2); \
+      const sf_##fmt##_t color1  = sf_load_##fmt(in + nextline - 1); \
+      const sf_##fmt##_t color2  = sf_load_##fmt(in + nextline + 0); \
+      const sf_##fmt##_t color3  = sf_load_##fmt(in + nextline + 1); \
+      const sf_##fmt##_t colorS1 = sf_load_##fmt(in + nextline + 2); \
+      const sf_##fmt##_t colorA1 = sf_load_##fmt(in + nextline2 + 0); \
+      const sf_##fmt##_t colorA2 = sf_load_##fmt(in + nextline2 + 1); \
+      const sf_##fmt##_t eq26 = sf_eq_##fmt(color2, color6); \
+      const sf_##fmt##_t eq53 = sf_eq_##fmt(color5, color3); \
+      const sf_##fmt##_t case1 = sf_andnot_##fmt(eq53, eq26); \
+      const sf_##fmt##_t case2 = sf_andnot_##fmt(eq26, eq53); \
+      const sf_##fmt##_t case3 = sf_and_##fmt(eq26, eq53); \
+      const sf_##fmt##_t i56 = sf_interpolate_##fmt(color5, color6); \
+      const sf_##fmt##_t i23 = sf_interpolate_##fmt(color2, color3); \
+      const sf_##fmt##_t i26 = sf_interpolate_##fmt(color2, color6); \
+      const sf_##fmt##_t i53 = sf_interpolate_##fmt(color5, color3); \
+      const sf_##fmt##_t r = sf_add_##fmt( \
+            sf_add_##fmt(sf_result_##fmt(color6, color5, color1, colorA1), \
+               sf_result_##fmt(color6, color5, color4, colorB1)), \
+            sf_add_##fmt(sf_result_##fmt(color6, color5, colorA2, colorS1), \
+               sf_result_##fmt(color6, color5, colorB2, colorS2))); \
+      const sf_##fmt##_t gt = sf_gtz_##fmt(r); \
+      const sf_##fmt##_t lt = sf_ltz_##fmt(r); \
+      sf_##fmt##_t product1a, product1b, product2a, product2b; \
+      \
+      product1a = sf_interpolate2_##fmt(color5, color5, color5, i26); \
+      product1a = sf_sel_##fmt(case3, sf_sel_##fmt(gt, i56, color5), product1a); \
+      product1a = sf_sel_##fmt(case2, color5, product1a); \
+      product1a = sf_sel_##fmt(case1, sf_sel_##fmt( \
+               sf_or_##fmt(sf_eq_##fmt(color1, color2), sf_eq_##fmt(color6, colorB2)), \
+               sf_interpolate_##fmt(color2, sf_interpolate_##fmt(color2, color5)), \
+               i56), product1a); \
+      \
+      product1b = sf_interpolate2_##fmt(color6, color6, color6, i53); \
+      product1b = sf_sel_##fmt(case3, sf_sel_##fmt(lt, i56, color2), product1b); \
+      product1b = sf_sel_##fmt(case2, sf_sel_##fmt( \
+               sf_or_##fmt(sf_eq_##fmt(colorB1, color5), sf_eq_##fmt(color3, colorS1)), \
+               sf_interpolate_##fmt(color5, i56), i56), product1b); \
+      product1b = sf_sel_##fmt(case1, color2, product1b); \
+      \
+      product2a = sf_interpolate2_##fmt(color2, color2, color2, i53); \
+      product2a = sf_sel_##fmt(case3, sf_sel_##fmt(lt, i56, color2), product2a); \
+      product2a = sf_sel_##fmt(case2, sf_sel_##fmt( \
+               sf_or_##fmt(sf_eq_##fmt(color3, colorA2), sf_eq_##fmt(color4, color5)), \
+               sf_interpolate_##fmt(color5, sf_interpolate_##fmt(color5, color2)), \
+               i23), product2a); \
+      product2a = sf_sel_##fmt(case1, color2, product2a); \
+      \
+      product2b = sf_interpolate2_##fmt(color3, color3, color3, i26); \
+      product2b = sf_sel_##fmt(case3, sf_sel_##fmt(gt, i56, color5), product2b); \
+      product2b = sf_sel_##fmt(case2, color5, product2b); \
+      product2b = sf_sel_##fmt(case1, sf_sel_##fmt( \
+               sf_or_##fmt(sf_eq_##fmt(color6, colorS2), sf_eq_##fmt(color2, colorA1)), \
+               sf_interpolate_##fmt(color2, i23), i23), product2b); \
+      \
+      sf_store2_##fmt(out, product1a, product1b); \
+      sf_store2_##fmt(out + dst_stride, product2a, product2b); \
+   }
+
+static void supereagle_simd_xrgb8888(unsigned width, unsigned height,
+      int first, int last, uint32_t *src, 
+      unsigned src_stride, uint32_t *dst, unsigned dst_stride)
+{
+   unsigned y, finish;
+
+   for (y = 0; y < height; y++)
+   {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
+      uint32_t *in  = (uint32_t*)src;
+      uint32_t *out = (uint32_t*)dst;
+
+      for (finish = width; finish >= SF_XRGB8888_LANES;
+            finish -= SF_XRGB8888_LANES)
+      {
+         supereagle_simd_block(xrgb8888, in, prevline, nextline, nextline2);
+         in  += SF_XRGB8888_LANES;
+         out += 2 * SF_XRGB8888_LANES;
+      }
+
+      for (; finish; finish -= 1)
+      {
+         supereagle_declare_variables(uint32_t, in, prevline, nextline, nextline2);
+         supereagle_function(supereagle_result, supereagle_interpolate_xrgb8888,
+               supereagle_interpolate2_xrgb8888);
+      }
+
+      src += src_stride;
+      dst += 2 * dst_stride;
+   }
+}
+
+static void supereagle_simd_rgb565(unsigned width, unsigned height,
+      int first, int last, uint16_t *src, 
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+{
+   unsigned y, finish;
+
+   for (y = 0; y < height; y++)
+   {
+      /* Rows beyond the frame are clamped to its edges. */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height) ?
+         nextline : nextline + src_stride;
+      uint16_t *in  = (uint16_t*)src;
+      uint16_t *out = (uint16_t*)dst;
+
+      for (finish = width; finish >= SF_RGB565_LANES;
+            finish -= SF_RGB565_LANES)
+      {
+         supereagle_simd_block(rgb565, in, prevline, nextline, nextline2);
+         in  += SF_RGB565_LANES;
+         out += 2 * SF_RGB565_LANES;
+      }
+
+      for (; finish; finish -= 1)
+      {
+         supereagle_declare_variables(uint16_t, in, prevline, nextline, nextline2);
+         supereagle_function(supereagle_result, supereagle_interpolate_rgb565,
+               supereagle_interpolate2_rgb565);
+      }
+
+      src += src_stride;
+      dst += 2 * dst_stride;
+   }
+}
+#endif
+
 static void supereagle_work_cb_rgb565(void *data, void *thread_data)
 {
    struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
@@ -270,6 +425,16 @@ static void supereagle_work_cb_rgb565(void *data, void *thread_data)
    uint16_t *output = (uint16_t*)thr->out_data;
    unsigned width = thr->width;
    unsigned height = thr->height;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   struct filter_data *filt = (struct filter_data*)data;
+
+   if (filt->simd)
+   {
+      supereagle_simd_rgb565(width, height,
+            thr->first, thr->last, input, thr->in_pitch / SOFTFILTER_BPP_RGB565, output, thr->out_pitch / SOFTFILTER_BPP_RGB565);
+      return;
+   }
+#endif
 
    supereagle_generic_rgb565(width, height,
          thr->first, thr->last, input, thr->in_pitch / SOFTFILTER_BPP_RGB565, output, thr->out_pitch / SOFTFILTER_BPP_RGB565);
@@ -282,6 +447,16 @@ static void supereagle_work_cb_xrgb8888(void *data, void *thread_data)
    uint32_t *output = (uint32_t*)thr->out_data;
    unsigned width = thr->width;
    unsigned height = thr->height;
+#ifdef SOFTFILTER_SIMD_NATIVE
+   struct filter_data *filt = (struct filter_data*)data;
+
+   if (filt->simd)
+   {
+      supereagle_simd_xrgb8888(width, height,
+            thr->first, thr->last, input, thr->in_pitch / SOFTFILTER_BPP_XRGB8888, output, thr->out_pitch / SOFTFILTER_BPP_XRGB8888);
+      return;
+   }
+#endif
 
    supereagle_generic_xrgb8888(width, height,
          thr->first, thr->last, input, thr->in_pitch / SOFTFILTER_BPP_XRGB8888, output, thr->out_pitch / SOFTFILTER_BPP_XRGB8888);
@@ -294,12 +469,19 @@ static void supereagle_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   unsigned bands = filt->threads;
+
+   /* Bands read up to two rows beyond their edges from the
+    * neighbouring bands, so keep them at least two rows high. */
+   if (bands > height / 2)
+      bands = (height > 1) ? height / 2 : 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = (i < bands) ? (height * i) / bands : height;
+      unsigned y_end   = (i < bands) ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * SUPEREAGLE_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
@@ -308,7 +490,7 @@ static void supereagle_generic_packets(void *data,
       thr->height = y_end - y_start;
 
       // Workers need to know if they can access pixels outside their given buffer.
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
@@ -16,6 +16,7 @@
 
 #include "video_thread_wrapper.h"
 #include "../performance.h"
+#include "../performance/performance_trace.h"
 #include "../runloop.h"
 #include <stdlib.h>
 #include <string.h>
@@ -360,6 +361,8 @@ static void thread_loop(void *data)
    unsigned i = 0;
    (void)i;
 
+   perf_trace_thread_name("Video");
+
    for (;;)
    {
       thread_packet_t pkt;
@@ -389,6 +392,7 @@ static void thread_loop(void *data)
          bool has_windowed = true;
          struct video_viewport vp = {0};
 
+         RARCH_TRACE_BEGIN("video_thread_frame");
          slock_lock(thr->frame.lock);
 
          thread_update_driver_state(thr);
@@ -399,6 +403,7 @@ static void thread_loop(void *data)
                thr->frame.pitch, *thr->frame.msg ? thr->frame.msg : NULL);
 
          slock_unlock(thr->frame.lock);
+         RARCH_TRACE_END("video_thread_frame");
 
          if (thr->driver && thr->driver->alive)
             alive = ret && thr->driver->alive(thr->driver_data);
@@ -57,6 +57,8 @@ PERFORMANCE
 #endif
 
 #include "../performance.c"
+#include "../performance/performance_trace.c"
+#include "../benchmark.c"
 
 /*============================================================
 COMPATIBILITY
@@ -358,6 +360,9 @@ INPUT
 #ifdef HAVE_UDEV
 #include "../input/drivers/udev_input.c"
 #include "../input/drivers_joypad/udev_joypad.c"
+#ifdef HAVE_THREADS
+#include "../input/input_evdev_thread.c"
+#endif
 #endif
 
 #include "../input/drivers/nullinput.c"
@@ -514,6 +519,7 @@ DRIVERS
 #include "../gfx/video_viewport.c"
 #include "../input/input_driver.c"
 #include "../audio/audio_driver.c"
+#include "../audio/audio_ring.c"
 #include "../camera/camera_driver.c"
 #include "../location/location_driver.c"
 #include "../menu/menu_driver.c"
@@ -635,6 +641,7 @@ FRONTEND
 #include "../frontend/drivers/platform_null.c"
 
 #include "../core_info.c"
+#include "../core_info_cache.c"
 
 /*============================================================
 UI
@@ -726,6 +733,7 @@ NETPLAY
 DATA RUNLOOP
 ============================================================ */
 #include "../tasks/task_file_transfer.c"
+#include "../tasks/task_dir_list.c"
 #ifdef HAVE_LIBRETRODB
 #include "../tasks/task_database.c"
 #endif
@@ -815,6 +823,10 @@ MENU
 
 #include "../command_event.c"
 
+#ifdef HAVE_SHM
+#include "../shm_export.c"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -889,6 +901,7 @@ XML
 #include "../libretro-db/rmsgpack_dom.c"
 #include "../libretro-db/query.c"
 #include "../database_info.c"
+#include "../database_scan_cache.c"
 #endif
 
 
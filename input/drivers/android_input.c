@@ -1091,6 +1091,7 @@ static void handle_hotplug(android_input_t *android,
 
    if (!ignore_back && !back_mapped && settings->input.back_as_menu_toggle_enable) {
       settings->input.autoconf_binds[port][RARCH_MENU_TOGGLE].joykey = AKEYCODE_BACK;
+      input_driver_binds_changed();
    }
 
    android->pad_states[port].id = id;
@@ -30,6 +30,12 @@
 
 #include <retro_inline.h>
 
+#include "../input_evdev_thread.h"
+
+#if defined(HAVE_THREADS) && !defined(IS_JOYCONFIG)
+#define HAVE_UDEV_POLL_THREAD
+#endif
+
 /* Udev/evdev Linux joypad driver.
  * More complex and extremely low level,
  * but only Linux driver which can support joypad rumble.
@@ -37,11 +43,15 @@
  * Uses udev for device detection + hotplug.
  *
  * Code adapted from SDL 2.0's implementation.
+ *
+ * With input_poll_thread enabled, evdev events are drained
+ * by a separate thread as soon as they arrive, and polling
+ * only samples the latest state.
  */
 
 #define UDEV_NUM_BUTTONS 32
-#define NUM_AXES 32
-#define NUM_HATS 4
+#define NUM_AXES EVDEV_NUM_AXES
+#define NUM_HATS EVDEV_NUM_HATS
 
 #define test_bit(nr, addr) \
    (((1UL << ((nr) % (sizeof(long) * CHAR_BIT))) & ((addr)[(nr) / (sizeof(long) * CHAR_BIT)])) != 0)
@@ -53,9 +63,7 @@ struct udev_joypad
    dev_t device;
 
    /* Input state polled. */
-   uint64_t buttons;
-   int16_t axes[NUM_AXES];
-   int8_t hats[NUM_HATS][2];
+   evdev_pad_state_t state;
 
    /* Maps keycodes -> button/axes */
    uint8_t button_bind[KEY_MAX];
@@ -77,6 +85,11 @@ struct udev_joypad
 static struct udev *g_udev;
 static struct udev_monitor *g_udev_mon;
 static struct udev_joypad udev_pads[MAX_USERS];
+#ifdef HAVE_UDEV_POLL_THREAD
+static evdev_thread_t *udev_thread;
+#endif
+/* Timestamp of the newest event seen by udev_joypad_poll. */
+static int64_t udev_last_event_time;
 
 static INLINE int16_t udev_compute_axis(const struct input_absinfo *info, int value)
 {
@@ -90,6 +103,60 @@ static INLINE int16_t udev_compute_axis(const struct input_absinfo *info, int va
    return axis;
 }
 
+static void udev_handle_pad_event(void *data, unsigned p,
+      const struct input_event *event, evdev_pad_state_t *state)
+{
+   const struct udev_joypad *pad = (const struct udev_joypad*)&udev_pads[p];
+   int code                      = event->code;
+
+   (void)data;
+
+   switch (event->type)
+   {
+      case EV_KEY:
+         if (code >= BTN_MISC || (code >= KEY_UP && code <= KEY_DOWN))
+         {
+            if (event->value)
+               BIT64_SET(state->buttons, pad->button_bind[code]);
+            else
+               BIT64_CLEAR(state->buttons, pad->button_bind[code]);
+         }
+         break;
+
+      case EV_ABS:
+         if (code >= ABS_MISC)
+            break;
+
+         switch (code)
+         {
+            case ABS_HAT0X:
+            case ABS_HAT0Y:
+            case ABS_HAT1X:
+            case ABS_HAT1Y:
+            case ABS_HAT2X:
+            case ABS_HAT2Y:
+            case ABS_HAT3X:
+            case ABS_HAT3Y:
+            {
+               code                             -= ABS_HAT0X;
+               state->hats[code >> 1][code & 1]  = event->value;
+               break;
+            }
+
+            default:
+            {
+               unsigned axis     = pad->axes_bind[code];
+               state->axes[axis] = udev_compute_axis(&pad->absinfo[axis], event->value);
+               break;
+            }
+         }
+         break;
+
+      default:
+         break;
+   }
+}
+
 static void udev_poll_pad(struct udev_joypad *pad, unsigned p)
 {
    int i, len;
@@ -98,57 +165,21 @@ static void udev_poll_pad(struct udev_joypad *pad, unsigned p)
    if (pad->fd < 0)
       return;
 
+#ifdef HAVE_UDEV_POLL_THREAD
+   if (udev_thread)
+   {
+      evdev_thread_read(udev_thread, p, &pad->state);
+      return;
+   }
+#endif
+
    while ((len = read(pad->fd, events, sizeof(events))) > 0)
    {
       len /= sizeof(*events);
       for (i = 0; i < len; i++)
-      {
-         int code = events[i].code;
-         switch (events[i].type)
-         {
-            case EV_KEY:
-               if (code >= BTN_MISC || (code >= KEY_UP && code <= KEY_DOWN))
-               {
-                  if (events[i].value)
-                     BIT64_SET(pad->buttons, pad->button_bind[code]);
-                  else
-                     BIT64_CLEAR(pad->buttons, pad->button_bind[code]);
-               }
-               break;
-
-            case EV_ABS:
-               if (code >= ABS_MISC)
-                  break;
-
-               switch (code)
-               {
-                  case ABS_HAT0X:
-                  case ABS_HAT0Y:
-                  case ABS_HAT1X:
-                  case ABS_HAT1Y:
-                  case ABS_HAT2X:
-                  case ABS_HAT2Y:
-                  case ABS_HAT3X:
-                  case ABS_HAT3Y:
-                  {
-                     code                           -= ABS_HAT0X;
-                     pad->hats[code >> 1][code & 1]  = events[i].value;
-                     break;
-                  }
-
-                  default:
-                  {
-                     unsigned axis   = pad->axes_bind[code];
-                     pad->axes[axis] = udev_compute_axis(&pad->absinfo[axis], events[i].value);
-                     break;
-                  }
-               }
-               break;
+         udev_handle_pad_event(NULL, p, &events[i], &pad->state);
 
-            default:
-               break;
-         }
-      }
+      pad->state.time = evdev_event_time(&events[len - 1]);
    }
 }
 
@@ -181,11 +212,16 @@ static int udev_open_joystick(const char *path)
    unsigned long evbit[NBITS(EV_MAX)]   = {0};
    unsigned long keybit[NBITS(KEY_MAX)] = {0};
    unsigned long absbit[NBITS(ABS_MAX)] = {0};
-   int fd = open(path, O_RDWR | O_NONBLOCK);
+   int clock = CLOCK_MONOTONIC;
+   int fd    = open(path, O_RDWR | O_NONBLOCK);
 
    if (fd < 0)
       return fd;
 
+   /* Timestamp events on the same clock as rarch_get_time_usec(),
+    * so that input latency can be measured. Not fatal if unsupported. */
+   ioctl(fd, EVIOCSCLOCKID, &clock);
+
    if ((ioctl(fd, EVIOCGBIT(0, sizeof(evbit)), evbit) < 0) ||
          (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keybit)), keybit) < 0) ||
          (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absbit)), absbit) < 0))
@@ -273,8 +309,8 @@ static int udev_add_pad(struct udev_device *dev, unsigned p, int fd, const char
             continue;
          if (abs->maximum > abs->minimum)
          {
-            pad->axes[axes]   = udev_compute_axis(abs, abs->value);
-            pad->axes_bind[i] = axes++;
+            pad->state.axes[axes] = udev_compute_axis(abs, abs->value);
+            pad->axes_bind[i]     = axes++;
          }
       }
    }
@@ -283,6 +319,11 @@ static int udev_add_pad(struct udev_device *dev, unsigned p, int fd, const char
    pad->fd     = fd;
    pad->path   = strdup(path);
 
+#ifdef HAVE_UDEV_POLL_THREAD
+   if (udev_thread && !evdev_thread_add(udev_thread, p, fd, &pad->state))
+      RARCH_WARN("[udev]: Failed to add pad #%u to input thread.\n", p);
+#endif
+
    if (*pad->ident)
    {
       params.idx = p;
@@ -363,6 +404,10 @@ static void udev_check_device(struct udev_device *dev, const char *path, bool ho
 
 static void udev_free_pad(unsigned pad)
 {
+#ifdef HAVE_UDEV_POLL_THREAD
+   evdev_thread_remove(udev_thread, pad);
+#endif
+
    if (udev_pads[pad].fd >= 0)
       close(udev_pads[pad].fd);
 
@@ -399,6 +444,11 @@ static void udev_joypad_destroy(void)
    for (i = 0; i < MAX_USERS; i++)
       udev_free_pad(i);
 
+#ifdef HAVE_UDEV_POLL_THREAD
+   evdev_thread_free(udev_thread);
+   udev_thread = NULL;
+#endif
+
    if (g_udev_mon)
       udev_monitor_unref(g_udev_mon);
    g_udev_mon = NULL;
@@ -514,7 +564,17 @@ static void udev_joypad_poll(void)
       udev_joypad_handle_hotplug();
 
    for (i = 0; i < MAX_USERS; i++)
+   {
       udev_poll_pad(&udev_pads[i], i);
+
+#ifndef IS_JOYCONFIG
+      if (udev_pads[i].state.time > udev_last_event_time)
+      {
+         udev_last_event_time = udev_pads[i].state.time;
+         input_driver_latency_event(udev_last_event_time);
+      }
+#endif
+   }
 }
 
 static bool udev_joypad_init(void *data)
@@ -541,6 +601,19 @@ static bool udev_joypad_init(void *data)
       udev_monitor_enable_receiving(g_udev_mon);
    }
 
+   /* Started once udev is up, so that failing above leaves
+    * no thread behind. Pads found below are added to it. */
+#ifdef HAVE_UDEV_POLL_THREAD
+   if (settings->input.poll_thread)
+   {
+      udev_thread = evdev_thread_new(udev_handle_pad_event, NULL);
+      if (udev_thread)
+         RARCH_LOG("[udev]: Polling joypads on input thread.\n");
+      else
+         RARCH_WARN("[udev]: Failed to start input thread.\n");
+   }
+#endif
+
    enumerate = udev_enumerate_new(g_udev);
    if (!enumerate)
       goto error;
@@ -580,13 +653,13 @@ static bool udev_joypad_hat(const struct udev_joypad *pad, uint16_t hat)
    switch (GET_HAT_DIR(hat))
    {
       case HAT_LEFT_MASK:
-         return pad->hats[h][0] < 0;
+         return pad->state.hats[h][0] < 0;
       case HAT_RIGHT_MASK:
-         return pad->hats[h][0] > 0;
+         return pad->state.hats[h][0] > 0;
       case HAT_UP_MASK:
-         return pad->hats[h][1] < 0;
+         return pad->state.hats[h][1] < 0;
       case HAT_DOWN_MASK:
-         return pad->hats[h][1] > 0;
+         return pad->state.hats[h][1] > 0;
    }
 
    return 0;
@@ -598,7 +671,7 @@ static bool udev_joypad_button(unsigned port, uint16_t joykey)
 
    if (GET_HAT_DIR(joykey))
       return udev_joypad_hat(pad, joykey);
-   return joykey < UDEV_NUM_BUTTONS && BIT64_GET(pad->buttons, joykey);
+   return joykey < UDEV_NUM_BUTTONS && BIT64_GET(pad->state.buttons, joykey);
 }
 
 static uint64_t udev_joypad_get_buttons(unsigned port)
@@ -606,7 +679,7 @@ static uint64_t udev_joypad_get_buttons(unsigned port)
    const struct udev_joypad *pad = (const struct udev_joypad*)&udev_pads[port];
    if (!pad)
       return 0;
-   return pad->buttons;
+   return pad->state.buttons;
 }
 
 static int16_t udev_joypad_axis(unsigned port, uint32_t joyaxis)
@@ -620,13 +693,13 @@ static int16_t udev_joypad_axis(unsigned port, uint32_t joyaxis)
 
    if (AXIS_NEG_GET(joyaxis) < NUM_AXES)
    {
-      val = pad->axes[AXIS_NEG_GET(joyaxis)];
+      val = pad->state.axes[AXIS_NEG_GET(joyaxis)];
       if (val > 0)
          val = 0;
    }
    else if (AXIS_POS_GET(joyaxis) < NUM_AXES)
    {
-      val = pad->axes[AXIS_POS_GET(joyaxis)];
+      val = pad->state.axes[AXIS_POS_GET(joyaxis)];
       if (val < 0)
          val = 0;
    }
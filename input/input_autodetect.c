@@ -50,6 +50,8 @@ static void input_autoconfigure_joypad_conf(config_file_t *conf,
       input_config_parse_joy_axis(conf, "input",
             input_config_bind_map[i].base, &binds[i]);
    }
+
+   input_driver_binds_changed();
 }
 
 static int input_try_autoconfigure_joypad_from_conf(config_file_t *conf,
@@ -266,6 +268,7 @@ static bool input_config_autoconfigure_joypad_init(autoconfig_params_t *params)
       settings->input.autoconf_binds[params->idx][i].joyaxis_label[0] = '\0';
    }
    settings->input.autoconfigured[params->idx] = false;
+   input_driver_binds_changed();
 
    return true;
 }
@@ -16,11 +16,58 @@
 
 #include <string.h>
 #include <string/string_list.h>
+#include <retro_inline.h>
 #include "input_driver.h"
 #include "../driver.h"
 #include "../general.h"
 #include "../libretro.h"
+#include "../performance.h"
 
+#ifdef HAVE_COMMAND
+#include "../command.h"
+#endif
+
+/* RetroPad buttons (RETRO_DEVICE_ID_JOYPAD_*) answered from the snapshot. */
+#define INPUT_SNAPSHOT_BUTTONS (RETRO_DEVICE_ID_JOYPAD_R3 + 1)
+
+typedef struct input_snapshot
+{
+   /* Per-user RetroPad button bitmask, (1 << RETRO_DEVICE_ID_JOYPAD_*). */
+   uint16_t buttons[MAX_USERS];
+   /* Per-user analog axes, [RETRO_DEVICE_INDEX_ANALOG_*][RETRO_DEVICE_ID_ANALOG_*]. */
+   int16_t analog[MAX_USERS][2][2];
+   /* Bitmask of users whose buttons/axes were sampled since the last poll. */
+   uint32_t buttons_valid;
+   uint32_t analog_valid;
+   /* Time of the last driver poll, in microseconds. */
+   retro_time_t poll_time;
+} input_snapshot_t;
+
+typedef struct input_bind_table
+{
+   /* Bitmask of (1 << key_bind_id) for every bind of user 1 which has
+    * a keyboard, joypad button or joypad axis assigned to it. */
+   retro_input_t bound;
+   /* Joypad whose autoconfig binds were used to build the table. */
+   unsigned joy_idx;
+   bool dirty;
+} input_bind_table_t;
+
+typedef struct input_latency
+{
+   /* Timestamp of the oldest input event not yet shown in a frame. */
+   retro_time_t pending;
+   /* Timestamp of the newest input event reported. */
+   retro_time_t last;
+
+   uint64_t count;
+   retro_time_t total;
+   retro_time_t max;
+} input_latency_t;
+
+static input_snapshot_t input_snapshot;
+static input_latency_t input_latency;
+static input_bind_table_t input_bind_table = { 0, 0, true };
 
 static const input_driver_t *input_drivers[] = {
 #ifdef __CELLOS_LV2__
@@ -199,36 +246,273 @@ bool input_driver_set_rumble_state(unsigned port,
    return false;
 }
 
+/**
+ * input_driver_binds_changed:
+ *
+ * Marks the compiled bind table as stale. Must be called whenever
+ * the binds of user 1 or its autoconfig binds are modified.
+ **/
+void input_driver_binds_changed(void)
+{
+   input_bind_table.dirty = true;
+}
+
+static INLINE bool input_bind_is_set(const struct retro_keybind *bind)
+{
+   return bind->key != RETROK_UNKNOWN || bind->joykey != NO_BTN
+      || bind->joyaxis != AXIS_NONE;
+}
+
+static void input_driver_compile_binds(settings_t *settings,
+      unsigned joy_idx)
+{
+   unsigned key;
+   const struct retro_keybind *binds      = settings->input.binds[0];
+   const struct retro_keybind *auto_binds = NULL;
+   retro_input_t bound                    = 0;
+
+   if (joy_idx < MAX_USERS)
+      auto_binds = settings->input.autoconf_binds[joy_idx];
+
+   for (key = 0; key < RARCH_BIND_LIST_END; key++)
+   {
+      if (input_bind_is_set(&binds[key]) ||
+            (auto_binds && input_bind_is_set(&auto_binds[key])))
+         BIT64_SET(bound, key);
+   }
+
+   /* Analog D-Pad mode rewrites the D-Pad axes on the fly,
+    * so these are always queried. */
+   for (key = RETRO_DEVICE_ID_JOYPAD_UP;
+         key <= RETRO_DEVICE_ID_JOYPAD_RIGHT; key++)
+      BIT64_SET(bound, key);
+
+   input_bind_table.bound   = bound;
+   input_bind_table.joy_idx = joy_idx;
+   input_bind_table.dirty   = false;
+}
+
+/**
+ * input_driver_keys_pressed:
+ *
+ * Samples all RetroArch binds of user 1 (RetroPad and hotkeys).
+ * Only binds which have something assigned to them are queried
+ * from the driver; overlay and command interface state are
+ * merged in as bitmasks.
+ *
+ * Returns: bitmask of (1 << key_bind_id) of all pressed binds.
+ **/
 retro_input_t input_driver_keys_pressed(void)
 {
    int key;
    retro_input_t                ret = 0;
+   retro_input_t              query = 0;
    driver_t                 *driver = driver_get_ptr();
+   settings_t             *settings = config_get_ptr();
    const input_driver_t      *input = input_get_ptr(driver);
+   unsigned                 joy_idx = settings->input.joypad_map[0];
+
+   if (input_bind_table.dirty || input_bind_table.joy_idx != joy_idx)
+      input_driver_compile_binds(settings, joy_idx);
+
+   if (!driver->block_hotkey)
+      query = ~(retro_input_t)0;
+   else if (!driver->block_libretro_input)
+      query = (UINT64_C(1) << RARCH_FIRST_META_KEY) - 1;
+   BIT64_SET(query, RARCH_MENU_TOGGLE);
+
+   query &= input_bind_table.bound;
 
    for (key = 0; key < RARCH_BIND_LIST_END; key++)
    {
-      bool state = false;
-      if ((!driver->block_libretro_input && ((key < RARCH_FIRST_META_KEY)))
-            || !driver->block_hotkey || key == RARCH_MENU_TOGGLE)
-         state = input->key_pressed(driver->input_data, key);
+      if (BIT64_GET(query, key) &&
+            input->key_pressed(driver->input_data, key))
+         BIT64_SET(ret, key);
+   }
 
-      if (key >= RARCH_FIRST_META_KEY)
-         state |= input->meta_key_pressed(driver->input_data, key);
+   for (key = RARCH_FIRST_META_KEY; key < RARCH_BIND_LIST_END; key++)
+   {
+      if (input->meta_key_pressed(driver->input_data, key))
+         BIT64_SET(ret, key);
+   }
 
 #ifdef HAVE_OVERLAY
-      state |= input_overlay_key_pressed(key);
+   ret |= input_overlay_keys_pressed();
 #endif
 
 #ifdef HAVE_COMMAND
-      if (driver->command)
-         state |= rarch_cmd_get(driver->command, key);
+   if (driver->command)
+      ret |= rarch_cmd_get_state(driver->command);
 #endif
 
-      if (state)
-         ret |= (UINT64_C(1) << key);
+   return ret & ((UINT64_C(1) << RARCH_BIND_LIST_END) - 1);
+}
+
+/**
+ * input_driver_poll:
+ *
+ * Polls the input driver and invalidates the input snapshot,
+ * so that core queries sample the new driver state.
+ **/
+void input_driver_poll(void)
+{
+   driver_t            *driver = driver_get_ptr();
+   const input_driver_t *input = input_get_ptr(driver);
+
+   input->poll(driver->input_data);
+
+   input_driver_snapshot_invalidate();
+   input_snapshot.poll_time = rarch_get_time_usec();
+}
+
+/**
+ * input_driver_snapshot_invalidate:
+ *
+ * Forces the next core queries to sample the driver again.
+ * Binds may have been changed since the snapshot was taken
+ * (e.g. analog D-Pad mode), so this is done every frame.
+ **/
+void input_driver_snapshot_invalidate(void)
+{
+   input_snapshot.buttons_valid = 0;
+   input_snapshot.analog_valid  = 0;
+}
+
+/**
+ * input_driver_snapshot_poll_time:
+ *
+ * Returns: time of the last input driver poll, in microseconds.
+ **/
+retro_time_t input_driver_snapshot_poll_time(void)
+{
+   return input_snapshot.poll_time;
+}
+
+/**
+ * input_driver_latency_event:
+ * @event_time         : Timestamp of an input event, in microseconds,
+ *                       on the rarch_get_time_usec() clock.
+ *
+ * Called by drivers when polling picks up new input events.
+ * The latency until the next video frame is accounted for.
+ **/
+void input_driver_latency_event(retro_time_t event_time)
+{
+   if (event_time <= input_latency.last)
+      return;
+
+   input_latency.last = event_time;
+   if (!input_latency.pending)
+      input_latency.pending = event_time;
+}
+
+/**
+ * input_driver_latency_frame:
+ *
+ * Called when a video frame is handed to the video driver.
+ * Records the time elapsed since the oldest input event
+ * sampled for this frame.
+ **/
+void input_driver_latency_frame(void)
+{
+   retro_time_t delta;
+
+   if (!input_latency.pending)
+      return;
+
+   delta                 = rarch_get_time_usec() - input_latency.pending;
+   input_latency.pending = 0;
+
+   /* Drivers might not be able to timestamp events
+    * on our clock, don't let that skew the statistics. */
+   if (delta < 0 || delta > 1000000)
+      return;
+
+   input_latency.count++;
+   input_latency.total += delta;
+   if (delta > input_latency.max)
+      input_latency.max = delta;
+}
+
+static void input_driver_latency_log(void)
+{
+   if (!input_latency.count)
+      return;
+
+   RARCH_LOG("[Input]: Average input-to-frame latency: %.3f ms (max %.3f ms, %u events).\n",
+         (double)input_latency.total / input_latency.count / 1000.0,
+         (double)input_latency.max / 1000.0,
+         (unsigned)input_latency.count);
+
+   memset(&input_latency, 0, sizeof(input_latency));
+}
+
+/**
+ * input_driver_snapshot_state:
+ * @retro_keybinds     : Binds of all users.
+ * @port               : User number.
+ * @device             : Device identifier of user.
+ * @index              : Index value of user.
+ * @id                 : Identifier of key pressed by user.
+ *
+ * Like input_driver_state(), but RetroPad buttons and analog axes
+ * are sampled from the driver only once per poll for every user.
+ * Subsequent queries are answered from the snapshot.
+ *
+ * Returns: Non-zero if the given key (identified by @id) was pressed
+ * by the user (assigned to @port).
+ **/
+int16_t input_driver_snapshot_state(
+      const struct retro_keybind **retro_keybinds,
+      unsigned port, unsigned device, unsigned index, unsigned id)
+{
+   unsigned i, j;
+   driver_t            *driver = driver_get_ptr();
+   const input_driver_t *input = input_get_ptr(driver);
+
+   if (port >= MAX_USERS)
+      return input->input_state(driver->input_data, retro_keybinds,
+            port, device, index, id);
+
+   switch (device)
+   {
+      case RETRO_DEVICE_JOYPAD:
+         if (id >= INPUT_SNAPSHOT_BUTTONS)
+            break;
+
+         if (!(input_snapshot.buttons_valid & (1 << port)))
+         {
+            uint16_t buttons = 0;
+
+            for (i = 0; i < INPUT_SNAPSHOT_BUTTONS; i++)
+               if (input->input_state(driver->input_data, retro_keybinds,
+                        port, RETRO_DEVICE_JOYPAD, 0, i))
+                  buttons |= 1 << i;
+
+            input_snapshot.buttons[port]  = buttons;
+            input_snapshot.buttons_valid |= 1 << port;
+         }
+         return (input_snapshot.buttons[port] >> id) & 1;
+      case RETRO_DEVICE_ANALOG:
+         if (index > RETRO_DEVICE_INDEX_ANALOG_RIGHT ||
+               id > RETRO_DEVICE_ID_ANALOG_Y)
+            break;
+
+         if (!(input_snapshot.analog_valid & (1 << port)))
+         {
+            for (i = 0; i < 2; i++)
+               for (j = 0; j < 2; j++)
+                  input_snapshot.analog[port][i][j] = input->input_state(
+                        driver->input_data, retro_keybinds,
+                        port, RETRO_DEVICE_ANALOG, i, j);
+
+            input_snapshot.analog_valid |= 1 << port;
+         }
+         return input_snapshot.analog[port][index][id];
    }
-   return ret;
+
+   return input->input_state(driver->input_data, retro_keybinds,
+         port, device, index, id);
 }
 
 int16_t input_driver_state(const struct retro_keybind **retro_keybinds,
@@ -297,6 +581,8 @@ void input_driver_free(void)
 {
    driver_t *driver               = driver_get_ptr();
 
+   input_driver_latency_log();
+
    if (driver && driver->input)
       driver->input->free(driver->input_data);
 }
@@ -140,8 +140,65 @@ void find_input_driver(void);
 bool input_driver_set_rumble_state(unsigned port,
       enum retro_rumble_effect effect, uint16_t strength);
 
+/**
+ * input_driver_binds_changed:
+ *
+ * Marks the compiled bind table as stale. Must be called whenever
+ * the binds of user 1 or its autoconfig binds are modified.
+ **/
+void input_driver_binds_changed(void);
+
+/**
+ * input_driver_keys_pressed:
+ *
+ * Samples all RetroArch binds of user 1 (RetroPad and hotkeys).
+ *
+ * Returns: bitmask of (1 << key_bind_id) of all pressed binds.
+ **/
 retro_input_t input_driver_keys_pressed(void);
 
+/**
+ * input_driver_poll:
+ *
+ * Polls the input driver and invalidates the input snapshot.
+ **/
+void input_driver_poll(void);
+
+void input_driver_snapshot_invalidate(void);
+
+/**
+ * input_driver_snapshot_poll_time:
+ *
+ * Returns: time of the last input driver poll, in microseconds.
+ **/
+retro_time_t input_driver_snapshot_poll_time(void);
+
+/**
+ * input_driver_latency_event:
+ * @event_time         : Timestamp of an input event, in microseconds,
+ *                       on the rarch_get_time_usec() clock.
+ *
+ * Called by drivers when polling picks up new input events.
+ **/
+void input_driver_latency_event(retro_time_t event_time);
+
+/**
+ * input_driver_latency_frame:
+ *
+ * Called when a video frame is handed to the video driver.
+ **/
+void input_driver_latency_frame(void);
+
+/**
+ * input_driver_snapshot_state:
+ *
+ * Like input_driver_state(), but RetroPad buttons and analog axes
+ * are sampled from the driver only once per poll for every user.
+ **/
+int16_t input_driver_snapshot_state(
+      const struct retro_keybind **retro_keybinds,
+      unsigned port, unsigned device, unsigned index, unsigned id);
+
 int16_t input_driver_state(const struct retro_keybind **retro_keybinds,
       unsigned port, unsigned device, unsigned index, unsigned id);
 
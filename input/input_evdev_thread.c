@@ -0,0 +1,284 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include <rthreads/rthreads.h>
+
+#include "input_evdev_thread.h"
+
+/* Event data of the pipe used to wake up the thread on shutdown. */
+#define EVDEV_THREAD_WAKEUP 0xffffffffu
+
+struct evdev_thread_port
+{
+   int fd;
+
+   /* State owned by the input thread. */
+   evdev_pad_state_t state;
+
+   /* Published copy of @state, guarded by @seq.
+    * @seq is odd while the input thread is writing. */
+   volatile unsigned seq;
+   evdev_pad_state_t published;
+};
+
+struct evdev_thread
+{
+   sthread_t *thread;
+
+   /* Held while events are processed, so that ports
+    * can be removed safely from the main thread. */
+   slock_t *lock;
+
+   int epfd;
+   int wakeup[2];
+   volatile bool alive;
+
+   evdev_event_cb_t cb;
+   void *data;
+
+   struct evdev_thread_port ports[EVDEV_THREAD_MAX_PORTS];
+};
+
+static void evdev_thread_publish(struct evdev_thread_port *port)
+{
+   port->seq++;
+   __sync_synchronize();
+   memcpy(&port->published, &port->state, sizeof(port->published));
+   __sync_synchronize();
+   port->seq++;
+}
+
+/* Stops watching a port whose device is gone. Its file descriptor
+ * is left to the main thread, which removes the port when udev
+ * reports the device removal. */
+static void evdev_thread_drop(evdev_thread_t *thr, unsigned idx)
+{
+   struct evdev_thread_port *port = &thr->ports[idx];
+
+   epoll_ctl(thr->epfd, EPOLL_CTL_DEL, port->fd, NULL);
+   port->fd = -1;
+
+   memset(&port->state, 0, sizeof(port->state));
+   evdev_thread_publish(port);
+}
+
+static void evdev_thread_drain(evdev_thread_t *thr, unsigned idx,
+      uint32_t revents)
+{
+   int i, len;
+   struct input_event events[32];
+   struct evdev_thread_port *port = &thr->ports[idx];
+   bool changed                   = false;
+
+   if (port->fd < 0)
+      return;
+
+   while ((len = read(port->fd, events, sizeof(events))) > 0)
+   {
+      len /= sizeof(*events);
+      for (i = 0; i < len; i++)
+         thr->cb(thr->data, idx, &events[i], &port->state);
+
+      port->state.time = evdev_event_time(&events[len - 1]);
+      changed          = true;
+   }
+
+   /* EPOLLHUP and EPOLLERR are reported on every epoll_wait()
+    * once the device is unplugged, so stop polling it right away. */
+   if ((revents & (EPOLLHUP | EPOLLERR))
+         || (len < 0 && errno != EAGAIN && errno != EINTR))
+   {
+      evdev_thread_drop(thr, idx);
+      return;
+   }
+
+   if (changed)
+      evdev_thread_publish(port);
+}
+
+static void evdev_thread_loop(void *data)
+{
+   int i, n;
+   struct epoll_event events[EVDEV_THREAD_MAX_PORTS + 1];
+   evdev_thread_t *thr = (evdev_thread_t*)data;
+
+   while (thr->alive)
+   {
+      n = epoll_wait(thr->epfd, events, EVDEV_THREAD_MAX_PORTS + 1, -1);
+
+      slock_lock(thr->lock);
+      for (i = 0; i < n; i++)
+      {
+         if (events[i].data.u32 == EVDEV_THREAD_WAKEUP)
+            continue;
+         if (events[i].data.u32 < EVDEV_THREAD_MAX_PORTS)
+            evdev_thread_drain(thr, events[i].data.u32, events[i].events);
+      }
+      slock_unlock(thr->lock);
+   }
+}
+
+evdev_thread_t *evdev_thread_new(evdev_event_cb_t cb, void *data)
+{
+   unsigned i;
+   struct epoll_event event = {0};
+   evdev_thread_t *thr      = (evdev_thread_t*)calloc(1, sizeof(*thr));
+
+   if (!thr)
+      return NULL;
+
+   thr->cb         = cb;
+   thr->data       = data;
+   thr->alive      = true;
+   thr->wakeup[0]  = -1;
+   thr->wakeup[1]  = -1;
+
+   for (i = 0; i < EVDEV_THREAD_MAX_PORTS; i++)
+      thr->ports[i].fd = -1;
+
+   thr->epfd = epoll_create(EVDEV_THREAD_MAX_PORTS + 1);
+   if (thr->epfd < 0)
+      goto error;
+
+   if (pipe(thr->wakeup) < 0)
+      goto error;
+
+   event.events   = EPOLLIN;
+   event.data.u32 = EVDEV_THREAD_WAKEUP;
+   if (epoll_ctl(thr->epfd, EPOLL_CTL_ADD, thr->wakeup[0], &event) < 0)
+      goto error;
+
+   thr->lock = slock_new();
+   if (!thr->lock)
+      goto error;
+
+   thr->thread = sthread_create(evdev_thread_loop, thr);
+   if (!thr->thread)
+      goto error;
+
+   return thr;
+
+error:
+   thr->alive = false;
+   evdev_thread_free(thr);
+   return NULL;
+}
+
+void evdev_thread_free(evdev_thread_t *thr)
+{
+   if (!thr)
+      return;
+
+   if (thr->thread)
+   {
+      ssize_t ret;
+
+      thr->alive = false;
+      ret        = write(thr->wakeup[1], "", 1);
+      (void)ret;
+
+      sthread_join(thr->thread);
+   }
+
+   if (thr->lock)
+      slock_free(thr->lock);
+   if (thr->wakeup[0] >= 0)
+      close(thr->wakeup[0]);
+   if (thr->wakeup[1] >= 0)
+      close(thr->wakeup[1]);
+   if (thr->epfd >= 0)
+      close(thr->epfd);
+
+   free(thr);
+}
+
+bool evdev_thread_add(evdev_thread_t *thr, unsigned idx, int fd,
+      const evdev_pad_state_t *state)
+{
+   struct epoll_event event = {0};
+   struct evdev_thread_port *port;
+   bool ret                 = true;
+
+   if (!thr || idx >= EVDEV_THREAD_MAX_PORTS)
+      return false;
+
+   port = &thr->ports[idx];
+
+   slock_lock(thr->lock);
+
+   port->fd    = fd;
+   port->state = *state;
+   evdev_thread_publish(port);
+
+   event.events   = EPOLLIN;
+   event.data.u32 = idx;
+   if (epoll_ctl(thr->epfd, EPOLL_CTL_ADD, fd, &event) < 0)
+   {
+      port->fd = -1;
+      ret      = false;
+   }
+
+   slock_unlock(thr->lock);
+
+   return ret;
+}
+
+void evdev_thread_remove(evdev_thread_t *thr, unsigned idx)
+{
+   struct evdev_thread_port *port;
+
+   if (!thr || idx >= EVDEV_THREAD_MAX_PORTS)
+      return;
+
+   port = &thr->ports[idx];
+
+   slock_lock(thr->lock);
+
+   if (port->fd >= 0)
+      epoll_ctl(thr->epfd, EPOLL_CTL_DEL, port->fd, NULL);
+   port->fd = -1;
+
+   memset(&port->state, 0, sizeof(port->state));
+   evdev_thread_publish(port);
+
+   slock_unlock(thr->lock);
+}
+
+void evdev_thread_read(evdev_thread_t *thr, unsigned idx,
+      evdev_pad_state_t *state)
+{
+   unsigned seq;
+   const struct evdev_thread_port *port;
+
+   if (!thr || idx >= EVDEV_THREAD_MAX_PORTS)
+      return;
+
+   port = &thr->ports[idx];
+
+   do
+   {
+      while ((seq = port->seq) & 1)
+         ;
+      __sync_synchronize();
+      memcpy(state, &port->published, sizeof(*state));
+      __sync_synchronize();
+   } while (seq != port->seq);
+}
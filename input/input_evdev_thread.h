@@ -0,0 +1,121 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INPUT_EVDEV_THREAD_H
+#define __INPUT_EVDEV_THREAD_H
+
+#include <stdint.h>
+#include <boolean.h>
+#include <retro_inline.h>
+#include <linux/input.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVDEV_THREAD_MAX_PORTS 16
+#define EVDEV_NUM_AXES 32
+#define EVDEV_NUM_HATS 4
+
+/* Input state of one evdev device. */
+typedef struct evdev_pad_state
+{
+   uint64_t buttons;
+   int16_t axes[EVDEV_NUM_AXES];
+   int8_t hats[EVDEV_NUM_HATS][2];
+
+   /* Kernel timestamp of the last event applied to this state,
+    * in microseconds. */
+   int64_t time;
+} evdev_pad_state_t;
+
+/* Applies a single evdev event of device @port to @state. */
+typedef void (*evdev_event_cb_t)(void *data, unsigned port,
+      const struct input_event *event, evdev_pad_state_t *state);
+
+typedef struct evdev_thread evdev_thread_t;
+
+/**
+ * evdev_event_time:
+ * @event                 : evdev event.
+ *
+ * Returns: timestamp of @event in microseconds.
+ **/
+static INLINE int64_t evdev_event_time(const struct input_event *event)
+{
+   return (int64_t)event->time.tv_sec * 1000000 + event->time.tv_usec;
+}
+
+/**
+ * evdev_thread_new:
+ * @cb                    : Callback applying events to a device state.
+ * @data                  : User data passed to @cb.
+ *
+ * Starts a thread which drains all added evdev file descriptors
+ * as soon as events arrive. @cb is called on the input thread.
+ *
+ * Returns: handle to the input thread, NULL on error.
+ **/
+evdev_thread_t *evdev_thread_new(evdev_event_cb_t cb, void *data);
+
+/**
+ * evdev_thread_free:
+ * @thread                : Input thread handle.
+ *
+ * Stops the input thread. File descriptors are not closed.
+ **/
+void evdev_thread_free(evdev_thread_t *thread);
+
+/**
+ * evdev_thread_add:
+ * @thread                : Input thread handle.
+ * @port                  : Device index.
+ * @fd                    : Non-blocking evdev file descriptor.
+ * @state                 : Initial device state.
+ *
+ * Starts draining @fd on the input thread.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool evdev_thread_add(evdev_thread_t *thread, unsigned port, int fd,
+      const evdev_pad_state_t *state);
+
+/**
+ * evdev_thread_remove:
+ * @thread                : Input thread handle.
+ * @port                  : Device index.
+ *
+ * Stops draining the file descriptor of @port. Once this returns,
+ * @cb will not be called for @port anymore and the file descriptor
+ * can be closed.
+ **/
+void evdev_thread_remove(evdev_thread_t *thread, unsigned port);
+
+/**
+ * evdev_thread_read:
+ * @thread                : Input thread handle.
+ * @port                  : Device index.
+ * @state                 : Latest device state.
+ *
+ * Samples the latest state of @port. Never blocks on the input thread.
+ **/
+void evdev_thread_read(evdev_thread_t *thread, unsigned port,
+      evdev_pad_state_t *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1446,6 +1446,22 @@ bool input_overlay_key_pressed(int key)
    return (ol_state->buttons & (UINT64_C(1) << key));
 }
 
+/**
+ * input_overlay_keys_pressed:
+ *
+ * Returns: bitmask of (1 << key_bind_id) of all binds
+ * currently pressed on the overlay.
+ **/
+uint64_t input_overlay_keys_pressed(void)
+{
+   input_overlay_state_t *ol_state  = input_overlay_get_state_ptr();
+
+   if (!ol_state)
+      return 0;
+
+   return ol_state->buttons;
+}
+
 /*
  * input_poll_overlay:
  *
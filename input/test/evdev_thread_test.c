@@ -0,0 +1,181 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Feeds fake evdev devices (pipes carrying struct input_event,
+ * like a uinput device would produce) through the input thread
+ * and checks that the sampled state and timestamps follow. */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include <retro_miscellaneous.h>
+
+#include "../input_evdev_thread.h"
+
+#define NUM_PORTS 2
+
+static int64_t now_usec(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return (int64_t)tv.tv_sec * 1000000 + tv.tv_nsec / 1000;
+}
+
+static void handle_event(void *data, unsigned port,
+      const struct input_event *event, evdev_pad_state_t *state)
+{
+   (void)data;
+   (void)port;
+
+   switch (event->type)
+   {
+      case EV_KEY:
+         if (event->value)
+            BIT64_SET(state->buttons, event->code - BTN_MISC);
+         else
+            BIT64_CLEAR(state->buttons, event->code - BTN_MISC);
+         break;
+      case EV_ABS:
+         if (event->code < EVDEV_NUM_AXES)
+            state->axes[event->code] = event->value;
+         break;
+   }
+}
+
+static void inject(int fd, unsigned type, unsigned code, int value)
+{
+   struct input_event ev[2];
+   int64_t t = now_usec();
+
+   memset(ev, 0, sizeof(ev));
+   ev[0].time.tv_sec  = t / 1000000;
+   ev[0].time.tv_usec = t % 1000000;
+   ev[0].type         = type;
+   ev[0].code         = code;
+   ev[0].value        = value;
+   ev[1].time         = ev[0].time;
+   ev[1].type         = EV_SYN;
+   ev[1].code         = SYN_REPORT;
+
+   if (write(fd, ev, sizeof(ev)) != sizeof(ev))
+      fprintf(stderr, "Short write on fake device.\n");
+}
+
+/* Waits until @port reflects @buttons, returns latency in usec or -1. */
+static int64_t wait_state(evdev_thread_t *thr, unsigned port,
+      uint64_t buttons, int64_t since)
+{
+   evdev_pad_state_t state;
+   int64_t start = now_usec();
+
+   while (now_usec() - start < 1000000)
+   {
+      evdev_thread_read(thr, port, &state);
+      if (state.buttons == buttons && state.time >= since)
+         return now_usec() - state.time;
+   }
+
+   return -1;
+}
+
+int main(void)
+{
+   unsigned i, port;
+   int fds[NUM_PORTS][2];
+   int ret                   = 0;
+   int64_t worst             = 0;
+   evdev_pad_state_t initial = {0};
+   evdev_pad_state_t state;
+   evdev_thread_t *thr       = evdev_thread_new(handle_event, NULL);
+
+   if (!thr)
+   {
+      fprintf(stderr, "Failed to start input thread.\n");
+      return 1;
+   }
+
+   for (port = 0; port < NUM_PORTS; port++)
+   {
+      if (pipe(fds[port]) < 0)
+         return 1;
+      fcntl(fds[port][0], F_SETFL, O_NONBLOCK);
+
+      initial.axes[0] = port;
+      if (!evdev_thread_add(thr, port, fds[port][0], &initial))
+      {
+         fprintf(stderr, "Failed to add fake device #%u.\n", port);
+         return 1;
+      }
+
+      evdev_thread_read(thr, port, &state);
+      if (state.axes[0] != (int16_t)port)
+      {
+         fprintf(stderr, "Initial state of #%u not published.\n", port);
+         ret = 1;
+      }
+   }
+
+   for (i = 0; i < 1000; i++)
+   {
+      int64_t latency;
+      int64_t t = now_usec();
+
+      port = i % NUM_PORTS;
+      inject(fds[port][1], EV_KEY, BTN_MISC + (i % 16), 1);
+
+      latency = wait_state(thr, port, UINT64_C(1) << (i % 16), t);
+      if (latency < 0)
+      {
+         fprintf(stderr, "Press #%u on device #%u was lost.\n", i, port);
+         ret = 1;
+         break;
+      }
+      if (latency > worst)
+         worst = latency;
+
+      inject(fds[port][1], EV_KEY, BTN_MISC + (i % 16), 0);
+      if (wait_state(thr, port, 0, t) < 0)
+      {
+         fprintf(stderr, "Release #%u on device #%u was lost.\n", i, port);
+         ret = 1;
+         break;
+      }
+   }
+
+   inject(fds[0][1], EV_ABS, 3, -1234);
+   evdev_thread_remove(thr, 0);
+   evdev_thread_read(thr, 0, &state);
+   if (state.buttons || state.axes[0] || state.axes[3])
+   {
+      fprintf(stderr, "State of removed device was not cleared.\n");
+      ret = 1;
+   }
+
+   evdev_thread_free(thr);
+
+   for (port = 0; port < NUM_PORTS; port++)
+   {
+      close(fds[port][0]);
+      close(fds[port][1]);
+   }
+
+   printf("%s: worst event-to-sample latency %.3f ms.\n",
+         ret ? "FAIL" : "PASS", worst / 1000.0);
+
+   return ret;
+}
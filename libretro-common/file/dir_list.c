@@ -25,6 +25,9 @@
 #include <compat/strl.h>
 #include <compat/posix_string.h>
 
+#include <ctype.h>
+#include <stdlib.h>
+
 #if defined(_WIN32)
 #ifdef _MSC_VER
 #define setmode _setmode
@@ -127,14 +130,132 @@ static bool dirent_is_directory(const char *path,
 }
 #endif
 
+struct dir_list_handle
+{
+#ifdef _WIN32
+   WIN32_FIND_DATA ffd;
+   HANDLE hFind;
+   bool ffd_valid;
+#else
+   DIR *directory;
+#endif
+   char dir[PATH_MAX_LENGTH];
+   bool include_dirs;
+
+   /* Allowed extensions, lower case, in an open addressed
+    * hash table of ext_mask + 1 slots. NULL if every
+    * extension is allowed. */
+   char **ext_table;
+   size_t ext_mask;
+};
+
+static uint32_t dir_list_ext_hash(const char *ext)
+{
+   uint32_t hash = 5381;
+
+   for (; *ext; ext++)
+      hash = (hash << 5) + hash + (uint8_t)tolower((unsigned char)*ext);
+
+   return hash;
+}
+
+static void dir_list_ext_set_free(struct dir_list_handle *handle)
+{
+   size_t i;
+
+   if (!handle->ext_table)
+      return;
+
+   for (i = 0; i <= handle->ext_mask; i++)
+      free(handle->ext_table[i]);
+   free(handle->ext_table);
+   handle->ext_table = NULL;
+}
+
+/**
+ * dir_list_ext_set_init:
+ * @handle       : directory listing handle.
+ * @ext          : allowed extensions, separated by '|'. A leading
+ *                 dot on an extension is ignored.
+ *
+ * Builds the hashed set of allowed extensions of @handle.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool dir_list_ext_set_init(struct dir_list_handle *handle,
+      const char *ext)
+{
+   size_t i, size = 8;
+   struct string_list *ext_list = string_split(ext, "|");
+
+   if (!ext_list)
+      return false;
+
+   while (size < ext_list->size * 2)
+      size *= 2;
+
+   handle->ext_table = (char**)calloc(size, sizeof(*handle->ext_table));
+   handle->ext_mask  = size - 1;
+
+   if (!handle->ext_table)
+      goto error;
+
+   for (i = 0; i < ext_list->size; i++)
+   {
+      char *elem   = ext_list->elems[i].data;
+      size_t slot;
+
+      if (*elem == '.')
+         elem++;
+
+      for (slot = dir_list_ext_hash(elem) & handle->ext_mask;
+            handle->ext_table[slot];
+            slot = (slot + 1) & handle->ext_mask)
+      {
+         if (!strcasecmp(handle->ext_table[slot], elem))
+            break;
+      }
+
+      if (handle->ext_table[slot])
+         continue;
+
+      handle->ext_table[slot] = strdup(elem);
+      if (!handle->ext_table[slot])
+         goto error;
+   }
+
+   string_list_free(ext_list);
+   return true;
+
+error:
+   string_list_free(ext_list);
+   dir_list_ext_set_free(handle);
+   return false;
+}
+
+static bool dir_list_ext_set_find(const struct dir_list_handle *handle,
+      const char *ext)
+{
+   size_t slot;
+
+   for (slot = dir_list_ext_hash(ext) & handle->ext_mask;
+         handle->ext_table[slot];
+         slot = (slot + 1) & handle->ext_mask)
+   {
+      if (!strcasecmp(handle->ext_table[slot], ext))
+         return true;
+   }
+
+   return false;
+}
+
 /**
  * parse_dir_entry:
+ * @handle       : directory listing handle.
  * @name         : name of the directory listing entry.
  * @file_path    : file path of the directory listing entry.
  * @is_dir       : is the directory listing a directory?
- * @include_dirs : include directories as part of the finished directory listing?
  * @list         : pointer to directory listing.
- * @ext_list     : pointer to allowed file extensions listing.
  * @file_ext     : file extension of the directory listing entry.
  *
  * Parses a directory listing.
@@ -142,10 +263,9 @@ static bool dirent_is_directory(const char *path,
  * Returns: zero on success, -1 on error, 1 if we should
  * continue to the next entry in the directory listing.
  **/
-static int parse_dir_entry(const char *name, char *file_path,
-      bool is_dir, bool include_dirs,
-      struct string_list *list, struct string_list *ext_list,
-      const char *file_ext)
+static int parse_dir_entry(const struct dir_list_handle *handle,
+      const char *name, char *file_path, bool is_dir,
+      struct string_list *list, const char *file_ext)
 {
    union string_list_elem_attr attr;
    bool is_compressed_file = false;
@@ -156,17 +276,18 @@ static int parse_dir_entry(const char *name, char *file_path,
    if (!is_dir)
    {
       is_compressed_file = path_is_compressed_file(file_path);
-      if (string_list_find_elem_prefix(ext_list, ".", file_ext))
+      if (handle->ext_table && dir_list_ext_set_find(handle, file_ext))
          supported_by_core = true;
    }
 
-   if (!include_dirs && is_dir)
+   if (!handle->include_dirs && is_dir)
       return 1;
 
    if (!strcmp(name, ".") || !strcmp(name, ".."))
       return 1;
 
-   if (!is_compressed_file && !is_dir && ext_list && !supported_by_core)
+   if (!is_compressed_file && !is_dir && handle->ext_table
+         && !supported_by_core)
       return 1;
 
    if (is_dir)
@@ -191,111 +312,185 @@ static int parse_dir_entry(const char *name, char *file_path,
 }
 
 /**
- * dir_list_new:
+ * dir_list_open:
  * @dir          : directory path.
  * @ext          : allowed extensions of file directory entries to include.
  * @include_dirs : include directories as part of the finished directory listing?
  *
- * Create a directory listing.
+ * Starts reading a directory listing in steps, see dir_list_iterate().
  *
- * Returns: pointer to a directory listing of type 'struct string_list *' on success,
- * NULL in case of error. Has to be freed manually.
+ * Returns: handle to the directory listing on success, NULL if the
+ * directory cannot be opened. Has to be freed with dir_list_close().
  **/
-struct string_list *dir_list_new(const char *dir,
+dir_list_handle_t *dir_list_open(const char *dir,
       const char *ext, bool include_dirs)
 {
 #ifdef _WIN32
-   WIN32_FIND_DATA ffd;
-   HANDLE hFind = INVALID_HANDLE_VALUE;
-#else
-   DIR *directory = NULL;
-   const struct dirent *entry = NULL;
-#endif
    char path_buf[PATH_MAX_LENGTH] = {0};
-   struct string_list *ext_list   = NULL;
-   struct string_list *list       = NULL;
-
-   (void)path_buf;
+#endif
+   dir_list_handle_t *handle      = (dir_list_handle_t*)
+      calloc(1, sizeof(*handle));
 
-   if (!(list = string_list_new()))
+   if (!handle)
       return NULL;
 
-   if (ext)
-      ext_list = string_split(ext, "|");
+   strlcpy(handle->dir, dir, sizeof(handle->dir));
+   handle->include_dirs = include_dirs;
+
+   if (ext && !dir_list_ext_set_init(handle, ext))
+      goto error;
 
 #ifdef _WIN32
    snprintf(path_buf, sizeof(path_buf), "%s\\*", dir);
 
-   hFind = FindFirstFile(path_buf, &ffd);
-   if (hFind == INVALID_HANDLE_VALUE)
+   handle->hFind = FindFirstFile(path_buf, &handle->ffd);
+   if (handle->hFind == INVALID_HANDLE_VALUE)
       goto error;
+   handle->ffd_valid = true;
+#else
+   handle->directory = opendir(dir);
+   if (!handle->directory)
+      goto error;
+#endif
 
-   do
+   return handle;
+
+error:
+   dir_list_close(handle);
+   return NULL;
+}
+
+/**
+ * dir_list_iterate:
+ * @handle       : directory listing handle.
+ * @list         : directory listing the entries are appended to.
+ * @max_entries  : maximum number of directory entries to read.
+ *
+ * Reads up to @max_entries further entries of the directory and
+ * appends the ones that pass the filters of dir_list_open() to @list.
+ *
+ * Returns: 1 if there are entries left to read, 0 when the whole
+ * directory has been read and -1 on error.
+ **/
+int dir_list_iterate(dir_list_handle_t *handle,
+      struct string_list *list, size_t max_entries)
+{
+   size_t read = 0;
+
+#ifdef _WIN32
+   if (handle->hFind == INVALID_HANDLE_VALUE)
+      return 0;
+
+   for (; handle->ffd_valid && read < max_entries; read++)
    {
-      int ret                         = 0;
       char file_path[PATH_MAX_LENGTH] = {0};
-      const char *name                = ffd.cFileName;
+      const char *name                = handle->ffd.cFileName;
       const char *file_ext            = path_get_extension(name);
-      bool is_dir                     = ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
+      bool is_dir                     = handle->ffd.dwFileAttributes
+         & FILE_ATTRIBUTE_DIRECTORY;
 
-      fill_pathname_join(file_path, dir, name, sizeof(file_path));
+      fill_pathname_join(file_path, handle->dir, name, sizeof(file_path));
 
-      ret = parse_dir_entry(name, file_path, is_dir,
-            include_dirs, list, ext_list, file_ext);
+      if (parse_dir_entry(handle, name, file_path, is_dir,
+               list, file_ext) == -1)
+         return -1;
 
-      if (ret == -1)
-         goto error;
-
-      if (ret == 1)
-         continue;
-   }while (FindNextFile(hFind, &ffd) != 0);
-
-   FindClose(hFind);
-   string_list_free(ext_list);
-   return list;
+      handle->ffd_valid = FindNextFile(handle->hFind, &handle->ffd) != 0;
+   }
 
-error:
-   if (hFind != INVALID_HANDLE_VALUE)
-      FindClose(hFind);
+   return handle->ffd_valid ? 1 : 0;
 #else
-   directory = opendir(dir);
-   if (!directory)
-      goto error;
+   const struct dirent *entry = NULL;
 
-   while ((entry = readdir(directory)))
+   if (!handle->directory)
+      return 0;
+
+   for (; read < max_entries; read++)
    {
-      int ret                         = 0;
       char file_path[PATH_MAX_LENGTH] = {0};
-      const char *name                = entry->d_name;
-      const char *file_ext            = path_get_extension(name);
+      const char *name                = NULL;
+      const char *file_ext            = NULL;
       bool is_dir                     = false;
 
-      fill_pathname_join(file_path, dir, name, sizeof(file_path));
+      if (!(entry = readdir(handle->directory)))
+         return 0;
 
-      is_dir = dirent_is_directory(file_path, entry);
+      name     = entry->d_name;
+      file_ext = path_get_extension(name);
 
-      ret = parse_dir_entry(name, file_path, is_dir,
-            include_dirs, list, ext_list, file_ext);
+      fill_pathname_join(file_path, handle->dir, name, sizeof(file_path));
 
-      if (ret == -1)
-         goto error;
+      is_dir = dirent_is_directory(file_path, entry);
 
-      if (ret == 1)
-         continue;
+      if (parse_dir_entry(handle, name, file_path, is_dir,
+               list, file_ext) == -1)
+         return -1;
    }
 
-   closedir(directory);
+   return 1;
+#endif
+}
 
-   string_list_free(ext_list);
-   return list;
+/**
+ * dir_list_close:
+ * @handle       : directory listing handle.
+ *
+ * Stops reading a directory listing and frees @handle.
+ **/
+void dir_list_close(dir_list_handle_t *handle)
+{
+   if (!handle)
+      return;
 
-error:
+#ifdef _WIN32
+   if (handle->hFind != INVALID_HANDLE_VALUE && handle->hFind)
+      FindClose(handle->hFind);
+#else
+   if (handle->directory)
+      closedir(handle->directory);
+#endif
 
-   if (directory)
-      closedir(directory);
+   dir_list_ext_set_free(handle);
+   free(handle);
+}
 
-#endif
+/**
+ * dir_list_new:
+ * @dir          : directory path.
+ * @ext          : allowed extensions of file directory entries to include.
+ * @include_dirs : include directories as part of the finished directory listing?
+ *
+ * Create a directory listing.
+ *
+ * Returns: pointer to a directory listing of type 'struct string_list *' on success,
+ * NULL in case of error. Has to be freed manually.
+ **/
+struct string_list *dir_list_new(const char *dir,
+      const char *ext, bool include_dirs)
+{
+   int ret                    = 0;
+   struct string_list *list   = NULL;
+   dir_list_handle_t *handle  = dir_list_open(dir, ext, include_dirs);
+
+   if (!handle)
+      return NULL;
+
+   if (!(list = string_list_new()))
+      goto error;
+
+   do
+   {
+      ret = dir_list_iterate(handle, list, (size_t)-1);
+   } while (ret == 1);
+
+   if (ret == -1)
+      goto error;
+
+   dir_list_close(handle);
+   return list;
+
+error:
+   dir_list_close(handle);
    string_list_free(list);
-   string_list_free(ext_list);
    return NULL;
 }
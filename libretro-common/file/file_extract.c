@@ -28,6 +28,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <zlib.h>
 
 /* File backends. Can be fleshed out later, but keep it simple for now.
@@ -285,7 +287,7 @@ static uint32_t read_le(const uint8_t *data, unsigned size)
 
    size *= 8;
    for (i = 0; i < size; i += 8)
-      val |= *data++ << i;
+      val |= (uint32_t)*data++ << i;
 
    return val;
 }
@@ -671,181 +673,547 @@ bool zlib_parse_file(const char *file, const char *valid_exts,
          break;
    }
 
+   /* Unmaps the archive if parsing ended in the middle of an
+    * iteration. */
+   zlib_parse_file_iterate_stop(&state);
+
    return returnerr;
 }
 
-struct zip_extract_userdata
-{
-   char *zip_path;
-   const char *extraction_directory;
-   size_t zip_path_size;
-   struct string_list *ext;
-   bool found_content;
-};
-
 enum
 {
    ZLIB_MODE_UNCOMPRESSED = 0,
    ZLIB_MODE_DEFLATE      = 8
 } zlib_compression_mode;
 
-static int zip_extract_cb(const char *name, const char *valid_exts,
-      const uint8_t *cdata,
-      unsigned cmode, uint32_t csize, uint32_t size,
-      uint32_t checksum, void *userdata)
+#ifndef LOCAL_FILE_HEADER_SIGNATURE
+#define LOCAL_FILE_HEADER_SIGNATURE 0x04034b50
+#endif
+
+/* Archives whose central directory is kept around. */
+#define ZLIB_INDEX_CACHE_SIZE 4
+
+/* Buffer used to inflate entries to files. */
+#define ZLIB_EXTRACT_CHUNK_SIZE (64 * 1024)
+
+struct zlib_index
+{
+   char *path;
+   int64_t mtime;
+   uint64_t zip_size;
+   unsigned last_use;
+
+   struct zlib_index_entry *entries;
+   size_t count;
+   char *names;
+
+   /* Open addressing table of entry index + 1, 0 for free slots. */
+   size_t *slots;
+   size_t num_slots;
+};
+
+static zlib_index_t *zlib_index_cache[ZLIB_INDEX_CACHE_SIZE];
+static unsigned zlib_index_use_count;
+
+static uint32_t zlib_index_hash(const char *name)
 {
-   struct zip_extract_userdata *data = (struct zip_extract_userdata*)userdata;
+   uint32_t hash = 5381;
+
+   while (*name)
+      hash = (hash << 5) + hash + (uint8_t)*name++;
+
+   return hash;
+}
 
-   /* Extract first content that matches our list. */
-   const char *ext = path_get_extension(name);
+static size_t *zlib_index_slot(const zlib_index_t *index, const char *name)
+{
+   size_t mask = index->num_slots - 1;
+   size_t i    = zlib_index_hash(name) & mask;
 
-   if (ext && string_list_find_elem(data->ext, ext))
+   while (index->slots[i])
    {
-      char new_path[PATH_MAX_LENGTH] = {0};
+      if (!strcmp(index->entries[index->slots[i] - 1].name, name))
+         break;
+      i = (i + 1) & mask;
+   }
 
-      if (data->extraction_directory)
-         fill_pathname_join(new_path, data->extraction_directory,
-               path_basename(name), sizeof(new_path));
-      else
-         fill_pathname_resolve_relative(new_path, data->zip_path,
-               path_basename(name), sizeof(new_path));
+   return &index->slots[i];
+}
 
-      switch (cmode)
-      {
-         case ZLIB_MODE_UNCOMPRESSED:
-            data->found_content = zlib_write_file(new_path, cdata, size);
-            return false;
-         case ZLIB_MODE_DEFLATE:
-            {
-               int ret = 0;
-               zlib_file_handle_t handle = {0};
-               if (!zlib_inflate_data_to_file_init(&handle, cdata, csize, size))
-                  return 0;
-
-               do{
-                  ret = zlib_inflate_data_to_file_iterate(handle.stream);
-               }while(ret == 0);
-
-               if (zlib_inflate_data_to_file(&handle, ret, new_path, valid_exts,
-                        cdata, csize, size, checksum))
-               {
-                  strlcpy(data->zip_path, new_path, data->zip_path_size);
-                  data->found_content = true;
-                  return 0;
-               }
-               return 0;
-            }
-
-         default:
-            return 0;
-      }
+static void zlib_index_free(zlib_index_t *index)
+{
+   if (!index)
+      return;
+
+   free(index->path);
+   free(index->entries);
+   free(index->names);
+   free(index->slots);
+   free(index);
+}
+
+static zlib_index_t *zlib_index_new(const char *path,
+      int64_t mtime, uint64_t zip_size)
+{
+   size_t i, count, names_size = 0;
+   const uint8_t *directory, *end;
+   zlib_transfer_t state = {0};
+   zlib_index_t *index   = (zlib_index_t*)calloc(1, sizeof(*index));
+
+   if (!index)
+      return NULL;
+
+   if (zlib_parse_file_init(&state, path) != 0)
+      goto error;
+
+   count     = read_le(state.footer + 10, 2);
+   directory = state.directory;
+   end       = state.footer;
+
+   if (directory < state.data || directory > end)
+      goto error;
+
+   /* First pass to size the name storage. */
+   for (i = 0; i < count; i++)
+   {
+      if (end - directory < 46
+            || read_le(directory, 4) != CENTRAL_FILE_HEADER_SIGNATURE)
+         goto error;
+
+      names_size += read_le(directory + 28, 2) + 1;
+      directory  += 46 + read_le(directory + 28, 2)
+         + read_le(directory + 30, 2) + read_le(directory + 32, 2);
+
+      if (directory > end)
+         goto error;
    }
 
-   return 1;
+   index->path      = strdup(path);
+   index->mtime     = mtime;
+   index->zip_size  = zip_size;
+   index->entries   = (struct zlib_index_entry*)
+      calloc(count + 1, sizeof(*index->entries));
+   index->names     = (char*)malloc(names_size + 1);
+   for (index->num_slots = 16; index->num_slots < count * 2; )
+      index->num_slots *= 2;
+   index->slots     = (size_t*)calloc(index->num_slots, sizeof(*index->slots));
+
+   if (!index->path || !index->entries || !index->names || !index->slots)
+      goto error;
+
+   directory  = state.directory;
+   names_size = 0;
+
+   for (i = 0; i < count; i++)
+   {
+      size_t *slot;
+      struct zlib_index_entry *entry = &index->entries[index->count];
+      unsigned namelength            = read_le(directory + 28, 2);
+      char *name                     = index->names + names_size;
+
+      memcpy(name, directory + 46, namelength);
+      name[namelength] = '\0';
+      names_size      += namelength + 1;
+
+      entry->name   = name;
+      entry->cmode  = read_le(directory + 10, 2);
+      entry->crc32  = read_le(directory + 16, 4);
+      entry->csize  = read_le(directory + 20, 4);
+      entry->size   = read_le(directory + 24, 4);
+      entry->offset = read_le(directory + 42, 4);
+
+      directory += 46 + namelength
+         + read_le(directory + 30, 2) + read_le(directory + 32, 2);
+
+      /* Keep the first of entries with the same name. */
+      slot = zlib_index_slot(index, name);
+      if (*slot)
+         continue;
+
+      *slot = ++index->count;
+   }
+
+   state.backend->free(state.handle);
+   return index;
+
+error:
+   if (state.handle)
+      state.backend->free(state.handle);
+   zlib_index_free(index);
+   return NULL;
 }
 
 /**
- * zlib_extract_first_content_file:
- * @zip_path                    : filename path to ZIP archive.
- * @zip_path_size               : size of ZIP archive.
- * @valid_exts                  : valid extensions for a content file.
- * @extraction_directory        : the directory to extract temporary
- *                                unzipped content to.
+ * zlib_index_get:
+ * @path                        : filename path of archive.
  *
- * Extract first content file from archive.
+ * Gets the parsed central directory of an archive. The last few
+ * archives are cached until their size or modification time changes,
+ * so that listing and extracting from the same archive parses its
+ * directory only once.
  *
- * Returns : true (1) on success, otherwise false (0).
+ * The index stays valid until the next call of zlib_index_get(),
+ * and should not be used by more than one thread at a time.
+ *
+ * Returns: index of archive on success, otherwise NULL.
  **/
-bool zlib_extract_first_content_file(char *zip_path, size_t zip_path_size,
-      const char *valid_exts, const char *extraction_directory)
+const zlib_index_t *zlib_index_get(const char *path)
 {
-   struct string_list *list;
-   bool ret = true;
-   struct zip_extract_userdata userdata = {0};
+   unsigned i;
+   struct stat st;
+   zlib_index_t **slot = &zlib_index_cache[0];
 
-   if (!valid_exts)
+   if (!path || stat(path, &st) < 0)
+      return NULL;
+
+   for (i = 0; i < ZLIB_INDEX_CACHE_SIZE; i++)
    {
-      /* Libretro implementation does not have any valid extensions.
-       * Cannot unzip without knowing this. */
+      zlib_index_t *index = zlib_index_cache[i];
+
+      if (!index)
+      {
+         slot = &zlib_index_cache[i];
+         continue;
+      }
+
+      if (!strcmp(index->path, path))
+      {
+         if (index->mtime == (int64_t)st.st_mtime
+               && index->zip_size == (uint64_t)st.st_size)
+         {
+            index->last_use = ++zlib_index_use_count;
+            return index;
+         }
+
+         /* Changed since, parse it again. */
+         slot = &zlib_index_cache[i];
+         break;
+      }
+
+      if (*slot && index->last_use < (*slot)->last_use)
+         slot = &zlib_index_cache[i];
+   }
+
+   zlib_index_free(*slot);
+   *slot = zlib_index_new(path, st.st_mtime, st.st_size);
+
+   if (*slot)
+      (*slot)->last_use = ++zlib_index_use_count;
+
+   return *slot;
+}
+
+size_t zlib_index_count(const zlib_index_t *index)
+{
+   return index ? index->count : 0;
+}
+
+const struct zlib_index_entry *zlib_index_entry(const zlib_index_t *index,
+      size_t i)
+{
+   if (!index || i >= index->count)
+      return NULL;
+   return &index->entries[i];
+}
+
+const struct zlib_index_entry *zlib_index_find(const zlib_index_t *index,
+      const char *name)
+{
+   size_t i;
+
+   if (!index || !name)
+      return NULL;
+
+   if (!(i = *zlib_index_slot(index, name)))
+      return NULL;
+
+   return &index->entries[i - 1];
+}
+
+/* Returns the compressed data of @entry, or NULL if it
+ * does not fit into the archive. */
+static const uint8_t *zlib_index_entry_data(const uint8_t *data,
+      size_t zip_size, const struct zlib_index_entry *entry)
+{
+   size_t start;
+
+   if ((size_t)entry->offset + 30 > zip_size
+         || read_le(data + entry->offset, 4) != LOCAL_FILE_HEADER_SIGNATURE)
+      return NULL;
+
+   start = (size_t)entry->offset + 30
+      + read_le(data + entry->offset + 26, 2)
+      + read_le(data + entry->offset + 28, 2);
+
+   if (start + entry->csize > zip_size)
+      return NULL;
+
+   return data + start;
+}
+
+/* Inflates @entry either into @out, which holds entry->size bytes,
+ * or to @file through a fixed size buffer. */
+static bool zlib_index_inflate(const uint8_t *cdata,
+      const struct zlib_index_entry *entry, uint8_t *out, FILE *file)
+{
+   int zstatus;
+   z_stream stream;
+   uint32_t checksum = 0;
+   uint8_t *chunk    = NULL;
+
+   if (entry->cmode == ZLIB_MODE_UNCOMPRESSED)
+   {
+      if (entry->csize != entry->size)
+         return false;
+
+      if (crc32(0, cdata, entry->size) != entry->crc32)
+         return false;
+
+      if (out)
+         memcpy(out, cdata, entry->size);
+      else if (fwrite(cdata, 1, entry->size, file) != entry->size)
+         return false;
+
+      return true;
+   }
+
+   if (entry->cmode != ZLIB_MODE_DEFLATE)
       return false;
+
+   memset(&stream, 0, sizeof(stream));
+   if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+      return false;
+
+   stream.next_in  = (uint8_t*)cdata;
+   stream.avail_in = entry->csize;
+
+   if (out)
+   {
+      stream.next_out  = out;
+      stream.avail_out = entry->size;
+      zstatus          = inflate(&stream, Z_FINISH);
+      checksum         = crc32(0, out, stream.total_out);
    }
+   else if ((chunk = (uint8_t*)malloc(ZLIB_EXTRACT_CHUNK_SIZE)))
+   {
+      do
+      {
+         size_t have;
 
-   list = string_split(valid_exts, "|");
-   if (!list)
-      GOTO_END_ERROR();
+         stream.next_out  = chunk;
+         stream.avail_out = ZLIB_EXTRACT_CHUNK_SIZE;
+         zstatus          = inflate(&stream, Z_NO_FLUSH);
+
+         if (zstatus != Z_OK && zstatus != Z_STREAM_END)
+            break;
+
+         have     = ZLIB_EXTRACT_CHUNK_SIZE - stream.avail_out;
+         checksum = crc32(checksum, chunk, have);
+
+         if (fwrite(chunk, 1, have, file) != have)
+            zstatus = Z_ERRNO;
+      } while (zstatus == Z_OK && stream.total_out <= entry->size);
+
+      free(chunk);
+   }
+   else
+      zstatus = Z_MEM_ERROR;
+
+   inflateEnd(&stream);
+
+   return zstatus == Z_STREAM_END
+      && stream.total_out == entry->size
+      && checksum == entry->crc32;
+}
+
+static bool zlib_index_extract(const char *path, const char *name,
+      void **buf, size_t *len, FILE *file)
+{
+   bool ret                              = false;
+   void *handle                          = NULL;
+   uint8_t *out                          = NULL;
+   const uint8_t *cdata                  = NULL;
+   const struct zlib_file_backend *backend = zlib_get_default_file_backend();
+   const struct zlib_index_entry *entry  = zlib_index_find(
+         zlib_index_get(path), name);
+
+   if (!entry || !(handle = backend->open(path)))
+      return false;
 
-   userdata.zip_path             = zip_path;
-   userdata.zip_path_size        = zip_path_size;
-   userdata.extraction_directory = extraction_directory;
-   userdata.ext                  = list;
+   cdata = zlib_index_entry_data(backend->data(handle),
+         backend->size(handle), entry);
+   if (!cdata)
+      goto end;
 
-   if (!zlib_parse_file(zip_path, valid_exts, zip_extract_cb, &userdata))
+#if defined(HAVE_MMAP) && defined(POSIX_MADV_SEQUENTIAL)
    {
-      /* Parsing ZIP failed. */
-      GOTO_END_ERROR();
+      uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+      posix_madvise((void*)((uintptr_t)cdata & ~page),
+            entry->csize + ((uintptr_t)cdata & page), POSIX_MADV_SEQUENTIAL);
    }
+#endif
 
-   if (!userdata.found_content)
+   if (buf)
    {
-      /* Didn't find any content that matched valid extensions
-       * for libretro implementation. */
-      GOTO_END_ERROR();
+      if (!(out = (uint8_t*)malloc(entry->size + 1)))
+         goto end;
+
+      if (!(ret = zlib_index_inflate(cdata, entry, out, NULL)))
+      {
+         free(out);
+         goto end;
+      }
+
+      out[entry->size] = '\0';
+      *buf = out;
+      if (len)
+         *len = entry->size;
    }
+   else
+      ret = zlib_index_inflate(cdata, entry, NULL, file);
 
 end:
-   if (list)
-      string_list_free(list);
+   backend->free(handle);
    return ret;
 }
 
-static int zlib_get_file_list_cb(const char *path, const char *valid_exts,
-      const uint8_t *cdata,
-      unsigned cmode, uint32_t csize, uint32_t size, uint32_t checksum,
-      void *userdata)
+/**
+ * zlib_extract_to_buffer:
+ * @path                        : filename path of archive.
+ * @name                        : name of entry in archive.
+ * @buf                         : buffer to allocate and extract the
+ *                                entry into. Needs to be freed manually.
+ * @len                         : size of the extracted entry.
+ *
+ * Inflates a single entry straight from the archive into memory.
+ * The buffer is NUL terminated for convenience.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool zlib_extract_to_buffer(const char *path, const char *name,
+      void **buf, size_t *len)
 {
-   union string_list_elem_attr attr;
-   struct string_list *ext_list = NULL;
-   const char *file_ext = NULL;
-   struct string_list *list = (struct string_list*)userdata;
-
-   (void)cdata;
-   (void)cmode;
-   (void)csize;
-   (void)size;
-   (void)checksum;
-   (void)valid_exts;
-   (void)file_ext;
-   (void)ext_list;
+   if (!buf)
+      return false;
+   *buf = NULL;
+   return zlib_index_extract(path, name, buf, len, NULL);
+}
 
-   memset(&attr, 0, sizeof(attr));
+/**
+ * zlib_extract_to_file:
+ * @path                        : filename path of archive.
+ * @name                        : name of entry in archive.
+ * @out_path                    : file to extract the entry to.
+ *
+ * Inflates a single entry from the archive to a file, through a
+ * fixed size buffer.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool zlib_extract_to_file(const char *path, const char *name,
+      const char *out_path)
+{
+   bool ret;
+   FILE *file = NULL;
 
-   if (valid_exts)
-      ext_list = string_split(valid_exts, "|");
+   if (!zlib_index_find(zlib_index_get(path), name))
+      return false;
 
-   if (ext_list)
-   {
-      char last_char = ' ';
+   if (!(file = fopen(out_path, "wb")))
+      return false;
 
-      /* Checks if this entry is a directory or a file. */
-      last_char = path[strlen(path)-1];
+   ret = zlib_index_extract(path, name, NULL, NULL, file);
 
-      if (last_char == '/' || last_char == '\\' ) /* Skip if directory. */
-         goto error;
+   if (fclose(file) != 0)
+      ret = false;
 
-      file_ext = path_get_extension(path);
+   if (!ret)
+      remove(out_path);
 
-      if (!file_ext || 
-            !string_list_find_elem_prefix(ext_list, ".", file_ext))
-         goto error;
+   return ret;
+}
 
-      attr.i = RARCH_COMPRESSED_FILE_IN_ARCHIVE;
-      string_list_free(ext_list);
+/**
+ * zlib_find_first_content_file:
+ * @zip_path                    : filename path to ZIP archive.
+ * @valid_exts                  : valid extensions for a content file.
+ *
+ * Finds the first content file in an archive.
+ *
+ * Returns : name of the entry in the archive, or NULL if there is none.
+ * Valid until the next call of zlib_index_get().
+ **/
+const char *zlib_find_first_content_file(const char *zip_path,
+      const char *valid_exts)
+{
+   size_t i;
+   const char *name          = NULL;
+   struct string_list *list  = NULL;
+   const zlib_index_t *index = NULL;
+
+   /* Libretro implementation does not have any valid extensions.
+    * Cannot unzip without knowing this. */
+   if (!valid_exts)
+      return NULL;
+
+   /* Parsing ZIP failed. */
+   if (!(index = zlib_index_get(zip_path)))
+      return NULL;
+
+   if (!(list = string_split(valid_exts, "|")))
+      return NULL;
+
+   for (i = 0; i < zlib_index_count(index); i++)
+   {
+      const struct zlib_index_entry *entry = zlib_index_entry(index, i);
+      const char *ext                      = path_get_extension(entry->name);
+
+      if (ext && string_list_find_elem(list, ext))
+      {
+         name = entry->name;
+         break;
+      }
    }
 
-   return string_list_append(list, path, attr);
-error:
-   string_list_free(ext_list);
-   return 0;
+   string_list_free(list);
+   return name;
+}
+
+/**
+ * zlib_extract_first_content_file:
+ * @zip_path                    : filename path to ZIP archive.
+ * @zip_path_size               : size of ZIP archive.
+ * @valid_exts                  : valid extensions for a content file.
+ * @extraction_directory        : the directory to extract temporary
+ *                                unzipped content to.
+ *
+ * Extract first content file from archive.
+ *
+ * Returns : true (1) on success, otherwise false (0).
+ **/
+bool zlib_extract_first_content_file(char *zip_path, size_t zip_path_size,
+      const char *valid_exts, const char *extraction_directory)
+{
+   char new_path[PATH_MAX_LENGTH] = {0};
+   const char *name = zlib_find_first_content_file(zip_path, valid_exts);
+
+   /* Didn't find any content that matched valid extensions
+    * for libretro implementation. */
+   if (!name)
+      return false;
+
+   if (extraction_directory)
+      fill_pathname_join(new_path, extraction_directory,
+            path_basename(name), sizeof(new_path));
+   else
+      fill_pathname_resolve_relative(new_path, zip_path,
+            path_basename(name), sizeof(new_path));
+
+   if (!zlib_extract_to_file(zip_path, name, new_path))
+      return false;
+
+   strlcpy(zip_path, new_path, zip_path_size);
+   return true;
 }
 
 /**
@@ -856,20 +1224,59 @@ error:
  **/
 struct string_list *zlib_get_file_list(const char *path, const char *valid_exts)
 {
-   struct string_list *list = string_list_new();
+   size_t i;
+   union string_list_elem_attr attr;
+   struct string_list *ext_list = NULL;
+   struct string_list *list     = NULL;
+   const zlib_index_t *index    = zlib_index_get(path);
 
-   if (!list)
+   /* Parsing ZIP failed. */
+   if (!index)
       return NULL;
 
-   if (!zlib_parse_file(path, valid_exts,
-            zlib_get_file_list_cb, list))
-   {
-      /* Parsing ZIP failed. */
-      string_list_free(list);
+   if (!(list = string_list_new()))
       return NULL;
+
+   memset(&attr, 0, sizeof(attr));
+
+   if (valid_exts)
+   {
+      if (!(ext_list = string_split(valid_exts, "|")))
+         goto error;
+      attr.i = RARCH_COMPRESSED_FILE_IN_ARCHIVE;
    }
 
+   for (i = 0; i < zlib_index_count(index); i++)
+   {
+      const char *name = zlib_index_entry(index, i)->name;
+
+      if (ext_list)
+      {
+         const char *file_ext = NULL;
+         size_t len           = strlen(name);
+
+         /* Skip directories. */
+         if (!len || name[len - 1] == '/' || name[len - 1] == '\\')
+            continue;
+
+         file_ext = path_get_extension(name);
+
+         if (!file_ext ||
+               !string_list_find_elem_prefix(ext_list, ".", file_ext))
+            continue;
+      }
+
+      if (!string_list_append(list, name, attr))
+         goto error;
+   }
+
+   string_list_free(ext_list);
    return list;
+
+error:
+   string_list_free(ext_list);
+   string_list_free(list);
+   return NULL;
 }
 
 bool zlib_perform_mode(const char *path, const char *valid_exts,
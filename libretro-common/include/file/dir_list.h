@@ -29,6 +29,45 @@
 extern "C" {
 #endif
 
+typedef struct dir_list_handle dir_list_handle_t;
+
+/**
+ * dir_list_open:
+ * @dir          : directory path.
+ * @ext          : allowed extensions of file directory entries to include.
+ * @include_dirs : include directories as part of the finished directory listing?
+ *
+ * Starts reading a directory listing in steps, see dir_list_iterate().
+ *
+ * Returns: handle to the directory listing on success, NULL if the
+ * directory cannot be opened. Has to be freed with dir_list_close().
+ **/
+dir_list_handle_t *dir_list_open(const char *dir, const char *ext,
+      bool include_dirs);
+
+/**
+ * dir_list_iterate:
+ * @handle       : directory listing handle.
+ * @list         : directory listing the entries are appended to.
+ * @max_entries  : maximum number of directory entries to read.
+ *
+ * Reads up to @max_entries further entries of the directory and
+ * appends the ones that pass the filters of dir_list_open() to @list.
+ *
+ * Returns: 1 if there are entries left to read, 0 when the whole
+ * directory has been read and -1 on error.
+ **/
+int dir_list_iterate(dir_list_handle_t *handle,
+      struct string_list *list, size_t max_entries);
+
+/**
+ * dir_list_close:
+ * @handle       : directory listing handle.
+ *
+ * Stops reading a directory listing and frees @handle.
+ **/
+void dir_list_close(dir_list_handle_t *handle);
+
 /**
  * dir_list_new:
  * @dir          : directory path.
@@ -85,6 +85,19 @@ int zlib_parse_file_iterate(void *data, bool *returnerr,
 
 void zlib_parse_file_iterate_stop(void *data);
 
+/**
+ * zlib_find_first_content_file:
+ * @zip_path                    : filename path to ZIP archive.
+ * @valid_exts                  : valid extensions for a content file.
+ *
+ * Finds the first content file in an archive.
+ *
+ * Returns : name of the entry in the archive, or NULL if there is none.
+ * Valid until the next call of zlib_index_get().
+ **/
+const char *zlib_find_first_content_file(const char *zip_path,
+      const char *valid_exts);
+
 /**
  * zlib_extract_first_content_file:
  * @zip_path                    : filename path to ZIP archive.
@@ -110,6 +123,81 @@ bool zlib_extract_first_content_file(char *zip_path, size_t zip_path_size,
  **/
 struct string_list *zlib_get_file_list(const char *path, const char *valid_exts);
 
+/* Entry of the central directory of a ZIP archive. */
+struct zlib_index_entry
+{
+   const char *name;
+   uint32_t crc32;
+   uint32_t csize;
+   uint32_t size;
+   unsigned cmode;
+   /* Offset of the local file header. */
+   uint32_t offset;
+};
+
+typedef struct zlib_index zlib_index_t;
+
+/**
+ * zlib_index_get:
+ * @path                        : filename path of archive.
+ *
+ * Gets the parsed central directory of an archive. The last few
+ * archives are cached until their size or modification time changes,
+ * so that listing and extracting from the same archive parses its
+ * directory only once.
+ *
+ * The index stays valid until the next call of zlib_index_get(),
+ * and should not be used by more than one thread at a time.
+ *
+ * Returns: index of archive on success, otherwise NULL.
+ **/
+const zlib_index_t *zlib_index_get(const char *path);
+
+size_t zlib_index_count(const zlib_index_t *index);
+
+const struct zlib_index_entry *zlib_index_entry(const zlib_index_t *index,
+      size_t i);
+
+/**
+ * zlib_index_find:
+ * @index                       : index of archive.
+ * @name                        : name of entry in archive.
+ *
+ * Returns: entry called @name, or NULL if there is none.
+ **/
+const struct zlib_index_entry *zlib_index_find(const zlib_index_t *index,
+      const char *name);
+
+/**
+ * zlib_extract_to_buffer:
+ * @path                        : filename path of archive.
+ * @name                        : name of entry in archive.
+ * @buf                         : buffer to allocate and extract the
+ *                                entry into. Needs to be freed manually.
+ * @len                         : size of the extracted entry.
+ *
+ * Inflates a single entry straight from the archive into memory.
+ * The buffer is NUL terminated for convenience.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool zlib_extract_to_buffer(const char *path, const char *name,
+      void **buf, size_t *len);
+
+/**
+ * zlib_extract_to_file:
+ * @path                        : filename path of archive.
+ * @name                        : name of entry in archive.
+ * @out_path                    : file to extract the entry to.
+ *
+ * Inflates a single entry from the archive to a file, through a
+ * fixed size buffer.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool zlib_extract_to_file(const char *path, const char *name,
+      const char *out_path);
+
 bool zlib_inflate_data_to_file_init(
       zlib_file_handle_t *handle,
       const uint8_t *cdata,  uint32_t csize, uint32_t size);
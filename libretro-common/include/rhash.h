@@ -20,29 +20,6 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
-/*
- *  sha1.h
- *
- *  Copyright (C) 1998, 2009
- *  Paul E. Jones <paulej@packetizer.com>
- *  All Rights Reserved
- *
- *****************************************************************************
- *  $Id: sha1.h 12 2009-06-22 19:34:25Z paulej $
- *****************************************************************************
- *
- *  Description:
- *      This class implements the Secure Hashing Standard as defined
- *      in FIPS PUB 180-1 published April 17, 1995.
- *
- *      Many of the variable names in the SHA1Context, especially the
- *      single character names, were used because those were the names
- *      used in the publication.
- *
- *      Please read the file sha1.c for more information.
- *
- */
-
 #ifndef __RARCH_HASH_H
 #define __RARCH_HASH_H
 
@@ -55,6 +32,7 @@
 #endif
 
 #include <retro_inline.h>
+#include <boolean.h>
 
 /** 
  * sha256_hash:
@@ -66,22 +44,127 @@
  **/
 void sha256_hash(char *out, const uint8_t *in, size_t size);
 
-typedef struct SHA1Context
+/**
+ * crc32_adjust:
+ * @checksum          : running checksum, not inverted.
+ * @input             : next byte.
+ *
+ * Bytewise CRC32 update, without the initial and final inversion.
+ *
+ * Returns: updated checksum.
+ **/
+uint32_t crc32_adjust(uint32_t checksum, uint8_t input);
+
+/**
+ * crc32_update:
+ * @checksum          : CRC32 of the preceding data, 0 to start.
+ * @data              : input.
+ * @length            : size of @data.
+ *
+ * Continues a CRC32 (as used by zlib and ZIP) over @data.
+ * Uses PCLMULQDQ or the ARMv8 CRC32 instructions where available.
+ *
+ * Returns: CRC32 of the preceding data and @data.
+ **/
+uint32_t crc32_update(uint32_t checksum, const uint8_t *data, size_t length);
+
+uint32_t crc32_calculate(const uint8_t *data, size_t length);
+
+struct sha1_context
 {
-   unsigned Message_Digest[5]; /* Message Digest (output)          */
+   uint32_t state[5];
+   uint64_t length;
+   uint8_t block[64];
+};
+
+void sha1_init(struct sha1_context *ctx);
+
+void sha1_update(struct sha1_context *ctx, const void *data, size_t size);
 
-   unsigned Length_Low;        /* Message length in bits           */
-   unsigned Length_High;       /* Message length in bits           */
+void sha1_final(struct sha1_context *ctx, uint8_t digest[20]);
+
+struct md5_context
+{
+   uint32_t state[4];
+   uint64_t length;
+   uint8_t block[64];
+};
 
-   unsigned char Message_Block[64]; /* 512-bit message blocks      */
-   int Message_Block_Index;    /* Index into message block array   */
+void md5_init(struct md5_context *ctx);
 
-   int Computed;               /* Is the digest computed?          */
-   int Corrupted;              /* Is the message digest corruped?  */
-} SHA1Context;
+void md5_update(struct md5_context *ctx, const void *data, size_t size);
+
+void md5_final(struct md5_context *ctx, uint8_t digest[16]);
+
+enum rhash_type
+{
+   RHASH_CRC32 = (1 << 0),
+   RHASH_MD5   = (1 << 1),
+   RHASH_SHA1  = (1 << 2)
+};
+
+struct rhash_result
+{
+   uint64_t size;
+   uint32_t crc32;
+   uint8_t md5[16];
+   uint8_t sha1[20];
+};
+
+/* Computes several hashes of the same data in one pass. */
+typedef struct rhash_stream
+{
+   unsigned types;
+   uint64_t size;
+   uint32_t crc32;
+   struct md5_context md5;
+   struct sha1_context sha1;
+} rhash_stream_t;
+
+/**
+ * rhash_stream_init:
+ * @stream            : stream to initialize.
+ * @types             : bitmask of enum rhash_type values.
+ **/
+void rhash_stream_init(rhash_stream_t *stream, unsigned types);
+
+void rhash_stream_update(rhash_stream_t *stream,
+      const void *data, size_t size);
+
+/**
+ * rhash_stream_final:
+ * @stream            : stream.
+ * @result            : hashes of all data passed to the stream.
+ *                      Hashes not in the types of @stream are zero.
+ **/
+void rhash_stream_final(rhash_stream_t *stream, struct rhash_result *result);
+
+/**
+ * rhash_file:
+ * @path              : path of file.
+ * @types             : bitmask of enum rhash_type values.
+ * @result            : hashes of the file.
+ *
+ * Hashes a file in one pass. The file is mapped to memory
+ * if possible and read in chunks otherwise.
+ *
+ * Returns: 0 on success, -1 if the file could not be read.
+ **/
+int rhash_file(const char *path, unsigned types, struct rhash_result *result);
+
+/**
+ * rhash_set_simd:
+ * @enable            : use CPU specific code paths if available.
+ *
+ * Enabled by default. Tests and benchmarks turn it off
+ * to compare against the portable code.
+ **/
+void rhash_set_simd(bool enable);
 
 int sha1_calculate(const char *path, char *result);
 
+int md5_calculate(const char *path, char *result);
+
 uint32_t djb2_calculate(const char *str);
 
 #endif
@@ -173,7 +173,7 @@ int libretrodb_open(const char *path, libretrodb_t *db)
       goto error;
    }
 
-   if (strncmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)) != 0)
+   if (memcmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER) - 1) != 0)
    {
       rv = -EINVAL;
       goto error;
@@ -310,7 +310,11 @@ int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       return EOF;
 
 retry:
-   rv = rmsgpack_dom_read(cursor->fp, out);
+   /* Items rejected by the query are discarded by
+    * reusing their memory for the next item. */
+   rmsgpack_dom_arena_reset(cursor->arena);
+
+   rv = rmsgpack_dom_read_arena(cursor->fp, out, cursor->arena);
    if (rv < 0)
       return rv;
 
@@ -323,10 +327,7 @@ retry:
    if (cursor->query)
    {
       if (!libretrodb_query_filter(cursor->query, out))
-      {
-         rmsgpack_dom_value_free(out);
          goto retry;
-      }
    }
 
    return 0;
@@ -348,11 +349,14 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
    if (cursor->query)
       libretrodb_query_free(cursor->query);
 
+   rmsgpack_dom_arena_free(cursor->arena);
+
    cursor->is_valid = 0;
    cursor->fp       = NULL;
    cursor->eof      = 1;
    cursor->db       = NULL;
    cursor->query    = NULL;
+   cursor->arena    = NULL;
 }
 
 /**
@@ -373,6 +377,15 @@ int libretrodb_cursor_open(libretrodb_t *db, libretrodb_cursor_t *cursor,
    if (cursor->fp == NULL)
       return -errno;
 
+   cursor->arena = rmsgpack_dom_arena_new(0);
+
+   if (!cursor->arena)
+   {
+      fclose(cursor->fp);
+      cursor->fp = NULL;
+      return -ENOMEM;
+   }
+
    cursor->db       = db;
    cursor->is_valid = 1;
 
@@ -496,7 +509,6 @@ int libretrodb_create_index(libretrodb_t *db,
          goto clean;
       }
       buff = NULL;
-      rmsgpack_dom_value_free(&item);
       item_loc = libretrodb_tell(db);
    }
 
@@ -516,7 +528,6 @@ int libretrodb_create_index(libretrodb_t *db,
    bintree_iterate(&tree, node_iter, &nictx);
    bintree_free(&tree);
 clean:
-   rmsgpack_dom_value_free(&item);
    if (buff)
       free(buff);
    if (cur.is_valid)
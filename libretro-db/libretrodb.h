@@ -52,6 +52,7 @@ typedef struct libretrodb_cursor
 	int eof;
 	libretrodb_query_t * query;
 	libretrodb_t * db;
+	struct rmsgpack_dom_arena * arena;
 } libretrodb_cursor_t;
 
 typedef int (* libretrodb_value_provider)(void * ctx,
@@ -117,6 +118,18 @@ void *libretrodb_query_compile(
 
 void libretrodb_query_free(void *q);
 
+/**
+ * libretrodb_cursor_read_item:
+ * @cursor              : Handle to database cursor.
+ * @out                 : Next item matching the query of @cursor.
+ *
+ * @out is owned by @cursor and stays valid until the next call
+ * to this function or libretrodb_cursor_close(). It must not be
+ * freed with rmsgpack_dom_value_free().
+ *
+ * Returns: 0 if successful, EOF at the end of the database,
+ * otherwise negative.
+ **/
 int libretrodb_cursor_read_item(libretrodb_cursor_t * cursor,
       struct rmsgpack_dom_value * out);
 
@@ -0,0 +1,185 @@
+/* Measures allocations and throughput of cursor scans over a
+ * synthetic database, with and without a query.
+ *
+ * Allocation counts come from linker-wrapped malloc/calloc/realloc,
+ * see the libretrodb_bench target in the Makefile. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libretrodb.h"
+#include "rmsgpack_dom.h"
+
+#define BENCH_RECORDS 50000
+#define BENCH_PATH    "libretrodb_bench.rdb"
+
+static unsigned long alloc_count;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+   alloc_count++;
+   return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+   alloc_count++;
+   return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+   alloc_count++;
+   return __real_realloc(ptr, size);
+}
+
+struct bench_provider
+{
+   unsigned i;
+   char strings[6][64];
+   uint8_t crc[4];
+   uint8_t md5[16];
+   uint8_t sha1[20];
+   struct rmsgpack_dom_pair pairs[9];
+};
+
+static void bench_set_string(struct rmsgpack_dom_value *v, char *s)
+{
+   v->type           = RDT_STRING;
+   v->val.string.len = strlen(s);
+   v->val.string.buff = s;
+}
+
+static void bench_set_binary(struct rmsgpack_dom_value *v,
+      uint8_t *data, uint32_t len)
+{
+   v->type            = RDT_BINARY;
+   v->val.binary.len  = len;
+   v->val.binary.buff = (char*)data;
+}
+
+static int bench_value_provider(void *ctx, struct rmsgpack_dom_value *out)
+{
+   unsigned j;
+   static const char *keys[] = {
+      "name", "description", "rom_name", "serial", "publisher",
+      "developer", "crc", "md5", "sha1"
+   };
+   struct bench_provider *p = (struct bench_provider*)ctx;
+
+   if (p->i == BENCH_RECORDS)
+   {
+      out->type = RDT_NULL;
+      return 1;
+   }
+
+   snprintf(p->strings[0], 64, "Game %u", p->i);
+   snprintf(p->strings[1], 64, "Game %u (USA) (Rev %u)", p->i, p->i % 3);
+   snprintf(p->strings[2], 64, "Game %u (USA).bin", p->i);
+   snprintf(p->strings[3], 64, "SLUS-%05u", p->i);
+   snprintf(p->strings[4], 64, "Publisher %u", p->i % 97);
+   snprintf(p->strings[5], 64, "Developer %u|Studio %u",
+         p->i % 31, p->i % 7);
+
+   for (j = 0; j < 4; j++)
+      p->crc[j] = (uint8_t)(p->i >> (24 - j * 8));
+   for (j = 0; j < 16; j++)
+      p->md5[j] = (uint8_t)(p->i * 7 + j);
+   for (j = 0; j < 20; j++)
+      p->sha1[j] = (uint8_t)(p->i * 13 + j);
+
+   for (j = 0; j < 9; j++)
+      bench_set_string(&p->pairs[j].key, (char*)keys[j]);
+   for (j = 0; j < 6; j++)
+      bench_set_string(&p->pairs[j].value, p->strings[j]);
+   bench_set_binary(&p->pairs[6].value, p->crc, 4);
+   bench_set_binary(&p->pairs[7].value, p->md5, 16);
+   bench_set_binary(&p->pairs[8].value, p->sha1, 20);
+
+   out->type          = RDT_MAP;
+   out->val.map.len   = 9;
+   out->val.map.items = p->pairs;
+
+   p->i++;
+   return 0;
+}
+
+static double bench_now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int bench_scan(libretrodb_t *db, const char *query,
+      const char *label)
+{
+   libretrodb_cursor_t cur;
+   struct rmsgpack_dom_value item;
+   libretrodb_query_t *q   = NULL;
+   const char *error       = NULL;
+   unsigned long allocs    = alloc_count;
+   unsigned matches        = 0;
+   double start            = bench_now();
+
+   if (query)
+   {
+      q = (libretrodb_query_t*)libretrodb_query_compile(db, query,
+            strlen(query), &error);
+      if (error)
+      {
+         printf("%s\n", error);
+         return -1;
+      }
+   }
+
+   if (libretrodb_cursor_open(db, &cur, q) != 0)
+      return -1;
+
+   while (libretrodb_cursor_read_item(&cur, &item) == 0)
+      matches++;
+
+   libretrodb_cursor_close(&cur);
+
+   if (q)
+      libretrodb_query_free(q);
+
+   printf("%-12s %6u matches %9lu allocs %8.3f ms %10.0f records/s\n",
+         label, matches, alloc_count - allocs,
+         (bench_now() - start) * 1000.0,
+         BENCH_RECORDS / (bench_now() - start));
+
+   return 0;
+}
+
+int main(void)
+{
+   libretrodb_t db;
+   struct bench_provider provider;
+   FILE *fp = fopen(BENCH_PATH, "wb");
+
+   if (!fp)
+      return 1;
+
+   memset(&provider, 0, sizeof(provider));
+   libretrodb_create(fp, bench_value_provider, &provider);
+   fclose(fp);
+
+   if (libretrodb_open(BENCH_PATH, &db) != 0)
+      return 1;
+
+   bench_scan(&db, NULL, "list");
+   bench_scan(&db, "{'crc':b'0000C34F'}", "crc lookup");
+   bench_scan(&db, "{'name':glob('Game 4999*')}", "name glob");
+
+   libretrodb_close(&db);
+   remove(BENCH_PATH);
+
+   return 0;
+}
@@ -49,7 +49,6 @@ int main(int argc, char ** argv)
       {
          rmsgpack_dom_value_print(&item);
          printf("\n");
-         rmsgpack_dom_value_free(&item);
       }
    }
    else if (!strcmp(command, "find"))
@@ -80,7 +79,6 @@ int main(int argc, char ** argv)
       {
          rmsgpack_dom_value_print(&item);
          printf("\n");
-         rmsgpack_dom_value_free(&item);
       }
    }
    else if (!strcmp(command, "create-index"))
@@ -398,18 +398,43 @@ static int read_int(FILE *fp, int64_t *out, size_t size)
    return 0;
 }
 
-static int read_buff(FILE *fp, size_t size, char **pbuff, uint64_t *len)
+static char *alloc_buff(size_t size,
+      struct rmsgpack_read_callbacks *callbacks, void *data)
+{
+   char *buff = NULL;
+
+   if (callbacks->alloc)
+      buff = (char*)callbacks->alloc(size + 1, data);
+   else
+      buff = (char*)malloc(size + 1);
+
+   if (buff)
+      buff[size] = '\0';
+   return buff;
+}
+
+static void free_buff(char *buff, struct rmsgpack_read_callbacks *callbacks)
+{
+   if (!callbacks->alloc)
+      free(buff);
+}
+
+static int read_buff(FILE *fp, size_t size, char **pbuff, uint64_t *len,
+      struct rmsgpack_read_callbacks *callbacks, void *data)
 {
    uint64_t tmp_len = 0;
 
    if (read_uint(fp, &tmp_len, size) == -1)
       return -errno;
 
-   *pbuff = (char *)calloc((size_t)tmp_len + 1, sizeof(char));
+   *pbuff = alloc_buff((size_t)tmp_len, callbacks, data);
+
+   if (!*pbuff)
+      return -ENOMEM;
 
    if (fpread(fp, *pbuff, (size_t)tmp_len) == -1)
    {
-      free(*pbuff);
+      free_buff(*pbuff, callbacks);
       return -errno;
    }
 
@@ -489,18 +514,17 @@ int rmsgpack_read(FILE *fp,
    else if (type < MPF_NIL)
    {
       tmp_len = type - MPF_FIXSTR;
-      buff = (char *)calloc((size_t)tmp_len + 1, sizeof(char));
+      buff = alloc_buff((size_t)tmp_len, callbacks, data);
       if (!buff)
          return -ENOMEM;
       if (fpread(fp, buff, (size_t)tmp_len) == -1)
       {
-         free(buff);
+         free_buff(buff, callbacks);
          return -errno;
       }
-      buff[tmp_len] = '\0';
       if (!callbacks->read_string)
       {
-         free(buff);
+         free_buff(buff, callbacks);
          return 0;
       }
       return callbacks->read_string(buff, (size_t)tmp_len, data);
@@ -530,11 +554,12 @@ int rmsgpack_read(FILE *fp,
       case 0xc5:
       case 0xc6:
          if ((rv = read_buff(fp, 1<<(type - 0xc4),
-                     &buff, &tmp_len)) < 0)
+                     &buff, &tmp_len, callbacks, data)) < 0)
             return rv;
 
          if (callbacks->read_bin)
             return callbacks->read_bin(buff, (size_t)tmp_len, data);
+         free_buff(buff, callbacks);
          break;
       case 0xcc:
       case 0xcd:
@@ -563,11 +588,13 @@ int rmsgpack_read(FILE *fp,
       case 0xd9:
       case 0xda:
       case 0xdb:
-         if ((rv = read_buff(fp, 1<<(type - 0xd9), &buff, &tmp_len)) < 0)
+         if ((rv = read_buff(fp, 1<<(type - 0xd9),
+                     &buff, &tmp_len, callbacks, data)) < 0)
             return rv;
 
          if (callbacks->read_string)
             return callbacks->read_string(buff, (size_t)tmp_len, data);
+         free_buff(buff, callbacks);
          break;
       case 0xdc:
       case 0xdd:
@@ -36,6 +36,12 @@ struct rmsgpack_read_callbacks {
 	        uint32_t,
 	        void *
 	);
+	/* Allocates string and binary buffers passed to read_string
+	 * and read_bin. Buffers are heap allocated if NULL. */
+	void *(* alloc)(
+	        size_t,
+	        void *
+	);
 };
 
 
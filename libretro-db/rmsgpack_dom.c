@@ -11,12 +11,124 @@
 
 #define MAX_DEPTH 128
 
+#define ARENA_BLOCK_SIZE 4096
+#define ARENA_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+struct rmsgpack_dom_arena_block
+{
+   struct rmsgpack_dom_arena_block *next;
+   size_t size;
+   size_t used;
+};
+
+struct rmsgpack_dom_arena
+{
+   /* Block allocations are served from, followed by all
+    * previously filled blocks. */
+   struct rmsgpack_dom_arena_block *head;
+   size_t block_size;
+};
+
 struct dom_reader_state
 {
    int i;
+   struct rmsgpack_dom_arena *arena;
    struct rmsgpack_dom_value *stack[MAX_DEPTH];
 };
 
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(struct rmsgpack_dom_arena_block))
+#define ARENA_BLOCK_DATA(block) ((char*)(block) + ARENA_HEADER_SIZE)
+
+struct rmsgpack_dom_arena *rmsgpack_dom_arena_new(size_t block_size)
+{
+   struct rmsgpack_dom_arena *arena = (struct rmsgpack_dom_arena*)
+      calloc(1, sizeof(*arena));
+
+   if (!arena)
+      return NULL;
+
+   arena->block_size = block_size ? ARENA_ALIGN(block_size) : ARENA_BLOCK_SIZE;
+   return arena;
+}
+
+static void rmsgpack_dom_arena_free_blocks(struct rmsgpack_dom_arena *arena)
+{
+   struct rmsgpack_dom_arena_block *block = arena->head;
+
+   while (block)
+   {
+      struct rmsgpack_dom_arena_block *next = block->next;
+      free(block);
+      block = next;
+   }
+
+   arena->head = NULL;
+}
+
+void rmsgpack_dom_arena_free(struct rmsgpack_dom_arena *arena)
+{
+   if (!arena)
+      return;
+
+   rmsgpack_dom_arena_free_blocks(arena);
+   free(arena);
+}
+
+void rmsgpack_dom_arena_reset(struct rmsgpack_dom_arena *arena)
+{
+   size_t total = 0;
+   struct rmsgpack_dom_arena_block *block;
+
+   if (!arena || !arena->head)
+      return;
+
+   if (!arena->head->next)
+   {
+      arena->head->used = 0;
+      return;
+   }
+
+   /* Everything did not fit into one block, grow the block size
+    * so that the next round of allocations does. */
+   for (block = arena->head; block; block = block->next)
+      total += block->size;
+
+   rmsgpack_dom_arena_free_blocks(arena);
+
+   if (total > arena->block_size)
+      arena->block_size = total;
+}
+
+void *rmsgpack_dom_arena_alloc(struct rmsgpack_dom_arena *arena, size_t size)
+{
+   void *ptr;
+   struct rmsgpack_dom_arena_block *block = arena->head;
+
+   size = ARENA_ALIGN(size);
+
+   if (!block || block->size - block->used < size)
+   {
+      size_t block_size = (size > arena->block_size) ?
+         size : arena->block_size;
+
+      block = (struct rmsgpack_dom_arena_block*)malloc(
+            ARENA_HEADER_SIZE + block_size);
+
+      if (!block)
+         return NULL;
+
+      block->size = block_size;
+      block->used = 0;
+      block->next = arena->head;
+      arena->head = block;
+   }
+
+   ptr          = ARENA_BLOCK_DATA(block) + block->used;
+   block->used += size;
+
+   return ptr;
+}
+
 static struct rmsgpack_dom_value *dom_reader_state_pop(
       struct dom_reader_state *s)
 {
@@ -73,6 +185,20 @@ static void puts_u64(uint64_t decimal)
    fputs(&digits[i], stdout);
 }
 
+static void *dom_reader_state_alloc(struct dom_reader_state *s,
+      size_t size)
+{
+   void *ptr;
+
+   if (!s->arena)
+      return calloc(1, size);
+
+   ptr = rmsgpack_dom_arena_alloc(s->arena, size);
+   if (ptr)
+      memset(ptr, 0, size);
+   return ptr;
+}
+
 static int dom_reader_state_push(struct dom_reader_state *s,
       struct rmsgpack_dom_value *v)
 {
@@ -160,8 +286,8 @@ static int dom_read_map_start(uint32_t len, void *data)
    v->val.map.len = len;
    v->val.map.items = NULL;
 
-   items = (struct rmsgpack_dom_pair *)calloc(len,
-         sizeof(struct rmsgpack_dom_pair));
+   items = (struct rmsgpack_dom_pair *)dom_reader_state_alloc(dom_state,
+         len * sizeof(struct rmsgpack_dom_pair));
 
    if (!items)
       return -ENOMEM;
@@ -190,7 +316,8 @@ static int dom_read_array_start(uint32_t len, void *data)
    v->val.array.len   = len;
    v->val.array.items = NULL;
 
-   items          = (struct rmsgpack_dom_value *)calloc(len, sizeof(struct rmsgpack_dom_pair));
+   items          = (struct rmsgpack_dom_value *)dom_reader_state_alloc(
+         dom_state, len * sizeof(struct rmsgpack_dom_value));
 
    if (!items)
       return -ENOMEM;
@@ -214,7 +341,26 @@ static struct rmsgpack_read_callbacks dom_reader_callbacks = {
    dom_read_string,
    dom_read_bin,
    dom_read_map_start,
-   dom_read_array_start
+   dom_read_array_start,
+   NULL
+};
+
+static void *dom_read_alloc(size_t size, void *data)
+{
+   struct dom_reader_state *dom_state = (struct dom_reader_state *)data;
+   return rmsgpack_dom_arena_alloc(dom_state->arena, size);
+}
+
+static struct rmsgpack_read_callbacks dom_arena_reader_callbacks = {
+   dom_read_nil,
+   dom_read_bool,
+   dom_read_int,
+   dom_read_uint,
+   dom_read_string,
+   dom_read_bin,
+   dom_read_map_start,
+   dom_read_array_start,
+   dom_read_alloc
 };
 
 void rmsgpack_dom_value_free(struct rmsgpack_dom_value *v)
@@ -449,6 +595,17 @@ int rmsgpack_dom_read(FILE *fp, struct rmsgpack_dom_value *out)
    return rv;
 }
 
+int rmsgpack_dom_read_arena(FILE *fp, struct rmsgpack_dom_value *out,
+      struct rmsgpack_dom_arena *arena)
+{
+   struct dom_reader_state s = {0};
+
+   s.arena    = arena;
+   s.stack[0] = out;
+
+   return rmsgpack_read(fp, &dom_arena_reader_callbacks, &s);
+}
+
 int rmsgpack_dom_read_into(FILE *fp, ...)
 {
    va_list ap;
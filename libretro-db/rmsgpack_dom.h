@@ -73,6 +73,23 @@ int rmsgpack_dom_read(
         FILE *fp,
         struct rmsgpack_dom_value * out
 );
+/* Bump allocator owning all strings, binaries, maps and arrays
+ * of values read with rmsgpack_dom_read_arena(). Values are
+ * released all at once by resetting or freeing the arena
+ * and must not be passed to rmsgpack_dom_value_free(). */
+struct rmsgpack_dom_arena;
+
+struct rmsgpack_dom_arena *rmsgpack_dom_arena_new(size_t block_size);
+void rmsgpack_dom_arena_free(struct rmsgpack_dom_arena *arena);
+void rmsgpack_dom_arena_reset(struct rmsgpack_dom_arena *arena);
+void *rmsgpack_dom_arena_alloc(struct rmsgpack_dom_arena *arena,
+        size_t size);
+
+int rmsgpack_dom_read_arena(
+        FILE *fp,
+        struct rmsgpack_dom_value * out,
+        struct rmsgpack_dom_arena * arena
+);
 int rmsgpack_dom_write(
         FILE *fp,
         const struct rmsgpack_dom_value * obj
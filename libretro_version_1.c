@@ -33,6 +33,7 @@
 #include "runloop_data.h"
 #include "retroarch.h"
 #include "performance.h"
+#include "performance/performance_trace.h"
 #include "input/keyboard_line.h"
 #include "input/input_remapping.h"
 #include "audio/audio_driver.h"
@@ -44,6 +45,10 @@
 #include "netplay.h"
 #endif
 
+#ifdef HAVE_SHM
+#include "shm_export.h"
+#endif
+
 /**
  * video_frame:
  * @data                 : pointer to data of the video frame.
@@ -69,6 +74,12 @@ static void video_frame(const void *data, unsigned width,
    if (!driver->video_active)
       return;
 
+   RARCH_TRACE_BEGIN("video_frame");
+
+#ifdef HAVE_SHM
+   shm_export_frame(data, width, height, pitch);
+#endif
+
    if (video_pixel_frame_scale(data, width, height, pitch))
    {
       video_pixel_scaler_t *scaler = scaler_get_ptr();
@@ -107,6 +118,10 @@ static void video_frame(const void *data, unsigned width,
 
    if (!video->frame(driver->video_data, data, width, height, pitch, driver->current_msg))
       driver->video_active = false;
+
+   input_driver_latency_frame();
+
+   RARCH_TRACE_END("video_frame");
 }
 
 /**
@@ -163,8 +178,6 @@ static int16_t input_state(unsigned port, unsigned device,
    settings_t *settings            = config_get_ptr();
    driver_t *driver                = driver_get_ptr();
    global_t *global                = global_get_ptr();
-   const input_driver_t *input     = driver ? 
-      (const input_driver_t*)driver->input : NULL;
    
    for (i = 0; i < MAX_USERS; i++)
       libretro_input_binds[i] = settings->input.binds[i];
@@ -186,7 +199,8 @@ static int16_t input_state(unsigned port, unsigned device,
    if (!driver->block_libretro_input || id == RETRO_DEVICE_ID_JOYPAD_START)
    {
       if (((id < RARCH_FIRST_META_KEY) || (device == RETRO_DEVICE_KEYBOARD)))
-         res = input->input_state(driver->input_data, libretro_input_binds, port, device, idx, id);
+         res = input_driver_snapshot_state(libretro_input_binds,
+               port, device, idx, id);
 
 #ifdef HAVE_OVERLAY
       input_state_overlay(&res, port, device, idx, id);
@@ -217,10 +231,10 @@ static void input_poll(void)
 {
    driver_t *driver               = driver_get_ptr();
    settings_t *settings           = config_get_ptr();
-   const input_driver_t *input     = driver ? 
-      (const input_driver_t*)driver->input : NULL;
 
-   input->poll(driver->input_data);
+   RARCH_TRACE_BEGIN("input_poll");
+
+   input_driver_poll();
 
    (void)driver;
 
@@ -232,6 +246,8 @@ static void input_poll(void)
    if (driver->command)
       rarch_cmd_poll(driver->command);
 #endif
+
+   RARCH_TRACE_END("input_poll");
 }
 
 /**
@@ -37,6 +37,7 @@
 #include "../config.features.h"
 #include "../git_version.h"
 #include "../performance.h"
+#include "../tasks/tasks.h"
 
 #ifdef ANDROID
 #include "../frontend/drivers/platform_android.h"
@@ -146,7 +147,7 @@ static int menu_displaylist_parse_core_info(menu_displaylist_info_t *info)
    global_t *global          = global_get_ptr();
    core_info_t *core_info    = global ? (core_info_t*)global->core_info_current : NULL;
 
-   if (!core_info || !core_info->data)
+   if (!core_info || !core_info->has_info)
    {
       menu_list_push(info->list,
             menu_hash_to_str(MENU_LABEL_VALUE_NO_CORE_INFORMATION_AVAILABLE),
@@ -1005,6 +1006,16 @@ static int create_string_list_rdb_entry_int(const char *desc, const char *label,
 }
 #endif
 
+#ifdef HAVE_LIBRETRODB
+static int menu_displaylist_playlist_idx_cmp(const void *a_, const void *b_)
+{
+   size_t a = *(const size_t*)a_;
+   size_t b = *(const size_t*)b_;
+
+   return (a > b) - (a < b);
+}
+#endif
+
 static int menu_displaylist_parse_database_entry(menu_displaylist_info_t *info)
 {
 #ifdef HAVE_LIBRETRODB
@@ -1053,51 +1064,42 @@ static int menu_displaylist_parse_database_entry(menu_displaylist_info_t *info)
 
       if (playlist)
       {
-         for (j = 0; j < playlist->size; j++)
-         {
-            uint32_t core_name_hash, core_path_hash;
-            char elem0[PATH_MAX_LENGTH]      = {0};
-            char elem1[PATH_MAX_LENGTH]      = {0};
-            bool match_found                 = false;
-            struct string_list *tmp_str_list = string_split(
-                  playlist->entries[j].crc32, "|");
-            uint32_t hash_value              = 0;
-
-            if (!tmp_str_list)
-               continue;
+         size_t matches[64];
+         size_t num_matches = 0;
+         char key[PATH_MAX_LENGTH] = {0};
 
-            if (tmp_str_list->size > 0)
-               strlcpy(elem0, tmp_str_list->elems[0].data, sizeof(elem0));
-            if (tmp_str_list->size > 1)
-               strlcpy(elem1, tmp_str_list->elems[1].data, sizeof(elem1));
+         /* Playlist entries store their hash as "<hash>|<type>". */
+         snprintf(key, sizeof(key), "%s|crc", crc_str);
+         num_matches += content_playlist_find_by_crc32(playlist, key, NULL,
+               matches + num_matches, ARRAY_SIZE(matches) - num_matches);
 
-            hash_value = menu_hash_calculate(elem1);
+         if (db_info_entry->sha1)
+         {
+            snprintf(key, sizeof(key), "%s|sha1", db_info_entry->sha1);
+            num_matches += content_playlist_find_by_crc32(playlist, key, NULL,
+                  matches + num_matches, ARRAY_SIZE(matches) - num_matches);
+         }
 
-            switch (hash_value)
-            {
-               case MENU_VALUE_CRC:
-                  if (!strcmp(crc_str, elem0))
-                     match_found = true;
-                  break;
-               case MENU_VALUE_SHA1:
-                  if (!strcmp(db_info_entry->sha1, elem0))
-                     match_found = true;
-                  break;
-               case MENU_VALUE_MD5:
-                  if (!strcmp(db_info_entry->md5, elem0))
-                     match_found = true;
-                  break;
-            }
+         if (db_info_entry->md5)
+         {
+            snprintf(key, sizeof(key), "%s|md5", db_info_entry->md5);
+            num_matches += content_playlist_find_by_crc32(playlist, key, NULL,
+                  matches + num_matches, ARRAY_SIZE(matches) - num_matches);
+         }
 
-            string_list_free(tmp_str_list);
+         qsort(matches, num_matches, sizeof(*matches),
+               menu_displaylist_playlist_idx_cmp);
 
-            if (!match_found)
-               continue;
+         for (j = 0; j < num_matches; j++)
+         {
+            uint32_t core_name_hash, core_path_hash;
+            const content_playlist_entry_t *entry =
+               &playlist->entries[matches[j]];
 
-            rdb_entry_start_game_selection_ptr = j;
+            rdb_entry_start_game_selection_ptr = matches[j];
 
-            core_name_hash = menu_hash_calculate(playlist->entries[j].core_name);
-            core_path_hash = menu_hash_calculate(playlist->entries[j].core_path);
+            core_name_hash = menu_hash_calculate(entry->core_name);
+            core_path_hash = menu_hash_calculate(entry->core_path);
 
             if (
                   (core_name_hash != MENU_VALUE_DETECT) &&
@@ -1918,6 +1920,7 @@ static int menu_displaylist_parse_options_remappings(menu_displaylist_info_t *in
 static int menu_displaylist_parse_generic(menu_displaylist_info_t *info, bool *need_sort)
 {
    bool path_is_compressed, push_dir, filter_ext;
+   bool complete                = true;
    size_t i, list_size;
    struct string_list *str_list = NULL;
    int                   device = 0;
@@ -1959,9 +1962,9 @@ static int menu_displaylist_parse_generic(menu_displaylist_info_t *info, bool *n
    if (path_is_compressed)
       str_list = compressed_file_list_new(info->path, info->exts);
    else
-      str_list = dir_list_new(info->path,
+      str_list = rarch_main_data_dir_list_get(info->path,
             filter_ext ? info->exts : NULL,
-            true);
+            true, &complete);
 
    if (hash_label == MENU_LABEL_SCAN_DIRECTORY)
       menu_list_push(info->list,
@@ -1991,7 +1994,9 @@ static int menu_displaylist_parse_generic(menu_displaylist_info_t *info, bool *n
 
    if (list_size <= 0)
    {
-      if (!(info->flags & SL_FLAG_ALLOW_EMPTY_LIST))
+      /* Large directories are read in the background,
+       * the list is refreshed as entries come in. */
+      if (complete && !(info->flags & SL_FLAG_ALLOW_EMPTY_LIST))
       {
          menu_list_push(info->list,
                menu_hash_to_str(MENU_LABEL_VALUE_NO_ITEMS),
@@ -23,6 +23,7 @@
 #include "menu_setting.h"
 #include "menu_input.h"
 #include "../runloop_data.h"
+#include "../input/input_driver.h"
 
 /* This file provides an abstraction of the currently displayed
  * menu.
@@ -205,18 +206,21 @@ void menu_entry_bind_key_set(uint32_t i, int32_t value)
 {
    rarch_setting_t *setting = menu_entry_get_setting(i);
    BINDFOR(*setting).key = (enum retro_key)value;
+   input_driver_binds_changed();
 }
 
 void menu_entry_bind_joykey_set(uint32_t i, int32_t value)
 {
    rarch_setting_t *setting = menu_entry_get_setting(i);
    BINDFOR(*setting).joykey = value;
+   input_driver_binds_changed();
 }
 
 void menu_entry_bind_joyaxis_set(uint32_t i, int32_t value)
 {
    rarch_setting_t *setting = menu_entry_get_setting(i);
    BINDFOR(*setting).joyaxis = value;
+   input_driver_binds_changed();
 }
 
 void menu_entry_pathdir_selected(uint32_t i)
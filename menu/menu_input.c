@@ -383,6 +383,7 @@ static bool menu_input_custom_bind_keyboard_cb(void *data, unsigned code)
       return false;
 
    menu_input->binds.target->key = (enum retro_key)code;
+   input_driver_binds_changed();
    menu_input->binds.begin++;
    menu_input->binds.target++;
    menu_input->binds.timeout_end = rarch_get_time_usec() +
@@ -502,6 +503,7 @@ static int menu_input_bind_iterate_keyboard(int64_t current, int timeout)
    {
       /* Could be unsafe, but whatever. */
       menu_input->binds.target->key = RETROK_UNKNOWN;
+      input_driver_binds_changed();
 
       menu_input->binds.begin++;
       menu_input->binds.target++;
@@ -574,6 +576,7 @@ int menu_input_bind_iterate(void)
       driver->flushing_input = true;
 
       binds.begin++;
+      input_driver_binds_changed();
 
       if (binds.begin > binds.last)
          return 1;
@@ -745,6 +745,7 @@ static int setting_bind_action_start(void *data)
    {
       keybind->joykey = NO_BTN;
       keybind->joyaxis = AXIS_NONE;
+      input_driver_binds_changed();
       return 0;
    }
 
@@ -755,6 +756,7 @@ static int setting_bind_action_start(void *data)
       return -1;
 
    keybind->key = def_binds[setting->bind_type - MENU_SETTINGS_BIND_BEGIN].key;
+   input_driver_binds_changed();
 
    return 0;
 }
@@ -1187,6 +1189,8 @@ static int setting_action_ok_bind_defaults(void *data, bool wraparound)
       }
    }
 
+   input_driver_binds_changed();
+
    return 0;
 }
 
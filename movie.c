@@ -22,15 +22,87 @@
 #include "general.h"
 #include "dynamic.h"
 
+/* Size of the buffer encoded data is written through and read ahead into. */
+#define BSV_BUFFER_SIZE         (64 * 1024)
+
+/* Recorded frames are written out at least this often. */
+#define BSV_FLUSH_INTERVAL      600
+
+/* A state snapshot is embedded in recordings every this many frames. */
+#define BSV_SNAPSHOT_INTERVAL   3600
+
+/* Frame positions kept for rewinding. Grows up to this size. */
+#define BSV_FRAME_POS_MIN       (1 << 10)
+#define BSV_FRAME_POS_MAX       (1 << 16)
+
+/* Offset of the index record (64-bit) followed by BSV_INDEX_MAGIC. */
+#define BSV_FOOTER_SIZE         12
+
+/* Position of the input stream when a frame started. */
+struct bsv_frame_pos
+{
+   uint64_t frame;
+
+   /* Offset of the next record or input. */
+   uint64_t offset;
+
+   /* FRAME record holding the last inputs, 0 if there is none. */
+   uint64_t input_offset;
+
+   /* Repeats of the last inputs which are pending (recording)
+    * or left to play (playback). */
+   uint32_t run;
+
+   /* Next input of the last inputs (playback). */
+   uint32_t input_ptr;
+};
+
+struct bsv_snapshot
+{
+   uint64_t frame;
+   uint64_t offset;
+};
+
 struct bsv_movie
 {
    FILE *file;
-
-   /* A ring buffer keeping track of positions
-    * in the file for each frame. */
-   size_t *frame_pos;
+   unsigned version;
+
+   /* Recording: encoded data not written yet, which goes to buf_offset.
+    * Playback: data read ahead from buf_offset, buf_ptr is
+    * the read position. */
+   uint8_t *buf;
+   size_t buf_size;
+   size_t buf_ptr;
+   uint64_t buf_offset;
+   uint64_t file_end;
+
+   /* Inputs of the last FRAME record, in file byte order. */
+   int16_t *input;
+   size_t input_size;
+   size_t input_cap;
+   size_t input_ptr;
+   uint64_t input_offset;
+   uint32_t run;
+
+   /* Inputs of the frame being recorded. */
+   int16_t *frame_input;
+   size_t frame_input_size;
+   size_t frame_input_cap;
+
+   /* A ring buffer keeping track of stream positions
+    * for each frame. */
+   struct bsv_frame_pos *frame_pos;
    size_t frame_mask;
    size_t frame_ptr;
+   uint64_t frame_count;
+   uint64_t first_frame;
+
+   /* Embedded state snapshots, sorted by frame. */
+   struct bsv_snapshot *snapshots;
+   size_t num_snapshots;
+   size_t snapshots_cap;
+   bool has_index;
 
    size_t min_file_pos;
 
@@ -42,9 +114,306 @@ struct bsv_movie
    bool did_rewind;
 };
 
+static uint64_t bsv_movie_tell(bsv_movie_t *handle)
+{
+   return handle->buf_offset +
+      (handle->playback ? handle->buf_ptr : handle->buf_size);
+}
+
+/* Moves the stream position, keeping data already read ahead
+ * if possible. Everything buffered has to be flushed when recording. */
+static void bsv_movie_seek_stream(bsv_movie_t *handle, uint64_t offset)
+{
+   if (handle->playback && offset >= handle->buf_offset
+         && offset <= handle->buf_offset + handle->buf_size)
+   {
+      handle->buf_ptr = offset - handle->buf_offset;
+      return;
+   }
+
+   fseek(handle->file, (long)offset, SEEK_SET);
+   handle->buf_offset = offset;
+   handle->buf_size   = 0;
+   handle->buf_ptr    = 0;
+}
+
+static bool bsv_movie_read(bsv_movie_t *handle, void *data, size_t size)
+{
+   uint8_t *out = (uint8_t*)data;
+
+   while (size)
+   {
+      size_t avail = handle->buf_size - handle->buf_ptr;
+
+      if (!avail)
+      {
+         handle->buf_offset += handle->buf_size;
+         handle->buf_ptr     = 0;
+         handle->buf_size    = fread(handle->buf, 1,
+               BSV_BUFFER_SIZE, handle->file);
+
+         if (!handle->buf_size)
+            return false;
+         continue;
+      }
+
+      if (avail > size)
+         avail = size;
+
+      if (out)
+      {
+         memcpy(out, handle->buf + handle->buf_ptr, avail);
+         out += avail;
+      }
+
+      handle->buf_ptr += avail;
+      size            -= avail;
+   }
+
+   return true;
+}
+
+static bool bsv_movie_read_varint(bsv_movie_t *handle, uint64_t *val)
+{
+   unsigned shift = 0;
+
+   *val = 0;
+
+   for (;;)
+   {
+      uint8_t byte;
+
+      if (shift > 63 || !bsv_movie_read(handle, &byte, 1))
+         return false;
+
+      *val |= (uint64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+         return true;
+      shift += 7;
+   }
+}
+
+static void bsv_movie_flush(bsv_movie_t *handle)
+{
+   if (handle->buf_size)
+      fwrite(handle->buf, 1, handle->buf_size, handle->file);
+
+   handle->buf_offset += handle->buf_size;
+   handle->buf_size    = 0;
+
+   if (handle->buf_offset > handle->file_end)
+      handle->file_end = handle->buf_offset;
+}
+
+static void bsv_movie_write(bsv_movie_t *handle,
+      const void *data, size_t size)
+{
+   if (handle->buf_size + size > BSV_BUFFER_SIZE)
+   {
+      bsv_movie_flush(handle);
+
+      if (size > BSV_BUFFER_SIZE)
+      {
+         fwrite(data, 1, size, handle->file);
+         handle->buf_offset += size;
+         if (handle->buf_offset > handle->file_end)
+            handle->file_end = handle->buf_offset;
+         return;
+      }
+   }
+
+   memcpy(handle->buf + handle->buf_size, data, size);
+   handle->buf_size += size;
+}
+
+static void bsv_movie_write_varint(bsv_movie_t *handle, uint64_t val)
+{
+   uint8_t bytes[10];
+   size_t size = 0;
+
+   do
+   {
+      bytes[size] = val & 0x7f;
+      val       >>= 7;
+      if (val)
+         bytes[size] |= 0x80;
+      size++;
+   } while (val);
+
+   bsv_movie_write(handle, bytes, size);
+}
+
+static void bsv_movie_write_tag(bsv_movie_t *handle,
+      enum bsv_record_type type, uint64_t arg)
+{
+   bsv_movie_write_varint(handle, (arg << 2) | type);
+}
+
+static bool bsv_movie_reserve(int16_t **input, size_t *cap, size_t size)
+{
+   int16_t *tmp;
+   size_t new_cap = *cap ? *cap : 32;
+
+   if (size <= *cap)
+      return true;
+
+   while (new_cap < size)
+      new_cap *= 2;
+
+   if (!(tmp = (int16_t*)realloc(*input, new_cap * sizeof(int16_t))))
+      return false;
+
+   *input = tmp;
+   *cap   = new_cap;
+   return true;
+}
+
+static bool bsv_movie_add_snapshot(bsv_movie_t *handle,
+      uint64_t frame, uint64_t offset)
+{
+   if (handle->num_snapshots == handle->snapshots_cap)
+   {
+      size_t new_cap = handle->snapshots_cap ? handle->snapshots_cap * 2 : 16;
+      struct bsv_snapshot *tmp = (struct bsv_snapshot*)realloc(
+            handle->snapshots, new_cap * sizeof(*tmp));
+
+      if (!tmp)
+         return false;
+
+      handle->snapshots     = tmp;
+      handle->snapshots_cap = new_cap;
+   }
+
+   handle->snapshots[handle->num_snapshots].frame  = frame;
+   handle->snapshots[handle->num_snapshots].offset = offset;
+   handle->num_snapshots++;
+   return true;
+}
+
+/**
+ * bsv_movie_read_record:
+ * @handle               : movie handle.
+ *
+ * Reads the next record of a BSV2 stream. FRAME records
+ * replace the last inputs, REPEAT records set how often
+ * they are played again, STATE records are skipped.
+ *
+ * Returns: false at the end of the movie.
+ **/
+static bool bsv_movie_read_record(bsv_movie_t *handle)
+{
+   uint64_t tag;
+   uint64_t offset = bsv_movie_tell(handle);
+
+   if (!bsv_movie_read_varint(handle, &tag))
+      return false;
+
+   switch (tag & 3)
+   {
+      case BSV_RECORD_FRAME:
+         if ((tag >> 2) > BSV_BUFFER_SIZE
+               || !bsv_movie_reserve(&handle->input,
+                  &handle->input_cap, tag >> 2)
+               || !bsv_movie_read(handle, handle->input,
+                  (tag >> 2) * sizeof(int16_t)))
+            return false;
+
+         handle->input_size   = tag >> 2;
+         handle->input_ptr    = 0;
+         handle->input_offset = offset;
+         break;
+      case BSV_RECORD_REPEAT:
+         handle->run = (tag >> 2) > UINT32_MAX ?
+            UINT32_MAX : (uint32_t)(tag >> 2);
+         break;
+      case BSV_RECORD_STATE:
+         return bsv_movie_read(handle, NULL, handle->state_size);
+      default:
+         return false;
+   }
+
+   return true;
+}
+
+/* Loads the index of snapshots from the footer of a BSV2 file. */
+static bool bsv_movie_read_index(bsv_movie_t *handle)
+{
+   size_t i;
+   uint8_t footer[BSV_FOOTER_SIZE];
+   uint64_t tag, index_offset = 0;
+
+   if (fseek(handle->file, -BSV_FOOTER_SIZE, SEEK_END) != 0
+         || fread(footer, 1, sizeof(footer), handle->file) != sizeof(footer))
+      return false;
+
+   for (i = 8; i > 0; i--)
+      index_offset = (index_offset << 8) | footer[i - 1];
+
+   if ((footer[8] | (footer[9] << 8) | (footer[10] << 16)
+            | ((uint32_t)footer[11] << 24)) != BSV_INDEX_MAGIC
+         || index_offset < handle->min_file_pos)
+      return false;
+
+   bsv_movie_seek_stream(handle, index_offset);
+
+   if (!bsv_movie_read_varint(handle, &tag)
+         || (tag & 3) != BSV_RECORD_INDEX)
+      return false;
+
+   for (i = 0; i < (tag >> 2); i++)
+   {
+      uint64_t frame, offset;
+
+      if (!bsv_movie_read_varint(handle, &frame)
+            || !bsv_movie_read_varint(handle, &offset)
+            || !bsv_movie_add_snapshot(handle, frame, offset))
+      {
+         handle->num_snapshots = 0;
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/* Finds the snapshots of a BSV2 file without an index,
+ * e.g. if recording was interrupted. */
+static void bsv_movie_build_index(bsv_movie_t *handle)
+{
+   uint64_t tag;
+
+   handle->num_snapshots = 0;
+   bsv_movie_seek_stream(handle, handle->min_file_pos);
+
+   for (;;)
+   {
+      uint64_t offset = bsv_movie_tell(handle);
+
+      if (!bsv_movie_read_varint(handle, &tag))
+         break;
+
+      if ((tag & 3) == BSV_RECORD_FRAME)
+      {
+         if (!bsv_movie_read(handle, NULL, (tag >> 2) * sizeof(int16_t)))
+            break;
+      }
+      else if ((tag & 3) == BSV_RECORD_STATE)
+      {
+         if (!bsv_movie_add_snapshot(handle, tag >> 2, offset)
+               || !bsv_movie_read(handle, NULL, handle->state_size))
+            break;
+      }
+      else if ((tag & 3) == BSV_RECORD_INDEX)
+         break;
+   }
+
+   handle->has_index = true;
+}
+
 static bool init_playback(bsv_movie_t *handle, const char *path)
 {
    uint32_t state_size;
+   uint32_t magic;
    uint32_t header[4] = {0};
    global_t *global   = global_get_ptr();
 
@@ -65,10 +434,17 @@ static bool init_playback(bsv_movie_t *handle, const char *path)
 
    /* Compatibility with old implementation that
     * used incorrect documentation. */
-   if (swap_if_little32(header[MAGIC_INDEX]) != BSV_MAGIC
-         && swap_if_big32(header[MAGIC_INDEX]) != BSV_MAGIC)
+   magic = swap_if_little32(header[MAGIC_INDEX]);
+   if (magic != BSV_MAGIC && magic != BSV2_MAGIC)
+      magic = swap_if_big32(header[MAGIC_INDEX]);
+
+   if (magic == BSV2_MAGIC)
+      handle->version = 2;
+   else if (magic == BSV_MAGIC)
+      handle->version = 1;
+   else
    {
-      RARCH_ERR("Movie file is not a valid BSV1 file.\n");
+      RARCH_ERR("Movie file is not a valid BSV1 or BSV2 file.\n");
       return false;
    }
 
@@ -98,6 +474,11 @@ static bool init_playback(bsv_movie_t *handle, const char *path)
 
    handle->min_file_pos = sizeof(header) + state_size;
 
+   if (handle->version >= 2)
+      handle->has_index = bsv_movie_read_index(handle);
+
+   bsv_movie_seek_stream(handle, handle->min_file_pos);
+
    return true;
 }
 
@@ -107,7 +488,9 @@ static bool init_record(bsv_movie_t *handle, const char *path)
    uint32_t header[4] = {0};
    global_t *global   = global_get_ptr();
 
-   handle->file       = fopen(path, "wb");
+   /* Opened for reading too, rewinding reads back
+    * inputs which are already written. */
+   handle->file       = fopen(path, "w+b");
    if (!handle->file)
    {
       RARCH_ERR("Couldn't open BSV \"%s\" for recording.\n", path);
@@ -115,8 +498,9 @@ static bool init_record(bsv_movie_t *handle, const char *path)
    }
 
    /* This value is supposed to show up as
-    * BSV1 in a HEX editor, big-endian. */
-   header[MAGIC_INDEX]      = swap_if_little32(BSV_MAGIC);
+    * BSV2 in a HEX editor, big-endian. */
+   handle->version          = 2;
+   header[MAGIC_INDEX]      = swap_if_little32(BSV2_MAGIC);
    header[CRC_INDEX]        = swap_if_big32(global->content_crc);
    state_size               = pretro_serialize_size();
    header[STATE_SIZE_INDEX] = swap_if_big32(state_size);
@@ -125,6 +509,8 @@ static bool init_record(bsv_movie_t *handle, const char *path)
 
    handle->min_file_pos     = sizeof(header) + state_size;
    handle->state_size       = state_size;
+   handle->buf_offset       = handle->min_file_pos;
+   handle->file_end         = handle->min_file_pos;
 
    if (state_size)
    {
@@ -139,13 +525,120 @@ static bool init_record(bsv_movie_t *handle, const char *path)
    return true;
 }
 
+/* Writes out the pending repeats of the last inputs. */
+static void bsv_movie_write_run(bsv_movie_t *handle)
+{
+   if (!handle->run)
+      return;
+
+   bsv_movie_write_tag(handle, BSV_RECORD_REPEAT, handle->run);
+   handle->run = 0;
+}
+
+/* Encodes the inputs of the frame which just ended. Frames with the
+ * same inputs as the one before are only counted. */
+static void bsv_movie_write_frame(bsv_movie_t *handle)
+{
+   int16_t *tmp;
+   size_t tmp_cap;
+
+   if (handle->input_offset
+         && handle->input_size == handle->frame_input_size
+         && handle->run < UINT32_MAX
+         && !memcmp(handle->input, handle->frame_input,
+            handle->input_size * sizeof(int16_t)))
+   {
+      handle->run++;
+      handle->frame_input_size = 0;
+      return;
+   }
+
+   bsv_movie_write_run(handle);
+
+   handle->input_offset = bsv_movie_tell(handle);
+   bsv_movie_write_tag(handle, BSV_RECORD_FRAME, handle->frame_input_size);
+   bsv_movie_write(handle, handle->frame_input,
+         handle->frame_input_size * sizeof(int16_t));
+
+   /* The inputs of this frame become the last inputs. */
+   tmp                      = handle->input;
+   tmp_cap                  = handle->input_cap;
+   handle->input            = handle->frame_input;
+   handle->input_cap        = handle->frame_input_cap;
+   handle->input_size       = handle->frame_input_size;
+   handle->frame_input      = tmp;
+   handle->frame_input_cap  = tmp_cap;
+   handle->frame_input_size = 0;
+}
+
+static void bsv_movie_write_snapshot(bsv_movie_t *handle)
+{
+   if (!pretro_serialize(handle->state, handle->state_size))
+      return;
+
+   bsv_movie_write_run(handle);
+
+   if (!bsv_movie_add_snapshot(handle, handle->frame_count,
+            bsv_movie_tell(handle)))
+      return;
+
+   bsv_movie_write_tag(handle, BSV_RECORD_STATE, handle->frame_count);
+   bsv_movie_write(handle, handle->state, handle->state_size);
+
+   /* Playback can start here, so the next
+    * frame must not be a repeat. */
+   handle->input_offset = 0;
+}
+
+/* Writes the last frames, the index of snapshots and the footer. */
+static void bsv_movie_finish_record(bsv_movie_t *handle)
+{
+   size_t i;
+   uint8_t footer[BSV_FOOTER_SIZE];
+   uint64_t index_offset;
+
+   if (handle->frame_input_size)
+      bsv_movie_write_frame(handle);
+   bsv_movie_write_run(handle);
+
+   index_offset = bsv_movie_tell(handle);
+   bsv_movie_write_tag(handle, BSV_RECORD_INDEX, handle->num_snapshots);
+
+   for (i = 0; i < handle->num_snapshots; i++)
+   {
+      bsv_movie_write_varint(handle, handle->snapshots[i].frame);
+      bsv_movie_write_varint(handle, handle->snapshots[i].offset);
+   }
+
+   bsv_movie_flush(handle);
+
+   for (i = 0; i < 8; i++)
+      footer[i] = (uint8_t)(index_offset >> (8 * i));
+   for (i = 0; i < 4; i++)
+      footer[8 + i] = (uint8_t)(BSV_INDEX_MAGIC >> (8 * i));
+
+   /* Anything past the index is left over from before
+    * a rewind. The footer has to be at the very end. */
+   fseek(handle->file, (long)handle->file_end, SEEK_SET);
+   fwrite(footer, 1, sizeof(footer), handle->file);
+}
+
 void bsv_movie_free(bsv_movie_t *handle)
 {
    if (!handle)
       return;
 
    if (handle->file)
+   {
+      if (!handle->playback && handle->buf)
+         bsv_movie_finish_record(handle);
       fclose(handle->file);
+   }
+
+   free(handle->buf);
+   free(handle->input);
+   free(handle->frame_input);
+   free(handle->snapshots);
    free(handle->state);
    free(handle->frame_pos);
    free(handle);
@@ -153,17 +646,37 @@ void bsv_movie_free(bsv_movie_t *handle)
 
 bool bsv_movie_get_input(bsv_movie_t *handle, int16_t *input)
 {
-   if (fread(input, sizeof(int16_t), 1, handle->file) != 1)
-      return false;
+   if (handle->version < 2)
+   {
+      if (!bsv_movie_read(handle, input, sizeof(int16_t)))
+         return false;
+
+      *input = swap_if_big16(*input);
+      return true;
+   }
 
-   *input = swap_if_big16(*input);
+   while (handle->input_ptr >= handle->input_size)
+   {
+      if (handle->run)
+      {
+         handle->run--;
+         handle->input_ptr = 0;
+      }
+      else if (!bsv_movie_read_record(handle))
+         return false;
+   }
+
+   *input = swap_if_big16(handle->input[handle->input_ptr++]);
    return true;
 }
 
 void bsv_movie_set_input(bsv_movie_t *handle, int16_t input)
 {
-   input = swap_if_big16(input);
-   fwrite(&input, sizeof(int16_t), 1, handle->file);
+   if (!bsv_movie_reserve(&handle->frame_input,
+            &handle->frame_input_cap, handle->frame_input_size + 1))
+      return;
+
+   handle->frame_input[handle->frame_input_size++] = swap_if_big16(input);
 }
 
 bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
@@ -172,6 +685,9 @@ bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
    if (!handle)
       return NULL;
 
+   if (!(handle->buf = (uint8_t*)malloc(BSV_BUFFER_SIZE)))
+      goto error;
+
    if (type == RARCH_MOVIE_PLAYBACK)
    {
       if (!init_playback(handle, path))
@@ -180,13 +696,13 @@ bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
    else if (!init_record(handle, path))
       goto error;
 
-   /* Just pick something really large 
-    * ~1 million frames rewind should do the trick. */
-   if (!(handle->frame_pos = (size_t*)calloc((1 << 20), sizeof(size_t))))
-      goto error; 
+   /* Grows as frames are played, up to BSV_FRAME_POS_MAX. */
+   if (!(handle->frame_pos = (struct bsv_frame_pos*)calloc(
+               BSV_FRAME_POS_MIN, sizeof(*handle->frame_pos))))
+      goto error;
 
-   handle->frame_pos[0]    = handle->min_file_pos;
-   handle->frame_mask      = (1 << 20) - 1;
+   handle->frame_pos[0].offset = handle->min_file_pos;
+   handle->frame_mask          = BSV_FRAME_POS_MIN - 1;
 
    return handle;
 
@@ -197,9 +713,21 @@ error:
 
 void bsv_movie_set_frame_start(bsv_movie_t *handle)
 {
+   struct bsv_frame_pos *pos;
+
    if (!handle)
       return;
-   handle->frame_pos[handle->frame_ptr] = ftell(handle->file);
+
+   pos               = &handle->frame_pos[handle->frame_ptr];
+   pos->frame        = handle->frame_count;
+   pos->offset       = bsv_movie_tell(handle);
+   pos->input_offset = handle->input_offset;
+   pos->run          = handle->run;
+   pos->input_ptr    = handle->input_ptr;
+
+   if (!handle->playback && handle->state_size && handle->frame_count
+         && !(handle->frame_count % BSV_SNAPSHOT_INTERVAL))
+      bsv_movie_write_snapshot(handle);
 }
 
 void bsv_movie_set_frame_end(bsv_movie_t *handle)
@@ -207,21 +735,81 @@ void bsv_movie_set_frame_end(bsv_movie_t *handle)
    if (!handle)
       return;
 
+   if (!handle->playback)
+   {
+      bsv_movie_write_frame(handle);
+
+      if (!((handle->frame_count + 1) % BSV_FLUSH_INTERVAL))
+         bsv_movie_flush(handle);
+   }
+
+   handle->frame_count++;
+
+   if (handle->frame_ptr == handle->frame_mask
+         && handle->frame_mask + 1 < BSV_FRAME_POS_MAX)
+   {
+      size_t size = (handle->frame_mask + 1) * 2;
+      struct bsv_frame_pos *tmp = (struct bsv_frame_pos*)realloc(
+            handle->frame_pos, size * sizeof(*tmp));
+
+      if (tmp)
+      {
+         handle->frame_pos  = tmp;
+         handle->frame_mask = size - 1;
+      }
+   }
+
    handle->frame_ptr    = (handle->frame_ptr + 1) & handle->frame_mask;
 
    handle->first_rewind = !handle->did_rewind;
    handle->did_rewind   = false;
 }
 
+/* Puts the stream back to where it was at the start of a frame. */
+static void bsv_movie_restore_pos(bsv_movie_t *handle,
+      const struct bsv_frame_pos *pos)
+{
+   handle->frame_count = pos->frame;
+
+   if (handle->version < 2)
+   {
+      bsv_movie_seek_stream(handle, pos->offset);
+      return;
+   }
+
+   /* Recording reads back the last inputs from the file. */
+   if (!handle->playback)
+      bsv_movie_flush(handle);
+
+   handle->input_size   = 0;
+   handle->input_offset = 0;
+
+   if (pos->input_offset)
+   {
+      bsv_movie_seek_stream(handle, pos->input_offset);
+      bsv_movie_read_record(handle);
+   }
+
+   bsv_movie_seek_stream(handle, pos->offset);
+   handle->input_offset     = pos->input_offset;
+   handle->run              = pos->run;
+   handle->input_ptr        = pos->input_ptr;
+   handle->frame_input_size = 0;
+
+   while (!handle->playback && handle->num_snapshots
+         && handle->snapshots[handle->num_snapshots - 1].offset >= pos->offset)
+      handle->num_snapshots--;
+}
+
 void bsv_movie_frame_rewind(bsv_movie_t *handle)
 {
    handle->did_rewind = true;
 
-   if ((handle->frame_ptr <= 1) && (handle->frame_pos[0] == handle->min_file_pos))
+   if ((handle->frame_ptr <= 1)
+         && (handle->frame_pos[0].frame == handle->first_frame))
    {
       /* If we're at the beginning... */
       handle->frame_ptr = 0;
-      fseek(handle->file, handle->min_file_pos, SEEK_SET);
    }
    else
    {
@@ -233,23 +821,97 @@ void bsv_movie_frame_rewind(bsv_movie_t *handle)
        * plus another. */
       handle->frame_ptr = (handle->frame_ptr -
             (handle->first_rewind ? 1 : 2)) & handle->frame_mask;
-      fseek(handle->file, handle->frame_pos[handle->frame_ptr], SEEK_SET);
    }
 
-   if (ftell(handle->file) <= (long)handle->min_file_pos)
+   bsv_movie_restore_pos(handle, &handle->frame_pos[handle->frame_ptr]);
+
+   if (bsv_movie_tell(handle) <= handle->min_file_pos && !handle->playback)
+   {
+      /* We rewound past the beginning. If recording,
+       * we simply reset the starting point. Nice and easy. */
+      fseek(handle->file, 4 * sizeof(uint32_t), SEEK_SET);
+      pretro_serialize(handle->state, handle->state_size);
+      fwrite(handle->state, 1, handle->state_size, handle->file);
+   }
+}
+
+bool bsv_movie_seek(bsv_movie_t *handle, uint64_t frame)
+{
+   size_t i;
+   bool video_active, audio_active;
+   uint64_t start   = 0;
+   uint64_t offset  = handle->min_file_pos;
+   uint8_t *state   = handle->state;
+   driver_t *driver = driver_get_ptr();
+   global_t *global = global_get_ptr();
+
+   if (!handle->playback || handle->version < 2)
+      return false;
+
+   if (!handle->has_index)
+      bsv_movie_build_index(handle);
+
+   for (i = 0; i < handle->num_snapshots; i++)
    {
-      /* We rewound past the beginning. */
+      if (handle->snapshots[i].frame > frame
+            || handle->snapshots[i].frame < start)
+         continue;
+
+      start  = handle->snapshots[i].frame;
+      offset = handle->snapshots[i].offset;
+   }
+
+   bsv_movie_seek_stream(handle, offset);
 
-      if (!handle->playback)
+   if (start)
+   {
+      uint64_t tag;
+
+      if (!(state = (uint8_t*)malloc(handle->state_size)))
+         return false;
+
+      if (!bsv_movie_read_varint(handle, &tag)
+            || (tag & 3) != BSV_RECORD_STATE
+            || !bsv_movie_read(handle, state, handle->state_size))
       {
-         /* If recording, we simply reset
-          * the starting point. Nice and easy. */
-         fseek(handle->file, 4 * sizeof(uint32_t), SEEK_SET);
-         pretro_serialize(handle->state, handle->state_size);
-         fwrite(handle->state, 1, handle->state_size, handle->file);
+         free(state);
+         return false;
       }
-      else
-         fseek(handle->file, handle->min_file_pos, SEEK_SET);
    }
-}
 
+   if (handle->state_size)
+      pretro_unserialize(state, handle->state_size);
+   if (state != handle->state)
+      free(state);
+
+   handle->input_size   = 0;
+   handle->input_ptr    = 0;
+   handle->input_offset = 0;
+   handle->run          = 0;
+   handle->frame_count  = start;
+   handle->first_frame  = start;
+   handle->frame_ptr    = 0;
+   handle->first_rewind = false;
+   handle->did_rewind   = false;
+   handle->frame_pos[0].frame  = start;
+   handle->frame_pos[0].offset = bsv_movie_tell(handle);
+   global->bsv.movie_end       = false;
+
+   /* Run the frames up to the target without output. */
+   video_active         = driver->video_active;
+   audio_active         = driver->audio_active;
+   driver->video_active = false;
+   driver->audio_active = false;
+
+   while (handle->frame_count < frame && !global->bsv.movie_end)
+   {
+      bsv_movie_set_frame_start(handle);
+      pretro_run();
+      bsv_movie_set_frame_end(handle);
+   }
+
+   driver->video_active = video_active;
+   driver->audio_active = audio_active;
+
+   return !global->bsv.movie_end;
+}
@@ -26,12 +26,38 @@ extern "C" {
 #include <boolean.h>
 
 #define BSV_MAGIC 0x42535631
+#define BSV2_MAGIC 0x42535632
+#define BSV_INDEX_MAGIC 0x42535649
 
 #define MAGIC_INDEX 0
 #define SERIALIZER_INDEX 1
 #define CRC_INDEX 2
 #define STATE_SIZE_INDEX 3
 
+/* BSV1 files are the header and initial state followed by
+ * one little-endian int16_t for every input state query.
+ *
+ * BSV2 files have the same header, followed by records. Every record
+ * starts with a LEB128 varint, the low two bits of which are the
+ * record type and the rest its argument:
+ *
+ * FRAME:  number of inputs, followed by the int16_t inputs of a frame.
+ * REPEAT: number of frames repeating the inputs of the last FRAME.
+ * STATE:  frame number, followed by a serialized state taken before
+ *         that frame. The next record is always a FRAME.
+ * INDEX:  number of STATE records, followed by the frame number and
+ *         file offset of each. Ends the movie.
+ *
+ * The last 12 bytes of a finished BSV2 file are the little-endian
+ * 64-bit offset of the INDEX record and BSV_INDEX_MAGIC. */
+enum bsv_record_type
+{
+   BSV_RECORD_FRAME = 0,
+   BSV_RECORD_REPEAT,
+   BSV_RECORD_STATE,
+   BSV_RECORD_INDEX
+};
+
 typedef struct bsv_movie bsv_movie_t;
 
 enum rarch_movie_type
@@ -55,6 +81,19 @@ void bsv_movie_set_frame_end(bsv_movie_t *handle);
 
 void bsv_movie_frame_rewind(bsv_movie_t *handle);
 
+/**
+ * bsv_movie_seek:
+ * @handle               : movie handle, opened for playback.
+ * @frame                : frame to continue playback from.
+ *
+ * Loads the closest state snapshot before @frame and runs
+ * the core without video and audio output up to it.
+ * Only supported by BSV2 movies.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+bool bsv_movie_seek(bsv_movie_t *handle, uint64_t frame);
+
 void bsv_movie_free(bsv_movie_t *handle);
 
 #ifdef __cplusplus
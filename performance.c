@@ -15,8 +15,10 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "libretro.h"
 #include "performance.h"
+#include "performance/performance_trace.h"
 #include "general.h"
 #include "compat/strl.h"
 
@@ -102,6 +104,189 @@ const struct retro_perf_counter *perf_counters_libretro[MAX_COUNTERS];
 unsigned perf_ptr_rarch;
 unsigned perf_ptr_libretro;
 
+/* Latency histogram of a counter. Values below 4 ticks get a bucket
+ * each, above that every power of two is split into 4 buckets, so
+ * percentiles are accurate to within 25%. Larger values than the
+ * last bucket covers are counted in it.
+ *
+ * The windowed view is made of PERF_WINDOW_SLICES slices, the oldest
+ * of which is cleared by rarch_perf_frame() whenever it starts over.
+ *
+ * Like the counters themselves, histograms are not synchronized,
+ * counters stopped on other threads may lose samples. */
+typedef struct perf_histogram
+{
+   const struct retro_perf_counter *counter;
+   retro_perf_tick_t calls;
+   retro_perf_tick_t max;
+   uint32_t buckets[PERF_HISTOGRAM_BUCKETS];
+   retro_perf_tick_t window_max[PERF_WINDOW_SLICES];
+   uint32_t window[PERF_WINDOW_SLICES][PERF_HISTOGRAM_BUCKETS];
+} perf_histogram_t;
+
+#define PERF_HISTOGRAM_MAP_SIZE (4 * MAX_COUNTERS)
+
+static perf_histogram_t *perf_histograms_rarch[MAX_COUNTERS];
+static perf_histogram_t *perf_histograms_libretro[MAX_COUNTERS];
+
+/* Open addressing table from counters to their histograms. */
+static perf_histogram_t *perf_histogram_map[PERF_HISTOGRAM_MAP_SIZE];
+
+static unsigned perf_window_slice;
+static unsigned perf_frame_count;
+
+static unsigned perf_histogram_hash(const struct retro_perf_counter *perf)
+{
+   return (unsigned)(((uintptr_t)perf >> 3) * 2654435761u)
+      & (PERF_HISTOGRAM_MAP_SIZE - 1);
+}
+
+static perf_histogram_t *perf_histogram_find(
+      const struct retro_perf_counter *perf)
+{
+   unsigned i = perf_histogram_hash(perf);
+
+   while (perf_histogram_map[i])
+   {
+      if (perf_histogram_map[i]->counter == perf)
+         return perf_histogram_map[i];
+      i = (i + 1) & (PERF_HISTOGRAM_MAP_SIZE - 1);
+   }
+
+   return NULL;
+}
+
+static void perf_histogram_map_insert(perf_histogram_t *hist)
+{
+   unsigned i = perf_histogram_hash(hist->counter);
+
+   while (perf_histogram_map[i])
+      i = (i + 1) & (PERF_HISTOGRAM_MAP_SIZE - 1);
+
+   perf_histogram_map[i] = hist;
+}
+
+static perf_histogram_t *perf_histogram_new(
+      const struct retro_perf_counter *perf)
+{
+   global_t *global      = global_get_ptr();
+   perf_histogram_t *hist = NULL;
+
+   if (!global->perfcnt_histogram_enable)
+      return NULL;
+
+   if (!(hist = (perf_histogram_t*)calloc(1, sizeof(*hist))))
+      return NULL;
+
+   hist->counter = perf;
+   perf_histogram_map_insert(hist);
+   return hist;
+}
+
+static unsigned perf_histogram_bucket(retro_perf_tick_t ticks)
+{
+   unsigned msb, bucket;
+
+   if (ticks < 4)
+      return (unsigned)ticks;
+
+#if defined(__GNUC__)
+   msb = 63 - __builtin_clzll((unsigned long long)ticks);
+#else
+   for (msb = 2; msb < 63 && (ticks >> (msb + 1)); msb++);
+#endif
+
+   bucket = (msb - 1) * 4 + (unsigned)((ticks >> (msb - 2)) & 3);
+   return bucket < PERF_HISTOGRAM_BUCKETS ?
+      bucket : PERF_HISTOGRAM_BUCKETS - 1;
+}
+
+/* Largest value counted in @bucket. */
+static retro_perf_tick_t perf_histogram_bucket_limit(unsigned bucket)
+{
+   unsigned msb;
+
+   if (bucket < 4)
+      return bucket;
+
+   msb = bucket / 4 + 1;
+   return ((retro_perf_tick_t)(4 + bucket % 4 + 1) << (msb - 2)) - 1;
+}
+
+static void perf_histogram_add(perf_histogram_t *hist,
+      retro_perf_tick_t ticks)
+{
+   unsigned bucket = perf_histogram_bucket(ticks);
+   unsigned slice  = perf_window_slice;
+
+   hist->calls++;
+   hist->buckets[bucket]++;
+   hist->window[slice][bucket]++;
+
+   if (ticks > hist->max)
+      hist->max = ticks;
+   if (ticks > hist->window_max[slice])
+      hist->window_max[slice] = ticks;
+}
+
+static retro_perf_tick_t perf_histogram_percentile(
+      const uint32_t *buckets, retro_perf_tick_t calls,
+      retro_perf_tick_t max, unsigned percent)
+{
+   unsigned i;
+   retro_perf_tick_t seen   = 0;
+   retro_perf_tick_t target = (calls * percent + 99) / 100;
+
+   if (!calls)
+      return 0;
+
+   for (i = 0; i < PERF_HISTOGRAM_BUCKETS; i++)
+   {
+      seen += buckets[i];
+      if (seen >= target)
+      {
+         retro_perf_tick_t limit = perf_histogram_bucket_limit(i);
+         return limit < max ? limit : max;
+      }
+   }
+
+   return max;
+}
+
+static void perf_histogram_stats(const perf_histogram_t *hist,
+      struct rarch_perf_stats *stats)
+{
+   unsigned i, j;
+   uint32_t window[PERF_HISTOGRAM_BUCKETS] = {0};
+
+   stats->p50 = perf_histogram_percentile(hist->buckets,
+         hist->calls, hist->max, 50);
+   stats->p95 = perf_histogram_percentile(hist->buckets,
+         hist->calls, hist->max, 95);
+   stats->p99 = perf_histogram_percentile(hist->buckets,
+         hist->calls, hist->max, 99);
+   stats->max = hist->max;
+
+   for (i = 0; i < PERF_WINDOW_SLICES; i++)
+   {
+      for (j = 0; j < PERF_HISTOGRAM_BUCKETS; j++)
+      {
+         window[j]             += hist->window[i][j];
+         stats->window.calls   += hist->window[i][j];
+      }
+
+      if (hist->window_max[i] > stats->window.max)
+         stats->window.max = hist->window_max[i];
+   }
+
+   stats->window.p50 = perf_histogram_percentile(window,
+         stats->window.calls, stats->window.max, 50);
+   stats->window.p95 = perf_histogram_percentile(window,
+         stats->window.calls, stats->window.max, 95);
+   stats->window.p99 = perf_histogram_percentile(window,
+         stats->window.calls, stats->window.max, 99);
+}
+
 void rarch_perf_register(struct retro_perf_counter *perf)
 {
    global_t *global = global_get_ptr();
@@ -110,6 +295,7 @@ void rarch_perf_register(struct retro_perf_counter *perf)
          || perf_ptr_rarch >= MAX_COUNTERS)
       return;
 
+   perf_histograms_rarch[perf_ptr_rarch] = perf_histogram_new(perf);
    perf_counters_rarch[perf_ptr_rarch++] = perf;
    perf->registered = true;
 }
@@ -119,30 +305,59 @@ void retro_perf_register(struct retro_perf_counter *perf)
    if (perf->registered || perf_ptr_libretro >= MAX_COUNTERS)
       return;
 
+   perf_histograms_libretro[perf_ptr_libretro] = perf_histogram_new(perf);
    perf_counters_libretro[perf_ptr_libretro++] = perf;
    perf->registered = true;
 }
 
 void retro_perf_clear(void)
 {
+   unsigned i;
+
+   for (i = 0; i < MAX_COUNTERS; i++)
+      free(perf_histograms_libretro[i]);
+
    perf_ptr_libretro = 0;
    memset(perf_counters_libretro, 0, sizeof(perf_counters_libretro));
+   memset(perf_histograms_libretro, 0, sizeof(perf_histograms_libretro));
+
+   perf_trace_forget_names();
+
+   /* Counters of the unloaded core are gone, start the map over. */
+   memset(perf_histogram_map, 0, sizeof(perf_histogram_map));
+   for (i = 0; i < perf_ptr_rarch; i++)
+      if (perf_histograms_rarch[i])
+         perf_histogram_map_insert(perf_histograms_rarch[i]);
 }
 
 static void log_counters(
-      const struct retro_perf_counter **counters, unsigned num)
+      const struct retro_perf_counter **counters,
+      perf_histogram_t **histograms, unsigned num)
 {
    unsigned i;
    for (i = 0; i < num; i++)
    {
-      if (counters[i]->call_cnt)
-      {
-         RARCH_LOG(PERF_LOG_FMT,
-               counters[i]->ident,
-               (unsigned long long)counters[i]->total / 
-               (unsigned long long)counters[i]->call_cnt,
-               (unsigned long long)counters[i]->call_cnt);
-      }
+      struct rarch_perf_stats stats = {0};
+
+      if (!counters[i]->call_cnt)
+         continue;
+
+      RARCH_LOG(PERF_LOG_FMT,
+            counters[i]->ident,
+            (unsigned long long)counters[i]->total / 
+            (unsigned long long)counters[i]->call_cnt,
+            (unsigned long long)counters[i]->call_cnt);
+
+      if (!histograms[i])
+         continue;
+
+      perf_histogram_stats(histograms[i], &stats);
+      RARCH_LOG(PERF_HISTOGRAM_LOG_FMT,
+            counters[i]->ident,
+            (unsigned long long)stats.p50,
+            (unsigned long long)stats.p95,
+            (unsigned long long)stats.p99,
+            (unsigned long long)stats.max);
    }
 }
 
@@ -154,13 +369,214 @@ void rarch_perf_log(void)
       return;
 
    RARCH_LOG("[PERF]: Performance counters (RetroArch):\n");
-   log_counters(perf_counters_rarch, perf_ptr_rarch);
+   log_counters(perf_counters_rarch, perf_histograms_rarch, perf_ptr_rarch);
 }
 
 void retro_perf_log(void)
 {
    RARCH_LOG("[PERF]: Performance counters (libretro):\n");
-   log_counters(perf_counters_libretro, perf_ptr_libretro);
+   log_counters(perf_counters_libretro, perf_histograms_libretro,
+         perf_ptr_libretro);
+}
+
+static size_t perf_get_stats(struct rarch_perf_stats *stats, size_t len,
+      const struct retro_perf_counter **counters,
+      perf_histogram_t **histograms, unsigned num, bool libretro)
+{
+   unsigned i;
+   size_t count = 0;
+
+   for (i = 0; i < num && count < len; i++)
+   {
+      struct rarch_perf_stats *stat = &stats[count++];
+
+      memset(stat, 0, sizeof(*stat));
+      stat->ident    = counters[i]->ident;
+      stat->libretro = libretro;
+      stat->calls    = counters[i]->call_cnt;
+      stat->total    = counters[i]->total;
+      if (stat->calls)
+         stat->avg   = counters[i]->total / stat->calls;
+
+      if (histograms[i])
+      {
+         stat->has_histogram = true;
+         perf_histogram_stats(histograms[i], stat);
+      }
+   }
+
+   return count;
+}
+
+/**
+ * rarch_perf_get_stats:
+ * @stats              : array to fill in.
+ * @len                : number of elements in @stats.
+ *
+ * Takes a snapshot of the RetroArch and libretro performance
+ * counters, in that order.
+ *
+ * Returns: number of elements filled in.
+ **/
+size_t rarch_perf_get_stats(struct rarch_perf_stats *stats, size_t len)
+{
+   size_t count = perf_get_stats(stats, len, perf_counters_rarch,
+         perf_histograms_rarch, perf_ptr_rarch, false);
+
+   return count + perf_get_stats(stats + count, len - count,
+         perf_counters_libretro, perf_histograms_libretro,
+         perf_ptr_libretro, true);
+}
+
+/**
+ * rarch_perf_get_stats_string:
+ * @s                  : buffer to write to.
+ * @len                : size of @s.
+ *
+ * Formats a snapshot of all performance counters as text,
+ * one counter per line.
+ *
+ * Returns: length of the text that would have been written
+ * if @s was large enough.
+ **/
+size_t rarch_perf_get_stats_string(char *s, size_t len)
+{
+   size_t i, count;
+   size_t pos                      = 0;
+   struct rarch_perf_stats *stats  = (struct rarch_perf_stats*)
+      calloc(2 * MAX_COUNTERS, sizeof(*stats));
+
+   if (len)
+      *s = '\0';
+
+   if (!stats)
+      return 0;
+
+   count = rarch_perf_get_stats(stats, 2 * MAX_COUNTERS);
+
+   for (i = 0; i < count; i++)
+   {
+      const struct rarch_perf_stats *stat = &stats[i];
+      int ret = snprintf(pos < len ? s + pos : NULL,
+            pos < len ? len - pos : 0,
+            "%s %s calls=%llu avg=%llu p50=%llu p95=%llu p99=%llu max=%llu"
+            " window_calls=%llu window_p50=%llu window_p95=%llu"
+            " window_p99=%llu window_max=%llu\n",
+            stat->libretro ? "libretro" : "rarch", stat->ident,
+            (unsigned long long)stat->calls,
+            (unsigned long long)stat->avg,
+            (unsigned long long)stat->p50,
+            (unsigned long long)stat->p95,
+            (unsigned long long)stat->p99,
+            (unsigned long long)stat->max,
+            (unsigned long long)stat->window.calls,
+            (unsigned long long)stat->window.p50,
+            (unsigned long long)stat->window.p95,
+            (unsigned long long)stat->window.p99,
+            (unsigned long long)stat->window.max);
+
+      if (ret > 0)
+         pos += ret;
+   }
+
+   free(stats);
+   return pos;
+}
+
+/**
+ * rarch_perf_dump:
+ * @path               : path of the file to write.
+ *
+ * Writes rarch_perf_get_stats_string() to @path. The file is
+ * replaced at once, so it can be polled while RetroArch runs.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+bool rarch_perf_dump(const char *path)
+{
+   FILE *file;
+   char *buf;
+   size_t len;
+   bool ret                       = false;
+   char tmp_path[PATH_MAX_LENGTH] = {0};
+
+   len = rarch_perf_get_stats_string(NULL, 0) + 1;
+   if (!(buf = (char*)malloc(len)))
+      return false;
+   rarch_perf_get_stats_string(buf, len);
+   len = strlen(buf);
+
+   snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+   if ((file = fopen(tmp_path, "wb")))
+   {
+      ret = fwrite(buf, 1, len, file) == len;
+      ret = (fclose(file) == 0) && ret;
+   }
+
+   /* rename() does not replace existing files on Windows. */
+#ifdef _WIN32
+   if (ret)
+      remove(path);
+#endif
+   if (ret)
+      ret = rename(tmp_path, path) == 0;
+   if (!ret)
+      remove(tmp_path);
+
+   free(buf);
+   return ret;
+}
+
+/**
+ * rarch_perf_frame:
+ *
+ * Advances the windowed view of the histograms by one frame and
+ * writes the periodic performance counter dump, if it is due.
+ **/
+void rarch_perf_frame(void)
+{
+   unsigned i;
+   global_t *global = global_get_ptr();
+
+   if (!global->perfcnt_enable)
+      return;
+
+   perf_frame_count++;
+
+   if (global->perfcnt_histogram_enable &&
+         perf_frame_count % (PERF_WINDOW_FRAMES / PERF_WINDOW_SLICES) == 0)
+   {
+      unsigned slice = (perf_window_slice + 1) % PERF_WINDOW_SLICES;
+
+      for (i = 0; i < MAX_COUNTERS; i++)
+      {
+         perf_histogram_t *rarch    = perf_histograms_rarch[i];
+         perf_histogram_t *libretro = perf_histograms_libretro[i];
+
+         if (rarch)
+         {
+            memset(rarch->window[slice], 0, sizeof(rarch->window[slice]));
+            rarch->window_max[slice] = 0;
+         }
+         if (libretro)
+         {
+            memset(libretro->window[slice], 0,
+                  sizeof(libretro->window[slice]));
+            libretro->window_max[slice] = 0;
+         }
+      }
+
+      perf_window_slice = slice;
+   }
+
+   if (global->perfcnt_dump_interval && *global->perfcnt_dump_path &&
+         perf_frame_count % global->perfcnt_dump_interval == 0)
+   {
+      if (!rarch_perf_dump(global->perfcnt_dump_path))
+         RARCH_WARN("[PERF]: Failed to write \"%s\".\n",
+               global->perfcnt_dump_path);
+   }
 }
 
 /**
@@ -548,6 +964,10 @@ uint64_t rarch_get_cpu_features(void)
 void rarch_perf_start(struct retro_perf_counter *perf)
 {
    global_t *global = global_get_ptr();
+
+   if (perf_trace_enabled && perf)
+      perf_trace_begin(perf->ident);
+
    if (!global->perfcnt_enable || !perf)
       return;
 
@@ -557,9 +977,19 @@ void rarch_perf_start(struct retro_perf_counter *perf)
 
 void rarch_perf_stop(struct retro_perf_counter *perf)
 {
-   global_t *global = global_get_ptr();
+   retro_perf_tick_t ticks;
+   perf_histogram_t *hist = NULL;
+   global_t *global       = global_get_ptr();
+
+   if (perf_trace_enabled && perf)
+      perf_trace_end(perf->ident);
+
    if (!global->perfcnt_enable || !perf)
       return;
 
-   perf->total += rarch_get_perf_counter() - perf->start;
+   ticks        = rarch_get_perf_counter() - perf->start;
+   perf->total += ticks;
+
+   if (global->perfcnt_histogram_enable && (hist = perf_histogram_find(perf)))
+      perf_histogram_add(hist, ticks);
 }
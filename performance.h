@@ -17,8 +17,11 @@
 #ifndef _RARCH_PERF_H
 #define _RARCH_PERF_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <boolean.h>
+
 #include <retro_inline.h>
 
 #include "libretro.h"
@@ -33,6 +36,12 @@ extern "C" {
 #define PERF_LOG_FMT "[PERF]: Avg (%s): %llu ticks, %llu runs.\n"
 #endif
 
+#ifdef _WIN32
+#define PERF_HISTOGRAM_LOG_FMT "[PERF]: Latency (%s): p50 %I64u, p95 %I64u, p99 %I64u, max %I64u ticks.\n"
+#else
+#define PERF_HISTOGRAM_LOG_FMT "[PERF]: Latency (%s): p50 %llu, p95 %llu, p99 %llu, max %llu ticks.\n"
+#endif
+
 /* Used internally by RetroArch. */
 #define RARCH_PERFORMANCE_INIT(X) \
    static struct retro_perf_counter X = {#X}; \
@@ -48,6 +57,42 @@ extern "C" {
 #define MAX_COUNTERS 64
 #endif
 
+/* Log-bucketed histogram size, covers up to 2^33 ticks. */
+#define PERF_HISTOGRAM_BUCKETS 128
+
+/* The windowed view covers the last PERF_WINDOW_FRAMES frames,
+ * at a granularity of PERF_WINDOW_FRAMES / PERF_WINDOW_SLICES. */
+#ifndef PERF_WINDOW_FRAMES
+#define PERF_WINDOW_FRAMES 600
+#endif
+#define PERF_WINDOW_SLICES 4
+
+struct rarch_perf_stats
+{
+   const char *ident;
+   bool libretro;
+   bool has_histogram;
+
+   retro_perf_tick_t calls;
+   retro_perf_tick_t total;
+   retro_perf_tick_t avg;
+
+   /* Only set if has_histogram is. */
+   retro_perf_tick_t p50;
+   retro_perf_tick_t p95;
+   retro_perf_tick_t p99;
+   retro_perf_tick_t max;
+
+   struct
+   {
+      retro_perf_tick_t calls;
+      retro_perf_tick_t p50;
+      retro_perf_tick_t p95;
+      retro_perf_tick_t p99;
+      retro_perf_tick_t max;
+   } window;
+};
+
 extern const struct retro_perf_counter *perf_counters_rarch[MAX_COUNTERS];
 extern const struct retro_perf_counter *perf_counters_libretro[MAX_COUNTERS];
 extern unsigned perf_ptr_rarch;
@@ -98,6 +143,50 @@ void rarch_perf_start(struct retro_perf_counter *perf);
  **/
 void rarch_perf_stop(struct retro_perf_counter *perf);
 
+/**
+ * rarch_perf_get_stats:
+ * @stats              : array to fill in.
+ * @len                : number of elements in @stats.
+ *
+ * Takes a snapshot of the RetroArch and libretro performance
+ * counters, in that order.
+ *
+ * Returns: number of elements filled in.
+ **/
+size_t rarch_perf_get_stats(struct rarch_perf_stats *stats, size_t len);
+
+/**
+ * rarch_perf_get_stats_string:
+ * @s                  : buffer to write to.
+ * @len                : size of @s.
+ *
+ * Formats a snapshot of all performance counters as text,
+ * one counter per line.
+ *
+ * Returns: length of the text that would have been written
+ * if @s was large enough.
+ **/
+size_t rarch_perf_get_stats_string(char *s, size_t len);
+
+/**
+ * rarch_perf_dump:
+ * @path               : path of the file to write.
+ *
+ * Writes rarch_perf_get_stats_string() to @path. The file is
+ * replaced at once, so it can be polled while RetroArch runs.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+bool rarch_perf_dump(const char *path);
+
+/**
+ * rarch_perf_frame:
+ *
+ * Advances the windowed view of the histograms by one frame and
+ * writes the periodic performance counter dump, if it is due.
+ **/
+void rarch_perf_frame(void);
+
 /**
  * rarch_get_cpu_features:
  *
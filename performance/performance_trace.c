@@ -0,0 +1,462 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(_MSC_VER) && !defined(_XBOX)
+#include <windows.h>
+#endif
+
+#include <compat/strl.h>
+#include <retro_miscellaneous.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "performance_trace.h"
+#include "../performance.h"
+
+#if !defined(HAVE_THREADS)
+#define PERF_TRACE_TLS
+#elif defined(__GNUC__)
+#define PERF_TRACE_TLS __thread
+#elif defined(_MSC_VER)
+#define PERF_TRACE_TLS __declspec(thread)
+#endif
+
+#if defined(__GNUC__)
+#define PERF_TRACE_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER) && !defined(_XBOX)
+#define PERF_TRACE_BARRIER() MemoryBarrier()
+#else
+#define PERF_TRACE_BARRIER()
+#endif
+
+#define PERF_TRACE_MAX_RINGS     64
+#define PERF_TRACE_MAX_NAMES     1024
+#define PERF_TRACE_NAME_MAP_SIZE (2 * PERF_TRACE_MAX_NAMES)
+
+enum perf_trace_type
+{
+   PERF_TRACE_BEGIN = 0,
+   PERF_TRACE_END
+};
+
+typedef struct perf_trace_event
+{
+   /* Nanoseconds. */
+   uint64_t time;
+   uint16_t name;
+   uint8_t type;
+} perf_trace_event_t;
+
+typedef struct perf_trace_ring
+{
+   /* Number of events written so far. Only the owning thread
+    * writes events, and advances this after each one. */
+   volatile uint32_t head;
+   unsigned tid;
+   char thread_name[32];
+   perf_trace_event_t events[PERF_TRACE_RING_SIZE];
+} perf_trace_ring_t;
+
+typedef struct perf_trace
+{
+#ifdef HAVE_THREADS
+   slock_t *lock;
+#endif
+
+   perf_trace_ring_t *rings[PERF_TRACE_MAX_RINGS];
+   volatile unsigned num_rings;
+
+   /* Copies of all span names, events refer to them by index. */
+   char *names[PERF_TRACE_MAX_NAMES];
+   unsigned num_names;
+
+   /* Open addressing table from name pointers to indices. Lookups
+    * are lock-free, inserting takes the lock. */
+   const char * volatile map_keys[PERF_TRACE_NAME_MAP_SIZE];
+   volatile uint16_t map_ids[PERF_TRACE_NAME_MAP_SIZE];
+} perf_trace_t;
+
+volatile bool perf_trace_enabled;
+
+static perf_trace_t *perf_trace_ptr;
+
+/* Rings of earlier traces are stale, threads notice that
+ * by the generation having changed. */
+static unsigned perf_trace_generation;
+
+#ifdef PERF_TRACE_TLS
+static PERF_TRACE_TLS perf_trace_ring_t *perf_trace_thread_ring;
+static PERF_TRACE_TLS unsigned perf_trace_thread_generation;
+#endif
+
+static void perf_trace_lock(perf_trace_t *trace)
+{
+#ifdef HAVE_THREADS
+   slock_lock(trace->lock);
+#endif
+}
+
+static void perf_trace_unlock(perf_trace_t *trace)
+{
+#ifdef HAVE_THREADS
+   slock_unlock(trace->lock);
+#endif
+}
+
+static uint64_t perf_trace_time(void)
+{
+#if defined(__linux__) || defined(__QNX__)
+   struct timespec tv;
+   if (clock_gettime(CLOCK_MONOTONIC, &tv) == 0)
+      return (uint64_t)tv.tv_sec * 1000000000 + tv.tv_nsec;
+#endif
+   return (uint64_t)rarch_get_time_usec() * 1000;
+}
+
+#ifdef PERF_TRACE_TLS
+static perf_trace_ring_t *perf_trace_get_ring(perf_trace_t *trace)
+{
+   perf_trace_ring_t *ring = NULL;
+
+   if (perf_trace_thread_generation == perf_trace_generation)
+      return perf_trace_thread_ring;
+
+   perf_trace_lock(trace);
+
+   if (trace->num_rings < PERF_TRACE_MAX_RINGS &&
+         (ring = (perf_trace_ring_t*)calloc(1, sizeof(*ring))))
+   {
+      ring->tid = trace->num_rings + 1;
+      snprintf(ring->thread_name, sizeof(ring->thread_name),
+            "Thread %u", ring->tid);
+
+      trace->rings[trace->num_rings] = ring;
+      PERF_TRACE_BARRIER();
+      trace->num_rings++;
+   }
+
+   perf_trace_unlock(trace);
+
+   /* Threads beyond the limit do not retry. */
+   perf_trace_thread_ring       = ring;
+   perf_trace_thread_generation = perf_trace_generation;
+   return ring;
+}
+#endif
+
+static unsigned perf_trace_name_hash(const char *name)
+{
+   return (unsigned)(((uintptr_t)name >> 2) * 2654435761u)
+      & (PERF_TRACE_NAME_MAP_SIZE - 1);
+}
+
+static int perf_trace_name_id(perf_trace_t *trace, const char *name)
+{
+   unsigned i;
+   const char *key = NULL;
+   int id          = -1;
+
+   for (i = perf_trace_name_hash(name); (key = trace->map_keys[i]);
+         i = (i + 1) & (PERF_TRACE_NAME_MAP_SIZE - 1))
+   {
+      if (key == name)
+         return trace->map_ids[i];
+   }
+
+   perf_trace_lock(trace);
+
+   /* Another thread might have been first. */
+   for (i = perf_trace_name_hash(name); (key = trace->map_keys[i]);
+         i = (i + 1) & (PERF_TRACE_NAME_MAP_SIZE - 1))
+   {
+      if (key == name)
+      {
+         id = trace->map_ids[i];
+         goto end;
+      }
+   }
+
+   for (id = 0; id < (int)trace->num_names; id++)
+      if (!strcmp(trace->names[id], name))
+         break;
+
+   if (id == (int)trace->num_names)
+   {
+      if (trace->num_names >= PERF_TRACE_MAX_NAMES ||
+            !(trace->names[id] = strdup(name)))
+      {
+         id = -1;
+         goto end;
+      }
+      trace->num_names++;
+   }
+
+   trace->map_ids[i] = id;
+   PERF_TRACE_BARRIER();
+   trace->map_keys[i] = name;
+
+end:
+   perf_trace_unlock(trace);
+   return id;
+}
+
+static void perf_trace_record(const char *name, enum perf_trace_type type)
+{
+#ifdef PERF_TRACE_TLS
+   int id;
+   uint32_t head;
+   perf_trace_event_t *event = NULL;
+   perf_trace_ring_t *ring   = NULL;
+   perf_trace_t *trace       = perf_trace_ptr;
+
+   if (!trace || !name || !(ring = perf_trace_get_ring(trace)))
+      return;
+
+   if ((id = perf_trace_name_id(trace, name)) < 0)
+      return;
+
+   head        = ring->head;
+   event       = &ring->events[head & (PERF_TRACE_RING_SIZE - 1)];
+   event->time = perf_trace_time();
+   event->name = id;
+   event->type = type;
+
+   PERF_TRACE_BARRIER();
+   ring->head  = head + 1;
+#endif
+}
+
+void perf_trace_begin(const char *name)
+{
+   perf_trace_record(name, PERF_TRACE_BEGIN);
+}
+
+void perf_trace_end(const char *name)
+{
+   perf_trace_record(name, PERF_TRACE_END);
+}
+
+void perf_trace_thread_name(const char *name)
+{
+#ifdef PERF_TRACE_TLS
+   perf_trace_ring_t *ring = NULL;
+   perf_trace_t *trace     = perf_trace_ptr;
+
+   if (!trace || !(ring = perf_trace_get_ring(trace)))
+      return;
+
+   perf_trace_lock(trace);
+   strlcpy(ring->thread_name, name, sizeof(ring->thread_name));
+   perf_trace_unlock(trace);
+#endif
+}
+
+void perf_trace_forget_names(void)
+{
+   unsigned i;
+   perf_trace_t *trace = perf_trace_ptr;
+
+   if (!trace)
+      return;
+
+   perf_trace_lock(trace);
+   for (i = 0; i < PERF_TRACE_NAME_MAP_SIZE; i++)
+      trace->map_keys[i] = NULL;
+   perf_trace_unlock(trace);
+}
+
+static void perf_trace_write_string(FILE *file, const char *s)
+{
+   fputc('"', file);
+
+   for (; *s; s++)
+   {
+      if (*s == '"' || *s == '\\')
+         fputc('\\', file);
+      if ((unsigned char)*s >= 0x20)
+         fputc(*s, file);
+   }
+
+   fputc('"', file);
+}
+
+static void perf_trace_write_ring(perf_trace_t *trace,
+      perf_trace_ring_t *ring, perf_trace_event_t *events,
+      FILE *file, bool *first)
+{
+   uint32_t i, head, start, begin;
+   unsigned depth = 0;
+
+   head  = ring->head;
+   PERF_TRACE_BARRIER();
+   start = head > PERF_TRACE_RING_SIZE ? head - PERF_TRACE_RING_SIZE : 0;
+
+   for (i = start; i != head; i++)
+      events[i - start] = ring->events[i & (PERF_TRACE_RING_SIZE - 1)];
+
+   PERF_TRACE_BARRIER();
+
+   /* Skip events the thread overwrote while they were copied. */
+   begin = ring->head;
+   begin = begin > PERF_TRACE_RING_SIZE ? begin - PERF_TRACE_RING_SIZE : 0;
+   if (begin < start)
+      begin = start;
+
+   fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+         "\"tid\":%u,\"args\":{\"name\":", *first ? "" : ",\n", ring->tid);
+   perf_trace_write_string(file, ring->thread_name);
+   fputs("}}", file);
+   *first = false;
+
+   for (i = begin; i != head; i++)
+   {
+      const perf_trace_event_t *event = &events[i - start];
+
+      /* Spans which began before the oldest event. */
+      if (event->type == PERF_TRACE_END && !depth)
+         continue;
+
+      if (event->type == PERF_TRACE_BEGIN)
+         depth++;
+      else
+         depth--;
+
+      fputs(",\n{\"name\":", file);
+      perf_trace_write_string(file, event->name < trace->num_names ?
+            trace->names[event->name] : "?");
+      fprintf(file, ",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%u}",
+            event->type == PERF_TRACE_BEGIN ? 'B' : 'E',
+            (unsigned long long)(event->time / 1000),
+            (unsigned)(event->time % 1000), ring->tid);
+   }
+}
+
+/**
+ * perf_trace_dump:
+ * @path               : path of the JSON file to write.
+ *
+ * Writes the events currently held by all rings to @path.
+ * Recording goes on while doing so.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+bool perf_trace_dump(const char *path)
+{
+   unsigned i;
+   FILE *file                 = NULL;
+   bool first                 = true;
+   bool ret                   = false;
+   perf_trace_event_t *events = NULL;
+   perf_trace_t *trace        = perf_trace_ptr;
+
+   if (!trace)
+      return false;
+
+   if (!(events = (perf_trace_event_t*)
+            malloc(PERF_TRACE_RING_SIZE * sizeof(*events))))
+      return false;
+
+   if (!(file = fopen(path, "wb")))
+   {
+      free(events);
+      return false;
+   }
+
+   fputs("{\"traceEvents\":[\n", file);
+
+   /* Keeps the names and thread names from changing,
+    * recording into existing rings goes on. */
+   perf_trace_lock(trace);
+   for (i = 0; i < trace->num_rings; i++)
+      perf_trace_write_ring(trace, trace->rings[i], events, file, &first);
+   perf_trace_unlock(trace);
+
+   fputs("\n],\"displayTimeUnit\":\"ns\"}\n", file);
+
+   ret = !ferror(file);
+   ret = (fclose(file) == 0) && ret;
+
+   free(events);
+   return ret;
+}
+
+/**
+ * perf_trace_init:
+ * @enable             : start recording right away.
+ *
+ * Sets up tracing. Does nothing if it is already set up.
+ *
+ * Returns: true if tracing is available, otherwise false.
+ **/
+bool perf_trace_init(bool enable)
+{
+#ifdef PERF_TRACE_TLS
+   perf_trace_t *trace = NULL;
+
+   if (perf_trace_ptr)
+      return true;
+
+   if (!(trace = (perf_trace_t*)calloc(1, sizeof(*trace))))
+      return false;
+
+#ifdef HAVE_THREADS
+   if (!(trace->lock = slock_new()))
+   {
+      free(trace);
+      return false;
+   }
+#endif
+
+   perf_trace_generation++;
+   perf_trace_ptr     = trace;
+   perf_trace_enabled = enable;
+
+   perf_trace_thread_name("Main");
+   return true;
+#else
+   return false;
+#endif
+}
+
+/* Other threads must not record anymore. */
+void perf_trace_deinit(void)
+{
+   unsigned i;
+   perf_trace_t *trace = perf_trace_ptr;
+
+   if (!trace)
+      return;
+
+   perf_trace_enabled = false;
+   perf_trace_ptr     = NULL;
+
+   for (i = 0; i < trace->num_rings; i++)
+      free(trace->rings[i]);
+   for (i = 0; i < trace->num_names; i++)
+      free(trace->names[i]);
+
+#ifdef HAVE_THREADS
+   slock_free(trace->lock);
+#endif
+   free(trace);
+}
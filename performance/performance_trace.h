@@ -0,0 +1,116 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RARCH_PERF_TRACE_H
+#define _RARCH_PERF_TRACE_H
+
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Records begin and end events of spans into a ring buffer per thread,
+ * to be written out in the Chrome trace event format, which can be
+ * viewed in chrome://tracing or Perfetto.
+ *
+ * Recording only takes the lock the first time a thread or span name
+ * shows up, after that an event is a timestamp written to the ring of
+ * the calling thread. The rings keep the most recent
+ * PERF_TRACE_RING_SIZE events of every thread. */
+
+/* Used if perfcnt_trace_path is not set. */
+#define PERF_TRACE_DEFAULT_PATH "retroarch_trace.json"
+
+#ifndef PERF_TRACE_RING_SIZE
+#define PERF_TRACE_RING_SIZE (1 << 16)
+#endif
+
+extern volatile bool perf_trace_enabled;
+
+#define RARCH_TRACE_BEGIN(name) \
+   do { \
+      if (perf_trace_enabled) \
+         perf_trace_begin(name); \
+   } while(0)
+
+#define RARCH_TRACE_END(name) \
+   do { \
+      if (perf_trace_enabled) \
+         perf_trace_end(name); \
+   } while(0)
+
+/**
+ * perf_trace_init:
+ * @enable             : start recording right away.
+ *
+ * Sets up tracing. Does nothing if it is already set up.
+ *
+ * Returns: true if tracing is available, otherwise false.
+ **/
+bool perf_trace_init(bool enable);
+
+void perf_trace_deinit(void);
+
+/**
+ * perf_trace_begin:
+ * @name               : name of the span.
+ *
+ * Starts a span on the calling thread. @name only has to stay
+ * valid until perf_trace_forget_names() is called.
+ **/
+void perf_trace_begin(const char *name);
+
+/**
+ * perf_trace_end:
+ * @name               : name of the span.
+ *
+ * Ends the span started last on the calling thread.
+ **/
+void perf_trace_end(const char *name);
+
+/**
+ * perf_trace_thread_name:
+ * @name               : name of the calling thread.
+ *
+ * Names the calling thread in the trace.
+ **/
+void perf_trace_thread_name(const char *name);
+
+/**
+ * perf_trace_forget_names:
+ *
+ * Called before span names go away, like the performance counter
+ * names of a core which is unloaded. Spans recorded so far keep
+ * their names.
+ **/
+void perf_trace_forget_names(void);
+
+/**
+ * perf_trace_dump:
+ * @path               : path of the JSON file to write.
+ *
+ * Writes the events currently held by all rings to @path.
+ * Recording goes on while doing so.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+bool perf_trace_dump(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,13 +18,371 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/types.h>
 
 #include <boolean.h>
 #include <compat/posix_string.h>
+#include <compat/strl.h>
 #include <retro_log.h>
+#include <retro_miscellaneous.h>
+#include <rhash.h>
 
 #include "playlist.h"
 
+#ifndef PLAYLIST_ENTRIES
+#define PLAYLIST_ENTRIES 6
+#endif
+
+/* Don't bother merging small journals into the playlist file. */
+#define PLAYLIST_JOURNAL_COMPACT_MIN 1024
+
+enum
+{
+   PLAYLIST_SLOT_EMPTY = 0,
+   PLAYLIST_SLOT_USED,
+   PLAYLIST_SLOT_DELETED
+};
+
+typedef struct content_playlist_slot
+{
+   uint64_t seq;
+   uint32_t hash;
+   uint32_t state;
+} content_playlist_slot_t;
+
+/* Open addressing hash table mapping a key to the sequence
+ * numbers of entries. Several entries can share a key. */
+struct content_playlist_index
+{
+   content_playlist_slot_t *slots;
+   size_t mask;
+   /* Used and deleted slots. */
+   size_t used;
+};
+
+static struct content_playlist_index *content_playlist_index_new(size_t cap)
+{
+   size_t size = 16;
+   struct content_playlist_index *index = (struct content_playlist_index*)
+      calloc(1, sizeof(*index));
+
+   if (!index)
+      return NULL;
+
+   while (size < cap * 2)
+      size <<= 1;
+
+   index->slots = (content_playlist_slot_t*)calloc(size, sizeof(*index->slots));
+   index->mask  = size - 1;
+
+   if (!index->slots)
+   {
+      free(index);
+      return NULL;
+   }
+
+   return index;
+}
+
+static void content_playlist_index_free(struct content_playlist_index *index)
+{
+   if (!index)
+      return;
+   free(index->slots);
+   free(index);
+}
+
+static void content_playlist_index_clear(struct content_playlist_index *index)
+{
+   memset(index->slots, 0, (index->mask + 1) * sizeof(*index->slots));
+   index->used = 0;
+}
+
+/* Keeps at least a quarter of the slots empty, so probing terminates. */
+static bool content_playlist_index_full(const struct content_playlist_index *index)
+{
+   return (index->used + 1) * 4 > (index->mask + 1) * 3;
+}
+
+static void content_playlist_index_add(struct content_playlist_index *index,
+      uint32_t hash, uint64_t seq)
+{
+   size_t i;
+
+   for (i = hash & index->mask; ; i = (i + 1) & index->mask)
+   {
+      content_playlist_slot_t *slot = &index->slots[i];
+
+      if (slot->state == PLAYLIST_SLOT_USED)
+         continue;
+
+      if (slot->state == PLAYLIST_SLOT_EMPTY)
+         index->used++;
+
+      slot->seq   = seq;
+      slot->hash  = hash;
+      slot->state = PLAYLIST_SLOT_USED;
+      return;
+   }
+}
+
+static content_playlist_slot_t *content_playlist_index_get(
+      struct content_playlist_index *index, uint32_t hash, uint64_t seq)
+{
+   size_t i;
+
+   for (i = hash & index->mask;
+         index->slots[i].state != PLAYLIST_SLOT_EMPTY;
+         i = (i + 1) & index->mask)
+   {
+      content_playlist_slot_t *slot = &index->slots[i];
+
+      if (slot->state == PLAYLIST_SLOT_USED && slot->seq == seq)
+         return slot;
+   }
+
+   return NULL;
+}
+
+static bool content_playlist_path_equal(const char *a, const char *b)
+{
+   if (a && !*a)
+      a = NULL;
+   if (b && !*b)
+      b = NULL;
+   if (!a || !b)
+      return a == b;
+   return !strcmp(a, b);
+}
+
+static uint32_t content_playlist_path_hash(const char *path)
+{
+   return djb2_calculate(path ? path : "");
+}
+
+/**
+ * content_playlist_seq_to_idx:
+ * @playlist            : Playlist handle.
+ * @seq                 : Sequence number of an entry.
+ *
+ * Entries are ordered by descending sequence number,
+ * so the entry can be found with a binary search.
+ *
+ * Returns: index of the entry, -1 if there is none.
+ **/
+static ssize_t content_playlist_seq_to_idx(
+      const content_playlist_t *playlist, uint64_t seq)
+{
+   size_t lo = 0, hi = playlist->size;
+
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (playlist->entries[mid].seq == seq)
+         return mid;
+
+      if (playlist->entries[mid].seq > seq)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   return -1;
+}
+
+/**
+ * content_playlist_index_find:
+ * @index               : Path index.
+ * @playlist            : Playlist referenced by @index, or NULL if
+ *                        sequence numbers are indices into @entries.
+ * @entries             : Entries referenced by @index.
+ * @path                : Path to look for.
+ * @core_path           : Core path to look for, NULL for any.
+ *
+ * Returns: index of the topmost entry matching @path
+ * and @core_path, otherwise -1.
+ **/
+static ssize_t content_playlist_index_find(
+      const struct content_playlist_index *index,
+      const content_playlist_t *playlist,
+      const content_playlist_entry_t *entries,
+      const char *path, const char *core_path)
+{
+   size_t i;
+   ssize_t found = -1;
+   uint32_t hash = content_playlist_path_hash(path);
+
+   for (i = hash & index->mask;
+         index->slots[i].state != PLAYLIST_SLOT_EMPTY;
+         i = (i + 1) & index->mask)
+   {
+      ssize_t idx;
+      const content_playlist_entry_t *entry = NULL;
+      const content_playlist_slot_t *slot   = &index->slots[i];
+
+      if (slot->state != PLAYLIST_SLOT_USED || slot->hash != hash)
+         continue;
+
+      idx = playlist ? content_playlist_seq_to_idx(playlist, slot->seq)
+         : (ssize_t)slot->seq;
+
+      if (idx < 0 || (found >= 0 && idx > found))
+         continue;
+
+      entry = &entries[idx];
+
+      if (!content_playlist_path_equal(entry->path, path))
+         continue;
+      if (core_path && strcmp(entry->core_path, core_path))
+         continue;
+
+      found = idx;
+   }
+
+   return found;
+}
+
+static void content_playlist_index_entry(content_playlist_t *playlist,
+      size_t idx)
+{
+   const content_playlist_entry_t *entry = &playlist->entries[idx];
+
+   content_playlist_index_add(playlist->path_index,
+         content_playlist_path_hash(entry->path), entry->seq);
+   if (entry->crc32)
+      content_playlist_index_add(playlist->crc_index,
+            djb2_calculate(entry->crc32), entry->seq);
+}
+
+/**
+ * content_playlist_reindex:
+ * @playlist            : Playlist handle.
+ *
+ * Renumbers all entries and rebuilds both indices
+ * from scratch, dropping deleted slots.
+ **/
+static void content_playlist_reindex(content_playlist_t *playlist)
+{
+   size_t i;
+
+   content_playlist_index_clear(playlist->path_index);
+   content_playlist_index_clear(playlist->crc_index);
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      playlist->entries[i].seq = playlist->size - i;
+      content_playlist_index_entry(playlist, i);
+   }
+
+   playlist->seq = playlist->size;
+}
+
+static bool content_playlist_index_needs_rebuild(
+      const content_playlist_t *playlist)
+{
+   return content_playlist_index_full(playlist->path_index) ||
+      content_playlist_index_full(playlist->crc_index);
+}
+
+static void content_playlist_unindex_entry(content_playlist_t *playlist,
+      size_t idx)
+{
+   content_playlist_slot_t *slot         = NULL;
+   const content_playlist_entry_t *entry = &playlist->entries[idx];
+
+   slot = content_playlist_index_get(playlist->path_index,
+         content_playlist_path_hash(entry->path), entry->seq);
+   if (slot)
+      slot->state = PLAYLIST_SLOT_DELETED;
+
+   if (!entry->crc32)
+      return;
+
+   slot = content_playlist_index_get(playlist->crc_index,
+         djb2_calculate(entry->crc32), entry->seq);
+   if (slot)
+      slot->state = PLAYLIST_SLOT_DELETED;
+}
+
+/* Gives an entry a new sequence number, moving it to the top. */
+static void content_playlist_renumber_entry(content_playlist_t *playlist,
+      content_playlist_entry_t *entry)
+{
+   content_playlist_slot_t *slot = NULL;
+   uint64_t seq                  = ++playlist->seq;
+
+   slot = content_playlist_index_get(playlist->path_index,
+         content_playlist_path_hash(entry->path), entry->seq);
+   if (slot)
+      slot->seq = seq;
+
+   if (entry->crc32)
+   {
+      slot = content_playlist_index_get(playlist->crc_index,
+            djb2_calculate(entry->crc32), entry->seq);
+      if (slot)
+         slot->seq = seq;
+   }
+
+   entry->seq = seq;
+}
+
+static void content_playlist_journal_add(content_playlist_t *playlist,
+      const char *path, const char *label,
+      const char *core_path, const char *core_name,
+      const char *crc32,
+      const char *db_name)
+{
+   unsigned i;
+   const char *fields[PLAYLIST_ENTRIES];
+   size_t len = 0;
+
+   /* Not recorded, rewrite everything on the next write. */
+   if (!playlist->journal)
+   {
+      playlist->modified = true;
+      return;
+   }
+
+   fields[0] = path      ? path      : "";
+   fields[1] = label     ? label     : "";
+   fields[2] = core_path;
+   fields[3] = core_name;
+   fields[4] = crc32     ? crc32     : "";
+   fields[5] = db_name   ? db_name   : "";
+
+   for (i = 0; i < PLAYLIST_ENTRIES; i++)
+      len += strlen(fields[i]) + 1;
+
+   if (playlist->journal_len + len > playlist->journal_cap)
+   {
+      size_t cap = (playlist->journal_len + len) * 2;
+      char *buf  = (char*)realloc(playlist->journal_buf, cap);
+
+      /* Can't record it, rewrite everything instead. */
+      if (!buf)
+      {
+         playlist->modified = true;
+         return;
+      }
+
+      playlist->journal_buf = buf;
+      playlist->journal_cap = cap;
+   }
+
+   for (i = 0; i < PLAYLIST_ENTRIES; i++)
+   {
+      size_t field_len = strlen(fields[i]);
+      memcpy(playlist->journal_buf + playlist->journal_len,
+            fields[i], field_len);
+      playlist->journal_len += field_len;
+      playlist->journal_buf[playlist->journal_len++] = '\n';
+   }
+
+   playlist->journal_pending++;
+}
+
 /**
  * content_playlist_get_index:
  * @playlist        	   : Playlist handle.
@@ -67,29 +425,91 @@ void content_playlist_get_index_by_path(content_playlist_t *playlist,
       char **db_name)
 {
    size_t i;
-   if (!playlist)
+
+   if (!content_playlist_find_by_path(playlist, search_path, &i))
       return;
 
-   for (i = 0; i < playlist->size; i++)
+   if (path)
+      *path      = playlist->entries[i].path;
+   if (label)
+      *label     = playlist->entries[i].label;
+   if (core_path)
+      *core_path = playlist->entries[i].core_path;
+   if (core_name)
+      *core_name = playlist->entries[i].core_name;
+   if (db_name)
+      *db_name   = playlist->entries[i].db_name;
+   if (crc32)
+      *crc32     = playlist->entries[i].crc32;
+}
+
+bool content_playlist_find_by_path(content_playlist_t *playlist,
+      const char *path, size_t *idx)
+{
+   ssize_t found;
+
+   if (!playlist || !path)
+      return false;
+
+   found = content_playlist_index_find(playlist->path_index,
+         playlist, playlist->entries, path, NULL);
+
+   if (found < 0)
+      return false;
+
+   *idx = found;
+   return true;
+}
+
+static int content_playlist_idx_cmp(const void *a_, const void *b_)
+{
+   size_t a = *(const size_t*)a_;
+   size_t b = *(const size_t*)b_;
+
+   return (a > b) - (a < b);
+}
+
+size_t content_playlist_find_by_crc32(content_playlist_t *playlist,
+      const char *crc32, const char *db_name, size_t *idx, size_t max)
+{
+   size_t i, num = 0;
+   uint32_t hash;
+   const struct content_playlist_index *index = NULL;
+
+   if (!playlist || !crc32)
+      return 0;
+
+   index = playlist->crc_index;
+   hash  = djb2_calculate(crc32);
+
+   for (i = hash & index->mask;
+         index->slots[i].state != PLAYLIST_SLOT_EMPTY && num < max;
+         i = (i + 1) & index->mask)
    {
-      if (strcmp(playlist->entries[i].path, search_path) != 0)
+      ssize_t found;
+      const content_playlist_entry_t *entry = NULL;
+      const content_playlist_slot_t *slot   = &index->slots[i];
+
+      if (slot->state != PLAYLIST_SLOT_USED || slot->hash != hash)
+         continue;
+
+      found = content_playlist_seq_to_idx(playlist, slot->seq);
+      if (found < 0)
+         continue;
+
+      entry = &playlist->entries[found];
+
+      if (strcmp(entry->crc32, crc32))
+         continue;
+      if (db_name && (!entry->db_name || strcmp(entry->db_name, db_name)))
          continue;
 
-      if (path)
-         *path      = playlist->entries[i].path;
-      if (label)
-         *label     = playlist->entries[i].label;
-      if (core_path)
-         *core_path = playlist->entries[i].core_path;
-      if (core_name)
-         *core_name = playlist->entries[i].core_name;
-      if (db_name)
-         *db_name   = playlist->entries[i].db_name;
-      if (crc32)
-         *crc32     = playlist->entries[i].crc32;
-      break;
+      idx[num++] = found;
    }
 
+   qsort(idx, num, sizeof(*idx), content_playlist_idx_cmp);
+
+   return num;
 }
 
 /**
@@ -147,12 +567,17 @@ void content_playlist_update(content_playlist_t *playlist, size_t idx,
    if (!entry)
       return;
 
+   playlist->modified = true;
+
    entry->path      = path ?  strdup(path)          : entry->path;
    entry->label     = label ? strdup(label)         : entry->label;
    entry->core_path = core_path ? strdup(core_path) : entry->core_path;
    entry->core_name = core_name ? strdup(core_name) : entry->core_name;
    entry->db_name   = db_name ? strdup(db_name)     : entry->db_name;
    entry->crc32     = crc32 ? strdup(crc32)         : entry->crc32;
+
+   if (path || crc32)
+      content_playlist_reindex(playlist);
 }
 
 /**
@@ -170,7 +595,7 @@ void content_playlist_push(content_playlist_t *playlist,
       const char *crc32,
       const char *db_name)
 {
-   size_t i;
+   ssize_t found;
 
    if (!playlist)
       return;
@@ -184,43 +609,37 @@ void content_playlist_push(content_playlist_t *playlist,
    if (path && !*path)
       path = NULL;
 
-   for (i = 0; i < playlist->size; i++)
+   found = content_playlist_index_find(playlist->path_index,
+         playlist, playlist->entries, path, core_path);
+
+   if (found >= 0)
    {
       content_playlist_entry_t tmp;
-      bool equal_path = (!path && !playlist->entries[i].path) ||
-         (path && playlist->entries[i].path &&
-          !strcmp(path,playlist->entries[i].path));
-
-      /* Core name can have changed while still being the same core.
-       * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
-      if (strcmp(playlist->entries[i].core_path, core_path))
-         continue;
 
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
-      if (i == 0)
+      if (found == 0)
          return;
 
       /* Seen it before, bump to top. */
-      tmp = playlist->entries[i];
+      tmp = playlist->entries[found];
       memmove(playlist->entries + 1, playlist->entries,
-		      i * sizeof(content_playlist_entry_t));
+		      found * sizeof(content_playlist_entry_t));
       playlist->entries[0] = tmp;
 
-      return;
+      content_playlist_renumber_entry(playlist, &playlist->entries[0]);
+      goto journal;
    }
 
    if (playlist->size == playlist->cap)
    {
+      content_playlist_unindex_entry(playlist, playlist->cap - 1);
       content_playlist_free_entry(&playlist->entries[playlist->cap - 1]);
       playlist->size--;
    }
 
    memmove(playlist->entries + 1, playlist->entries,
-         (playlist->cap - 1) * sizeof(content_playlist_entry_t));
+         playlist->size * sizeof(content_playlist_entry_t));
 
    playlist->entries[0].path      = path ? strdup(path) : NULL;
    playlist->entries[0].label     = label ? strdup(label) : NULL;
@@ -228,7 +647,202 @@ void content_playlist_push(content_playlist_t *playlist,
    playlist->entries[0].core_name = core_name ? strdup(core_name) : NULL;
    playlist->entries[0].db_name   = db_name ? strdup(db_name) : NULL;
    playlist->entries[0].crc32     = crc32 ? strdup(crc32) : NULL;
+   playlist->entries[0].seq       = ++playlist->seq;
    playlist->size++;
+
+   if (content_playlist_index_needs_rebuild(playlist))
+      content_playlist_reindex(playlist);
+   else
+      content_playlist_index_entry(playlist, 0);
+
+journal:
+   content_playlist_journal_add(playlist, path, label,
+         core_path, core_name, crc32, db_name);
+}
+
+/**
+ * content_playlist_push_bulk:
+ * @playlist            : Playlist handle.
+ * @entries             : Entries to push.
+ * @count               : Number of entries in @entries.
+ *
+ * Pushing a sequence of entries leaves the last occurrence of every
+ * pushed entry on top, most recent first, followed by the old entries
+ * which were not pushed again. Build that list in a single pass.
+ *
+ * Returns: number of entries pushed.
+ **/
+size_t content_playlist_push_bulk(content_playlist_t *playlist,
+      const content_playlist_entry_t *entries, size_t count)
+{
+   size_t i, num_selected = 0, num_new, size = 0, pushed = 0;
+   size_t *selected                     = NULL;
+   bool *removed                        = NULL;
+   struct content_playlist_index *batch = NULL;
+
+   if (!playlist || !entries || !count)
+      return 0;
+
+   selected = (size_t*)calloc(count, sizeof(*selected));
+   removed  = (bool*)calloc(playlist->size + 1, sizeof(*removed));
+   batch    = content_playlist_index_new(count);
+
+   if (!selected || !removed || !batch)
+      goto end;
+
+   for (i = count; i-- > 0; )
+   {
+      ssize_t found;
+      const content_playlist_entry_t *entry = &entries[i];
+
+      if (!entry->core_path || !*entry->core_path ||
+            !entry->core_name || !*entry->core_name)
+      {
+         RARCH_ERR("cannot push NULL or empty core info into the playlist.\n");
+         continue;
+      }
+
+      pushed++;
+
+      if (content_playlist_index_find(batch, NULL, entries,
+               entry->path, entry->core_path) >= 0)
+         continue;
+
+      content_playlist_index_add(batch,
+            content_playlist_path_hash(entry->path), i);
+      selected[num_selected++] = i;
+
+      found = content_playlist_index_find(playlist->path_index,
+            playlist, playlist->entries, entry->path, entry->core_path);
+      if (found >= 0)
+         removed[found] = true;
+   }
+
+   num_new = num_selected < playlist->cap ? num_selected : playlist->cap;
+
+   /* Drop the entries which are pushed again, and evict
+    * from the bottom to make room. */
+   for (i = 0; i < playlist->size; i++)
+   {
+      if (removed[i] || size == playlist->cap - num_new)
+      {
+         content_playlist_unindex_entry(playlist, i);
+         content_playlist_free_entry(&playlist->entries[i]);
+      }
+      else
+         playlist->entries[size++] = playlist->entries[i];
+   }
+
+   memmove(playlist->entries + num_new, playlist->entries,
+         size * sizeof(content_playlist_entry_t));
+   memset(playlist->entries, 0, num_new * sizeof(content_playlist_entry_t));
+
+   for (i = num_new; i-- > 0; )
+   {
+      const content_playlist_entry_t *entry = &entries[selected[i]];
+      content_playlist_entry_t *dst         = &playlist->entries[i];
+
+      dst->path      = (entry->path && *entry->path) ? strdup(entry->path) : NULL;
+      dst->label     = entry->label ? strdup(entry->label) : NULL;
+      dst->core_path = strdup(entry->core_path);
+      dst->core_name = strdup(entry->core_name);
+      dst->db_name   = entry->db_name ? strdup(entry->db_name) : NULL;
+      dst->crc32     = entry->crc32 ? strdup(entry->crc32) : NULL;
+      dst->seq       = ++playlist->seq;
+   }
+
+   playlist->size = size + num_new;
+
+   for (i = 0; i < num_new; i++)
+   {
+      if (content_playlist_index_needs_rebuild(playlist))
+      {
+         content_playlist_reindex(playlist);
+         break;
+      }
+      content_playlist_index_entry(playlist, i);
+   }
+
+   for (i = 0; i < count; i++)
+   {
+      const content_playlist_entry_t *entry = &entries[i];
+
+      if (!entry->core_path || !*entry->core_path ||
+            !entry->core_name || !*entry->core_name)
+         continue;
+
+      content_playlist_journal_add(playlist,
+            (entry->path && *entry->path) ? entry->path : NULL,
+            entry->label, entry->core_path, entry->core_name,
+            entry->crc32, entry->db_name);
+   }
+
+end:
+   content_playlist_index_free(batch);
+   free(removed);
+   free(selected);
+   return pushed;
+}
+
+static void content_playlist_journal_path(const content_playlist_t *playlist,
+      char *s, size_t len)
+{
+   strlcpy(s, playlist->conf_path, len);
+   strlcat(s, PLAYLIST_JOURNAL_EXT, len);
+}
+
+void content_playlist_set_journal(content_playlist_t *playlist, bool enable)
+{
+   if (!playlist)
+      return;
+   playlist->journal = enable;
+}
+
+/**
+ * content_playlist_write_journal:
+ * @playlist            : Playlist handle.
+ *
+ * Appends pending pushes to the journal file.
+ *
+ * Returns: true (1) if the journal is up to date, false (0) if
+ * the whole playlist file has to be rewritten instead.
+ **/
+static bool content_playlist_write_journal(content_playlist_t *playlist)
+{
+   char journal_path[PATH_MAX_LENGTH] = {0};
+   size_t records = playlist->journal_count + playlist->journal_pending;
+   FILE *file     = NULL;
+   bool ret       = false;
+
+   if (!playlist->journal || playlist->modified)
+      return false;
+
+   /* Merge once replaying the journal would cost more
+    * than reading the playlist itself. */
+   if (records >= PLAYLIST_JOURNAL_COMPACT_MIN && records >= playlist->size)
+      return false;
+
+   if (!playlist->journal_pending)
+      return true;
+
+   content_playlist_journal_path(playlist, journal_path, sizeof(journal_path));
+
+   file = fopen(journal_path, "ab");
+   if (!file)
+      return false;
+
+   ret = fwrite(playlist->journal_buf, 1, playlist->journal_len, file)
+      == playlist->journal_len;
+   ret = (fclose(file) == 0) && ret;
+
+   if (ret)
+   {
+      playlist->journal_count  += playlist->journal_pending;
+      playlist->journal_pending = 0;
+      playlist->journal_len     = 0;
+   }
+
+   return ret;
 }
 
 void content_playlist_write_file(content_playlist_t *playlist)
@@ -239,6 +853,9 @@ void content_playlist_write_file(content_playlist_t *playlist)
    if (!playlist)
       return;
 
+   if (content_playlist_write_journal(playlist))
+      return;
+
    file = fopen(playlist->conf_path, "w");
 
    if (!file)
@@ -255,6 +872,19 @@ void content_playlist_write_file(content_playlist_t *playlist)
             );
 
    fclose(file);
+
+   /* Everything in the journal is in the playlist file now. */
+   if (playlist->journal_count)
+   {
+      char journal_path[PATH_MAX_LENGTH] = {0};
+      content_playlist_journal_path(playlist, journal_path, sizeof(journal_path));
+      remove(journal_path);
+   }
+
+   playlist->journal_count   = 0;
+   playlist->journal_pending = 0;
+   playlist->journal_len     = 0;
+   playlist->modified        = false;
 }
 
 /**
@@ -275,12 +905,19 @@ void content_playlist_free(content_playlist_t *playlist)
 
    playlist->conf_path = NULL;
 
-   for (i = 0; i < playlist->cap; i++)
-      content_playlist_free_entry(&playlist->entries[i]);
+   if (playlist->entries)
+   {
+      for (i = 0; i < playlist->cap; i++)
+         content_playlist_free_entry(&playlist->entries[i]);
+   }
 
    free(playlist->entries);
    playlist->entries = NULL;
 
+   content_playlist_index_free(playlist->path_index);
+   content_playlist_index_free(playlist->crc_index);
+   free(playlist->journal_buf);
+
    free(playlist);
 }
 
@@ -298,7 +935,10 @@ void content_playlist_clear(content_playlist_t *playlist)
 
    for (i = 0; i < playlist->cap; i++)
       content_playlist_free_entry(&playlist->entries[i]);
-   playlist->size = 0;
+   playlist->size     = 0;
+   playlist->modified = true;
+
+   content_playlist_reindex(playlist);
 }
 
 /**
@@ -315,58 +955,94 @@ size_t content_playlist_size(content_playlist_t *playlist)
    return playlist->size;
 }
 
-#ifndef PLAYLIST_ENTRIES
-#define PLAYLIST_ENTRIES 6
-#endif
+/**
+ * content_playlist_read_entry:
+ * @file                : Playlist or journal file.
+ * @buf                 : Lines of the entry.
+ *
+ * Returns: true (1) if a complete entry was read, otherwise false (0).
+ **/
+static bool content_playlist_read_entry(FILE *file,
+      char buf[PLAYLIST_ENTRIES][1024])
+{
+   unsigned i;
+
+   for (i = 0; i < PLAYLIST_ENTRIES; i++)
+   {
+      char *last = NULL;
+
+      *buf[i] = '\0';
+
+      if (!fgets(buf[i], sizeof(buf[i]), file))
+         return false;
+
+      last = strrchr(buf[i], '\n');
+      if (last)
+         *last = '\0';
+   }
+
+   return true;
+}
 
 static bool content_playlist_read_file(
       content_playlist_t *playlist, const char *path)
 {
-   unsigned i;
-   char buf[PLAYLIST_ENTRIES][1024] = {{0}};
-   content_playlist_entry_t *entry  = NULL;
-   char *last                       = NULL;
-   FILE *file                       = fopen(path, "r");
+   char journal_path[PATH_MAX_LENGTH] = {0};
+   char buf[PLAYLIST_ENTRIES][1024]   = {{0}};
+   content_playlist_entry_t *entry    = NULL;
+   FILE *file                         = fopen(path, "r");
 
    /* If playlist file does not exist,
     * create an empty playlist instead.
     */
-   if (!file)
-      return true;
-
-   for (playlist->size = 0; playlist->size < playlist->cap; )
+   if (file)
    {
-      for (i = 0; i < PLAYLIST_ENTRIES; i++)
+      for (playlist->size = 0; playlist->size < playlist->cap; )
       {
-         *buf[i] = '\0';
+         if (!content_playlist_read_entry(file, buf))
+            break;
+
+         entry = &playlist->entries[playlist->size];
+
+         if (!*buf[2] || !*buf[3])
+            continue;
+
+         if (*buf[0])
+            entry->path      = strdup(buf[0]);
+         if (*buf[1])
+            entry->label     = strdup(buf[1]);
+         entry->core_path    = strdup(buf[2]);
+         entry->core_name    = strdup(buf[3]);
+         if (*buf[4])
+            entry->crc32     = strdup(buf[4]);
+         if (*buf[5])
+            entry->db_name   = strdup(buf[5]);
+         playlist->size++;
+      }
 
-         if (!fgets(buf[i], sizeof(buf[i]), file))
-            goto end;
+      fclose(file);
+   }
 
-         last = strrchr(buf[i], '\n');
-         if (last)
-            *last = '\0';
-      }
+   content_playlist_reindex(playlist);
 
-      entry = &playlist->entries[playlist->size];
+   /* Replay pushes recorded after the playlist was last written. */
+   strlcpy(journal_path, path, sizeof(journal_path));
+   strlcat(journal_path, PLAYLIST_JOURNAL_EXT, sizeof(journal_path));
 
-      if (!*buf[2] || !*buf[3])
-         continue;
+   file = fopen(journal_path, "r");
+   if (!file)
+      return true;
 
-      if (*buf[0])
-         entry->path      = strdup(buf[0]);
-      if (*buf[1])
-         entry->label     = strdup(buf[1]);
-      entry->core_path    = strdup(buf[2]);
-      entry->core_name    = strdup(buf[3]);
-      if (*buf[4])
-         entry->crc32     = strdup(buf[4]);
-      if (*buf[5])
-         entry->db_name   = strdup(buf[5]);
-      playlist->size++;
+   while (content_playlist_read_entry(file, buf))
+   {
+      content_playlist_push(playlist, buf[0], buf[1], buf[2], buf[3],
+            *buf[4] ? buf[4] : NULL, *buf[5] ? buf[5] : NULL);
+      playlist->journal_count++;
    }
 
-end:
+   /* Replayed pushes are on disk already. */
+   playlist->modified = false;
+
    fclose(file);
    return true;
 }
@@ -394,6 +1070,11 @@ content_playlist_t *content_playlist_init(const char *path, size_t size)
 
    playlist->cap = size;
 
+   playlist->path_index = content_playlist_index_new(size);
+   playlist->crc_index  = content_playlist_index_new(size);
+   if (!playlist->path_index || !playlist->crc_index)
+      goto error;
+
    content_playlist_read_file(playlist, path);
 
    playlist->conf_path = strdup(path);
@@ -408,4 +1089,7 @@ void content_playlist_qsort(content_playlist_t *playlist, content_playlist_sort_
 {
    qsort(playlist->entries, playlist->size, sizeof(content_playlist_entry_t),
          (int (*)(const void *, const void *))fn);
+
+   playlist->modified = true;
+   content_playlist_reindex(playlist);
 }
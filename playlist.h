@@ -19,6 +19,8 @@
 #define CONTENT_HISTORY_H__
 
 #include <stddef.h>
+#include <stdint.h>
+#include <boolean.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +34,8 @@ typedef struct content_playlist_entry
    char *core_name;
    char *db_name;
    char *crc32;
+   /* Push order, higher is newer. Maintained by the playlist. */
+   uint64_t seq;
 } content_playlist_entry_t;
 
 typedef struct content_playlist
@@ -41,8 +45,28 @@ typedef struct content_playlist
    size_t cap;
 
    char *conf_path;
+
+   /* Hash indices on path and on crc32, mapping to entry
+    * sequence numbers. @seq is the last number handed out. */
+   struct content_playlist_index *path_index;
+   struct content_playlist_index *crc_index;
+   uint64_t seq;
+
+   /* Pushes not written to disk yet, in LPL format. */
+   bool journal;
+   char *journal_buf;
+   size_t journal_len;
+   size_t journal_cap;
+   size_t journal_pending;
+   /* Records in the journal file on disk. */
+   size_t journal_count;
+   /* Set if the playlist changed in a way the journal can not
+    * record, the next write rewrites the whole file. */
+   bool modified;
 } content_playlist_t;
 
+#define PLAYLIST_JOURNAL_EXT ".journal"
+
 typedef int (content_playlist_sort_fun_t)(const content_playlist_entry_t *a,
       const content_playlist_entry_t *b);
 
@@ -114,6 +138,20 @@ void content_playlist_push(content_playlist_t *playlist,
       const char *db_name,
       const char *crc32);
 
+/**
+ * content_playlist_push_bulk:
+ * @playlist            : Playlist handle.
+ * @entries             : Entries to push.
+ * @count               : Number of entries in @entries.
+ *
+ * Same as calling content_playlist_push() for every entry
+ * of @entries in order, but rebuilds the playlist only once.
+ *
+ * Returns: number of entries pushed.
+ **/
+size_t content_playlist_push_bulk(content_playlist_t *playlist,
+      const content_playlist_entry_t *entries, size_t count);
+
 void content_playlist_update(content_playlist_t *playlist, size_t idx,
       const char *path, const char *label,
       const char *core_path, const char *core_name,
@@ -127,6 +165,42 @@ void content_playlist_get_index_by_path(content_playlist_t *playlist,
       char **db_name,
       char **crc32);
 
+/**
+ * content_playlist_find_by_path:
+ * @playlist            : Playlist handle.
+ * @path                : Path of playlist entry.
+ * @idx                 : Index of the topmost entry with @path.
+ *
+ * Returns: true (1) if an entry with @path exists, otherwise false (0).
+ **/
+bool content_playlist_find_by_path(content_playlist_t *playlist,
+      const char *path, size_t *idx);
+
+/**
+ * content_playlist_find_by_crc32:
+ * @playlist            : Playlist handle.
+ * @crc32               : Hash of playlist entry, e.g. "DEADBEEF|crc".
+ * @db_name             : Database of playlist entry, NULL for any.
+ * @idx                 : Indices of matching entries, in ascending order.
+ * @max                 : Size of @idx.
+ *
+ * Returns: number of matching entries, at most @max.
+ **/
+size_t content_playlist_find_by_crc32(content_playlist_t *playlist,
+      const char *crc32, const char *db_name, size_t *idx, size_t max);
+
+/**
+ * content_playlist_set_journal:
+ * @playlist            : Playlist handle.
+ * @enable              : Enable journal.
+ *
+ * With the journal enabled, content_playlist_write_file() appends
+ * pushed entries to PLAYLIST_JOURNAL_EXT next to the playlist file
+ * instead of rewriting the whole playlist. The journal is merged
+ * into the playlist file once it grows larger than the playlist.
+ **/
+void content_playlist_set_journal(content_playlist_t *playlist, bool enable);
+
 void content_playlist_write_file(content_playlist_t *playlist);
 
 void content_playlist_qsort(content_playlist_t *playlist, content_playlist_sort_fun_t *fn);
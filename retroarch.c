@@ -45,6 +45,8 @@
 #include "retroarch.h"
 #include "runloop_data.h"
 #include "performance.h"
+#include "performance/performance_trace.h"
+#include "benchmark.h"
 #include "cheats.h"
 #include "system.h"
 
@@ -81,7 +83,11 @@ enum {
    RA_OPT_VERSION,
    RA_OPT_EOF_EXIT,
    RA_OPT_LOG_FILE,
-   RA_OPT_MAX_FRAMES
+   RA_OPT_MAX_FRAMES,
+   RA_OPT_BSV_SEEK,
+   RA_OPT_BENCHMARK,
+   RA_OPT_BENCHMARK_OUTPUT,
+   RA_OPT_BENCHMARK_DRIVERS
 };
 
 #include "config.features.h"
@@ -209,6 +215,7 @@ static void print_help(const char *arg0)
 
    puts("  -P, --bsvplay=FILE    Playback a BSV movie file.");
    puts("  -R, --bsvrecord=FILE  Start recording a BSV movie file from the beginning.");
+   puts("      --bsvseek=FRAME   Start BSV movie playback at FRAME.");
    puts("      --eof-exit        Exit upon reaching the end of the BSV movie file.");
    puts("  -M, --sram-mode=MODE  SRAM handling mode. MODE can be 'noload-nosave',\n"
         "                        'noload-save', 'load-nosave' or 'load-save'.\n"
@@ -237,7 +244,18 @@ static void print_help(const char *arg0)
    puts("      --no-patch        Disables all forms of content patching.");
    puts("  -D, --detach          Detach program from the running console. Not relevant for all platforms.");
    puts("      --max-frames=NUMBER\n"
-        "                        Runs for the specified number of frames, then exits.\n");
+        "                        Runs for the specified number of frames, then exits.");
+   printf("      --benchmark       Runs unthrottled with the null drivers and performance\n"
+          "                        counters enabled for --max-frames frames (default %u),\n"
+          "                        then reports frames/s and the counters as JSON. Use\n"
+          "                        with --bsvplay for reproducible input, and with\n"
+          "                        --appendconfig to toggle rewind, filters or resampler.\n",
+          BENCHMARK_DEFAULT_FRAMES);
+   puts("      --benchmark-output=FILE\n"
+        "                        Writes the benchmark report to FILE instead of stdout.");
+   puts("      --benchmark-drivers\n"
+        "                        Benchmarks with the configured drivers instead of the\n"
+        "                        null drivers.\n");
 }
 
 static void set_basename(const char *path)
@@ -555,6 +573,7 @@ static void parse_input(int argc, char *argv[])
       { "savestate",    1, NULL, 'S' },
       { "bsvplay",      1, NULL, 'P' },
       { "bsvrecord",    1, NULL, 'R' },
+      { "bsvseek",      1, NULL, RA_OPT_BSV_SEEK },
       { "sram-mode",    1, NULL, 'M' },
 #ifdef HAVE_NETPLAY
       { "host",         0, NULL, 'H' },
@@ -575,6 +594,9 @@ static void parse_input(int argc, char *argv[])
       { "features",     0, NULL, RA_OPT_FEATURES },
       { "subsystem",    1, NULL, RA_OPT_SUBSYSTEM },
       { "max-frames",   1, NULL, RA_OPT_MAX_FRAMES },
+      { "benchmark",    0, NULL, RA_OPT_BENCHMARK },
+      { "benchmark-output", 1, NULL, RA_OPT_BENCHMARK_OUTPUT },
+      { "benchmark-drivers", 0, NULL, RA_OPT_BENCHMARK_DRIVERS },
       { "eof-exit",     0, NULL, RA_OPT_EOF_EXIT },
       { "version",      0, NULL, RA_OPT_VERSION },
 #ifdef HAVE_FILE_LOGGER
@@ -868,6 +890,19 @@ static void parse_input(int argc, char *argv[])
             runloop->frames.video.max = strtoul(optarg, NULL, 10);
             break;
 
+         case RA_OPT_BENCHMARK:
+            global->benchmark.enable = true;
+            break;
+
+         case RA_OPT_BENCHMARK_OUTPUT:
+            strlcpy(global->benchmark.output, optarg,
+                  sizeof(global->benchmark.output));
+            break;
+
+         case RA_OPT_BENCHMARK_DRIVERS:
+            global->benchmark.real_drivers = true;
+            break;
+
          case RA_OPT_SUBSYSTEM:
             strlcpy(global->subsystem, optarg, sizeof(global->subsystem));
             break;
@@ -880,6 +915,10 @@ static void parse_input(int argc, char *argv[])
             global->bsv.eof_exit = true;
             break;
 
+         case RA_OPT_BSV_SEEK:
+            global->bsv.movie_start_frame = strtoul(optarg, NULL, 0);
+            break;
+
          case RA_OPT_VERSION:
             print_version();
             exit(0);
@@ -1231,6 +1270,11 @@ int rarch_main_init(int argc, char *argv[])
    validate_cpu_features();
    config_load();
 
+   rarch_benchmark_init();
+
+   if (global->perfcnt_trace_enable && !perf_trace_init(true))
+      RARCH_WARN("Tracing is not supported on this platform.\n");
+
    {
       settings_t *settings = config_get_ptr();
 
@@ -25,6 +25,8 @@
 #include "configuration.h"
 #include "dynamic.h"
 #include "performance.h"
+#include "performance/performance_trace.h"
+#include "benchmark.h"
 #include "retroarch.h"
 #include "runloop.h"
 #include "runloop_data.h"
@@ -193,6 +195,8 @@ static bool check_rewind(settings_t *settings,
       if ((cnt == 0) || global->bsv.movie)
       {
          void *state = NULL;
+
+         RARCH_TRACE_BEGIN("rewind_push");
          state_manager_push_where(global->rewind.state, &state);
 
          RARCH_PERFORMANCE_INIT(rewind_serialize);
@@ -201,6 +205,7 @@ static bool check_rewind(settings_t *settings,
          RARCH_PERFORMANCE_STOP(rewind_serialize);
 
          state_manager_push_do(global->rewind.state);
+         RARCH_TRACE_END("rewind_push");
       }
    }
 
@@ -752,14 +757,20 @@ static INLINE retro_input_t input_keys_pressed(driver_t *driver,
          settings, driver->input->key_pressed(
             driver->input_data, RARCH_ENABLE_HOTKEY));
 
+   RARCH_PERFORMANCE_INIT(input_keys_pressed_perf);
+   RARCH_PERFORMANCE_START(input_keys_pressed_perf);
+
    for (i = 0; i < settings->input.max_users; i++)
    {
+      global->turbo_frame_enable[i] = 0;
+
+      if (!settings->input.analog_dpad_mode[i])
+         continue;
+
       input_push_analog_dpad(settings->input.binds[i],
             settings->input.analog_dpad_mode[i]);
       input_push_analog_dpad(settings->input.autoconf_binds[i],
             settings->input.analog_dpad_mode[i]);
-
-      global->turbo_frame_enable[i] = 0;
    }
 
    if (!driver->block_libretro_input)
@@ -773,10 +784,15 @@ static INLINE retro_input_t input_keys_pressed(driver_t *driver,
 
    for (i = 0; i < settings->input.max_users; i++)
    {
+      if (!settings->input.analog_dpad_mode[i])
+         continue;
+
       input_pop_analog_dpad(settings->input.binds[i]);
       input_pop_analog_dpad(settings->input.autoconf_binds[i]);
    }
 
+   RARCH_PERFORMANCE_STOP(input_keys_pressed_perf);
+
    return ret;
 }
 
@@ -1068,15 +1084,7 @@ static void rarch_main_cmd_get_state(event_cmd_state_t *cmd,
 
 }
 
-/**
- * rarch_main_iterate:
- *
- * Run Libretro core in RetroArch for one frame.
- *
- * Returns: 0 on success, 1 if we have to wait until button input in order
- * to wake up the loop, -1 if we forcibly quit out of the RetroArch iteration loop. 
- **/
-int rarch_main_iterate(void)
+static int rarch_main_iterate_frame(void)
 {
    unsigned i;
    retro_input_t trigger_input, old_input;
@@ -1136,6 +1144,10 @@ int rarch_main_iterate(void)
    {
       /* RetroArch has been paused */
       driver->retro_ctx.poll_cb();
+#ifdef HAVE_COMMAND
+      if (driver->command)
+         rarch_cmd_run_queries(driver->command);
+#endif
       rarch_sleep(10);
 
       return 1;
@@ -1150,6 +1162,14 @@ int rarch_main_iterate(void)
       netplay_pre_frame((netplay_t*)driver->netplay_data);
 #endif
 
+   if (global->bsv.movie_playback && global->bsv.movie_start_frame)
+   {
+      if (!bsv_movie_seek(global->bsv.movie, global->bsv.movie_start_frame))
+         RARCH_WARN("Couldn't seek to frame %llu of movie.\n",
+               (unsigned long long)global->bsv.movie_start_frame);
+      global->bsv.movie_start_frame = 0;
+   }
+
    if (global->bsv.movie)
       bsv_movie_set_frame_start(global->bsv.movie);
 
@@ -1171,9 +1191,14 @@ int rarch_main_iterate(void)
    if ((settings->video.frame_delay > 0) && !driver->nonblock_state)
       rarch_sleep(settings->video.frame_delay);
 
+   /* Binds may have changed since the last snapshot was taken. */
+   input_driver_snapshot_invalidate();
+
 
    /* Run libretro for one frame. */
+   RARCH_TRACE_BEGIN("retro_run");
    pretro_run();
+   RARCH_TRACE_END("retro_run");
 
    for (i = 0; i < settings->input.max_users; i++)
    {
@@ -1197,8 +1222,40 @@ int rarch_main_iterate(void)
 #endif
 
 success:
+#ifdef HAVE_COMMAND
+   /* Queries may access the core, which is not possible while
+    * it is polling input inside retro_run(). */
+   if (driver->command)
+      rarch_cmd_run_queries(driver->command);
+#endif
+
+   rarch_perf_frame();
+
    if (settings->fastforward_ratio_throttle_enable)
       rarch_limit_frame_time(settings, runloop);
 
    return ret;
 }
+
+/**
+ * rarch_main_iterate:
+ *
+ * Run Libretro core in RetroArch for one frame.
+ *
+ * Returns: 0 on success, 1 if we have to wait until button input in order
+ * to wake up the loop, -1 if we forcibly quit out of the RetroArch iteration loop. 
+ **/
+int rarch_main_iterate(void)
+{
+   int ret;
+
+   RARCH_PERFORMANCE_INIT(rarch_main_iterate);
+   RARCH_PERFORMANCE_START(rarch_main_iterate);
+   ret = rarch_main_iterate_frame();
+   RARCH_PERFORMANCE_STOP(rarch_main_iterate);
+
+   if (ret != -1)
+      rarch_benchmark_frame();
+
+   return ret;
+}
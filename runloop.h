@@ -69,6 +69,11 @@ typedef struct global
 {
    bool verbosity;
    bool perfcnt_enable;
+   bool perfcnt_histogram_enable;
+   unsigned perfcnt_dump_interval;
+   char perfcnt_dump_path[PATH_MAX_LENGTH];
+   bool perfcnt_trace_enable;
+   char perfcnt_trace_path[PATH_MAX_LENGTH];
    bool force_fullscreen;
    bool core_shutdown_initiated;
 
@@ -189,9 +194,21 @@ typedef struct global
       char movie_start_path[PATH_MAX_LENGTH];
       bool movie_start_recording;
       bool movie_start_playback;
+      uint64_t movie_start_frame;
       bool movie_end;
    } bsv;
 
+   struct
+   {
+      /* Headless benchmark run, see benchmark.h. */
+      bool enable;
+      bool real_drivers;
+      char output[PATH_MAX_LENGTH];
+      retro_time_t start;
+      retro_time_t end;
+      uint64_t frames;
+   } benchmark;
+
    bool sram_load_disable;
    bool sram_save_disable;
    bool use_sram;
@@ -19,6 +19,7 @@
 #endif
 
 #include "general.h"
+#include "performance/performance_trace.h"
 
 #include "runloop_data.h"
 #include "tasks/tasks.h"
@@ -116,6 +117,7 @@ static void rarch_main_data_free_internal(void)
 void rarch_main_data_free(void)
 {
    rarch_main_data_nbio_uninit();
+   rarch_main_data_dir_list_uninit();
 #ifdef HAVE_NETWORKING
    rarch_main_data_http_uninit();
 #endif
@@ -129,6 +131,7 @@ void rarch_main_data_free(void)
 static void data_runloop_iterate(bool is_thread)
 {
    rarch_main_data_nbio_iterate       (is_thread);
+   rarch_main_data_dir_list_iterate   (is_thread);
 #ifdef HAVE_RPNG
    rarch_main_data_nbio_image_iterate (is_thread);
 #endif
@@ -157,6 +160,8 @@ bool rarch_main_data_active(void)
       active = true;
    if (rarch_main_data_nbio_get_handle())
       active = true;
+   if (rarch_main_data_dir_list_is_active())
+      active = true;
 #ifdef HAVE_NETWORKING
    if (rarch_main_data_http_get_handle())
       active = true;
@@ -180,6 +185,7 @@ static void data_thread_loop(void *data)
    slock_unlock(runloop->lock);
 
    RARCH_LOG("[Data Thread]: Starting data thread.\n");
+   perf_trace_thread_name("Data");
 
    while (runloop->alive)
    {
@@ -188,7 +194,9 @@ static void data_thread_loop(void *data)
       if (!runloop->alive)
          break;
 
+      RARCH_TRACE_BEGIN("data_runloop_iterate");
       data_runloop_iterate(true);
+      RARCH_TRACE_END("data_runloop_iterate");
 
       if (!rarch_main_data_active())
          rarch_sleep(10);
@@ -267,6 +275,8 @@ void rarch_main_data_iterate(void)
 #endif
 
 #ifdef HAVE_MENU
+   if (rarch_main_data_dir_list_pending_refresh())
+      menu_entries_set_refresh();
 #ifdef HAVE_LIBRETRODB
    if (rarch_main_data_db_pending_scan_finished())
       menu_environment_cb(MENU_ENVIRON_RESET_HORIZONTAL_LIST, NULL);
@@ -320,6 +330,7 @@ void rarch_main_data_clear_state(void)
       return;
 
    rarch_main_data_nbio_init();
+   rarch_main_data_dir_list_init();
 #ifdef HAVE_NETWORKING
    rarch_main_data_http_init();
 #endif
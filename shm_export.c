@@ -0,0 +1,218 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <compat/strl.h>
+
+#include "shm_export.h"
+#include "configuration.h"
+#include "dynamic.h"
+#include "general.h"
+#include "gfx/video_driver.h"
+#include "gfx/video_viewport.h"
+
+#if defined(__ATOMIC_ACQUIRE)
+#define SHM_EXPORT_STORE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELAXED)
+#define SHM_EXPORT_FENCE()         __atomic_thread_fence(__ATOMIC_RELEASE)
+#define SHM_EXPORT_PUBLISH(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#else
+#define SHM_EXPORT_STORE(ptr, val)   (*(ptr) = (val))
+#define SHM_EXPORT_FENCE()           __sync_synchronize()
+#define SHM_EXPORT_PUBLISH(ptr, val) do { __sync_synchronize(); *(ptr) = (val); } while (0)
+#endif
+
+/* Keeps the frame and the RAM on their own cache lines. */
+#define SHM_EXPORT_ALIGN(x) (((x) + 63) & ~(size_t)63)
+
+typedef struct shm_export
+{
+   int fd;
+   size_t size;
+   uint8_t *map;
+   struct rarch_shm_export_header *header;
+   bool warned;
+   char name[PATH_MAX_LENGTH];
+} shm_export_t;
+
+static shm_export_t *shm_export_data;
+
+bool shm_export_init(void)
+{
+   size_t video_capacity, ram_size;
+   shm_export_t *shm                  = NULL;
+   settings_t *settings               = config_get_ptr();
+   struct retro_system_av_info *av_info =
+      video_viewport_get_system_av_info();
+
+   shm_export_deinit();
+
+   if (!settings->shm_export_enable || !*settings->shm_export_name)
+      return false;
+
+   video_capacity = SHM_EXPORT_ALIGN((size_t)av_info->geometry.max_width
+         * av_info->geometry.max_height * sizeof(uint32_t));
+   ram_size       = pretro_get_memory_size(RETRO_MEMORY_SYSTEM_RAM);
+   if (!pretro_get_memory_data(RETRO_MEMORY_SYSTEM_RAM))
+      ram_size = 0;
+
+   shm = (shm_export_t*)calloc(1, sizeof(*shm));
+   if (!shm)
+      return false;
+
+   strlcpy(shm->name, settings->shm_export_name, sizeof(shm->name));
+   shm->size = SHM_EXPORT_ALIGN(sizeof(struct rarch_shm_export_header))
+      + video_capacity + SHM_EXPORT_ALIGN(ram_size);
+
+   shm->fd = shm_open(shm->name, O_CREAT | O_RDWR, 0600);
+   if (shm->fd < 0)
+   {
+      RARCH_ERR("Failed to create shared memory \"%s\".\n", shm->name);
+      free(shm);
+      return false;
+   }
+
+   if (ftruncate(shm->fd, shm->size) < 0)
+      goto error;
+
+   shm->map = (uint8_t*)mmap(NULL, shm->size, PROT_READ | PROT_WRITE,
+         MAP_SHARED, shm->fd, 0);
+   if (shm->map == MAP_FAILED)
+   {
+      shm->map = NULL;
+      goto error;
+   }
+
+   shm->header                 = (struct rarch_shm_export_header*)shm->map;
+   memset(shm->header, 0, sizeof(*shm->header));
+   shm->header->magic          = RARCH_SHM_EXPORT_MAGIC;
+   shm->header->version        = RARCH_SHM_EXPORT_VERSION;
+   shm->header->size           = shm->size;
+   shm->header->video_offset   =
+      SHM_EXPORT_ALIGN(sizeof(struct rarch_shm_export_header));
+   shm->header->video_capacity = video_capacity;
+   shm->header->ram_offset     = shm->header->video_offset + video_capacity;
+   shm->header->ram_size       = ram_size;
+
+   RARCH_LOG("Exporting frames and %u bytes of RAM to shared memory \"%s\".\n",
+         (unsigned)ram_size, shm->name);
+
+   shm_export_data = shm;
+   return true;
+
+error:
+   RARCH_ERR("Failed to map shared memory \"%s\".\n", shm->name);
+   close(shm->fd);
+   shm_unlink(shm->name);
+   free(shm);
+   return false;
+}
+
+void shm_export_deinit(void)
+{
+   shm_export_t *shm = shm_export_data;
+
+   if (!shm)
+      return;
+
+   munmap(shm->map, shm->size);
+   close(shm->fd);
+   shm_unlink(shm->name);
+   free(shm);
+
+   shm_export_data = NULL;
+}
+
+static void shm_export_copy_frame(shm_export_t *shm, const void *data,
+      unsigned width, unsigned height, size_t pitch)
+{
+   struct rarch_shm_export_header *header = shm->header;
+   uint8_t *dst     = shm->map + header->video_offset;
+   size_t row_size  = width *
+      (video_driver_get_pixel_format() == RETRO_PIXEL_FORMAT_XRGB8888 ?
+       sizeof(uint32_t) : sizeof(uint16_t));
+   /* The core's buffer may end right after the last row. */
+   size_t size      = height ? (height - 1) * pitch + row_size : 0;
+
+   if (pitch >= row_size && size <= header->video_capacity)
+   {
+      /* Rows are kept as the core laid them out. */
+      memcpy(dst, data, size);
+   }
+   else if (height * row_size <= header->video_capacity)
+   {
+      unsigned y;
+      const uint8_t *src = (const uint8_t*)data;
+
+      for (y = 0; y < height; y++, src += pitch, dst += row_size)
+         memcpy(dst, src, row_size);
+      pitch = row_size;
+   }
+   else
+   {
+      if (!shm->warned)
+         RARCH_WARN("Frame of %ux%u does not fit in shared memory.\n",
+               width, height);
+      shm->warned   = true;
+      header->pitch = 0;
+      return;
+   }
+
+   header->width        = width;
+   header->height       = height;
+   header->pitch        = pitch;
+   header->pixel_format = video_driver_get_pixel_format();
+}
+
+void shm_export_frame(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   struct rarch_shm_export_header *header;
+   uint32_t sequence;
+   shm_export_t *shm = shm_export_data;
+
+   if (!shm)
+      return;
+
+   header   = shm->header;
+   sequence = header->sequence;
+
+   SHM_EXPORT_STORE(&header->sequence, sequence + 1);
+   SHM_EXPORT_FENCE();
+
+   /* Dupes keep the last frame. */
+   if (data == RETRO_HW_FRAME_BUFFER_VALID)
+      header->pitch = 0;
+   else if (data)
+      shm_export_copy_frame(shm, data, width, height, pitch);
+
+   if (header->ram_size)
+   {
+      const void *ram = pretro_get_memory_data(RETRO_MEMORY_SYSTEM_RAM);
+
+      if (ram)
+         memcpy(shm->map + header->ram_offset, ram, header->ram_size);
+   }
+
+   header->frame++;
+
+   SHM_EXPORT_PUBLISH(&header->sequence, sequence + 2);
+}
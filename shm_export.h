@@ -0,0 +1,101 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_SHM_EXPORT_H
+#define __RARCH_SHM_EXPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Every frame, the last video frame and the system RAM of the core
+ * are published in a POSIX shared memory object named by
+ * shm_export_name, for other processes to read.
+ *
+ * The object starts with struct rarch_shm_export_header. The frame
+ * and the RAM follow at video_offset and ram_offset.
+ *
+ * Readers never block the frontend. They check the sequence counter,
+ * which is odd while the frontend is writing:
+ *
+ *    do {
+ *       seq = sequence (acquire);
+ *       if (seq & 1) continue;
+ *       copy what is needed;
+ *       acquire fence;
+ *    } while (sequence != seq);
+ */
+#define RARCH_SHM_EXPORT_MAGIC   0x4d485352 /* "RSHM" */
+#define RARCH_SHM_EXPORT_VERSION 1
+
+struct rarch_shm_export_header
+{
+   uint32_t magic;
+   uint32_t version;
+   /* Size of the whole object. */
+   uint32_t size;
+   volatile uint32_t sequence;
+
+   /* Frames published since the content was loaded. */
+   uint64_t frame;
+
+   uint32_t width;
+   uint32_t height;
+   /* 0 if the frame is not in memory, e.g. rendered by the GPU. */
+   uint32_t pitch;
+   /* enum retro_pixel_format. */
+   uint32_t pixel_format;
+   uint32_t video_offset;
+   uint32_t video_capacity;
+
+   uint32_t ram_offset;
+   uint32_t ram_size;
+};
+
+/**
+ * shm_export_init:
+ *
+ * Creates the shared memory object for the loaded content if
+ * shm_export_enable is set. It is sized for the largest frame
+ * the core reports and for its system RAM.
+ *
+ * Returns: true if the object was created, otherwise false.
+ **/
+bool shm_export_init(void);
+
+void shm_export_deinit(void);
+
+/**
+ * shm_export_frame:
+ * @data               : frame from the core, may be NULL for a dupe
+ *                       or RETRO_HW_FRAME_BUFFER_VALID.
+ * @width              : width of the frame.
+ * @height             : height of the frame.
+ * @pitch              : pitch of the frame.
+ *
+ * Publishes the frame and the system RAM.
+ **/
+void shm_export_frame(const void *data, unsigned width,
+      unsigned height, size_t pitch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -13,11 +13,21 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
 #include <compat/strcasestr.h>
 #include <compat/strl.h>
+#include <rhash.h>
 
 #ifdef HAVE_LIBRETRODB
 #include "../database_info.h"
+#include "../database_scan_cache.h"
 #endif
 
 #include "../dir_list_special.h"
@@ -31,6 +41,27 @@
 
 #define HASH_EXTENSION_ZIP 0x0b88c7d8U
 
+/* Matches pushed to a playlist at once. */
+#define DB_PLAYLIST_BATCH 64
+
+/* Bytes hashed per iteration. */
+#define DB_HASH_CHUNK_SIZE (1024 * 1024)
+
+/* Files bigger than this are identified by the serial in their
+ * header if they have one, which saves hashing a whole disc image.
+ * Others, like PSX or PSP images, are still hashed. */
+#define DB_HASH_MAX_SIZE   (256 * 1024 * 1024)
+
+/* Scan cache file in the database directory. */
+#define DB_SCAN_CACHE_FILE "scan_cache.bin"
+
+/* Unchanged files skipped at once. */
+#define DB_SCAN_CACHE_BATCH 256
+
+/* Header bytes probed for a serial, enough for raw 2352 byte
+ * sectors where the data starts at offset 16. */
+#define DB_SERIAL_PROBE_SIZE 0x210
+
 typedef struct database_state_handle
 {
    database_info_list_t *info;
@@ -38,8 +69,24 @@ typedef struct database_state_handle
    size_t list_index;
    size_t entry_index;
    uint32_t crc;
-   uint8_t *buf;
+   char serial[32];
    char zip_name[PATH_MAX_LENGTH];
+
+   /* File being hashed and the buffer it is read through. */
+   FILE *file;
+   uint8_t *buf;
+
+   /* What is known about the scanned files, and the entry of the
+    * file being scanned. */
+   database_scan_cache_t *cache;
+   database_scan_cache_entry_t *cache_entry;
+   /* Directory being scanned, empty when scanning a single file. */
+   char scan_dir[PATH_MAX_LENGTH];
+
+   /* Playlist of the last match and matches not pushed to it yet. */
+   content_playlist_t *playlist;
+   content_playlist_entry_t matches[DB_PLAYLIST_BATCH];
+   size_t num_matches;
 } database_state_handle_t;
 
 typedef struct db_handle
@@ -76,6 +123,9 @@ static int zlib_compare_crc32(const char *name, const char *valid_exts,
 
    strlcpy(db_state->zip_name, name, sizeof(db_state->zip_name));
 
+   database_scan_cache_set_crc(db_state->cache, db_state->cache_entry,
+         crc32, name);
+
 #if 0
    RARCH_LOG("Going to compare CRC 0x%x for %s\n", crc32, name);
 #endif
@@ -113,6 +163,182 @@ static int database_info_iterate_start
    return 0;
 }
 
+/* Copies a space padded header field, without the padding. */
+static void database_info_serial_copy(char *s, size_t len,
+      const uint8_t *field, size_t field_len)
+{
+   size_t i;
+
+   while (field_len && (*field == ' ' || *field == '\0'))
+   {
+      field++;
+      field_len--;
+   }
+
+   while (field_len && (field[field_len - 1] == ' '
+            || field[field_len - 1] == '\0'))
+      field_len--;
+
+   if (field_len >= len)
+      field_len = len - 1;
+
+   for (i = 0; i < field_len; i++)
+   {
+      /* Keep the serial usable inside a quoted query. */
+      bool valid = field[i] >= 0x20 && field[i] < 0x7f
+         && field[i] != '"' && field[i] != '\\';
+      s[i] = valid ? field[i] : '\0';
+   }
+   s[field_len] = '\0';
+}
+
+static bool database_info_serial_from_header(const uint8_t *hdr,
+      char *s, size_t len)
+{
+   uint32_t magic;
+
+   s[0] = '\0';
+
+   if (!memcmp(hdr, "SEGA SEGASATURN ", 16))
+      database_info_serial_copy(s, len, hdr + 0x20, 10);
+   else if (!memcmp(hdr, "SEGA SEGAKATANA ", 16))
+      database_info_serial_copy(s, len, hdr + 0x40, 10);
+   else if (!memcmp(hdr, "SEGADISCSYSTEM  ", 16))
+      database_info_serial_copy(s, len, hdr + 0x183, 11);
+   else
+   {
+      /* GameCube and Wii discs start with the game ID. */
+      magic = (hdr[0x1c] << 24) | (hdr[0x1d] << 16)
+         | (hdr[0x1e] << 8) | hdr[0x1f];
+      if (magic == 0xc2339f3d)
+         database_info_serial_copy(s, len, hdr, 6);
+
+      magic = (hdr[0x18] << 24) | (hdr[0x19] << 16)
+         | (hdr[0x1a] << 8) | hdr[0x1b];
+      if (magic == 0x5d1c9ea3)
+         database_info_serial_copy(s, len, hdr, 6);
+   }
+
+   return s[0] != '\0';
+}
+
+/**
+ * database_info_probe_serial:
+ * @file       : disc image, positioned at its start.
+ * @s          : buffer to store the serial in.
+ * @len        : size of @s.
+ *
+ * Looks for a product serial at the start of a disc image,
+ * either with 2048 byte or with raw 2352 byte sectors.
+ *
+ * Returns: true if a serial was found, otherwise false.
+ **/
+static bool database_info_probe_serial(FILE *file, char *s, size_t len)
+{
+   uint8_t hdr[DB_SERIAL_PROBE_SIZE] = {0};
+
+   if (fread(hdr, 1, sizeof(hdr), file) < 0x200)
+      return false;
+
+   if (database_info_serial_from_header(hdr, s, len))
+      return true;
+
+   /* Raw sectors have a sync pattern, address and mode first. */
+   return database_info_serial_from_header(hdr + 16, s, len);
+}
+
+static void database_info_iterate_close(database_state_handle_t *db_state)
+{
+   if (db_state->file)
+      fclose(db_state->file);
+   db_state->file = NULL;
+}
+
+static int database_info_iterate_open(
+      database_state_handle_t *db_state,
+      database_info_handle_t *db, const char *name)
+{
+   struct stat st;
+
+   if (stat(name, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+      return 0;
+
+   if (!(db_state->file = fopen(name, "rb")))
+      return 0;
+
+   if (st.st_size > DB_HASH_MAX_SIZE)
+   {
+      if (database_info_probe_serial(db_state->file,
+               db_state->serial, sizeof(db_state->serial)))
+      {
+         database_info_iterate_close(db_state);
+
+         database_scan_cache_set_serial(db_state->cache,
+               db_state->cache_entry, db_state->serial);
+
+         db->type = DATABASE_TYPE_SERIAL_LOOKUP;
+         return 1;
+      }
+
+      /* No serial, fall back to the CRC. */
+      rewind(db_state->file);
+   }
+
+   if (!db_state->buf)
+      db_state->buf = (uint8_t*)malloc(DB_HASH_CHUNK_SIZE);
+
+   if (!db_state->buf)
+   {
+      database_info_iterate_close(db_state);
+      return 0;
+   }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+   posix_fadvise(fileno(db_state->file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+   db_state->crc = 0;
+   db->type      = DATABASE_TYPE_HASH;
+   return 1;
+}
+
+/* Hashes the next chunk of the file, so that neither memory use
+ * nor the time spent per iteration depends on the file size. */
+static int database_info_iterate_hash(
+      database_state_handle_t *db_state,
+      database_info_handle_t *db)
+{
+   size_t size;
+   bool error;
+
+   if (!db_state->file)
+      return 0;
+
+   size = fread(db_state->buf, 1, DB_HASH_CHUNK_SIZE, db_state->file);
+   db_state->crc = crc32_update(db_state->crc, db_state->buf, size);
+
+   if (size == DB_HASH_CHUNK_SIZE)
+      return 1;
+
+   error = ferror(db_state->file);
+
+#ifdef POSIX_FADV_DONTNEED
+   /* Scanned files are unlikely to be read again soon. */
+   posix_fadvise(fileno(db_state->file), 0, 0, POSIX_FADV_DONTNEED);
+#endif
+
+   database_info_iterate_close(db_state);
+
+   if (error)
+      return 0;
+
+   database_scan_cache_set_crc(db_state->cache, db_state->cache_entry,
+         db_state->crc, NULL);
+
+   db->type = DATABASE_TYPE_CRC_LOOKUP;
+   return 1;
+}
+
 static int database_info_iterate_playlist(
       database_state_handle_t *db_state,
       database_info_handle_t *db, const char *name)
@@ -136,20 +362,7 @@ static int database_info_iterate_playlist(
          return 1;
 #endif
       default:
-         {
-            ssize_t ret;
-            int read_from            = read_file(name, (void**)&db_state->buf, &ret);
-
-            if (read_from != 1 || ret <= 0)
-               return 0;
-
-
-#ifdef HAVE_ZLIB
-            db_state->crc = zlib_crc32_calculate(db_state->buf, ret);
-#endif
-            db->type = DATABASE_TYPE_CRC_LOOKUP;
-         }
-         break;
+         return database_info_iterate_open(db_state, db, name);
    }
 
    return 1;
@@ -188,35 +401,68 @@ static int database_info_list_iterate_new(database_state_handle_t *db_state, con
    return 0;
 }
 
-static int database_info_list_iterate_found_match(
+static void database_playlist_flush(database_state_handle_t *db_state,
+      bool close)
+{
+   size_t i;
+
+   if (!db_state->playlist)
+      return;
+
+   if (db_state->num_matches)
+   {
+      content_playlist_push_bulk(db_state->playlist,
+            db_state->matches, db_state->num_matches);
+      content_playlist_write_file(db_state->playlist);
+   }
+
+   for (i = 0; i < db_state->num_matches; i++)
+   {
+      free(db_state->matches[i].path);
+      free(db_state->matches[i].label);
+      free(db_state->matches[i].crc32);
+      free(db_state->matches[i].db_name);
+   }
+   db_state->num_matches = 0;
+
+   if (!close)
+      return;
+
+   content_playlist_free(db_state->playlist);
+   db_state->playlist = NULL;
+}
+
+/* Queues @entry_path for the playlist @db_name, like
+ * "Nintendo - Super Nintendo Entertainment System.lpl". */
+static int database_playlist_push_match(
       database_state_handle_t *db_state,
-      database_info_handle_t *db,
-      const char *zip_name
-      )
+      const char *db_name, const char *entry_path,
+      const char *zip_name, const char *label, uint32_t crc32)
 {
    char db_crc[PATH_MAX_LENGTH]                = {0};
    char db_playlist_path[PATH_MAX_LENGTH]      = {0};
-   char  db_playlist_base_str[PATH_MAX_LENGTH] = {0};
    char entry_path_str[PATH_MAX_LENGTH]        = {0};
-   content_playlist_t   *playlist = NULL;
+   content_playlist_entry_t          *match = NULL;
    settings_t           *settings = config_get_ptr();
-   const char            *db_path = db_state->list->elems[db_state->list_index].data;
-   const char         *entry_path = db ? db->list->elems[db->list_ptr].data : NULL;
-   database_info_t *db_info_entry = &db_state->info->list[db_state->entry_index];
 
-   fill_short_pathname_representation(db_playlist_base_str,
-         db_path, sizeof(db_playlist_base_str));
-
-   path_remove_extension(db_playlist_base_str);
-
-   strlcat(db_playlist_base_str, ".lpl", sizeof(db_playlist_base_str));
    fill_pathname_join(db_playlist_path, settings->playlist_directory,
-         db_playlist_base_str, sizeof(db_playlist_path));
+         db_name, sizeof(db_playlist_path));
+
+   if (db_state->playlist &&
+         strcmp(db_state->playlist->conf_path, db_playlist_path))
+      database_playlist_flush(db_state, true);
 
-   playlist = content_playlist_init(db_playlist_path, 1000);
+   if (!db_state->playlist)
+   {
+      db_state->playlist = content_playlist_init(db_playlist_path, 1000);
+      if (!db_state->playlist)
+         return -1;
 
+      /* Only append new matches instead of rewriting the playlist. */
+      content_playlist_set_journal(db_state->playlist, true);
+   }
 
-   snprintf(db_crc, sizeof(db_crc), "%08X|crc", db_info_entry->crc32);
+   snprintf(db_crc, sizeof(db_crc), "%08X|crc", crc32);
 
    strlcpy(entry_path_str, entry_path, sizeof(entry_path_str));
 
@@ -227,23 +473,160 @@ static int database_info_list_iterate_found_match(
 #if 0
    RARCH_LOG("Found match in database !\n");
 
-   RARCH_LOG("Path: %s\n", db_path);
    RARCH_LOG("CRC : %s\n", db_crc);
    RARCH_LOG("Playlist Path: %s\n", db_playlist_path);
    RARCH_LOG("Entry Path: %s\n", entry_path);
-   RARCH_LOG("Playlist not NULL: %d\n", playlist != NULL);
    RARCH_LOG("ZIP entry: %s\n", zip_name);
    RARCH_LOG("entry path str: %s\n", entry_path_str);
 #endif
 
-   content_playlist_push(playlist, entry_path_str,
-         db_info_entry->name, "DETECT", "DETECT", db_crc, db_playlist_base_str);
+   match            = &db_state->matches[db_state->num_matches++];
+   match->path      = strdup(entry_path_str);
+   match->label     = label ? strdup(label) : NULL;
+   match->core_path = (char*)"DETECT";
+   match->core_name = (char*)"DETECT";
+   match->crc32     = strdup(db_crc);
+   match->db_name   = strdup(db_name);
+
+   if (db_state->num_matches == DB_PLAYLIST_BATCH)
+      database_playlist_flush(db_state, false);
 
-   content_playlist_write_file(playlist);
-   content_playlist_free(playlist);
    return 0;
 }
 
+static int database_info_list_iterate_found_match(
+      database_state_handle_t *db_state,
+      database_info_handle_t *db,
+      const char *zip_name
+      )
+{
+   char  db_playlist_base_str[PATH_MAX_LENGTH] = {0};
+   const char            *db_path = db_state->list->elems[db_state->list_index].data;
+   const char         *entry_path = db ? db->list->elems[db->list_ptr].data : NULL;
+   database_info_t *db_info_entry = &db_state->info->list[db_state->entry_index];
+
+   fill_short_pathname_representation(db_playlist_base_str,
+         db_path, sizeof(db_playlist_base_str));
+
+   path_remove_extension(db_playlist_base_str);
+
+   strlcat(db_playlist_base_str, ".lpl", sizeof(db_playlist_base_str));
+
+   database_scan_cache_add_match(db_state->cache, db_state->cache_entry,
+         db_playlist_base_str, db_info_entry->name, db_info_entry->crc32);
+
+   return database_playlist_push_match(db_state, db_playlist_base_str,
+         entry_path, zip_name, db_info_entry->name, db_info_entry->crc32);
+}
+
+static void database_info_push_cached(database_state_handle_t *db_state,
+      const database_scan_cache_entry_t *entry, const char *name)
+{
+   size_t i;
+
+   for (i = 0; i < entry->num_matches; i++)
+   {
+      const database_scan_cache_match_t *match = &entry->matches[i];
+
+      if (database_playlist_push_match(db_state, match->db_name, name,
+               entry->zip_name, match->label, match->crc32) != 0)
+         break;
+   }
+}
+
+/* Pushes the cached matches of files which did not change, so that
+ * rescanning an unchanged library only has to stat every file.
+ * Returns: true if that includes the last file of the list. */
+static bool database_info_iterate_skip_cached(
+      database_state_handle_t *db_state, database_info_handle_t *db)
+{
+   unsigned i;
+
+   if (!db_state->cache)
+      return false;
+
+   for (i = 0; i < DB_SCAN_CACHE_BATCH; i++)
+   {
+      struct stat st;
+      database_scan_cache_entry_t *entry = NULL;
+      const char *name = db->list->elems[db->list_ptr].data;
+
+      if (stat(name, &st) < 0)
+         return false;
+
+      entry = database_scan_cache_find(db_state->cache, name,
+            st.st_size, st.st_mtime);
+
+      if (!entry || !(entry->flags & DATABASE_SCAN_CACHE_LOOKED_UP))
+         return false;
+
+      database_info_push_cached(db_state, entry, name);
+
+      if (db->list_ptr + 1 >= db->list->size)
+         return true;
+
+      db->list_ptr++;
+   }
+
+   return false;
+}
+
+/* Takes what is known about @name from the scan cache.
+ * Returns: 0 if the file is done, 1 if a lookup of its cached CRC
+ * or serial is needed, -1 if the file has to be scanned. */
+static int database_info_iterate_cached(
+      database_state_handle_t *db_state,
+      database_info_handle_t *db, const char *name)
+{
+   struct stat st;
+   database_scan_cache_entry_t *entry = NULL;
+
+   db_state->cache_entry = NULL;
+
+   if (!db_state->cache || stat(name, &st) < 0)
+      return -1;
+
+   entry = database_scan_cache_find(db_state->cache, name,
+         st.st_size, st.st_mtime);
+
+   if (!entry)
+   {
+      db_state->cache_entry = database_scan_cache_update(db_state->cache,
+            name, st.st_size, st.st_mtime);
+      return -1;
+   }
+
+   db_state->cache_entry = entry;
+
+   if (entry->flags & DATABASE_SCAN_CACHE_LOOKED_UP)
+   {
+      database_info_push_cached(db_state, entry, name);
+      return 0;
+   }
+
+   if (entry->flags & DATABASE_SCAN_CACHE_HAS_CRC)
+   {
+      db_state->crc = entry->crc32;
+      if (entry->zip_name)
+         strlcpy(db_state->zip_name, entry->zip_name,
+               sizeof(db_state->zip_name));
+      db->type      = DATABASE_TYPE_CRC_LOOKUP;
+      return 1;
+   }
+
+   if (entry->flags & DATABASE_SCAN_CACHE_HAS_SERIAL)
+   {
+      strlcpy(db_state->serial, entry->serial, sizeof(db_state->serial));
+      db->type      = DATABASE_TYPE_SERIAL_LOOKUP;
+      return 1;
+   }
+
+   /* Cached without anything useful, scan it again. */
+   db_state->cache_entry = database_scan_cache_update(db_state->cache,
+         name, st.st_size, st.st_mtime);
+   return -1;
+}
+
 /* End of entries in database info list and didn't find a 
  * match, go to the next database. */
 static int database_info_list_iterate_next(
@@ -271,16 +654,26 @@ static int database_info_iterate_crc_lookup(
    if (db_state->entry_index == 0)
    {
       char query[50] = {0};
-      snprintf(query, sizeof(query), "{crc: b\"%08X\"}", swap_if_big32(db_state->crc));
+
+      if (db->type == DATABASE_TYPE_SERIAL_LOOKUP)
+         snprintf(query, sizeof(query), "{serial: \"%s\"}", db_state->serial);
+      else
+         snprintf(query, sizeof(query), "{crc: b\"%08X\"}", swap_if_big32(db_state->crc));
 
       database_info_list_iterate_new(db_state, query);
    }
 
-   if (db_state->info)
+   if (db_state->info && db_state->entry_index < db_state->info->count)
    {
       database_info_t *db_info_entry = &db_state->info->list[db_state->entry_index];
 
-      if (db_info_entry && db_info_entry->crc32)
+      if (db->type == DATABASE_TYPE_SERIAL_LOOKUP)
+      {
+         if (db_info_entry->serial
+               && !strcasecmp(db_state->serial, db_info_entry->serial))
+            database_info_list_iterate_found_match(db_state, db, zip_entry);
+      }
+      else if (db_info_entry->crc32)
       {
 #if 0
          RARCH_LOG("CRC32: 0x%08X , entry CRC32: 0x%08X (%s).\n",
@@ -346,11 +739,19 @@ static int database_info_iterate(database_state_handle_t *state, database_info_h
       case DATABASE_TYPE_NONE:
          break;
       case DATABASE_TYPE_ITERATE:
+         {
+            int ret = database_info_iterate_cached(state, db, name);
+            if (ret >= 0)
+               return ret;
+         }
          return database_info_iterate_playlist(state, db, name);
       case DATABASE_TYPE_ITERATE_ZIP:
          return database_info_iterate_playlist_zip(state, db, name);
+      case DATABASE_TYPE_HASH:
+         return database_info_iterate_hash(state, db);
       case DATABASE_TYPE_CRC_LOOKUP:
-         return database_info_iterate_crc_lookup(state, db, NULL);
+      case DATABASE_TYPE_SERIAL_LOOKUP:
+         return database_info_iterate_crc_lookup(state, db, state->zip_name);
    }
 
    return 0;
@@ -376,6 +777,8 @@ static int database_info_poll(db_handle_t *db)
    if (str_list->size > 1)
       cb_type_hash = msg_hash_calculate(str_list->elems[1].data);
 
+   db->state.scan_dir[0] = '\0';
+
    switch (cb_type_hash)
    {
       case CB_DB_SCAN_FILE:
@@ -383,6 +786,7 @@ static int database_info_poll(db_handle_t *db)
          break;
       case CB_DB_SCAN_FOLDER:
          db->handle = database_info_dir_init(elem0, DATABASE_TYPE_ITERATE);
+         strlcpy(db->state.scan_dir, elem0, sizeof(db->state.scan_dir));
          break;
    }
 
@@ -402,9 +806,65 @@ static void rarch_main_data_db_cleanup_state(database_state_handle_t *db_state)
    if (!db_state)
       return;
 
-   if (db_state->buf)
-      free(db_state->buf);
-   db_state->buf = NULL;
+   database_info_iterate_close(db_state);
+   db_state->serial[0]   = '\0';
+   db_state->zip_name[0] = '\0';
+   db_state->cache_entry = NULL;
+}
+
+/* Sums up the databases, matches cached with other databases
+ * are not used. */
+static uint32_t database_info_signature(const struct string_list *list)
+{
+   size_t i;
+   uint32_t signature = 0;
+
+   for (i = 0; list && i < list->size; i++)
+   {
+      struct stat st;
+      uint64_t meta[2] = {0};
+      const char *path = list->elems[i].data;
+
+      if (stat(path, &st) == 0)
+      {
+         meta[0] = st.st_size;
+         meta[1] = st.st_mtime;
+      }
+
+      signature = crc32_update(signature, (const uint8_t*)path, strlen(path));
+      signature = crc32_update(signature, (const uint8_t*)meta, sizeof(meta));
+   }
+
+   return signature;
+}
+
+static void rarch_main_data_db_cache_open(database_state_handle_t *db_state)
+{
+   char path[PATH_MAX_LENGTH] = {0};
+   settings_t *settings       = config_get_ptr();
+
+   if (db_state->cache || !*settings->content_database)
+      return;
+
+   fill_pathname_join(path, settings->content_database,
+         DB_SCAN_CACHE_FILE, sizeof(path));
+
+   db_state->cache = database_scan_cache_new(path,
+         database_info_signature(db_state->list));
+}
+
+static void rarch_main_data_db_cache_close(database_state_handle_t *db_state)
+{
+   if (!db_state->cache)
+      return;
+
+   if (!database_scan_cache_write(db_state->cache))
+      RARCH_WARN("Could not write scan cache to %s.\n",
+            config_get_ptr()->content_database);
+
+   database_scan_cache_free(db_state->cache);
+   db_state->cache       = NULL;
+   db_state->cache_entry = NULL;
 }
 
 void rarch_main_data_db_iterate(bool is_thread)
@@ -421,17 +881,32 @@ void rarch_main_data_db_iterate(bool is_thread)
       case DATABASE_STATUS_ITERATE_BEGIN:
          if (db_state && !db_state->list)
             db_state->list = dir_list_new_special(NULL, DIR_LIST_DATABASES);
+         rarch_main_data_db_cache_open(db_state);
          db->status = DATABASE_STATUS_ITERATE_START;
          break;
       case DATABASE_STATUS_ITERATE_START:
          rarch_main_data_db_cleanup_state(db_state);
          db_state->list_index  = 0;
          db_state->entry_index = 0;
-         database_info_iterate_start(db, name);
+         if (database_info_iterate_skip_cached(db_state, db))
+         {
+            db->status = DATABASE_STATUS_ITERATE_NEXT;
+            break;
+         }
+         database_info_iterate_start(db, db->list->elems[db->list_ptr].data);
          break;
       case DATABASE_STATUS_ITERATE:
          if (database_info_iterate(&db_ptr->state, db) == 0)
          {
+            database_scan_cache_entry_t *entry = db_state->cache_entry;
+
+            /* Remember that every database was searched, so
+             * the file can be skipped until it changes. */
+            if (entry && (entry->flags & (DATABASE_SCAN_CACHE_HAS_CRC
+                        | DATABASE_SCAN_CACHE_HAS_SERIAL)))
+               database_scan_cache_set_looked_up(db_state->cache, entry);
+            db_state->cache_entry = NULL;
+
             db->status = DATABASE_STATUS_ITERATE_NEXT;
             db->type   = DATABASE_TYPE_ITERATE;
          }
@@ -444,16 +919,24 @@ void rarch_main_data_db_iterate(bool is_thread)
          }
          else
          {
+            /* Only a finished scan knows which files are gone. */
+            db_state->cache_entry = NULL;
+            database_scan_cache_prune(db_state->cache, db_state->scan_dir);
+            database_playlist_flush(db_state, true);
             rarch_main_msg_queue_push_new(MSG_SCANNING_OF_DIRECTORY_FINISHED, 0, 180, true);
             pending_scan_finished = true;
             db->status = DATABASE_STATUS_FREE;
          }
          break;
       case DATABASE_STATUS_FREE:
+         database_playlist_flush(db_state, true);
          if (db_state->list)
             dir_list_free(db_state->list);
          db_state->list = NULL;
          rarch_main_data_db_cleanup_state(db_state);
+         rarch_main_data_db_cache_close(db_state);
+         free(db_state->buf);
+         db_state->buf = NULL;
          database_info_free(db);
          if (db_ptr->handle)
             free(db_ptr->handle);
@@ -501,7 +984,12 @@ msg_queue_t *rarch_main_data_db_get_msg_queue_ptr(void)
 void rarch_main_data_db_uninit(void)
 {
    if (db_ptr)
+   {
+      rarch_main_data_db_cleanup_state(&db_ptr->state);
+      rarch_main_data_db_cache_close(&db_ptr->state);
+      free(db_ptr->state.buf);
       free(db_ptr);
+   }
    db_ptr = NULL;
    pending_scan_finished = false;
 }
@@ -0,0 +1,370 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <compat/strl.h>
+#include <file/dir_list.h>
+#include <string/string_list.h>
+#include <retro_miscellaneous.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "tasks.h"
+
+/* Directory entries read per step. The first step is done right
+ * away, so directories smaller than this never show up partially. */
+#define DIR_LIST_TASK_BATCH      1024
+
+/* Number of complete listings kept around. */
+#define DIR_LIST_TASK_CACHE_SIZE 4
+
+typedef struct dir_list_task_key
+{
+   char dir[PATH_MAX_LENGTH];
+   char exts[PATH_MAX_LENGTH];
+   bool has_exts;
+   bool include_dirs;
+   int64_t mtime;
+} dir_list_task_key_t;
+
+typedef struct dir_list_task_cache_entry
+{
+   dir_list_task_key_t key;
+   struct string_list *list;
+   unsigned last_use;
+} dir_list_task_cache_entry_t;
+
+typedef struct dir_list_task
+{
+   /* Listing being read in the background. */
+   dir_list_task_key_t key;
+   dir_list_handle_t *handle;
+   struct string_list *list;
+   size_t refresh_size;
+
+   dir_list_task_cache_entry_t cache[DIR_LIST_TASK_CACHE_SIZE];
+   unsigned use_count;
+
+   bool pending_refresh;
+
+#ifdef HAVE_THREADS
+   slock_t *lock;
+#endif
+} dir_list_task_t;
+
+static dir_list_task_t *dir_list_task_ptr;
+
+static void dir_list_task_lock(dir_list_task_t *task)
+{
+#ifdef HAVE_THREADS
+   slock_lock(task->lock);
+#endif
+}
+
+static void dir_list_task_unlock(dir_list_task_t *task)
+{
+#ifdef HAVE_THREADS
+   slock_unlock(task->lock);
+#endif
+}
+
+static bool dir_list_task_key_init(dir_list_task_key_t *key,
+      const char *dir, const char *exts, bool include_dirs)
+{
+   struct stat st;
+
+   memset(key, 0, sizeof(*key));
+
+   if (stat(dir, &st) < 0)
+      return false;
+
+   strlcpy(key->dir, dir, sizeof(key->dir));
+   if (exts)
+      strlcpy(key->exts, exts, sizeof(key->exts));
+   key->has_exts     = exts != NULL;
+   key->include_dirs = include_dirs;
+   key->mtime        = st.st_mtime;
+
+   return true;
+}
+
+static bool dir_list_task_key_equal(const dir_list_task_key_t *a,
+      const dir_list_task_key_t *b)
+{
+   return a->mtime == b->mtime
+      && a->has_exts == b->has_exts
+      && a->include_dirs == b->include_dirs
+      && !strcmp(a->dir, b->dir)
+      && !strcmp(a->exts, b->exts);
+}
+
+static struct string_list *dir_list_task_copy(const struct string_list *list)
+{
+   size_t i;
+   struct string_list *copy = string_list_new();
+
+   if (!copy)
+      return NULL;
+
+   for (i = 0; i < list->size; i++)
+   {
+      if (!string_list_append(copy, list->elems[i].data,
+               list->elems[i].attr))
+      {
+         string_list_free(copy);
+         return NULL;
+      }
+   }
+
+   return copy;
+}
+
+static void dir_list_task_cancel(dir_list_task_t *task)
+{
+   dir_list_close(task->handle);
+   string_list_free(task->list);
+   task->handle = NULL;
+   task->list   = NULL;
+}
+
+static dir_list_task_cache_entry_t *dir_list_task_cache_find(
+      dir_list_task_t *task, const dir_list_task_key_t *key)
+{
+   unsigned i;
+
+   for (i = 0; i < DIR_LIST_TASK_CACHE_SIZE; i++)
+   {
+      dir_list_task_cache_entry_t *entry = &task->cache[i];
+
+      if (!entry->list || !dir_list_task_key_equal(&entry->key, key))
+         continue;
+
+      entry->last_use = ++task->use_count;
+      return entry;
+   }
+
+   return NULL;
+}
+
+/* Moves the finished background listing into the cache,
+ * replacing the least recently used entry. */
+static void dir_list_task_finish(dir_list_task_t *task)
+{
+   unsigned i;
+   dir_list_task_cache_entry_t *entry = &task->cache[0];
+
+   for (i = 1; i < DIR_LIST_TASK_CACHE_SIZE; i++)
+   {
+      if (task->cache[i].last_use < entry->last_use)
+         entry = &task->cache[i];
+   }
+
+   string_list_free(entry->list);
+   entry->key      = task->key;
+   entry->list     = task->list;
+   entry->last_use = ++task->use_count;
+
+   dir_list_close(task->handle);
+   task->handle = NULL;
+   task->list   = NULL;
+}
+
+/* Reads the next batch of the background listing.
+ * Returns true if the listing changed. */
+static bool dir_list_task_step(dir_list_task_t *task)
+{
+   size_t size = task->list->size;
+
+   switch (dir_list_iterate(task->handle, task->list,
+            DIR_LIST_TASK_BATCH))
+   {
+      case 1:
+         break;
+      case 0:
+         dir_list_task_finish(task);
+         return true;
+      default:
+         dir_list_task_cancel(task);
+         return true;
+   }
+
+   return task->list->size != size;
+}
+
+/**
+ * rarch_main_data_dir_list_get:
+ * @dir          : directory path.
+ * @exts         : allowed extensions of file directory entries to include.
+ * @include_dirs : include directories as part of the directory listing?
+ * @complete     : set to false if the listing is still being read.
+ *
+ * Gets a directory listing like dir_list_new(), but reads large
+ * directories in the background. Until that is done, the entries
+ * read so far are returned and rarch_main_data_dir_list_pending_refresh()
+ * signals when there are more. Complete listings are cached until
+ * the modification time of the directory changes.
+ *
+ * Returns: copy of the directory listing on success, NULL if the
+ * directory cannot be read. Has to be freed manually.
+ **/
+struct string_list *rarch_main_data_dir_list_get(const char *dir,
+      const char *exts, bool include_dirs, bool *complete)
+{
+   dir_list_task_key_t key;
+   dir_list_task_cache_entry_t *entry = NULL;
+   struct string_list *list           = NULL;
+   dir_list_task_t *task              = dir_list_task_ptr;
+
+   *complete = true;
+
+   if (!task)
+      return dir_list_new(dir, exts, include_dirs);
+
+   if (!dir_list_task_key_init(&key, dir, exts, include_dirs))
+      return NULL;
+
+   dir_list_task_lock(task);
+
+   if ((entry = dir_list_task_cache_find(task, &key)))
+   {
+      list = dir_list_task_copy(entry->list);
+      goto end;
+   }
+
+   if (!task->handle || !dir_list_task_key_equal(&task->key, &key))
+   {
+      dir_list_task_cancel(task);
+
+      task->key          = key;
+      task->refresh_size = DIR_LIST_TASK_BATCH;
+      task->handle       = dir_list_open(dir, exts, include_dirs);
+      task->list         = string_list_new();
+
+      if (!task->handle || !task->list)
+      {
+         dir_list_task_cancel(task);
+         goto end;
+      }
+
+      /* Small directories are done after the first step
+       * and end up in the cache right away. */
+      dir_list_task_step(task);
+
+      if (!task->handle)
+      {
+         if ((entry = dir_list_task_cache_find(task, &key)))
+            list = dir_list_task_copy(entry->list);
+         goto end;
+      }
+   }
+
+   list      = dir_list_task_copy(task->list);
+   *complete = false;
+
+end:
+   dir_list_task_unlock(task);
+   return list;
+}
+
+void rarch_main_data_dir_list_iterate(bool is_thread)
+{
+   dir_list_task_t *task = dir_list_task_ptr;
+
+   if (!task || !task->handle)
+      return;
+
+   dir_list_task_lock(task);
+
+   if (task->handle && dir_list_task_step(task))
+   {
+      /* Refreshing rebuilds the whole menu list, so only do that
+       * whenever the listing has doubled, and once it is done. */
+      if (!task->handle || task->list->size >= task->refresh_size)
+      {
+         if (task->handle)
+            task->refresh_size = task->list->size * 2;
+         task->pending_refresh = true;
+      }
+   }
+
+   dir_list_task_unlock(task);
+}
+
+bool rarch_main_data_dir_list_pending_refresh(void)
+{
+   bool refresh;
+   dir_list_task_t *task = dir_list_task_ptr;
+
+   if (!task)
+      return false;
+
+   dir_list_task_lock(task);
+   refresh               = task->pending_refresh;
+   task->pending_refresh = false;
+   dir_list_task_unlock(task);
+
+   return refresh;
+}
+
+bool rarch_main_data_dir_list_is_active(void)
+{
+   dir_list_task_t *task = dir_list_task_ptr;
+   return task && task->handle;
+}
+
+void rarch_main_data_dir_list_uninit(void)
+{
+   unsigned i;
+   dir_list_task_t *task = dir_list_task_ptr;
+
+   if (!task)
+      return;
+
+   dir_list_task_cancel(task);
+
+   for (i = 0; i < DIR_LIST_TASK_CACHE_SIZE; i++)
+      string_list_free(task->cache[i].list);
+
+#ifdef HAVE_THREADS
+   slock_free(task->lock);
+#endif
+   free(task);
+   dir_list_task_ptr = NULL;
+}
+
+void rarch_main_data_dir_list_init(void)
+{
+   dir_list_task_t *task = (dir_list_task_t*)calloc(1, sizeof(*task));
+
+   if (!task)
+      return;
+
+#ifdef HAVE_THREADS
+   task->lock = slock_new();
+   if (!task->lock)
+   {
+      free(task);
+      return;
+   }
+#endif
+
+   dir_list_task_ptr = task;
+}
@@ -20,6 +20,7 @@
 #include <boolean.h>
 
 #include <queues/message_queue.h>
+#include <string/string_list.h>
 
 #include "../runloop_data.h"
 
@@ -105,6 +106,19 @@ void rarch_main_data_overlay_thread_init(void);
 #endif
 
 void rarch_main_data_nbio_iterate(bool is_thread);
+
+struct string_list *rarch_main_data_dir_list_get(const char *dir,
+      const char *exts, bool include_dirs, bool *complete);
+
+void rarch_main_data_dir_list_iterate(bool is_thread);
+
+bool rarch_main_data_dir_list_pending_refresh(void);
+
+bool rarch_main_data_dir_list_is_active(void);
+
+void rarch_main_data_dir_list_uninit(void);
+
+void rarch_main_data_dir_list_init(void);
     
 void data_runloop_osd_msg(const char *s, size_t len);
 
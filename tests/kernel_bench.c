@@ -0,0 +1,1137 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times the hot kernels of libretro-common and the frontend on fixed,
+ * seeded input and writes one row per kernel as CSV or JSON, so the
+ * results can be compared across commits and CPUs.
+ *
+ * Every kernel is run in rounds of a calibrated number of iterations,
+ * the best round is reported. Bytes are the input bytes handled by
+ * one iteration.
+ *
+ *    kernel_bench [--json] [--time SECONDS] [--filter PREFIX]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <boolean.h>
+#include <rhash.h>
+#include <formats/rpng.h>
+#include <file/config_file.h>
+#include <gfx/scaler/scaler.h>
+#include <gfx/scaler/pixconv.h>
+
+#include "../libretro.h"
+#include "../rewind.h"
+#include "../audio/audio_utils.h"
+#include "../audio/audio_resampler_driver.h"
+#include "../audio/audio_dsp_filter.h"
+#include "../libretro-db/libretrodb.h"
+#include "../libretro-db/rmsgpack_dom.h"
+
+#define RARCH_INTERNAL
+#include "../gfx/video_filters/2xsai.c"
+#include "../gfx/video_filters/super2xsai.c"
+#include "../gfx/video_filters/supereagle.c"
+#include "../gfx/video_filters/2xbr.c"
+#include "../gfx/video_filters/darken.c"
+#include "../gfx/video_filters/epx.c"
+#include "../gfx/video_filters/scale2x.c"
+#include "../gfx/video_filters/blargg_ntsc_snes.c"
+#include "../gfx/video_filters/lq2x.c"
+#include "../gfx/video_filters/phosphor2x.c"
+
+#include "../audio/audio_filters/echo.c"
+#include "../audio/audio_filters/eq.c"
+#include "../audio/audio_filters/chorus.c"
+#include "../audio/audio_filters/iir.c"
+#include "../audio/audio_filters/panning.c"
+#include "../audio/audio_filters/phaser.c"
+#include "../audio/audio_filters/reverb.c"
+#include "../audio/audio_filters/wahwah.c"
+
+#ifndef BENCH_COMMIT
+#define BENCH_COMMIT "unknown"
+#endif
+
+#define BENCH_ROUNDS        3
+#define BENCH_AUDIO_FRAMES  2048
+#define BENCH_WIDTH         256
+#define BENCH_HEIGHT        224
+#define BENCH_HASH_SIZE     (1024 * 1024)
+#define BENCH_STATE_SIZE    (256 * 1024)
+#define BENCH_CONFIG_LINES  1000
+#define BENCH_DB_RECORDS    20000
+#define BENCH_PNG_PATH      "kernel_bench.png"
+#define BENCH_CONFIG_PATH   "kernel_bench.cfg"
+#define BENCH_DB_PATH       "kernel_bench.rdb"
+#define BENCH_DSP_DIR       "../audio/audio_filters/"
+
+struct bench_state
+{
+   const void *param;
+   size_t bytes;
+
+   void *in;
+   void *out;
+   void *scratch;
+   size_t in_size;
+
+   void *handle;
+   const void *backend;
+   struct scaler_ctx scaler;
+   libretrodb_t db;
+};
+
+struct bench_kernel
+{
+   const char *name;
+   bool (*init)(struct bench_state *state);
+   void (*run)(struct bench_state *state);
+   void (*deinit)(struct bench_state *state);
+   const void *param;
+};
+
+static uint32_t bench_seed;
+static volatile uint32_t bench_sink;
+
+/* The audio, resampler and DSP code normally gets these from
+ * performance.c. */
+uint64_t rarch_get_cpu_features(void)
+{
+   uint64_t cpu = 0;
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("sse"))
+      cpu |= RETRO_SIMD_SSE;
+   if (__builtin_cpu_supports("sse2"))
+      cpu |= RETRO_SIMD_SSE2;
+   if (__builtin_cpu_supports("sse3"))
+      cpu |= RETRO_SIMD_SSE3;
+   if (__builtin_cpu_supports("ssse3"))
+      cpu |= RETRO_SIMD_SSSE3;
+   if (__builtin_cpu_supports("sse4.1"))
+      cpu |= RETRO_SIMD_SSE4;
+   if (__builtin_cpu_supports("sse4.2"))
+      cpu |= RETRO_SIMD_SSE42;
+   if (__builtin_cpu_supports("avx"))
+      cpu |= RETRO_SIMD_AVX;
+   if (__builtin_cpu_supports("avx2"))
+      cpu |= RETRO_SIMD_AVX2;
+#elif defined(__ARM_NEON__)
+   cpu |= RETRO_SIMD_NEON;
+#endif
+   return cpu;
+}
+
+static double bench_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static uint32_t bench_rand(void)
+{
+   bench_seed = bench_seed * 1103515245u + 12345u;
+   return bench_seed >> 8;
+}
+
+static void bench_fill(void *data, size_t size)
+{
+   size_t i;
+   for (i = 0; i < size; i++)
+      ((uint8_t*)data)[i] = bench_rand();
+}
+
+/* Pixel art like input: flat 4x4 blocks from a small palette,
+ * with some single pixel noise. */
+static void bench_fill_image(void *data, unsigned width, unsigned height,
+      unsigned bpp)
+{
+   unsigned x, y;
+   uint32_t palette[8];
+
+   for (x = 0; x < 8; x++)
+      palette[x] = bench_rand();
+
+   for (y = 0; y < height; y++)
+   {
+      for (x = 0; x < width; x++)
+      {
+         uint32_t color = palette[((x / 4) * 7 + (y / 4) * 3) & 7];
+         uint32_t noise = bench_rand();
+
+         if ((noise >> 8) % 13 == 0)
+            color = palette[noise & 7];
+
+         if (bpp == 4)
+            ((uint32_t*)data)[y * width + x] = color | 0xff000000;
+         else if (bpp == 2)
+            ((uint16_t*)data)[y * width + x] = (uint16_t)color;
+         else
+            memcpy((uint8_t*)data + (y * width + x) * 3, &color, 3);
+      }
+   }
+}
+
+static void bench_free_buffers(struct bench_state *state)
+{
+   free(state->in);
+   free(state->out);
+   free(state->scratch);
+}
+
+static bool bench_alloc_buffers(struct bench_state *state,
+      size_t in_size, size_t out_size)
+{
+   state->in      = calloc(1, in_size);
+   state->out     = calloc(1, out_size);
+   state->in_size = in_size;
+   return state->in && state->out;
+}
+
+/* audio_convert_*, bytes are those of the 16-bit samples. */
+
+static bool bench_audio_convert_init(struct bench_state *state)
+{
+   unsigned i;
+   size_t samples = BENCH_AUDIO_FRAMES * 2;
+
+   if (!bench_alloc_buffers(state, samples * sizeof(float),
+            samples * sizeof(float)))
+      return false;
+
+   audio_convert_init_simd();
+
+   for (i = 0; i < samples; i++)
+   {
+      ((int16_t*)state->out)[i] = (int16_t)bench_rand();
+      ((float*)state->in)[i]    = (int16_t)bench_rand() / 32768.0f;
+   }
+
+   state->bytes = samples * sizeof(int16_t);
+   return true;
+}
+
+static void bench_s16_to_float(struct bench_state *state)
+{
+   audio_convert_s16_to_float((float*)state->in,
+         (const int16_t*)state->out, BENCH_AUDIO_FRAMES * 2, 1.0f);
+}
+
+static void bench_s16_to_float_c(struct bench_state *state)
+{
+   audio_convert_s16_to_float_C((float*)state->in,
+         (const int16_t*)state->out, BENCH_AUDIO_FRAMES * 2, 1.0f);
+}
+
+static void bench_float_to_s16(struct bench_state *state)
+{
+   audio_convert_float_to_s16((int16_t*)state->out,
+         (const float*)state->in, BENCH_AUDIO_FRAMES * 2);
+}
+
+static void bench_float_to_s16_c(struct bench_state *state)
+{
+   audio_convert_float_to_s16_C((int16_t*)state->out,
+         (const float*)state->in, BENCH_AUDIO_FRAMES * 2);
+}
+
+/* Resamplers, 44.1 to 48 kHz. */
+
+static bool bench_resampler_init(struct bench_state *state)
+{
+   unsigned i;
+   const rarch_resampler_t *backend = NULL;
+   size_t samples = BENCH_AUDIO_FRAMES * 2;
+
+   if (!rarch_resampler_realloc(&state->handle, &backend,
+            (const char*)state->param, 1.0))
+      return false;
+   state->backend = backend;
+
+   if (!bench_alloc_buffers(state, samples * sizeof(float),
+            samples * 2 * sizeof(float)))
+      return false;
+
+   for (i = 0; i < samples; i++)
+      ((float*)state->in)[i] = (int16_t)bench_rand() / 32768.0f;
+
+   state->bytes = samples * sizeof(float);
+   return true;
+}
+
+static void bench_resampler(struct bench_state *state)
+{
+   struct resampler_data data;
+
+   data.data_in      = (const float*)state->in;
+   data.data_out     = (float*)state->out;
+   data.input_frames = BENCH_AUDIO_FRAMES;
+   data.ratio        = 48000.0 / 44100.0;
+
+   rarch_resampler_process((const rarch_resampler_t*)state->backend,
+         state->handle, &data);
+   bench_sink = data.output_frames;
+}
+
+static void bench_resampler_deinit(struct bench_state *state)
+{
+   const rarch_resampler_t *backend = (const rarch_resampler_t*)
+      state->backend;
+   rarch_resampler_freep(&backend, &state->handle);
+}
+
+/* DSP filter presets, run on fresh input every time. */
+
+static bool bench_dsp_init(struct bench_state *state)
+{
+   unsigned i;
+   char path[256];
+   size_t samples = BENCH_AUDIO_FRAMES * 2;
+
+   snprintf(path, sizeof(path), "%s%s.dsp", BENCH_DSP_DIR,
+         (const char*)state->param);
+   if (!(state->handle = rarch_dsp_filter_new(path, 44100.0f)))
+      return false;
+
+   if (!bench_alloc_buffers(state, samples * sizeof(float),
+            samples * sizeof(float)))
+      return false;
+
+   for (i = 0; i < samples; i++)
+      ((float*)state->in)[i] = (int16_t)bench_rand() / 65536.0f;
+
+   state->bytes = samples * sizeof(float);
+   return true;
+}
+
+static void bench_dsp(struct bench_state *state)
+{
+   struct rarch_dsp_data data = {0};
+
+   memcpy(state->out, state->in, state->in_size);
+   data.input        = (float*)state->out;
+   data.input_frames = BENCH_AUDIO_FRAMES;
+
+   rarch_dsp_filter_process((rarch_dsp_filter_t*)state->handle, &data);
+   bench_sink = data.output_frames;
+}
+
+static void bench_dsp_deinit(struct bench_state *state)
+{
+   rarch_dsp_filter_free((rarch_dsp_filter_t*)state->handle);
+}
+
+/* conv_* of pixconv.c */
+
+struct bench_pixconv
+{
+   void (*conv)(void *output, const void *input,
+         int width, int height, int out_stride, int in_stride);
+   unsigned in_bpp, out_bpp;
+};
+
+#define BENCH_PIXCONV(name, in_bpp, out_bpp) \
+   static const struct bench_pixconv bench_pixconv_##name = { \
+      conv_##name, in_bpp, out_bpp }
+
+BENCH_PIXCONV(0rgb1555_argb8888, 2, 4);
+BENCH_PIXCONV(0rgb1555_rgb565, 2, 2);
+BENCH_PIXCONV(rgb565_0rgb1555, 2, 2);
+BENCH_PIXCONV(rgb565_argb8888, 2, 4);
+BENCH_PIXCONV(rgba4444_argb8888, 2, 4);
+BENCH_PIXCONV(rgba4444_rgb565, 2, 2);
+BENCH_PIXCONV(bgr24_argb8888, 3, 4);
+BENCH_PIXCONV(argb8888_0rgb1555, 4, 2);
+BENCH_PIXCONV(argb8888_bgr24, 4, 3);
+BENCH_PIXCONV(argb8888_abgr8888, 4, 4);
+BENCH_PIXCONV(0rgb1555_bgr24, 2, 3);
+BENCH_PIXCONV(rgb565_bgr24, 2, 3);
+BENCH_PIXCONV(yuyv_argb8888, 2, 4);
+BENCH_PIXCONV(copy, 4, 4);
+
+static bool bench_pixconv_init(struct bench_state *state)
+{
+   const struct bench_pixconv *conv = (const struct bench_pixconv*)
+      state->param;
+
+   if (!bench_alloc_buffers(state,
+            BENCH_WIDTH * BENCH_HEIGHT * conv->in_bpp,
+            BENCH_WIDTH * BENCH_HEIGHT * conv->out_bpp))
+      return false;
+
+   bench_fill_image(state->in, BENCH_WIDTH, BENCH_HEIGHT, conv->in_bpp);
+   state->bytes = state->in_size;
+   return true;
+}
+
+static void bench_pixconv(struct bench_state *state)
+{
+   const struct bench_pixconv *conv = (const struct bench_pixconv*)
+      state->param;
+
+   conv->conv(state->out, state->in, BENCH_WIDTH, BENCH_HEIGHT,
+         BENCH_WIDTH * conv->out_bpp, BENCH_WIDTH * conv->in_bpp);
+}
+
+/* scaler_ctx_scale, to twice the size. */
+
+struct bench_scaler
+{
+   enum scaler_pix_fmt in_fmt;
+   unsigned in_bpp;
+   enum scaler_type type;
+};
+
+static const struct bench_scaler bench_scaler_point = {
+   SCALER_FMT_ARGB8888, 4, SCALER_TYPE_POINT };
+static const struct bench_scaler bench_scaler_bilinear = {
+   SCALER_FMT_ARGB8888, 4, SCALER_TYPE_BILINEAR };
+static const struct bench_scaler bench_scaler_sinc = {
+   SCALER_FMT_ARGB8888, 4, SCALER_TYPE_SINC };
+static const struct bench_scaler bench_scaler_rgb565_bilinear = {
+   SCALER_FMT_RGB565, 2, SCALER_TYPE_BILINEAR };
+
+static bool bench_scaler_init(struct bench_state *state)
+{
+   const struct bench_scaler *param = (const struct bench_scaler*)
+      state->param;
+   struct scaler_ctx *ctx = &state->scaler;
+
+   if (!bench_alloc_buffers(state,
+            BENCH_WIDTH * BENCH_HEIGHT * param->in_bpp,
+            BENCH_WIDTH * BENCH_HEIGHT * 4 * 4))
+      return false;
+
+   bench_fill_image(state->in, BENCH_WIDTH, BENCH_HEIGHT, param->in_bpp);
+
+   ctx->in_width    = BENCH_WIDTH;
+   ctx->in_height   = BENCH_HEIGHT;
+   ctx->in_stride   = BENCH_WIDTH * param->in_bpp;
+   ctx->in_fmt      = param->in_fmt;
+   ctx->out_width   = BENCH_WIDTH * 2;
+   ctx->out_height  = BENCH_HEIGHT * 2;
+   ctx->out_stride  = BENCH_WIDTH * 2 * 4;
+   ctx->out_fmt     = SCALER_FMT_ARGB8888;
+   ctx->scaler_type = param->type;
+
+   state->bytes = state->in_size;
+   return scaler_ctx_gen_filter(ctx);
+}
+
+static void bench_scaler(struct bench_state *state)
+{
+   scaler_ctx_scale(&state->scaler, state->out, state->in);
+}
+
+static void bench_scaler_deinit(struct bench_state *state)
+{
+   scaler_ctx_gen_reset(&state->scaler);
+}
+
+/* Softfilters, single threaded. Some of them read a pixel or two
+ * around the frame, which stays inside the rows of padding. */
+
+#define BENCH_SOFTFILTER_PAD 2
+
+struct bench_softfilter
+{
+   softfilter_get_implementation_t get_implementation;
+   unsigned fmt;
+};
+
+#define BENCH_SOFTFILTER_RGB565(name, impl) \
+   static const struct bench_softfilter bench_softfilter_##name##_rgb565 = { \
+      impl##_get_implementation, SOFTFILTER_FMT_RGB565 }
+#define BENCH_SOFTFILTER(name, impl) \
+   BENCH_SOFTFILTER_RGB565(name, impl); \
+   static const struct bench_softfilter bench_softfilter_##name##_xrgb8888 = { \
+      impl##_get_implementation, SOFTFILTER_FMT_XRGB8888 }
+
+BENCH_SOFTFILTER(2xsai, twoxsai);
+BENCH_SOFTFILTER(super2xsai, supertwoxsai);
+BENCH_SOFTFILTER(supereagle, supereagle);
+BENCH_SOFTFILTER(2xbr, twoxbr);
+BENCH_SOFTFILTER(darken, darken);
+BENCH_SOFTFILTER_RGB565(epx, epx);
+BENCH_SOFTFILTER(scale2x, scale2x);
+BENCH_SOFTFILTER_RGB565(blargg_ntsc_snes, blargg_ntsc_snes);
+BENCH_SOFTFILTER(lq2x, lq2x);
+BENCH_SOFTFILTER(phosphor2x, phosphor2x);
+
+static int bench_get_float(void *userdata, const char *key,
+      float *value, float default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int bench_get_int(void *userdata, const char *key,
+      int *value, int default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int bench_get_float_array(void *userdata, const char *key,
+      float **values, unsigned *out_num_values,
+      const float *default_values, unsigned num_default_values)
+{
+   *values = (float*)malloc(num_default_values * sizeof(float));
+   memcpy(*values, default_values, num_default_values * sizeof(float));
+   *out_num_values = num_default_values;
+   return 0;
+}
+
+static int bench_get_int_array(void *userdata, const char *key,
+      int **values, unsigned *out_num_values,
+      const int *default_values, unsigned num_default_values)
+{
+   *values = (int*)malloc(num_default_values * sizeof(int));
+   memcpy(*values, default_values, num_default_values * sizeof(int));
+   *out_num_values = num_default_values;
+   return 0;
+}
+
+static int bench_get_string(void *userdata, const char *key,
+      char **output, const char *default_output)
+{
+   *output = strdup(default_output);
+   return 0;
+}
+
+static const struct softfilter_config bench_softfilter_config = {
+   bench_get_float,
+   bench_get_int,
+   bench_get_float_array,
+   bench_get_int_array,
+   bench_get_string,
+   free,
+};
+
+static bool bench_softfilter_init(struct bench_state *state)
+{
+   unsigned out_width, out_height;
+   const struct bench_softfilter *param = (const struct bench_softfilter*)
+      state->param;
+   const struct softfilter_implementation *impl =
+      param->get_implementation(0);
+   unsigned bpp = (param->fmt == SOFTFILTER_FMT_XRGB8888) ?
+      SOFTFILTER_BPP_XRGB8888 : SOFTFILTER_BPP_RGB565;
+
+   if (!(impl->query_input_formats() & param->fmt))
+      return false;
+
+   state->backend = impl;
+   state->handle  = impl->create(&bench_softfilter_config,
+         param->fmt, param->fmt, BENCH_WIDTH, BENCH_HEIGHT, 1, 0, NULL);
+   if (!state->handle)
+      return false;
+
+   impl->query_output_size(state->handle, &out_width, &out_height,
+         BENCH_WIDTH, BENCH_HEIGHT);
+
+   /* Room for the work packets, then the output. */
+   state->scratch = calloc(impl->query_num_threads(state->handle),
+         sizeof(struct softfilter_work_packet));
+   if (!state->scratch || !bench_alloc_buffers(state,
+            BENCH_WIDTH * (BENCH_HEIGHT + 2 * BENCH_SOFTFILTER_PAD) * bpp,
+            out_width * out_height * bpp))
+      return false;
+
+   bench_fill_image(state->in, BENCH_WIDTH,
+         BENCH_HEIGHT + 2 * BENCH_SOFTFILTER_PAD, bpp);
+   if (bpp == 4)
+   {
+      unsigned i;
+      for (i = 0; i < state->in_size / 4; i++)
+         ((uint32_t*)state->in)[i] &= 0xffffff;
+   }
+
+   state->bytes = BENCH_WIDTH * BENCH_HEIGHT * bpp;
+   return true;
+}
+
+static void bench_softfilter(struct bench_state *state)
+{
+   unsigned i, out_width, out_height;
+   const struct bench_softfilter *param = (const struct bench_softfilter*)
+      state->param;
+   const struct softfilter_implementation *impl =
+      (const struct softfilter_implementation*)state->backend;
+   struct softfilter_work_packet *packets =
+      (struct softfilter_work_packet*)state->scratch;
+   unsigned bpp = (param->fmt == SOFTFILTER_FMT_XRGB8888) ?
+      SOFTFILTER_BPP_XRGB8888 : SOFTFILTER_BPP_RGB565;
+
+   impl->query_output_size(state->handle, &out_width, &out_height,
+         BENCH_WIDTH, BENCH_HEIGHT);
+   impl->get_work_packets(state->handle, packets,
+         state->out, out_width * bpp,
+         (uint8_t*)state->in + BENCH_SOFTFILTER_PAD * BENCH_WIDTH * bpp,
+         BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH * bpp);
+
+   for (i = 0; i < impl->query_num_threads(state->handle); i++)
+      if (packets[i].work)
+         packets[i].work(state->handle, packets[i].thread_data);
+}
+
+static void bench_softfilter_deinit(struct bench_state *state)
+{
+   const struct softfilter_implementation *impl =
+      (const struct softfilter_implementation*)state->backend;
+
+   if (impl && state->handle)
+      impl->destroy(state->handle);
+}
+
+/* Rewind: a savestate with a few changed regions per frame. */
+
+static bool bench_rewind_init(struct bench_state *state)
+{
+   unsigned i;
+
+   state->in      = state_manager_raw_alloc(BENCH_STATE_SIZE, 0);
+   state->out     = state_manager_raw_alloc(BENCH_STATE_SIZE, 1);
+   state->scratch = malloc(state_manager_raw_maxsize(BENCH_STATE_SIZE));
+   if (!state->in || !state->out || !state->scratch)
+      return false;
+
+   bench_fill(state->in, BENCH_STATE_SIZE);
+   memcpy(state->out, state->in, BENCH_STATE_SIZE);
+
+   /* About 2% of the state changes, in short runs. */
+   for (i = 0; i < BENCH_STATE_SIZE / 50 / 16; i++)
+   {
+      size_t offset = bench_rand() % (BENCH_STATE_SIZE - 16);
+      bench_fill((uint8_t*)state->out + offset, 16);
+   }
+
+   state->in_size = state_manager_raw_compress(state->in, state->out,
+         BENCH_STATE_SIZE, state->scratch);
+   state->bytes   = BENCH_STATE_SIZE;
+   return true;
+}
+
+static void bench_rewind_compress(struct bench_state *state)
+{
+   bench_sink = state_manager_raw_compress(state->in, state->out,
+         BENCH_STATE_SIZE, state->scratch);
+}
+
+static void bench_rewind_decompress(struct bench_state *state)
+{
+   state_manager_raw_decompress(state->scratch, state->in_size,
+         state->out, BENCH_STATE_SIZE);
+}
+
+/* Hashes */
+
+static bool bench_hash_init(struct bench_state *state)
+{
+   if (!bench_alloc_buffers(state, BENCH_HASH_SIZE, 1))
+      return false;
+   bench_fill(state->in, BENCH_HASH_SIZE);
+   state->bytes = BENCH_HASH_SIZE;
+   return true;
+}
+
+static void bench_crc32(struct bench_state *state)
+{
+   bench_sink = crc32_calculate((const uint8_t*)state->in, BENCH_HASH_SIZE);
+}
+
+static void bench_md5(struct bench_state *state)
+{
+   uint8_t digest[16];
+   struct md5_context md5;
+
+   md5_init(&md5);
+   md5_update(&md5, state->in, BENCH_HASH_SIZE);
+   md5_final(&md5, digest);
+   bench_sink = digest[0];
+}
+
+static void bench_sha1(struct bench_state *state)
+{
+   uint8_t digest[20];
+   struct sha1_context sha1;
+
+   sha1_init(&sha1);
+   sha1_update(&sha1, state->in, BENCH_HASH_SIZE);
+   sha1_final(&sha1, digest);
+   bench_sink = digest[0];
+}
+
+/* rpng, reading and decoding a file. */
+
+static bool bench_rpng_init(struct bench_state *state)
+{
+   if (!bench_alloc_buffers(state, BENCH_WIDTH * BENCH_HEIGHT * 4, 1))
+      return false;
+
+   bench_fill_image(state->in, BENCH_WIDTH, BENCH_HEIGHT, 4);
+   state->bytes = state->in_size;
+
+   return rpng_save_image_argb(BENCH_PNG_PATH, (const uint32_t*)state->in,
+         BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH * 4);
+}
+
+static void bench_rpng(struct bench_state *state)
+{
+   unsigned width, height;
+   uint32_t *data = NULL;
+
+   if (rpng_load_image_argb(BENCH_PNG_PATH, &data, &width, &height))
+      bench_sink = data[0];
+   free(data);
+}
+
+static void bench_rpng_deinit(struct bench_state *state)
+{
+   remove(BENCH_PNG_PATH);
+}
+
+/* config_file, loading a file like retroarch.cfg. */
+
+static bool bench_config_init(struct bench_state *state)
+{
+   unsigned i;
+   FILE *file = fopen(BENCH_CONFIG_PATH, "wb");
+
+   if (!file)
+      return false;
+
+   for (i = 0; i < BENCH_CONFIG_LINES; i++)
+   {
+      if (i % 4 == 0)
+         fprintf(file, "# Setting number %u.\n", i);
+      fprintf(file, "setting_%u_%08x = \"value %u\"\n", i, bench_rand(), i);
+   }
+
+   state->bytes = ftell(file);
+   fclose(file);
+   return true;
+}
+
+static void bench_config(struct bench_state *state)
+{
+   config_file_t *conf = config_file_new(BENCH_CONFIG_PATH);
+   bench_sink = conf != NULL;
+   config_file_free(conf);
+}
+
+static void bench_config_deinit(struct bench_state *state)
+{
+   remove(BENCH_CONFIG_PATH);
+}
+
+/* libretrodb, scanning a synthetic database with and without a query. */
+
+struct bench_db_provider
+{
+   unsigned i;
+   char strings[4][64];
+   uint8_t crc[4];
+   struct rmsgpack_dom_pair pairs[5];
+};
+
+static void bench_db_set_string(struct rmsgpack_dom_value *v, char *s)
+{
+   v->type            = RDT_STRING;
+   v->val.string.len  = strlen(s);
+   v->val.string.buff = s;
+}
+
+static int bench_db_value_provider(void *ctx, struct rmsgpack_dom_value *out)
+{
+   unsigned j;
+   static const char *keys[] = {
+      "name", "description", "rom_name", "serial", "crc"
+   };
+   struct bench_db_provider *p = (struct bench_db_provider*)ctx;
+
+   if (p->i == BENCH_DB_RECORDS)
+   {
+      out->type = RDT_NULL;
+      return 1;
+   }
+
+   snprintf(p->strings[0], 64, "Game %u", p->i);
+   snprintf(p->strings[1], 64, "Game %u (USA) (Rev %u)", p->i, p->i % 3);
+   snprintf(p->strings[2], 64, "Game %u (USA).bin", p->i);
+   snprintf(p->strings[3], 64, "SLUS-%05u", p->i);
+
+   for (j = 0; j < 4; j++)
+      p->crc[j] = (uint8_t)(p->i >> (24 - j * 8));
+
+   for (j = 0; j < 5; j++)
+      bench_db_set_string(&p->pairs[j].key, (char*)keys[j]);
+   for (j = 0; j < 4; j++)
+      bench_db_set_string(&p->pairs[j].value, p->strings[j]);
+   p->pairs[4].value.type            = RDT_BINARY;
+   p->pairs[4].value.val.binary.len  = 4;
+   p->pairs[4].value.val.binary.buff = (char*)p->crc;
+
+   out->type          = RDT_MAP;
+   out->val.map.len   = 5;
+   out->val.map.items = p->pairs;
+
+   p->i++;
+   return 0;
+}
+
+static bool bench_db_init(struct bench_state *state)
+{
+   struct bench_db_provider provider;
+   const char *query = (const char*)state->param;
+   const char *error = NULL;
+   FILE *file        = fopen(BENCH_DB_PATH, "wb");
+
+   if (!file)
+      return false;
+
+   memset(&provider, 0, sizeof(provider));
+   libretrodb_create(file, bench_db_value_provider, &provider);
+   fseek(file, 0, SEEK_END);
+   state->bytes = ftell(file);
+   fclose(file);
+
+   if (libretrodb_open(BENCH_DB_PATH, &state->db) != 0)
+      return false;
+
+   if (query)
+   {
+      state->handle = libretrodb_query_compile(&state->db, query,
+            strlen(query), &error);
+      if (error)
+         return false;
+   }
+
+   return true;
+}
+
+static void bench_db(struct bench_state *state)
+{
+   libretrodb_cursor_t cursor;
+   struct rmsgpack_dom_value item;
+   unsigned matches = 0;
+
+   if (libretrodb_cursor_open(&state->db, &cursor,
+            (libretrodb_query_t*)state->handle) != 0)
+      return;
+
+   while (libretrodb_cursor_read_item(&cursor, &item) == 0)
+      matches++;
+
+   libretrodb_cursor_close(&cursor);
+   bench_sink = matches;
+}
+
+static void bench_db_deinit(struct bench_state *state)
+{
+   if (state->handle)
+      libretrodb_query_free(state->handle);
+   if (state->db.fp)
+      libretrodb_close(&state->db);
+   remove(BENCH_DB_PATH);
+}
+
+#define BENCH_AUDIO_CONVERT(name, run) \
+   { "audio_convert/" name, bench_audio_convert_init, run, NULL, NULL }
+#define BENCH_RESAMPLER(ident) \
+   { "resampler/" ident, bench_resampler_init, bench_resampler, \
+      bench_resampler_deinit, ident }
+#define BENCH_DSP(preset) \
+   { "dsp/" preset, bench_dsp_init, bench_dsp, bench_dsp_deinit, preset }
+#define BENCH_CONV(name) \
+   { "pixconv/" #name, bench_pixconv_init, bench_pixconv, NULL, \
+      &bench_pixconv_##name }
+#define BENCH_SCALER(name) \
+   { "scaler/" #name, bench_scaler_init, bench_scaler, \
+      bench_scaler_deinit, &bench_scaler_##name }
+#define BENCH_FILTER_RGB565(name) \
+   { "softfilter/" #name "/rgb565", bench_softfilter_init, \
+      bench_softfilter, bench_softfilter_deinit, \
+      &bench_softfilter_##name##_rgb565 }
+#define BENCH_FILTER(name) \
+   BENCH_FILTER_RGB565(name), \
+   { "softfilter/" #name "/xrgb8888", bench_softfilter_init, \
+      bench_softfilter, bench_softfilter_deinit, \
+      &bench_softfilter_##name##_xrgb8888 }
+#define BENCH_DB(name, query) \
+   { "libretrodb/" name, bench_db_init, bench_db, bench_db_deinit, query }
+
+static const struct bench_kernel bench_kernels[] = {
+   BENCH_AUDIO_CONVERT("s16_to_float", bench_s16_to_float),
+   BENCH_AUDIO_CONVERT("s16_to_float_c", bench_s16_to_float_c),
+   BENCH_AUDIO_CONVERT("float_to_s16", bench_float_to_s16),
+   BENCH_AUDIO_CONVERT("float_to_s16_c", bench_float_to_s16_c),
+
+   BENCH_RESAMPLER("sinc"),
+   BENCH_RESAMPLER("CC"),
+   BENCH_RESAMPLER("nearest"),
+
+   BENCH_DSP("BassBoost"),
+   BENCH_DSP("Chorus"),
+   BENCH_DSP("EQ"),
+   BENCH_DSP("Echo"),
+   BENCH_DSP("EchoReverb"),
+   BENCH_DSP("HighShelfDampen"),
+   BENCH_DSP("IIR"),
+   BENCH_DSP("Panning"),
+   BENCH_DSP("Phaser"),
+   BENCH_DSP("Reverb"),
+   BENCH_DSP("WahWah"),
+
+   BENCH_CONV(0rgb1555_argb8888),
+   BENCH_CONV(0rgb1555_rgb565),
+   BENCH_CONV(rgb565_0rgb1555),
+   BENCH_CONV(rgb565_argb8888),
+   BENCH_CONV(rgba4444_argb8888),
+   BENCH_CONV(rgba4444_rgb565),
+   BENCH_CONV(bgr24_argb8888),
+   BENCH_CONV(argb8888_0rgb1555),
+   BENCH_CONV(argb8888_bgr24),
+   BENCH_CONV(argb8888_abgr8888),
+   BENCH_CONV(0rgb1555_bgr24),
+   BENCH_CONV(rgb565_bgr24),
+   BENCH_CONV(yuyv_argb8888),
+   BENCH_CONV(copy),
+
+   BENCH_SCALER(point),
+   BENCH_SCALER(bilinear),
+   BENCH_SCALER(sinc),
+   BENCH_SCALER(rgb565_bilinear),
+
+   BENCH_FILTER(2xsai),
+   BENCH_FILTER(super2xsai),
+   BENCH_FILTER(supereagle),
+   BENCH_FILTER(2xbr),
+   BENCH_FILTER(darken),
+   BENCH_FILTER_RGB565(epx),
+   BENCH_FILTER(scale2x),
+   BENCH_FILTER_RGB565(blargg_ntsc_snes),
+   BENCH_FILTER(lq2x),
+   BENCH_FILTER(phosphor2x),
+
+   { "rewind/compress", bench_rewind_init, bench_rewind_compress,
+      NULL, NULL },
+   { "rewind/decompress", bench_rewind_init, bench_rewind_decompress,
+      NULL, NULL },
+
+   { "hash/crc32", bench_hash_init, bench_crc32, NULL, NULL },
+   { "hash/md5", bench_hash_init, bench_md5, NULL, NULL },
+   { "hash/sha1", bench_hash_init, bench_sha1, NULL, NULL },
+
+   { "rpng/load_argb", bench_rpng_init, bench_rpng, bench_rpng_deinit,
+      NULL },
+
+   { "config_file/load", bench_config_init, bench_config,
+      bench_config_deinit, NULL },
+
+   BENCH_DB("scan", NULL),
+   BENCH_DB("query_crc", "{'crc':b'00004E1F'}"),
+   BENCH_DB("query_glob", "{'name':glob('Game 1999*')}"),
+};
+
+/* Returns seconds per iteration, best of BENCH_ROUNDS rounds which
+ * take about @round_time each. */
+static double bench_measure(const struct bench_kernel *kernel,
+      struct bench_state *state, double round_time, unsigned *iterations)
+{
+   unsigned i, round;
+   unsigned count = 1;
+   double best    = 0.0;
+
+   /* Warm up, then find an iteration count filling a round. */
+   kernel->run(state);
+
+   for (;;)
+   {
+      double start = bench_time();
+      double elapsed;
+
+      for (i = 0; i < count; i++)
+         kernel->run(state);
+
+      elapsed = bench_time() - start;
+      if (elapsed >= round_time / 4 || count >= (1u << 30))
+      {
+         if (elapsed > 0.0 && elapsed < round_time)
+            count = (unsigned)(count * (round_time / elapsed)) + 1;
+         break;
+      }
+
+      count *= 2;
+   }
+
+   for (round = 0; round < BENCH_ROUNDS; round++)
+   {
+      double start = bench_time();
+      double per_iteration;
+
+      for (i = 0; i < count; i++)
+         kernel->run(state);
+
+      per_iteration = (bench_time() - start) / count;
+      if (round == 0 || per_iteration < best)
+         best = per_iteration;
+   }
+
+   *iterations = count;
+   return best;
+}
+
+static void bench_cpu_name(char *s, size_t len)
+{
+   char line[256];
+   FILE *file = fopen("/proc/cpuinfo", "rb");
+
+   snprintf(s, len, "unknown");
+   if (!file)
+      return;
+
+   while (fgets(line, sizeof(line), file))
+   {
+      char *value = strchr(line, ':');
+
+      if (strncmp(line, "model name", 10) || !value)
+         continue;
+
+      for (value++; *value == ' '; value++);
+      value[strcspn(value, "\r\n")] = '\0';
+      snprintf(s, len, "%s", value);
+      break;
+   }
+
+   fclose(file);
+}
+
+static void bench_print_string(const char *s, bool json)
+{
+   putchar('"');
+   for (; *s; s++)
+   {
+      if (*s == '"' || (json && *s == '\\'))
+         putchar(json ? '\\' : '"');
+      putchar(*s);
+   }
+   putchar('"');
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   char cpu[128];
+   int ret            = 0;
+   bool json          = false;
+   bool first         = true;
+   double round_time  = 0.05;
+   const char *filter = NULL;
+
+   for (i = 1; i < (unsigned)argc; i++)
+   {
+      if (!strcmp(argv[i], "--json"))
+         json = true;
+      else if (!strcmp(argv[i], "--time") && i + 1 < (unsigned)argc)
+         round_time = atof(argv[++i]) / BENCH_ROUNDS;
+      else if (!strcmp(argv[i], "--filter") && i + 1 < (unsigned)argc)
+         filter = argv[++i];
+      else
+      {
+         fprintf(stderr, "Usage: %s [--json] [--time SECONDS] "
+               "[--filter PREFIX]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   bench_cpu_name(cpu, sizeof(cpu));
+
+   if (json)
+   {
+      printf("{\n  \"commit\": ");
+      bench_print_string(BENCH_COMMIT, true);
+      printf(",\n  \"cpu\": ");
+      bench_print_string(cpu, true);
+      printf(",\n  \"kernels\": [");
+   }
+   else
+      printf("commit,cpu,kernel,bytes,iterations,ns_per_iteration,mb_per_s\n");
+
+   for (i = 0; i < sizeof(bench_kernels) / sizeof(*bench_kernels); i++)
+   {
+      struct bench_state state;
+      unsigned iterations = 0;
+      double seconds, mb_per_s;
+      const struct bench_kernel *kernel = &bench_kernels[i];
+
+      if (filter && strncmp(kernel->name, filter, strlen(filter)))
+         continue;
+
+      /* Every kernel sees the same input, whatever runs before it. */
+      bench_seed = 1;
+      memset(&state, 0, sizeof(state));
+      state.param = kernel->param;
+
+      if (!kernel->init(&state))
+      {
+         fprintf(stderr, "%s: failed to set up.\n", kernel->name);
+         ret = 1;
+      }
+      else
+      {
+         seconds  = bench_measure(kernel, &state, round_time, &iterations);
+         mb_per_s = seconds > 0.0 ?
+            state.bytes / (1024.0 * 1024.0) / seconds : 0.0;
+
+         if (json)
+         {
+            printf("%s\n    { \"name\": ", first ? "" : ",");
+            bench_print_string(kernel->name, true);
+            printf(", \"bytes\": %lu, \"iterations\": %u,"
+                  " \"ns_per_iteration\": %.1f, \"mb_per_s\": %.2f }",
+                  (unsigned long)state.bytes, iterations,
+                  seconds * 1e9, mb_per_s);
+         }
+         else
+         {
+            bench_print_string(BENCH_COMMIT, false);
+            putchar(',');
+            bench_print_string(cpu, false);
+            printf(",%s,%lu,%u,%.1f,%.2f\n", kernel->name,
+                  (unsigned long)state.bytes, iterations,
+                  seconds * 1e9, mb_per_s);
+         }
+         fflush(stdout);
+
+         first = false;
+      }
+
+      if (kernel->deinit)
+         kernel->deinit(&state);
+      bench_free_buffers(&state);
+   }
+
+   if (json)
+      printf("%s]\n}\n", first ? "" : "\n  ");
+
+   return ret;
+}
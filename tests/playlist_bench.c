@@ -0,0 +1,166 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times building a large playlist the way the database scanner does,
+ * and checks that bulk pushes and the journal give the same playlist
+ * as pushing and rewriting entry by entry.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../playlist.h"
+
+#define BENCH_ENTRIES 50000
+#define BENCH_BATCH   64
+
+static double bench_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void bench_entry(content_playlist_entry_t *entry, unsigned i)
+{
+   static char path[BENCH_BATCH][64], crc[BENCH_BATCH][16];
+
+   /* Every 7th entry is seen twice. */
+   unsigned n = (i % 7 == 6) ? i / 2 : i;
+
+   snprintf(path[i % BENCH_BATCH], sizeof(path[0]), "/roms/game %u.bin", n);
+   snprintf(crc[i % BENCH_BATCH], sizeof(crc[0]), "%08X|crc", n * 2654435761u);
+
+   entry->path      = path[i % BENCH_BATCH];
+   entry->label     = path[i % BENCH_BATCH] + 6;
+   entry->core_path = (char*)"DETECT";
+   entry->core_name = (char*)"DETECT";
+   entry->crc32     = crc[i % BENCH_BATCH];
+   entry->db_name   = (char*)"Bench.lpl";
+}
+
+static bool bench_equal(content_playlist_t *a, content_playlist_t *b)
+{
+   size_t i;
+
+   if (a->size != b->size)
+      return false;
+
+   for (i = 0; i < a->size; i++)
+   {
+      if (strcmp(a->entries[i].path, b->entries[i].path))
+         return false;
+      if (strcmp(a->entries[i].crc32, b->entries[i].crc32))
+         return false;
+   }
+
+   return true;
+}
+
+int main(void)
+{
+   unsigned i;
+   double start;
+   size_t idx;
+   content_playlist_entry_t batch[BENCH_BATCH];
+   content_playlist_t *push = NULL, *bulk = NULL, *reload = NULL;
+   const char *push_path    = "playlist_bench_push.lpl";
+   const char *bulk_path    = "playlist_bench_bulk.lpl";
+   int ret                  = 1;
+
+   unlink(push_path);
+   unlink(bulk_path);
+   unlink("playlist_bench_bulk.lpl" PLAYLIST_JOURNAL_EXT);
+
+   push = content_playlist_init(push_path, BENCH_ENTRIES);
+   start = bench_time();
+   for (i = 0; i < BENCH_ENTRIES; i++)
+   {
+      content_playlist_entry_t entry;
+      bench_entry(&entry, i);
+      content_playlist_push(push, entry.path, entry.label,
+            entry.core_path, entry.core_name, entry.crc32, entry.db_name);
+   }
+   content_playlist_write_file(push);
+   printf("push:         %8.3f s (%u entries)\n",
+         bench_time() - start, (unsigned)content_playlist_size(push));
+
+   /* Like the database scanner, write after every batch. */
+   bulk = content_playlist_init(bulk_path, BENCH_ENTRIES);
+   content_playlist_set_journal(bulk, true);
+   start = bench_time();
+   for (i = 0; i < BENCH_ENTRIES; i++)
+   {
+      bench_entry(&batch[i % BENCH_BATCH], i);
+
+      if (i % BENCH_BATCH == BENCH_BATCH - 1 || i == BENCH_ENTRIES - 1)
+      {
+         content_playlist_push_bulk(bulk, batch, i % BENCH_BATCH + 1);
+         content_playlist_write_file(bulk);
+      }
+   }
+   printf("bulk+journal: %8.3f s (%u entries)\n",
+         bench_time() - start, (unsigned)content_playlist_size(bulk));
+
+   start = bench_time();
+   for (i = 0; i < BENCH_ENTRIES; i++)
+   {
+      content_playlist_entry_t entry;
+      bench_entry(&entry, i);
+      if (!content_playlist_find_by_path(bulk, entry.path, &idx))
+         goto end;
+   }
+   printf("find:         %8.3f s\n", bench_time() - start);
+
+   if (!bench_equal(push, bulk))
+   {
+      fprintf(stderr, "bulk push differs from push\n");
+      goto end;
+   }
+
+   reload = content_playlist_init(bulk_path, BENCH_ENTRIES);
+   if (!bench_equal(push, reload))
+   {
+      fprintf(stderr, "journal replay differs from push\n");
+      goto end;
+   }
+
+   {
+      content_playlist_entry_t entry;
+      bench_entry(&entry, 1234);
+      if (content_playlist_find_by_crc32(reload, entry.crc32,
+               "Bench.lpl", &idx, 1) != 1
+            || strcmp(reload->entries[idx].path, entry.path))
+      {
+         fprintf(stderr, "crc32 lookup failed\n");
+         goto end;
+      }
+   }
+
+   printf("PASS\n");
+   ret = 0;
+
+end:
+   content_playlist_free(push);
+   content_playlist_free(bulk);
+   content_playlist_free(reload);
+   unlink(push_path);
+   unlink(bulk_path);
+   unlink("playlist_bench_bulk.lpl" PLAYLIST_JOURNAL_EXT);
+   return ret;
+}
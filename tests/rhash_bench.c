@@ -0,0 +1,146 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the throughput of the hashes in rhash, with and without
+ * the CPU specific code paths, next to bytewise CRC32 and zlib.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+#include <boolean.h>
+#include <rhash.h>
+
+#define BENCH_SIZE   (32 * 1024 * 1024)
+#define BENCH_ROUNDS 4
+
+enum bench_hash
+{
+   BENCH_CRC32_BYTEWISE = 0,
+   BENCH_CRC32_ZLIB,
+   BENCH_CRC32,
+   BENCH_MD5,
+   BENCH_SHA1,
+   BENCH_LAST
+};
+
+static const char *bench_names[] = {
+   "crc32 (bytewise)", "crc32 (zlib)", "crc32", "md5", "sha1"
+};
+
+static volatile uint32_t bench_sink;
+
+static double bench_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void bench_run(enum bench_hash hash, const uint8_t *data, size_t size)
+{
+   size_t i;
+   uint8_t digest[20];
+   struct md5_context md5;
+   struct sha1_context sha1;
+   uint32_t crc = 0xffffffff;
+
+   switch (hash)
+   {
+      case BENCH_CRC32_BYTEWISE:
+         for (i = 0; i < size; i++)
+            crc = crc32_adjust(crc, data[i]);
+         bench_sink = crc;
+         break;
+      case BENCH_CRC32_ZLIB:
+         bench_sink = crc32(0, data, size);
+         break;
+      case BENCH_CRC32:
+         bench_sink = crc32_calculate(data, size);
+         break;
+      case BENCH_MD5:
+         md5_init(&md5);
+         md5_update(&md5, data, size);
+         md5_final(&md5, digest);
+         bench_sink = digest[0];
+         break;
+      case BENCH_SHA1:
+         sha1_init(&sha1);
+         sha1_update(&sha1, data, size);
+         sha1_final(&sha1, digest);
+         bench_sink = digest[0];
+         break;
+      default:
+         break;
+   }
+}
+
+/* Returns MB/s, best of BENCH_ROUNDS. */
+static double bench_hash(enum bench_hash hash, const uint8_t *data, size_t size)
+{
+   unsigned i;
+   double best = 0.0;
+
+   for (i = 0; i < BENCH_ROUNDS; i++)
+   {
+      double start = bench_time();
+      double speed;
+
+      bench_run(hash, data, size);
+
+      speed = size / (1024.0 * 1024.0) / (bench_time() - start);
+      if (speed > best)
+         best = speed;
+   }
+
+   return best;
+}
+
+int main(void)
+{
+   unsigned i;
+   uint32_t seed = 1;
+   uint8_t *data = (uint8_t*)malloc(BENCH_SIZE);
+
+   if (!data)
+      return 1;
+
+   for (i = 0; i < BENCH_SIZE; i++)
+   {
+      seed    = seed * 1103515245u + 12345u;
+      data[i] = seed >> 24;
+   }
+
+   printf("%-18s %12s %12s  (MB/s, %u MB)\n", "hash",
+         "portable", "simd", BENCH_SIZE / (1024 * 1024));
+
+   for (i = 0; i < BENCH_LAST; i++)
+   {
+      double portable, simd;
+
+      rhash_set_simd(false);
+      portable = bench_hash((enum bench_hash)i, data, BENCH_SIZE);
+      rhash_set_simd(true);
+      simd     = bench_hash((enum bench_hash)i, data, BENCH_SIZE);
+
+      printf("%-18s %12.1f %12.1f\n", bench_names[i], portable, simd);
+   }
+
+   free(data);
+   return 0;
+}
@@ -0,0 +1,222 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks CRC32, MD5 and SHA-1 against published test vectors, and
+ * the CPU specific code paths against the portable ones on random
+ * data, hashed in one go and in random sized pieces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <rhash.h>
+
+struct test_vector
+{
+   const char *input;
+   unsigned repeat;
+   uint32_t crc32;
+   const char *md5;
+   const char *sha1;
+};
+
+static const struct test_vector test_vectors[] = {
+   { "", 1, 0x00000000,
+      "d41d8cd98f00b204e9800998ecf8427e",
+      "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+   { "abc", 1, 0x352441c2,
+      "900150983cd24fb0d6963f7d28e17f72",
+      "a9993e364706816aba3e25717850c26c9cd0d89d" },
+   { "123456789", 1, 0xcbf43926,
+      "25f9e794323b453885f5181f1b624d0b",
+      "f7c3bc1d808e04732adf679965ccc34ca7ae3441" },
+   { "message digest", 1, 0x20159d7f,
+      "f96b697d7cb7938d525a2f31aaf161d0",
+      "c12252ceda8be8994d5fa0290a47231c1d16aae3" },
+   { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1, 0x171a3f5f,
+      "8215ef0796a20bcaaae116d3876c664a",
+      "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+   { "1234567890", 8, 0x7ca94a72,
+      "57edf4a22be3c955ac49da2e2107b67a",
+      "50abf5706a150990a08b2c5ea40fa0e585554732" },
+   { "a", 1000000, 0xdc25bfbc,
+      "7707d6ae4e027c70eea2a935c2296f21",
+      "34aa973cd4c4daa4f61eeb2bdbad27316534016f" },
+};
+
+#define TEST_RANDOM_SIZE (1024 * 1024 + 77)
+
+static void test_to_hex(char *s, const uint8_t *in, size_t size)
+{
+   size_t i;
+
+   for (i = 0; i < size; i++)
+      sprintf(s + 2 * i, "%02x", (unsigned)in[i]);
+}
+
+static uint32_t test_rand(uint32_t *seed)
+{
+   *seed = *seed * 1103515245u + 12345u;
+   return *seed >> 8;
+}
+
+/* Hashes @data in pieces of random size, or in one go if @seed is 0. */
+static void test_hash(const uint8_t *data, size_t size,
+      uint32_t seed, struct rhash_result *result)
+{
+   rhash_stream_t stream;
+   size_t pos = 0;
+
+   rhash_stream_init(&stream, RHASH_CRC32 | RHASH_MD5 | RHASH_SHA1);
+
+   while (pos < size)
+   {
+      size_t chunk = seed ? test_rand(&seed) % 300 : size;
+
+      if (chunk > size - pos)
+         chunk = size - pos;
+
+      rhash_stream_update(&stream, data + pos, chunk);
+      pos += chunk;
+   }
+
+   rhash_stream_final(&stream, result);
+}
+
+static unsigned test_vectors_run(const char *mode)
+{
+   unsigned i, j, failures = 0;
+
+   for (i = 0; i < sizeof(test_vectors) / sizeof(*test_vectors); i++)
+   {
+      char md5[33], sha1[41];
+      struct rhash_result result;
+      const struct test_vector *v = &test_vectors[i];
+      size_t len = strlen(v->input);
+      uint8_t *data = (uint8_t*)malloc(len * v->repeat + 1);
+
+      for (j = 0; j < v->repeat; j++)
+         memcpy(data + j * len, v->input, len);
+
+      test_hash(data, len * v->repeat, 0, &result);
+      test_to_hex(md5, result.md5, sizeof(result.md5));
+      test_to_hex(sha1, result.sha1, sizeof(result.sha1));
+
+      if (result.crc32 != v->crc32
+            || crc32_calculate(data, len * v->repeat) != v->crc32)
+      {
+         printf("FAIL: %s CRC32 of vector %u: %08x\n", mode, i,
+               (unsigned)result.crc32);
+         failures++;
+      }
+
+      if (strcmp(md5, v->md5))
+      {
+         printf("FAIL: %s MD5 of vector %u: %s\n", mode, i, md5);
+         failures++;
+      }
+
+      if (strcmp(sha1, v->sha1))
+      {
+         printf("FAIL: %s SHA-1 of vector %u: %s\n", mode, i, sha1);
+         failures++;
+      }
+
+      free(data);
+   }
+
+   return failures;
+}
+
+int main(void)
+{
+   size_t i;
+   unsigned offset;
+   unsigned failures = 0;
+   uint32_t seed     = 1;
+   uint8_t *data     = (uint8_t*)malloc(TEST_RANDOM_SIZE);
+
+   if (!data)
+      return 1;
+
+   for (i = 0; i < TEST_RANDOM_SIZE; i++)
+      data[i] = (uint8_t)test_rand(&seed);
+
+   rhash_set_simd(false);
+   failures += test_vectors_run("portable");
+   rhash_set_simd(true);
+   failures += test_vectors_run("simd");
+
+   /* Odd offsets and sizes exercise unaligned loads and the tails. */
+   for (offset = 0; offset < 4; offset++)
+   {
+      struct rhash_result portable, simd, pieces;
+      size_t size = TEST_RANDOM_SIZE - 4 - offset * 33;
+      uint32_t crc = 0xffffffff;
+
+      for (i = 0; i < size; i++)
+         crc = crc32_adjust(crc, data[offset + i]);
+
+      rhash_set_simd(false);
+      test_hash(data + offset, size, 0, &portable);
+      rhash_set_simd(true);
+      test_hash(data + offset, size, 0, &simd);
+      test_hash(data + offset, size, offset + 1, &pieces);
+
+      if (portable.crc32 != ~crc || simd.crc32 != ~crc
+            || pieces.crc32 != ~crc)
+      {
+         printf("FAIL: CRC32 of random data at offset %u\n", offset);
+         failures++;
+      }
+
+      if (memcmp(portable.md5, simd.md5, 16)
+            || memcmp(portable.md5, pieces.md5, 16))
+      {
+         printf("FAIL: MD5 of random data at offset %u\n", offset);
+         failures++;
+      }
+
+      if (memcmp(portable.sha1, simd.sha1, 20)
+            || memcmp(portable.sha1, pieces.sha1, 20))
+      {
+         printf("FAIL: SHA-1 of random data at offset %u\n", offset);
+         failures++;
+      }
+   }
+
+   /* Every length around the PCLMULQDQ block sizes. */
+   for (i = 0; i < 300; i++)
+   {
+      uint32_t crc = 0xffffffff;
+      size_t j;
+
+      for (j = 0; j < i; j++)
+         crc = crc32_adjust(crc, data[j + 3]);
+
+      if (crc32_calculate(data + 3, i) != ~crc)
+      {
+         printf("FAIL: CRC32 of %u bytes\n", (unsigned)i);
+         failures++;
+      }
+   }
+
+   printf("%s\n", failures ? "Some hash tests failed." : "All hash tests passed.");
+
+   free(data);
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,234 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Writes a scan cache, reads it back with the same and with other
+ * databases, checks that scanning a directory drops the entries of
+ * its files that are gone but keeps those of other directories, and
+ * that truncated cache files keep the entries which were written
+ * completely.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../database_scan_cache.h"
+
+#define TEST_ENTRIES   20000
+#define TEST_CACHE     "scan_cache_test.bin"
+
+static unsigned failures;
+
+#define CHECK(cond) do { \
+   if (!(cond)) \
+   { \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+   } \
+} while (0)
+
+static void test_path(char *s, size_t len, unsigned i)
+{
+   snprintf(s, len, "/roms/system %u/game %u.%s", i % 7, i,
+         (i % 5) ? "sfc" : "zip");
+}
+
+static void test_fill(database_scan_cache_t *cache)
+{
+   unsigned i;
+   char path[64];
+
+   for (i = 0; i < TEST_ENTRIES; i++)
+   {
+      database_scan_cache_entry_t *entry;
+
+      test_path(path, sizeof(path), i);
+      entry = database_scan_cache_update(cache, path, i * 1024, i + 1000);
+
+      if (i % 11 == 0)
+         database_scan_cache_set_serial(cache, entry, "T-12345G");
+      else
+         database_scan_cache_set_crc(cache, entry, i * 2654435761u,
+               (i % 5) ? NULL : "game.sfc");
+
+      if (i % 3 == 0)
+         database_scan_cache_add_match(cache, entry,
+               "Nintendo - Super Nintendo Entertainment System.lpl",
+               "Some Game (USA)", i);
+
+      /* Every 13th lookup did not finish. */
+      if (i % 13)
+         database_scan_cache_set_looked_up(cache, entry);
+   }
+}
+
+/* Scans directory @dir, in which only the even numbered files are
+ * still there.
+ * Returns: number of entries dropped. */
+static size_t test_scan_dir(unsigned dir)
+{
+   unsigned i;
+   char path[64];
+   size_t dropped               = 0;
+   database_scan_cache_t *cache = database_scan_cache_new(TEST_CACHE, 1);
+
+   for (i = 0; i < TEST_ENTRIES; i++)
+   {
+      if (i % 7 != dir)
+         continue;
+
+      if (i % 2)
+      {
+         dropped++;
+         continue;
+      }
+
+      test_path(path, sizeof(path), i);
+      CHECK(database_scan_cache_find(cache, path, i * 1024, i + 1000));
+   }
+
+   snprintf(path, sizeof(path), "/roms/system %u", dir);
+   database_scan_cache_prune(cache, path);
+   CHECK(database_scan_cache_write(cache));
+   database_scan_cache_free(cache);
+
+   return dropped;
+}
+
+static void test_check(database_scan_cache_t *cache, bool matches)
+{
+   unsigned i;
+   char path[64];
+
+   CHECK(database_scan_cache_size(cache) == TEST_ENTRIES);
+
+   for (i = 0; i < TEST_ENTRIES; i++)
+   {
+      database_scan_cache_entry_t *entry;
+      bool looked_up = matches && (i % 13);
+
+      test_path(path, sizeof(path), i);
+      entry = database_scan_cache_find(cache, path, i * 1024, i + 1000);
+
+      CHECK(entry != NULL);
+      if (!entry)
+         continue;
+
+      CHECK(!!(entry->flags & DATABASE_SCAN_CACHE_LOOKED_UP) == looked_up);
+      CHECK(entry->num_matches == ((looked_up && i % 3 == 0) ? 1 : 0));
+
+      if (i % 11 == 0)
+      {
+         CHECK(entry->flags & DATABASE_SCAN_CACHE_HAS_SERIAL);
+         CHECK(entry->serial && !strcmp(entry->serial, "T-12345G"));
+      }
+      else
+      {
+         CHECK(entry->flags & DATABASE_SCAN_CACHE_HAS_CRC);
+         CHECK(entry->crc32 == i * 2654435761u);
+         CHECK((i % 5) ? !entry->zip_name
+               : (entry->zip_name && !strcmp(entry->zip_name, "game.sfc")));
+      }
+
+      if (entry->num_matches)
+      {
+         CHECK(!strcmp(entry->matches[0].label, "Some Game (USA)"));
+         CHECK(entry->matches[0].crc32 == i);
+      }
+
+      /* Changed files are not found. */
+      CHECK(!database_scan_cache_find(cache, path, i * 1024 + 1, i + 1000));
+      CHECK(!database_scan_cache_find(cache, path, i * 1024, i + 1001));
+   }
+
+   CHECK(!database_scan_cache_find(cache, "/roms/missing.sfc", 0, 0));
+}
+
+int main(void)
+{
+   size_t dropped;
+   long size;
+   FILE *file;
+   database_scan_cache_t *cache = database_scan_cache_new(TEST_CACHE, 1);
+
+   remove(TEST_CACHE);
+   database_scan_cache_free(cache);
+
+   cache = database_scan_cache_new(TEST_CACHE, 1);
+   CHECK(cache && database_scan_cache_size(cache) == 0);
+   test_fill(cache);
+   CHECK(database_scan_cache_write(cache));
+   database_scan_cache_free(cache);
+
+   /* Same databases, the matches are kept. */
+   cache = database_scan_cache_new(TEST_CACHE, 1);
+   test_check(cache, true);
+   database_scan_cache_free(cache);
+
+   /* Other databases, only the CRCs and serials are kept. */
+   cache = database_scan_cache_new(TEST_CACHE, 2);
+   test_check(cache, false);
+   database_scan_cache_free(cache);
+
+   /* Scans of two directories in turn, each one only drops
+    * its own files which are gone. */
+   dropped = test_scan_dir(1);
+   cache   = database_scan_cache_new(TEST_CACHE, 1);
+   CHECK(database_scan_cache_size(cache) == TEST_ENTRIES - dropped);
+   CHECK(!database_scan_cache_find(cache, "/roms/system 1/game 1.sfc",
+            1024, 1001));
+   CHECK(database_scan_cache_find(cache, "/roms/system 1/game 8.sfc",
+            8192, 1008) != NULL);
+   database_scan_cache_free(cache);
+
+   dropped += test_scan_dir(2);
+   cache    = database_scan_cache_new(TEST_CACHE, 1);
+   CHECK(database_scan_cache_size(cache) == TEST_ENTRIES - dropped);
+   CHECK(database_scan_cache_find(cache, "/roms/system 1/game 8.sfc",
+            8192, 1008) != NULL);
+   CHECK(!database_scan_cache_find(cache, "/roms/system 2/game 9.sfc",
+            9216, 1009));
+   CHECK(database_scan_cache_find(cache, "/roms/system 2/game 2.sfc",
+            2048, 1002) != NULL);
+   CHECK(database_scan_cache_find(cache, "/roms/system 3/game 3.sfc",
+            3072, 1003) != NULL);
+   database_scan_cache_free(cache);
+
+   /* Truncated in the middle of an entry. */
+   file = fopen(TEST_CACHE, "rb+");
+   CHECK(file != NULL);
+   if (file)
+   {
+      fseek(file, 0, SEEK_END);
+      size = ftell(file);
+      fclose(file);
+      CHECK(truncate(TEST_CACHE, size / 2) == 0);
+   }
+
+   cache = database_scan_cache_new(TEST_CACHE, 1);
+   CHECK(database_scan_cache_size(cache) > 0
+         && database_scan_cache_size(cache) < TEST_ENTRIES);
+   CHECK(database_scan_cache_find(cache, "/roms/system 2/game 2.sfc",
+            2048, 1002) != NULL);
+   database_scan_cache_free(cache);
+
+   remove(TEST_CACHE);
+
+   printf("%s\n", failures ? "Scan cache tests failed." :
+         "All scan cache tests passed.");
+
+   return failures ? 1 : 0;
+}
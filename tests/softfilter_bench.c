@@ -0,0 +1,365 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times every bundled softfilter at 1, 2, 4 and 8 threads, and checks
+ * that the banded output is identical to the single-threaded one.
+ * Work packets are run on a thread pool like the one in
+ * gfx/video_filter.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <boolean.h>
+#include <rthreads/rthreads.h>
+
+#define RARCH_INTERNAL
+#include "../gfx/video_filters/2xsai.c"
+#include "../gfx/video_filters/super2xsai.c"
+#include "../gfx/video_filters/supereagle.c"
+#include "../gfx/video_filters/2xbr.c"
+#include "../gfx/video_filters/darken.c"
+#include "../gfx/video_filters/epx.c"
+#include "../gfx/video_filters/scale2x.c"
+#include "../gfx/video_filters/blargg_ntsc_snes.c"
+#include "../gfx/video_filters/lq2x.c"
+#include "../gfx/video_filters/phosphor2x.c"
+
+#define BENCH_WIDTH   256
+#define BENCH_HEIGHT  224
+#define BENCH_FRAMES  200
+#define BENCH_THREADS 8
+
+static const softfilter_get_implementation_t bench_filters[] = {
+   blargg_ntsc_snes_get_implementation,
+   lq2x_get_implementation,
+   phosphor2x_get_implementation,
+   twoxbr_get_implementation,
+   darken_get_implementation,
+   twoxsai_get_implementation,
+   supertwoxsai_get_implementation,
+   supereagle_get_implementation,
+   epx_get_implementation,
+   scale2x_get_implementation,
+};
+
+static const unsigned bench_thread_counts[] = { 1, 2, 4, 8 };
+
+struct bench_worker
+{
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   const struct softfilter_work_packet *packet;
+   void *userdata;
+   bool die;
+   bool done;
+};
+
+static struct bench_worker bench_workers[BENCH_THREADS];
+
+static void bench_worker_loop(void *data)
+{
+   struct bench_worker *worker = (struct bench_worker*)data;
+
+   for (;;)
+   {
+      bool die;
+
+      slock_lock(worker->lock);
+      while (worker->done && !worker->die)
+         scond_wait(worker->cond, worker->lock);
+      die = worker->die;
+      slock_unlock(worker->lock);
+
+      if (die)
+         break;
+
+      if (worker->packet->work)
+         worker->packet->work(worker->userdata, worker->packet->thread_data);
+
+      slock_lock(worker->lock);
+      worker->done = true;
+      scond_signal(worker->cond);
+      slock_unlock(worker->lock);
+   }
+}
+
+static void bench_pool_init(void)
+{
+   unsigned i;
+
+   for (i = 0; i < BENCH_THREADS; i++)
+   {
+      bench_workers[i].done   = true;
+      bench_workers[i].lock   = slock_new();
+      bench_workers[i].cond   = scond_new();
+      bench_workers[i].thread = sthread_create(bench_worker_loop,
+            &bench_workers[i]);
+   }
+}
+
+static void bench_pool_deinit(void)
+{
+   unsigned i;
+
+   for (i = 0; i < BENCH_THREADS; i++)
+   {
+      slock_lock(bench_workers[i].lock);
+      bench_workers[i].die = true;
+      scond_signal(bench_workers[i].cond);
+      slock_unlock(bench_workers[i].lock);
+      sthread_join(bench_workers[i].thread);
+      slock_free(bench_workers[i].lock);
+      scond_free(bench_workers[i].cond);
+   }
+}
+
+static void bench_pool_run(const struct softfilter_work_packet *packets,
+      unsigned threads, void *userdata)
+{
+   unsigned i;
+
+   for (i = 0; i < threads; i++)
+   {
+      slock_lock(bench_workers[i].lock);
+      bench_workers[i].packet   = &packets[i];
+      bench_workers[i].userdata = userdata;
+      bench_workers[i].done     = false;
+      scond_signal(bench_workers[i].cond);
+      slock_unlock(bench_workers[i].lock);
+   }
+
+   for (i = 0; i < threads; i++)
+   {
+      slock_lock(bench_workers[i].lock);
+      while (!bench_workers[i].done)
+         scond_wait(bench_workers[i].cond, bench_workers[i].lock);
+      slock_unlock(bench_workers[i].lock);
+   }
+}
+
+static int bench_get_float(void *userdata, const char *key,
+      float *value, float default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int bench_get_int(void *userdata, const char *key,
+      int *value, int default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int bench_get_float_array(void *userdata, const char *key,
+      float **values, unsigned *out_num_values,
+      const float *default_values, unsigned num_default_values)
+{
+   *values = (float*)malloc(num_default_values * sizeof(float));
+   memcpy(*values, default_values, num_default_values * sizeof(float));
+   *out_num_values = num_default_values;
+   return 0;
+}
+
+static int bench_get_int_array(void *userdata, const char *key,
+      int **values, unsigned *out_num_values,
+      const int *default_values, unsigned num_default_values)
+{
+   *values = (int*)malloc(num_default_values * sizeof(int));
+   memcpy(*values, default_values, num_default_values * sizeof(int));
+   *out_num_values = num_default_values;
+   return 0;
+}
+
+static int bench_get_string(void *userdata, const char *key,
+      char **output, const char *default_output)
+{
+   *output = strdup(default_output);
+   return 0;
+}
+
+static const struct softfilter_config bench_config = {
+   bench_get_float,
+   bench_get_int,
+   bench_get_float_array,
+   bench_get_int_array,
+   bench_get_string,
+   free,
+};
+
+static double bench_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+/* Pixel art like input: flat 4x4 blocks from a small palette,
+ * with some single pixel noise. */
+static void bench_fill_input(void *input, unsigned fmt)
+{
+   unsigned x, y;
+   uint32_t seed = 1;
+   uint32_t palette[8];
+
+   for (x = 0; x < 8; x++)
+   {
+      seed       = seed * 1103515245u + 12345u;
+      palette[x] = seed >> 8;
+   }
+
+   for (y = 0; y < BENCH_HEIGHT; y++)
+   {
+      for (x = 0; x < BENCH_WIDTH; x++)
+      {
+         uint32_t color;
+
+         seed  = seed * 1103515245u + 12345u;
+         color = palette[((x / 4) * 7 + (y / 4) * 3) & 7];
+         if ((seed >> 16) % 13 == 0)
+            color = palette[(seed >> 24) & 7];
+
+         if (fmt == SOFTFILTER_FMT_XRGB8888)
+            ((uint32_t*)input)[y * BENCH_WIDTH + x] = color & 0xffffff;
+         else
+            ((uint16_t*)input)[y * BENCH_WIDTH + x] = (uint16_t)color;
+      }
+   }
+}
+
+/* Returns frames per second, or a negative value on error. */
+static double bench_filter(const struct softfilter_implementation *impl,
+      unsigned fmt, unsigned threads, const void *input,
+      void *output, size_t output_size)
+{
+   unsigned i, out_width, out_height;
+   double start;
+   struct softfilter_work_packet packets[BENCH_THREADS];
+   size_t bpp      = (fmt == SOFTFILTER_FMT_XRGB8888) ?
+      SOFTFILTER_BPP_XRGB8888 : SOFTFILTER_BPP_RGB565;
+   void *data      = impl->create(&bench_config, fmt, fmt,
+         BENCH_WIDTH, BENCH_HEIGHT, threads, 0, NULL);
+
+   if (!data)
+      return -1.0;
+
+   threads = impl->query_num_threads(data);
+   impl->query_output_size(data, &out_width, &out_height,
+         BENCH_WIDTH, BENCH_HEIGHT);
+
+   if (threads > BENCH_THREADS
+         || out_width * out_height * bpp > output_size)
+   {
+      impl->destroy(data);
+      return -1.0;
+   }
+
+   start = bench_time();
+
+   for (i = 0; i < BENCH_FRAMES; i++)
+   {
+      impl->get_work_packets(data, packets,
+            output, out_width * bpp,
+            input, BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH * bpp);
+      bench_pool_run(packets, threads, data);
+
+      /* Keep the first frame for comparison. */
+      if (i == 0)
+         output = (uint8_t*)output + output_size;
+   }
+
+   impl->destroy(data);
+
+   return BENCH_FRAMES / (bench_time() - start);
+}
+
+int main(void)
+{
+   unsigned i, j, k;
+   int ret            = 0;
+   size_t output_size = BENCH_WIDTH * BENCH_HEIGHT * 4 * 4;
+   void *input        = malloc(BENCH_WIDTH * BENCH_HEIGHT * 4);
+   uint8_t *reference = (uint8_t*)malloc(output_size * 2);
+   uint8_t *output    = (uint8_t*)malloc(output_size * 2);
+   static const unsigned formats[] = {
+      SOFTFILTER_FMT_RGB565, SOFTFILTER_FMT_XRGB8888
+   };
+
+   if (!input || !reference || !output)
+      return 1;
+
+   bench_pool_init();
+
+   printf("%-18s %-8s", "filter", "format");
+   for (k = 0; k < sizeof(bench_thread_counts) / sizeof(*bench_thread_counts); k++)
+      printf(" %7u thr", bench_thread_counts[k]);
+   printf("  (frames/s, %ux%u)\n", BENCH_WIDTH, BENCH_HEIGHT);
+
+   for (i = 0; i < sizeof(bench_filters) / sizeof(*bench_filters); i++)
+   {
+      const struct softfilter_implementation *impl = bench_filters[i](0);
+
+      for (j = 0; j < sizeof(formats) / sizeof(*formats); j++)
+      {
+         bool exact = true;
+
+         if (!(impl->query_input_formats() & formats[j]))
+            continue;
+
+         bench_fill_input(input, formats[j]);
+
+         printf("%-18s %-8s", impl->short_ident,
+               formats[j] == SOFTFILTER_FMT_RGB565 ? "rgb565" : "xrgb8888");
+
+         for (k = 0; k < sizeof(bench_thread_counts) / sizeof(*bench_thread_counts); k++)
+         {
+            uint8_t *dst = k ? output : reference;
+            double fps;
+
+            memset(dst, 0, output_size);
+            fps = bench_filter(impl, formats[j], bench_thread_counts[k],
+                  input, dst, output_size);
+
+            if (fps < 0.0)
+            {
+               printf(" %11s", "error");
+               ret = 1;
+               continue;
+            }
+
+            if (k && memcmp(reference, output, output_size))
+               exact = false;
+
+            printf(" %11.1f", fps);
+         }
+
+         printf("  %s\n", exact ? "exact" : "MISMATCH");
+         if (!exact)
+            ret = 1;
+      }
+   }
+
+   bench_pool_deinit();
+
+   free(input);
+   free(reference);
+   free(output);
+
+   return ret;
+}
@@ -0,0 +1,299 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that the SIMD paths of the bundled softfilters are
+ * bit-exact with the scalar ones. The scalar output of every
+ * filter, format, frame size and input pattern is the golden
+ * image the SIMD output is compared against.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+
+#define RARCH_INTERNAL
+#include "../gfx/video_filters/2xsai.c"
+#include "../gfx/video_filters/super2xsai.c"
+#include "../gfx/video_filters/supereagle.c"
+#include "../gfx/video_filters/2xbr.c"
+#include "../gfx/video_filters/darken.c"
+#include "../gfx/video_filters/epx.c"
+#include "../gfx/video_filters/scale2x.c"
+#include "../gfx/video_filters/blargg_ntsc_snes.c"
+#include "../gfx/video_filters/lq2x.c"
+#include "../gfx/video_filters/phosphor2x.c"
+
+/* Filters read a few pixels beyond the edges of the frame,
+ * keep that inside the buffer. */
+#define TEST_GUARD_ROWS   4
+#define TEST_GUARD_PIXELS 16
+#define TEST_THREADS      3
+
+static const softfilter_get_implementation_t test_filters[] = {
+   blargg_ntsc_snes_get_implementation,
+   lq2x_get_implementation,
+   phosphor2x_get_implementation,
+   twoxbr_get_implementation,
+   darken_get_implementation,
+   twoxsai_get_implementation,
+   supertwoxsai_get_implementation,
+   supereagle_get_implementation,
+   epx_get_implementation,
+   scale2x_get_implementation,
+};
+
+static const unsigned test_sizes[][2] = {
+   { 256, 224 },
+   { 255,  31 },
+   {  19,   7 },
+   { 512,  16 },
+};
+
+enum test_pattern
+{
+   TEST_PATTERN_PIXEL_ART = 0,
+   TEST_PATTERN_FEW_COLORS,
+   TEST_PATTERN_NOISE,
+   TEST_PATTERN_LAST
+};
+
+static const char *test_pattern_names[] = {
+   "pixel art", "few colors", "noise"
+};
+
+static int test_get_float(void *userdata, const char *key,
+      float *value, float default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int test_get_int(void *userdata, const char *key,
+      int *value, int default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int test_get_float_array(void *userdata, const char *key,
+      float **values, unsigned *out_num_values,
+      const float *default_values, unsigned num_default_values)
+{
+   *values = (float*)malloc(num_default_values * sizeof(float));
+   memcpy(*values, default_values, num_default_values * sizeof(float));
+   *out_num_values = num_default_values;
+   return 0;
+}
+
+static int test_get_int_array(void *userdata, const char *key,
+      int **values, unsigned *out_num_values,
+      const int *default_values, unsigned num_default_values)
+{
+   *values = (int*)malloc(num_default_values * sizeof(int));
+   memcpy(*values, default_values, num_default_values * sizeof(int));
+   *out_num_values = num_default_values;
+   return 0;
+}
+
+static int test_get_string(void *userdata, const char *key,
+      char **output, const char *default_output)
+{
+   *output = strdup(default_output);
+   return 0;
+}
+
+static const struct softfilter_config test_config = {
+   test_get_float,
+   test_get_int,
+   test_get_float_array,
+   test_get_int_array,
+   test_get_string,
+   free,
+};
+
+static void test_fill(uint8_t *buf, size_t pixels, unsigned fmt,
+      enum test_pattern pattern, unsigned stride)
+{
+   size_t i;
+   uint32_t seed = 1;
+   uint32_t palette[8];
+
+   for (i = 0; i < 8; i++)
+   {
+      seed       = seed * 1103515245u + 12345u;
+      palette[i] = seed >> 8;
+   }
+
+   for (i = 0; i < pixels; i++)
+   {
+      uint32_t color;
+      size_t x = i % stride;
+      size_t y = i / stride;
+
+      seed = seed * 1103515245u + 12345u;
+
+      switch (pattern)
+      {
+         case TEST_PATTERN_PIXEL_ART:
+            color = palette[((x / 4) * 7 + (y / 4) * 3) & 7];
+            if ((seed >> 16) % 13 == 0)
+               color = palette[(seed >> 24) & 7];
+            break;
+         case TEST_PATTERN_FEW_COLORS:
+            color = palette[(seed >> 16) & 3];
+            break;
+         default:
+            color = seed ^ (seed >> 13);
+            break;
+      }
+
+      if (fmt == SOFTFILTER_FMT_XRGB8888)
+         ((uint32_t*)buf)[i] = color & 0xffffff;
+      else
+         ((uint16_t*)buf)[i] = (uint16_t)color;
+   }
+}
+
+/* Renders two frames, so that per-frame state like the
+ * NTSC burst phase is covered too. */
+static bool test_render(const struct softfilter_implementation *impl,
+      unsigned fmt, softfilter_simd_mask_t simd,
+      const uint8_t *input, unsigned width, unsigned height,
+      size_t in_stride, uint8_t *output, size_t out_size)
+{
+   unsigned i, frame, threads, out_width, out_height;
+   struct softfilter_work_packet packets[TEST_THREADS];
+   size_t bpp = (fmt == SOFTFILTER_FMT_XRGB8888) ?
+      SOFTFILTER_BPP_XRGB8888 : SOFTFILTER_BPP_RGB565;
+   void *data = impl->create(&test_config, fmt, fmt,
+         width, height, TEST_THREADS, simd, NULL);
+
+   if (!data)
+      return false;
+
+   threads = impl->query_num_threads(data);
+   impl->query_output_size(data, &out_width, &out_height, width, height);
+
+   if (threads > TEST_THREADS
+         || 2 * out_width * out_height * bpp > out_size)
+   {
+      impl->destroy(data);
+      return false;
+   }
+
+   for (frame = 0; frame < 2; frame++)
+   {
+      impl->get_work_packets(data, packets,
+            output + frame * out_width * out_height * bpp,
+            out_width * bpp, input, width, height, in_stride);
+
+      for (i = 0; i < threads; i++)
+         if (packets[i].work)
+            packets[i].work(data, packets[i].thread_data);
+   }
+
+   impl->destroy(data);
+   return true;
+}
+
+int main(void)
+{
+   unsigned i, j, k, p;
+   unsigned tests     = 0;
+   unsigned failures  = 0;
+   size_t in_stride_px = 512 + 2 * TEST_GUARD_PIXELS;
+   size_t in_pixels    = in_stride_px * (224 + 2 * TEST_GUARD_ROWS);
+   size_t out_size     = 2 * 1024 * 448 * 4;
+   uint8_t *input      = (uint8_t*)malloc(in_pixels * 4);
+   uint8_t *golden     = (uint8_t*)malloc(out_size);
+   uint8_t *output     = (uint8_t*)malloc(out_size);
+   static const unsigned formats[] = {
+      SOFTFILTER_FMT_RGB565, SOFTFILTER_FMT_XRGB8888
+   };
+
+   if (!input || !golden || !output)
+      return 1;
+
+#ifndef SOFTFILTER_SIMD_NATIVE
+   printf("No SIMD paths on this target, nothing to compare.\n");
+#endif
+
+   for (i = 0; i < sizeof(test_filters) / sizeof(*test_filters); i++)
+   {
+      const struct softfilter_implementation *impl = test_filters[i](0);
+
+      for (j = 0; j < sizeof(formats) / sizeof(*formats); j++)
+      {
+         size_t bpp = (formats[j] == SOFTFILTER_FMT_XRGB8888) ?
+            SOFTFILTER_BPP_XRGB8888 : SOFTFILTER_BPP_RGB565;
+         size_t in_stride = in_stride_px * bpp;
+         const uint8_t *frame = input + TEST_GUARD_ROWS * in_stride
+            + TEST_GUARD_PIXELS * bpp;
+
+         if (!(impl->query_input_formats() & formats[j]))
+            continue;
+
+         for (p = 0; p < TEST_PATTERN_LAST; p++)
+         {
+            test_fill(input, in_pixels, formats[j],
+                  (enum test_pattern)p, in_stride_px);
+
+            for (k = 0; k < sizeof(test_sizes) / sizeof(*test_sizes); k++)
+            {
+               unsigned width  = test_sizes[k][0];
+               unsigned height = test_sizes[k][1];
+
+               memset(golden, 0xa5, out_size);
+               memset(output, 0xa5, out_size);
+
+               tests++;
+
+               if (!test_render(impl, formats[j], 0,
+                        frame, width, height, in_stride, golden, out_size)
+                     || !test_render(impl, formats[j], ~0u,
+                        frame, width, height, in_stride, output, out_size))
+               {
+                  printf("FAIL: %s %s %ux%u: could not render\n",
+                        impl->short_ident,
+                        formats[j] == SOFTFILTER_FMT_RGB565 ?
+                        "rgb565" : "xrgb8888", width, height);
+                  failures++;
+                  continue;
+               }
+
+               if (memcmp(golden, output, out_size))
+               {
+                  printf("FAIL: %s %s %ux%u %s: SIMD output differs\n",
+                        impl->short_ident,
+                        formats[j] == SOFTFILTER_FMT_RGB565 ?
+                        "rgb565" : "xrgb8888", width, height,
+                        test_pattern_names[p]);
+                  failures++;
+               }
+            }
+         }
+      }
+   }
+
+   printf("%u/%u softfilter tests passed.\n", tests - failures, tests);
+
+   free(input);
+   free(golden);
+   free(output);
+
+   return failures ? 1 : 0;
+}
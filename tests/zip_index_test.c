@@ -0,0 +1,301 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Writes a ZIP archive with stored and deflated entries, then lists
+ * and extracts it through the central directory index, and times
+ * extracting single entries from a large archive.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <file/file_extract.h>
+#include <string/string_list.h>
+
+#define TEST_ZIP      "zip_index_test.zip"
+#define TEST_OUT      "zip_index_test.out"
+#define TEST_ENTRIES  2000
+
+static unsigned failures;
+
+#define CHECK(cond) do { \
+   if (!(cond)) \
+   { \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+   } \
+} while (0)
+
+struct test_central
+{
+   char name[64];
+   uint32_t crc, csize, size, offset;
+   unsigned cmode;
+};
+
+static void test_put_le(FILE *file, uint32_t value, unsigned size)
+{
+   while (size--)
+   {
+      fputc(value & 0xff, file);
+      value >>= 8;
+   }
+}
+
+static void test_entry_data(unsigned i, uint8_t *data, size_t size)
+{
+   size_t j;
+   uint32_t seed = i + 1;
+
+   /* Compressible, but different per entry. */
+   for (j = 0; j < size; j++)
+   {
+      seed    = seed * 1103515245u + 12345u;
+      data[j] = (j % 64 < 48) ? (uint8_t)(j / 64 + i) : (uint8_t)(seed >> 24);
+   }
+}
+
+static size_t test_entry_size(unsigned i)
+{
+   return (i % 97 == 0) ? 0 : 1000 + (i * 7919) % 70000;
+}
+
+static void test_write_zip(const char *path, unsigned count)
+{
+   unsigned i;
+   uint32_t dir_offset, dir_size;
+   FILE *file = fopen(path, "wb");
+   struct test_central *central = (struct test_central*)
+      calloc(count, sizeof(*central));
+   uint8_t *data  = (uint8_t*)malloc(80000);
+   uint8_t *cdata = (uint8_t*)malloc(compressBound(80000));
+
+   for (i = 0; i < count; i++)
+   {
+      z_stream stream;
+      struct test_central *c = &central[i];
+      size_t size            = test_entry_size(i);
+      size_t name_len;
+
+      test_entry_data(i, data, size);
+
+      snprintf(c->name, sizeof(c->name), "dir %u/game %u.%s",
+            i % 3, i, (i % 2) ? "sfc" : "bin");
+      name_len  = strlen(c->name);
+      c->cmode  = (i % 5 == 0) ? 0 : 8;
+      c->size   = size;
+      c->crc    = crc32(0, data, size);
+      c->offset = ftell(file);
+
+      if (c->cmode == 8)
+      {
+         memset(&stream, 0, sizeof(stream));
+         deflateInit2(&stream, 6, Z_DEFLATED, -MAX_WBITS, 8,
+               Z_DEFAULT_STRATEGY);
+         stream.next_in   = data;
+         stream.avail_in  = size;
+         stream.next_out  = cdata;
+         stream.avail_out = compressBound(80000);
+         deflate(&stream, Z_FINISH);
+         c->csize = stream.total_out;
+         deflateEnd(&stream);
+      }
+      else
+      {
+         memcpy(cdata, data, size);
+         c->csize = size;
+      }
+
+      test_put_le(file, 0x04034b50, 4);
+      test_put_le(file, 20, 2);
+      test_put_le(file, 0, 2);
+      test_put_le(file, c->cmode, 2);
+      test_put_le(file, 0, 4);
+      test_put_le(file, c->crc, 4);
+      test_put_le(file, c->csize, 4);
+      test_put_le(file, c->size, 4);
+      test_put_le(file, name_len, 2);
+      /* Extra field of a different size than in the directory. */
+      test_put_le(file, 4, 2);
+      fwrite(c->name, 1, name_len, file);
+      test_put_le(file, 0xcafe, 4);
+      fwrite(cdata, 1, c->csize, file);
+   }
+
+   dir_offset = ftell(file);
+
+   for (i = 0; i < count; i++)
+   {
+      struct test_central *c = &central[i];
+      size_t name_len        = strlen(c->name);
+
+      test_put_le(file, 0x02014b50, 4);
+      test_put_le(file, 20, 2);
+      test_put_le(file, 20, 2);
+      test_put_le(file, 0, 2);
+      test_put_le(file, c->cmode, 2);
+      test_put_le(file, 0, 4);
+      test_put_le(file, c->crc, 4);
+      test_put_le(file, c->csize, 4);
+      test_put_le(file, c->size, 4);
+      test_put_le(file, name_len, 2);
+      test_put_le(file, 0, 2);
+      test_put_le(file, 0, 2);
+      test_put_le(file, 0, 2);
+      test_put_le(file, 0, 2);
+      test_put_le(file, 0, 4);
+      test_put_le(file, c->offset, 4);
+      fwrite(c->name, 1, name_len, file);
+   }
+
+   dir_size = ftell(file) - dir_offset;
+
+   test_put_le(file, 0x06054b50, 4);
+   test_put_le(file, 0, 2);
+   test_put_le(file, 0, 2);
+   test_put_le(file, count, 2);
+   test_put_le(file, count, 2);
+   test_put_le(file, dir_size, 4);
+   test_put_le(file, dir_offset, 4);
+   test_put_le(file, 0, 2);
+
+   fclose(file);
+   free(central);
+   free(data);
+   free(cdata);
+}
+
+static double test_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static int test_count_cb(const char *name, const char *valid_exts,
+      const uint8_t *cdata, unsigned cmode, uint32_t csize, uint32_t size,
+      uint32_t crc32, void *userdata)
+{
+   (*(unsigned*)userdata)++;
+   return 1;
+}
+
+int main(void)
+{
+   unsigned i;
+   double start, index_time, parse_time;
+   char path[64];
+   const zlib_index_t *index = NULL;
+   struct string_list *list  = NULL;
+   uint8_t *expected         = (uint8_t*)malloc(80000);
+   uint8_t *expected_copy    = NULL;
+
+   test_write_zip(TEST_ZIP, TEST_ENTRIES);
+
+   index = zlib_index_get(TEST_ZIP);
+   CHECK(index && zlib_index_count(index) == TEST_ENTRIES);
+   CHECK(zlib_index_get(TEST_ZIP) == index);
+   CHECK(!zlib_index_find(index, "missing.sfc"));
+
+   for (i = 0; i < TEST_ENTRIES; i++)
+   {
+      void *buf  = NULL;
+      size_t len = 0;
+      size_t size = test_entry_size(i);
+
+      snprintf(path, sizeof(path), "dir %u/game %u.%s",
+            i % 3, i, (i % 2) ? "sfc" : "bin");
+
+      CHECK(zlib_index_entry(zlib_index_get(TEST_ZIP), i)
+            == zlib_index_find(zlib_index_get(TEST_ZIP), path));
+
+      test_entry_data(i, expected, size);
+
+      CHECK(zlib_extract_to_buffer(TEST_ZIP, path, &buf, &len));
+      CHECK(len == size && buf && !memcmp(buf, expected, size));
+      CHECK(buf && ((char*)buf)[len] == '\0');
+      free(buf);
+
+      if (i % 50 == 0)
+      {
+         FILE *file;
+         CHECK(zlib_extract_to_file(TEST_ZIP, path, TEST_OUT));
+         file = fopen(TEST_OUT, "rb");
+         CHECK(file != NULL);
+         if (file)
+         {
+            uint8_t *out = (uint8_t*)malloc(size + 1);
+            CHECK(fread(out, 1, size + 1, file) == size);
+            CHECK(!memcmp(out, expected, size));
+            free(out);
+            fclose(file);
+         }
+      }
+   }
+
+   list = zlib_get_file_list(TEST_ZIP, "sfc");
+   CHECK(list && list->size == TEST_ENTRIES / 2);
+   string_list_free(list);
+
+   list = zlib_get_file_list(TEST_ZIP, NULL);
+   CHECK(list && list->size == TEST_ENTRIES);
+   string_list_free(list);
+
+   CHECK(!strcmp(zlib_find_first_content_file(TEST_ZIP, "smc|sfc"),
+            "dir 1/game 1.sfc"));
+   CHECK(!zlib_find_first_content_file(TEST_ZIP, "smc"));
+
+   /* A changed archive is parsed again. */
+   sleep(1);
+   test_write_zip(TEST_ZIP, 10);
+   CHECK(zlib_index_count(zlib_index_get(TEST_ZIP)) == 10);
+   CHECK(!zlib_extract_to_buffer(TEST_ZIP, "dir 0/game 1500.bin",
+            (void**)&expected_copy, NULL));
+
+   /* Finding one entry of a big archive, compared to walking
+    * its central directory. */
+   test_write_zip(TEST_ZIP, 20000);
+   zlib_index_get(TEST_ZIP);
+
+   start = test_time();
+   for (i = 0; i < 1000; i++)
+      zlib_index_find(zlib_index_get(TEST_ZIP), "dir 1/game 19999.sfc");
+   index_time = (test_time() - start) / 1000;
+
+   start = test_time();
+   for (i = 0; i < 10; i++)
+   {
+      unsigned count = 0;
+      zlib_parse_file(TEST_ZIP, NULL, test_count_cb, &count);
+      CHECK(count == 20000);
+   }
+   parse_time = (test_time() - start) / 10;
+
+   printf("Lookup in 20000 entries: %.1f us indexed, %.1f us parsing.\n",
+         index_time * 1e6, parse_time * 1e6);
+
+   remove(TEST_ZIP);
+   remove(TEST_OUT);
+   free(expected);
+
+   printf("%s\n", failures ? "ZIP index tests failed." :
+         "All ZIP index tests passed.");
+
+   return failures ? 1 : 0;
+}